@@ -0,0 +1,402 @@
+/*
+  Check and benchmark for the SIMD literal CEL rows in
+  libopera/opera_madam.c (LiteralRow()).
+
+  Builds CCB lists of the sort the titles we regress spend their time
+  in, and runs them through opera_madam_cel_handle() at each
+  opera_madam_simd_set() level the CPU has:
+
+    fmv16      320x240 16 bit uncoded, opaque (FMV)
+    bg8        320x240 8 bit coded, through the PLUT (backgrounds)
+    blend16    320x240 16 bit uncoded, 50% over the frame buffer
+    sprites16  40 64x48 16 bit coded CELs with transparent pixels,
+               some part way off screen
+    add8       320x240 8 bit uncoded, additive, with different PIXC
+               halves picked by the P bit
+
+  Every level has to leave all of DRAM and VRAM the same as the scalar
+  path does, bit for bit. That's checked on the lists above and on
+  lots of random small CELs (random PIXC, CCBCTL0, PMODE, PLUTPOS,
+  NOBLK, BGND, bpp, positions, reading a frame buffer a few pixels off
+  the one written, and so on) first.
+
+  Build / run:
+    gcc -O2 -Ilibopera -o bench_cel bench_cel.c libopera/[a-z]*.c -lm
+    ./bench_cel [random CELs] [runs]     (default 20000 and 20)
+*/
+
+#include "opera_arm.h"
+#include "opera_madam.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RAM_BYTES  (3 * 1024 * 1024)
+#define CCB_LIST   0x00010000
+#define CEL_DATA   0x00040000
+#define FRAME      0x00200000
+
+/* CCB flags / PRE0 / PRE1 bits, as in opera_madam.c */
+#define CCB_LAST    0x40000000
+#define CCB_NPABS   0x20000000
+#define CCB_SPABS   0x10000000
+#define CCB_PPABS   0x08000000
+#define CCB_LDSIZE  0x04000000
+#define CCB_LDPRS   0x02000000
+#define CCB_LDPPMP  0x01000000
+#define CCB_LDPLUT  0x00800000
+#define CCB_CCBPRE  0x00400000
+#define CCB_YOXY    0x00200000
+#define CCB_ACW     0x00040000
+#define CCB_ACCW    0x00020000
+#define CCB_PXOR    0x00000800
+#define CCB_USEAV   0x00000400
+#define CCB_POVER   0x00000180
+#define CCB_PLUTPOS 0x00000040
+#define CCB_BGND    0x00000020
+#define CCB_NOBLK   0x00000010
+#define PRE0_LINEAR 0x00000010
+
+static const char *g_LEVEL_NAMES[] = {"scalar","sse4.1","avx2"};
+
+static uint32_t g_RNG = 0xCE1;
+
+static
+uint32_t
+rng(void)
+{
+  g_RNG ^= (g_RNG << 13);
+  g_RNG ^= (g_RNG >> 17);
+  g_RNG ^= (g_RNG << 5);
+
+  return g_RNG;
+}
+
+typedef struct cel_s cel_t;
+struct cel_s
+{
+  uint32_t flags;
+  int32_t  x;
+  int32_t  y;
+  int32_t  w;
+  int32_t  h;
+  uint32_t bpp;    /* 8 or 16 */
+  uint32_t coded;
+  uint32_t pixc;
+  int      zeros;  /* 1 in zeros_ pixels is 0 (transparent, unless BGND) */
+};
+
+static uint8_t *g_RAM;
+
+static
+void
+wr32(const uint32_t addr_,
+     const uint32_t val_)
+{
+  memcpy(&g_RAM[addr_],&val_,4);
+}
+
+/* Writes a CCB list and its CEL data. Returns the address of the first CCB. */
+static
+uint32_t
+build(const cel_t *cels_,
+      const int    count_)
+{
+  int i;
+  uint32_t ccb  = CCB_LIST;
+  uint32_t data = CEL_DATA;
+
+  for(i = 0; i < count_; i++)
+    {
+      const cel_t *c = &cels_[i];
+      uint32_t words = (((c->w * c->bpp) + 31) >> 5);
+      uint32_t pre0;
+      uint32_t pre1;
+      uint32_t plut;
+      uint32_t n;
+
+      if (words < 2)
+        words = 2;
+
+      pre0 = (((c->bpp == 16) ? 6 : 5) | ((c->h - 1) << 6) | (c->coded ? 0 : PRE0_LINEAR));
+      pre1 = ((c->w - 1) | ((words - 2) << 16));
+
+      plut = data;
+      for(n = 0; n < 16; n++)
+        wr32(data + (n << 2),rng());
+      data += 64;
+
+      for(n = 0; n < (words * c->h); n++)
+        {
+          uint32_t v = rng();
+
+          if (c->zeros && !(rng() % c->zeros))
+            v &= ((rng() & 1) ? 0xFFFF0000 : 0x0000FF00);
+          wr32(data + (n << 2),v);
+        }
+
+      wr32(ccb +  0,(c->flags | CCB_NPABS | CCB_SPABS | CCB_PPABS | CCB_LDSIZE | CCB_LDPRS |
+                     CCB_LDPPMP | CCB_CCBPRE | CCB_YOXY | CCB_ACW | CCB_ACCW |
+                     (c->coded ? CCB_LDPLUT : 0) | ((i == (count_ - 1)) ? CCB_LAST : 0)));
+      wr32(ccb +  4,((i == (count_ - 1)) ? 0 : (ccb + 64)));
+      wr32(ccb +  8,data);
+      wr32(ccb + 12,plut);
+      wr32(ccb + 16,(c->x << 16));
+      wr32(ccb + 20,(c->y << 16));
+      wr32(ccb + 24,0x00100000); /* HDX 1.0 (12.20) */
+      wr32(ccb + 28,0);
+      wr32(ccb + 32,0);
+      wr32(ccb + 36,0x00010000); /* VDY 1.0 (16.16) */
+      wr32(ccb + 40,0);
+      wr32(ccb + 44,0);
+      wr32(ccb + 48,c->pixc);
+      wr32(ccb + 52,pre0);
+      wr32(ccb + 56,pre1);
+
+      ccb  += 64;
+      data += (words * c->h * 4);
+    }
+
+  return CCB_LIST;
+}
+
+/* rdoff_ moves the frame buffer MADAM reads from, relative to the one it writes. */
+static
+void
+draw(const uint32_t first_,
+     const uint32_t ccbctl0_,
+     const int32_t  rdoff_)
+{
+  opera_madam_poke(0x110,ccbctl0_);
+  opera_madam_poke(0x130,0x1414);              /* 320 wide, read and write */
+  opera_madam_poke(0x134,((239 << 16) | 319)); /* clip */
+  opera_madam_poke(0x138,FRAME + rdoff_);
+  opera_madam_poke(0x13C,FRAME);
+  opera_madam_poke(0x5A4,first_);
+  opera_madam_cel_handle();
+}
+
+enum { LIST_FMV16, LIST_BG8, LIST_BLEND16, LIST_SPRITES16, LIST_ADD8, LIST_COUNT };
+
+static const char *g_LIST_NAMES[] = {"fmv16","bg8","blend16","sprites16","add8"};
+
+static
+int
+make_list(const int  list_,
+          cel_t     *cels_)
+{
+  int i;
+  cel_t full = {CCB_BGND,0,0,320,240,16,0,0x1F001F00,0};
+
+  switch(list_)
+    {
+    case LIST_FMV16:
+      cels_[0] = full;
+      return 1;
+    case LIST_BG8:
+      cels_[0] = full;
+      cels_[0].bpp   = 8;
+      cels_[0].coded = 1;
+      return 1;
+    case LIST_BLEND16:
+      cels_[0] = full;
+      cels_[0].flags = 0;
+      cels_[0].pixc  = 0x1F811F81;
+      return 1;
+    case LIST_SPRITES16:
+      for(i = 0; i < 40; i++)
+        {
+          cel_t c = {0,(int32_t)(rng() % 340) - 20,(int32_t)(rng() % 250) - 20,64,48,16,1,0x1F001F00,8};
+          cels_[i] = c;
+        }
+      return 40;
+    case LIST_ADD8:
+      cels_[0] = full;
+      cels_[0].flags = 0;
+      cels_[0].bpp   = 8;
+      cels_[0].pixc  = 0x1F801F00;
+      cels_[0].zeros = 16;
+      return 1;
+    }
+
+  return 0;
+}
+
+static
+void
+random_cel(cel_t *c_)
+{
+  static const uint32_t pixc[] =
+    {0x1F001F00,0x1F811F81,0x1F801F80,0x1F401F40,0x1F801F00,0x0F000F00,0x1F813F81};
+
+  c_->flags = (rng() & (CCB_POVER | CCB_PLUTPOS | CCB_BGND | CCB_NOBLK));
+  if (!(rng() % 8))
+    c_->flags |= (rng() & (CCB_PXOR | CCB_USEAV));
+  c_->w     = 1 + (rng() % 90);
+  c_->h     = 1 + (rng() % 12);
+  c_->x     = (int32_t)(rng() % 400) - 40;
+  c_->y     = (int32_t)(rng() % 280) - 20;
+  c_->bpp   = ((rng() & 1) ? 16 : 8);
+  c_->coded = (rng() & 1);
+  c_->pixc  = ((rng() & 3) ? pixc[rng() % 7] : rng());
+  c_->zeros = (rng() % 4);
+}
+
+static
+uint32_t
+random_ccbctl0(void)
+{
+  return (rng() & 0xF8000000);
+}
+
+static
+void
+fill_frame(uint32_t seed_)
+{
+  uint32_t i;
+  uint32_t save = g_RNG;
+
+  g_RNG = seed_;
+  for(i = FRAME; i < RAM_BYTES; i += 4)
+    wr32(i,rng());
+  g_RNG = save;
+}
+
+/* Every level against the scalar path, over the whole of DRAM and VRAM. */
+static
+int
+check(const int levels_,
+      const int randoms_)
+{
+  int t;
+  int level;
+  int fails = 0;
+  cel_t cels[40];
+  uint8_t *want = malloc(RAM_BYTES);
+
+  for(t = 0; t < (LIST_COUNT + randoms_); t++)
+    {
+      int count;
+      uint32_t first;
+      uint32_t ccbctl0;
+      int32_t  rdoff = 0;
+      uint32_t seed  = rng();
+
+      if (t < LIST_COUNT)
+        {
+          count   = make_list(t,cels);
+          ccbctl0 = 0xB0000000;
+        }
+      else
+        {
+          count = 1 + (rng() % 4);
+          for(level = 0; level < count; level++)
+            random_cel(&cels[level]);
+          ccbctl0 = random_ccbctl0();
+          if (!(rng() % 4))
+            rdoff = (((int32_t)(rng() % 81) - 40) * 2);
+        }
+      first = build(cels,count);
+
+      opera_madam_simd_set(OPERA_MADAM_SIMD_NONE);
+      fill_frame(seed);
+      draw(first,ccbctl0,rdoff);
+      memcpy(want,g_RAM,RAM_BYTES);
+
+      for(level = 1; level <= levels_; level++)
+        {
+          opera_madam_simd_set(level);
+          fill_frame(seed);
+          draw(first,ccbctl0,rdoff);
+          if (memcmp(want,g_RAM,RAM_BYTES) && (fails++ < 10))
+            printf("MISMATCH: %s, %s\n",
+                   ((t < LIST_COUNT) ? g_LIST_NAMES[t] : "random CELs"),
+                   g_LEVEL_NAMES[level]);
+        }
+    }
+
+  free(want);
+
+  return fails;
+}
+
+static
+double
+seconds(void)
+{
+  return ((double)clock() / CLOCKS_PER_SEC);
+}
+
+int
+main(int    argc_,
+     char **argv_)
+{
+  int list;
+  int level;
+  int levels;
+  int randoms;
+  int runs;
+
+  randoms = ((argc_ > 1) ? atoi(argv_[1]) : 20000);
+  runs    = ((argc_ > 2) ? atoi(argv_[2]) : 20);
+  if ((randoms < 0) || (runs <= 0))
+    {
+      fprintf(stderr,"Usage: %s [random CELs] [runs]\n",argv_[0]);
+      return -1;
+    }
+
+  opera_arm_init();
+  g_RAM = opera_arm_ram_get();
+  opera_madam_init(g_RAM);
+
+  levels = opera_madam_simd_get();
+  printf("CPU has: %s\n",g_LEVEL_NAMES[levels]);
+
+  if (check(levels,randoms))
+    {
+      printf("Results don't match the scalar path.\n");
+      return -1;
+    }
+  printf("%d lists and %d random CEL lists match at every level.\n\n",LIST_COUNT,randoms);
+
+  printf("%-10s","ms per list");
+  for(level = 0; level <= levels; level++)
+    printf(" %14s",g_LEVEL_NAMES[level]);
+  printf("\n");
+
+  for(list = 0; list < LIST_COUNT; list++)
+    {
+      cel_t cels[40];
+      uint32_t first;
+      double base = 0;
+
+      first = build(cels,make_list(list,cels));
+      printf("%-10s",g_LIST_NAMES[list]);
+      for(level = 0; level <= levels; level++)
+        {
+          int i;
+          double best = 1e9;
+
+          opera_madam_simd_set(level);
+          for(i = 0; i < runs; i++)
+            {
+              double t = seconds();
+
+              draw(first,0xB0000000,0);
+              t = (seconds() - t);
+              if (t < best)
+                best = t;
+            }
+
+          if (level == 0)
+            base = best;
+          printf(" %7.3f (%.1fx)",best * 1e3,base / best);
+        }
+      printf("\n");
+    }
+
+  return 0;
+}
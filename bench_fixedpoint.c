@@ -0,0 +1,317 @@
+/*
+  Microbenchmark for the Many calls in libopera/opera_fixedpoint_math.c.
+
+  Times MulManyVec3Mat33_F16, MulManyVec4Mat44_F16 and
+  MulManyVec3Mat33DivZ_F16 at each kernel level the CPU has, against the
+  original one-vertex-at-a-time loops (copied below), and checks every
+  result against them bit for bit. Corner values (0x7FFFFFFF,
+  0x80000000, etc.) and in-place calls (dest == src) are in the check.
+
+  Build / run:
+    gcc -O2 -Ilibopera -o bench_fixedpoint bench_fixedpoint.c libopera/opera_fixedpoint_math.c
+    ./bench_fixedpoint [vertices per call] [calls]     (default 64 and 200000)
+*/
+
+#include "opera_fixedpoint_math.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const char *g_LEVEL_NAMES[] = {"portable","sse4.1","avx2"};
+
+static uint32_t g_RNG = 0x3D0;
+
+static
+uint32_t
+rng(void)
+{
+  g_RNG ^= (g_RNG << 13);
+  g_RNG ^= (g_RNG >> 17);
+  g_RNG ^= (g_RNG << 5);
+
+  return g_RNG;
+}
+
+/* Mostly the sort of numbers a game would use, with the odd nasty one. */
+static
+frac16
+rnd_f16(void)
+{
+  static const frac16 corners[] =
+    {0,1,-1,0x10000,-0x10000,0x7FFFFFFF,(frac16)0x80000000,0x7FFF0000,(frac16)0x80010000,0xFFFF};
+
+  switch(rng() & 15)
+    {
+    case 0:
+      return corners[rng() % (sizeof(corners) / sizeof(corners[0]))];
+    case 1:
+      return (frac16)rng();
+    default:
+      return ((int32_t)rng() >> 8);
+    }
+}
+
+static
+void
+rnd_fill(frac16   *p_,
+         uint32_t  n_)
+{
+  while(n_--)
+    *p_++ = rnd_f16();
+}
+
+/* The loops as they were. */
+static
+void
+ref_many_vec3_mat33(vec3f16 *dest_, vec3f16 *src_, mat33f16 mat_, int32_t count_)
+{
+  int32_t i;
+  vec3f16 tmp;
+
+  for(i = 0; i < count_; i++)
+    {
+      tmp[0] = ((((int64_t)src_[i][0] * (int64_t)mat_[0][0]) +
+                 ((int64_t)src_[i][1] * (int64_t)mat_[1][0]) +
+                 ((int64_t)src_[i][2] * (int64_t)mat_[2][0])) >> 16);
+      tmp[1] = ((((int64_t)src_[i][0] * (int64_t)mat_[0][1]) +
+                 ((int64_t)src_[i][1] * (int64_t)mat_[1][1]) +
+                 ((int64_t)src_[i][2] * (int64_t)mat_[2][1])) >> 16);
+      tmp[2] = ((((int64_t)src_[i][0] * (int64_t)mat_[0][2]) +
+                 ((int64_t)src_[i][1] * (int64_t)mat_[1][2]) +
+                 ((int64_t)src_[i][2] * (int64_t)mat_[2][2])) >> 16);
+
+      dest_[i][0] = tmp[0];
+      dest_[i][1] = tmp[1];
+      dest_[i][2] = tmp[2];
+    }
+}
+
+static
+void
+ref_many_vec4_mat44(vec4f16 *dest_, vec4f16 *src_, mat44f16 mat_, int32_t count_)
+{
+  int32_t i;
+  int32_t j;
+  vec4f16 tmp;
+
+  for(i = 0; i < count_; i++)
+    {
+      for(j = 0; j < 4; j++)
+        tmp[j] = ((((int64_t)src_[i][0] * (int64_t)mat_[0][j]) +
+                   ((int64_t)src_[i][1] * (int64_t)mat_[1][j]) +
+                   ((int64_t)src_[i][2] * (int64_t)mat_[2][j]) +
+                   ((int64_t)src_[i][3] * (int64_t)mat_[3][j])) >> 16);
+
+      memcpy(dest_[i],tmp,sizeof(tmp));
+    }
+}
+
+static
+void
+ref_many_vec3_mat33_divz(vec3f16 *dest_, vec3f16 *src_, mat33f16 *mat_, frac16 n_, uint32_t count_)
+{
+  uint32_t i;
+
+  for(i = 0; i < count_; i++)
+    {
+      ref_many_vec3_mat33(&dest_[i],&src_[i],*mat_,1);
+      if(dest_[i][2] != 0)
+        {
+          int64_t mul;
+
+          mul = (((int64_t)n_ << 16) / (int64_t)dest_[i][2]);
+
+          dest_[i][0] = (((int64_t)dest_[i][0] * mul) >> 16);
+          dest_[i][1] = (((int64_t)dest_[i][1] * mul) >> 16);
+        }
+    }
+}
+
+enum { CALL_VEC3, CALL_VEC4, CALL_DIVZ, CALL_COUNT };
+
+static const char *g_CALL_NAMES[] = {"MulManyVec3Mat33_F16","MulManyVec4Mat44_F16","MulManyVec3Mat33DivZ_F16"};
+
+typedef struct bench_s bench_t;
+struct bench_s
+{
+  frac16   mat[16];
+  frac16  *src;
+  frac16  *dest;
+  frac16   n;
+  uint32_t count;
+};
+
+static
+void
+run(const int      call_,
+    const int      ref_,
+    bench_t       *b_,
+    frac16        *dest_)
+{
+  switch(call_)
+    {
+    case CALL_VEC3:
+      if(ref_)
+        ref_many_vec3_mat33((vec3f16*)dest_,(vec3f16*)b_->src,*(mat33f16*)b_->mat,b_->count);
+      else
+        MulManyVec3Mat33_F16((vec3f16*)dest_,(vec3f16*)b_->src,*(mat33f16*)b_->mat,b_->count);
+      break;
+    case CALL_VEC4:
+      if(ref_)
+        ref_many_vec4_mat44((vec4f16*)dest_,(vec4f16*)b_->src,*(mat44f16*)b_->mat,b_->count);
+      else
+        MulManyVec4Mat44_F16((vec4f16*)dest_,(vec4f16*)b_->src,*(mat44f16*)b_->mat,b_->count);
+      break;
+    case CALL_DIVZ:
+      if(ref_)
+        ref_many_vec3_mat33_divz((vec3f16*)dest_,(vec3f16*)b_->src,(mat33f16*)b_->mat,b_->n,b_->count);
+      else
+        MulManyVec3Mat33DivZ_F16((vec3f16*)dest_,(vec3f16*)b_->src,(mat33f16*)b_->mat,b_->n,b_->count);
+      break;
+    }
+}
+
+/* Every level against the reference, out of place and in place, for lots of sizes and values. */
+static
+int
+check(const int levels_)
+{
+  int call;
+  int level;
+  int trial;
+  int in_place;
+  int fails = 0;
+  bench_t b;
+  frac16 src[4 * 67];
+  frac16 want[4 * 67 + 4];
+  frac16 got[4 * 67 + 4];
+
+  b.src = src;
+  for(trial = 0; trial < 4000; trial++)
+    for(call = 0; call < CALL_COUNT; call++)
+      for(in_place = 0; in_place < 2; in_place++)
+        {
+          const uint32_t width = ((call == CALL_VEC4) ? 4 : 3);
+
+          b.count = (rng() % 67);
+          b.n     = rnd_f16();
+          rnd_fill(b.mat,16);
+          rnd_fill(src,4 * 67);
+
+          /* the guard words after dest catch anything written past the end */
+          memcpy(want,src,sizeof(src));
+          want[width * b.count] = 0x5A5A5A5A;
+          b.src = (in_place ? want : src);
+          run(call,1,&b,want);
+
+          for(level = 0; level <= levels_; level++)
+            {
+              opera_fixedpoint_simd_set(level);
+              memcpy(got,src,sizeof(src));
+              got[width * b.count] = 0x5A5A5A5A;
+              b.src = (in_place ? got : src);
+              run(call,0,&b,got);
+
+              if(memcmp(got,want,(width * b.count + 1) * sizeof(frac16)))
+                {
+                  if(fails++ < 10)
+                    printf("MISMATCH: %s %s count %u%s\n",
+                           g_CALL_NAMES[call],g_LEVEL_NAMES[level],b.count,
+                           (in_place ? " in place" : ""));
+                }
+            }
+          b.src = src;
+        }
+
+  return fails;
+}
+
+static
+double
+seconds(void)
+{
+  return ((double)clock() / CLOCKS_PER_SEC);
+}
+
+static
+double
+bench(const int  call_,
+      const int  ref_,
+      bench_t   *b_,
+      uint32_t   calls_)
+{
+  double t;
+
+  t = seconds();
+  while(calls_--)
+    run(call_,ref_,b_,b_->dest);
+
+  return (seconds() - t);
+}
+
+int
+main(int    argc_,
+     char **argv_)
+{
+  int call;
+  int level;
+  int levels;
+  uint32_t calls;
+  bench_t b;
+
+  b.count = ((argc_ > 1) ? (uint32_t)atoi(argv_[1]) : 64);
+  calls   = ((argc_ > 2) ? (uint32_t)atoi(argv_[2]) : 200000);
+  if(b.count == 0 || calls == 0)
+    {
+      fprintf(stderr,"Usage: %s [vertices per call] [calls]\n",argv_[0]);
+      return -1;
+    }
+
+  levels = opera_fixedpoint_simd_get();
+  printf("CPU has: %s\n",g_LEVEL_NAMES[levels]);
+
+  if(check(levels))
+    {
+      printf("Results don't match the reference.\n");
+      return -1;
+    }
+  printf("Results match the reference at every level.\n\n");
+
+  b.src  = (frac16*)malloc(b.count * 4 * sizeof(frac16));
+  b.dest = (frac16*)malloc(b.count * 4 * sizeof(frac16));
+  b.n    = (256 << 16);
+  rnd_fill(b.mat,16);
+  rnd_fill(b.src,b.count * 4);
+
+  printf("%u vertices per call, %u calls. ns per vertex:\n\n",b.count,calls);
+  printf("%-26s %10s","","reference");
+  for(level = 0; level <= levels; level++)
+    printf(" %10s",g_LEVEL_NAMES[level]);
+  printf("\n");
+
+  for(call = 0; call < CALL_COUNT; call++)
+    {
+      double ref;
+      double ns = (1e9 / ((double)calls * b.count));
+
+      ref = bench(call,1,&b,calls);
+      printf("%-26s %10.2f",g_CALL_NAMES[call],ref * ns);
+      for(level = 0; level <= levels; level++)
+        {
+          double t;
+
+          opera_fixedpoint_simd_set(level);
+          t = bench(call,0,&b,calls);
+          printf(" %5.2f (%.1fx)",t * ns,ref / t);
+        }
+      printf("\n");
+    }
+
+  free(b.src);
+  free(b.dest);
+
+  return 0;
+}
@@ -0,0 +1,237 @@
+// Bit-exactness check and benchmark for MADAM's matrix engine (the 0x7FC commands in libopera/opera_madam.c).
+//
+// Random matrices / vectors (plus the nasty corner values) go through opera_madam_poke(), and get checked against the
+// engine's arithmetic written out on its own (below), so anything that changes the results shows up. With BENCH_MATRIX_RTL=1 (a Verilator build, see bench_matrix.sh),
+// the 3x3 multiply also gets checked against rtl/matrix_engine.v, which is all the RTL does so far.
+//
+// Then it times the commands, the way a game would use them: load the registers, start a multiply, read the result back.
+//
+// Usage: ./bench_matrix.sh [tests] [timed ops]
+//
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "opera_madam.h"
+
+#if BENCH_MATRIX_RTL
+#include "Vmatrix_engine.h"
+#include "Vmatrix_engine___024root.h"
+#include "verilated.h"
+#endif
+
+enum { CMD_COPY = 0, CMD_MUL4X4 = 1, CMD_MUL3X3 = 2, CMD_MUL3X3_NZ = 3 };
+
+typedef struct matrix_regs_t {
+	int32_t mi[4][4];		// 0x600 - 0x63C, in rows.
+	int32_t mv[4];			// 0x640 - 0x64C
+	int32_t n[2];			// 0x680 / 0x684
+} matrix_regs_t;
+
+static uint32_t rng_state = 0x7FC;
+
+static uint32_t rng() {
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+	return rng_state;
+}
+
+static int32_t rnd_reg() {
+	static const int32_t corners[] = { 0, 1, -1, 0x10000, -0x10000, 0x7FFFFFFF, (int32_t)0x80000000, 0x7FFF0000, (int32_t)0x80010000 };
+	switch (rng() & 15) {
+		case 0: return corners[rng() % (sizeof(corners) / sizeof(corners[0]))];
+		case 1: return (int32_t)rng();
+		default: return (int32_t)rng() >> 8;		// 16.16 values a game might use.
+	}
+}
+
+static void rnd_regs(matrix_regs_t* r) {
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) r->mi[i][j] = rnd_reg();
+		r->mv[i] = rnd_reg();
+	}
+	r->n[0] = (rng() & 1) ? rnd_reg() : 0;
+	r->n[1] = rnd_reg();
+}
+
+// madam_matrix_mul4x4 / _mul3x3 / _mul3x3_nz, without the registers.
+static int ref_matrix(const matrix_regs_t* r, int cmd, int64_t* out) {
+#define MI(i_, j_) ((int64_t)r->mi[i_][j_])
+#define MV(j_) ((int64_t)r->mv[j_])
+	switch (cmd) {
+		case CMD_MUL4X4:
+			for (int i = 0; i < 4; i++) out[i] = ((MI(i, 0) * MV(0)) + (MI(i, 1) * MV(1)) + (MI(i, 2) * MV(2)) + (MI(i, 3) * MV(3))) >> 16;
+			return 4;
+		case CMD_MUL3X3:
+			for (int i = 0; i < 3; i++) out[i] = ((MI(i, 0) * MV(0)) + (MI(i, 1) * MV(1)) + (MI(i, 2) * MV(2))) >> 16;
+			return 3;
+		case CMD_MUL3X3_NZ: {
+			int64_t M = ((int64_t)r->n[0] << 32) | (uint32_t)r->n[1];
+			out[2] = ((MI(2, 0) * MV(0)) + (MI(2, 1) * MV(1)) + (MI(2, 2) * MV(2))) >> 16;
+			if (out[2] != 0) M /= out[2];
+			out[0] = ((MI(0, 0) * MV(0)) + (MI(0, 1) * MV(1)) + (MI(0, 2) * MV(2))) >> 16;
+			out[1] = ((MI(1, 0) * MV(0)) + (MI(1, 1) * MV(1)) + (MI(1, 2) * MV(2))) >> 16;
+			out[0] = (out[0] * M) >> 32;
+			out[1] = (out[1] * M) >> 32;
+			return 3;
+		}
+	}
+#undef MI
+#undef MV
+	return 0;
+}
+
+static void opera_load(const matrix_regs_t* r) {
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) opera_madam_poke(0x600 + (i << 4) + (j << 2), r->mi[i][j]);
+		opera_madam_poke(0x640 + (i << 2), r->mv[i]);
+	}
+	opera_madam_poke(0x680, r->n[0]);
+	opera_madam_poke(0x684, r->n[1]);
+}
+
+// The result shows up in MO0-3 on the next command, so there's a NOP after it. (same as the BIOS does)
+static void opera_run(int cmd, uint32_t* out) {
+	opera_madam_poke(0x7FC, cmd);
+	opera_madam_poke(0x7FC, CMD_COPY);
+	for (int i = 0; i < 4; i++) out[i] = opera_madam_peek(0x660 + (i << 2));
+}
+
+#if BENCH_MATRIX_RTL
+static Vmatrix_engine* rtl;
+
+// The RTL only has the 3x3 multiply, with the result in tmpMO0-2 a clock later. Its >> is a logical shift, so only the low 32 bits
+// (all that gets to MO0-2) are the same as the C. (the top 16 come out zero for a negative sum)
+static void rtl_mul3x3(const matrix_regs_t* r, uint32_t* out) {
+	rtl->MI00_in = r->mi[0][0]; rtl->MI01_in = r->mi[0][1]; rtl->MI02_in = r->mi[0][2]; rtl->MI03_in = r->mi[0][3];
+	rtl->MI10_in = r->mi[1][0]; rtl->MI11_in = r->mi[1][1]; rtl->MI12_in = r->mi[1][2]; rtl->MI13_in = r->mi[1][3];
+	rtl->MI20_in = r->mi[2][0]; rtl->MI21_in = r->mi[2][1]; rtl->MI22_in = r->mi[2][2]; rtl->MI23_in = r->mi[2][3];
+	rtl->MI30_in = r->mi[3][0]; rtl->MI31_in = r->mi[3][1]; rtl->MI32_in = r->mi[3][2]; rtl->MI33_in = r->mi[3][3];
+	rtl->MV0_in = r->mv[0]; rtl->MV1_in = r->mv[1]; rtl->MV2_in = r->mv[2]; rtl->MV3_in = r->mv[3];
+	rtl->clock = 0; rtl->eval();
+	rtl->clock = 1; rtl->eval();
+	out[0] = (uint32_t)rtl->rootp->matrix_engine__DOT__tmpMO0;
+	out[1] = (uint32_t)rtl->rootp->matrix_engine__DOT__tmpMO1;
+	out[2] = (uint32_t)rtl->rootp->matrix_engine__DOT__tmpMO2;
+}
+#endif
+
+static int check(int tests) {
+	static const char* cmd_names[] = { "", "mul4x4", "mul3x3", "mul3x3_nz" };
+	int fails = 0;
+	matrix_regs_t r;
+
+	for (int t = 0; t < tests; t++) {
+		rnd_regs(&r);
+		opera_load(&r);
+
+		for (int cmd = CMD_MUL4X4; cmd <= CMD_MUL3X3_NZ; cmd++) {
+			int64_t want[4];
+			uint32_t got[4];
+			int n = ref_matrix(&r, cmd, want);
+
+			opera_run(cmd, got);
+			for (int i = 0; i < n; i++) {
+				if (got[i] != (uint32_t)want[i] && fails++ < 10)
+					printf("MISMATCH: %s MO%d 0x%08X, should be 0x%08X\n", cmd_names[cmd], i, got[i], (uint32_t)want[i]);
+			}
+
+#if BENCH_MATRIX_RTL
+			if (cmd == CMD_MUL3X3) {
+				rtl_mul3x3(&r, got);
+				for (int i = 0; i < n; i++) {
+					if (got[i] != (uint32_t)want[i] && fails++ < 10)
+						printf("MISMATCH: mul3x3 rtl MO%d 0x%08X, should be 0x%08X\n", i, got[i], (uint32_t)want[i]);
+				}
+			}
+#endif
+		}
+	}
+	return fails;
+}
+
+static double seconds() {
+	return (double)clock() / CLOCKS_PER_SEC;
+}
+
+static uint32_t bench_sink = 0;
+
+// ops lots of: load the vector, start the multiply, read MO0-3. Or only the arithmetic, for comparison.
+static double time_ops(int cmd, bool opera, int ops) {
+	matrix_regs_t r;
+	uint32_t out[4];
+	int64_t want[4];
+
+	rng_state = 0x7FC;
+	rnd_regs(&r);
+	opera_load(&r);
+
+	double t = seconds();
+	if (!opera) {
+		for (int i = 0; i < ops; i++) {
+			r.mv[0] = i;
+			ref_matrix(&r, cmd, want);
+			bench_sink += (uint32_t)want[0];
+		}
+	}
+	else {
+		for (int i = 0; i < ops; i++) {
+			opera_madam_poke(0x640, i);
+			opera_run(cmd, out);
+			bench_sink += out[0];
+		}
+	}
+	return seconds() - t;
+}
+
+int main(int argc, char** argv) {
+	int tests = (argc > 1) ? atoi(argv[1]) : 200000;
+	int ops = (argc > 2) ? atoi(argv[2]) : 2000000;
+	if (tests <= 0 || ops <= 0) {
+		fprintf(stderr, "Usage: %s [tests] [timed ops]\n", argv[0]);
+		return -1;
+	}
+
+#if BENCH_MATRIX_RTL
+	Verilated::commandArgs(argc, argv);
+	rtl = new Vmatrix_engine;
+#endif
+
+	if (check(tests)) {
+		printf("Results don't match.\n");
+		return -1;
+	}
+#if BENCH_MATRIX_RTL
+	printf("%d tests match, and rtl/matrix_engine.v matches for mul3x3.\n\n", tests);
+#else
+	printf("%d tests match. (no RTL check in this build)\n\n", tests);
+#endif
+
+	// Each one gets a few goes, taking turns, and the best one counts. (the slower ones are mostly other things on the machine)
+	double best[4][2];
+	for (int cmd = CMD_MUL4X4; cmd <= CMD_MUL3X3_NZ; cmd++) best[cmd][0] = best[cmd][1] = 1e9;
+	for (int run = 0; run < 5; run++) {
+		for (int cmd = CMD_MUL4X4; cmd <= CMD_MUL3X3_NZ; cmd++) {
+			for (int opera = 0; opera < 2; opera++) {
+				double t = time_ops(cmd, opera, ops);
+				if (t < best[cmd][opera]) best[cmd][opera] = t;
+			}
+		}
+	}
+
+	printf("ns per op  arithmetic  through 0x7FC\n");
+	for (int cmd = CMD_MUL4X4; cmd <= CMD_MUL3X3_NZ; cmd++) {
+		static const char* names[] = { "", "mul4x4", "mul3x3", "mul3x3_nz" };
+		double ns = 1e9 / ops;
+		printf("%-10s %10.2f %14.2f\n", names[cmd], best[cmd][0] * ns, best[cmd][1] * ns);
+	}
+	printf("(checksum %08X)\n", bench_sink);
+
+#if BENCH_MATRIX_RTL
+	rtl->final();
+	delete rtl;
+#endif
+	return 0;
+}
@@ -0,0 +1,29 @@
+# Bit-exactness check and benchmark for MADAM's matrix engine. (bench_matrix.cpp)
+#
+# Checks the 0x7FC commands in libopera/opera_madam.c against the arithmetic written out on its own.
+# With Verilator on the path, the 3x3 multiply is checked against rtl/matrix_engine.v as well. Then it times them.
+#
+# Usage: ./bench_matrix.sh [tests] [timed ops]     (CC / CXX pick the compiler, OUT the build directory)
+
+set -e
+
+CC=${CC:-gcc}
+CXX=${CXX:-g++}
+OUT=${OUT:-out_bench_matrix}
+
+mkdir -p $OUT/libopera
+rm -f $OUT/libopera/*.o $OUT/bench_matrix
+
+for f in libopera/*.c; do
+	$CC -O2 -Ilibopera -c $f -o $OUT/libopera/$(basename $f .c).o
+done
+ar rcs $OUT/libopera.a $OUT/libopera/*.o
+
+if command -v verilator >/dev/null 2>&1; then
+	verilator --public-flat-rw -O3 -Wno-WIDTH -Wno-fatal --top-module matrix_engine -Mdir $OUT --cc rtl/matrix_engine.v --exe bench_matrix.cpp $PWD/$OUT/libopera.a -CFLAGS "-O2 -DBENCH_MATRIX_RTL=1 -I$PWD/libopera" -LDFLAGS "-lm" -MAKEFLAGS "CXX=$CXX" --build -j 0 -o bench_matrix
+else
+	echo "No Verilator, so no RTL check."
+	$CXX -O2 -Ilibopera -o $OUT/bench_matrix bench_matrix.cpp $OUT/libopera.a -lm
+fi
+
+$OUT/bench_matrix "$@"
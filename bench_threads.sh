@@ -0,0 +1,64 @@
+# Thread count sweep for the headless runner.
+#
+# Builds one model per thread count (out_bench_t<n>), then times the same BIOS boot on each and prints cycles/s.
+# Each count gets RUNS runs, and the best one is reported, since the slower runs are mostly other things on the machine.
+#
+# Usage: ./bench_threads.sh
+#   THREAD_LIST="1 2 4 8 16"   Thread counts to try.
+#   BIOS / ROM2 / CYCLES       The workload. (default: 20M cycles of panafz10.bin)
+#   RUNS=3                     Runs per thread count.
+#   PGO=1                      Build each one with pgo_headless.sh instead. (Trained on the same workload)
+#   REBUILD=1                  Rebuild models that are already there.
+#   CC / CXX                   As for verilate_headless.sh.
+
+set -e
+
+THREAD_LIST=${THREAD_LIST:-"1 2 4 8 16"}
+BIOS=${BIOS:-panafz10.bin}
+ROM2=${ROM2:-panafz1-kanji.bin}
+CYCLES=${CYCLES:-20000000}
+RUNS=${RUNS:-3}
+CPUS=$(nproc)
+
+for t in $THREAD_LIST; do
+	out=out_bench_t$t
+	if [ "${REBUILD:-0}" = "1" ] || [ ! -x $out/sim_3do_headless ]; then
+		echo "Building $out..."
+		mkdir -p $out
+		if [ "${PGO:-0}" = "1" ]; then
+			env -u PGO THREADS=$t OUT=$out BIOS=$BIOS ROM2=$ROM2 CYCLES=$CYCLES ./pgo_headless.sh > $out/build.log 2>&1
+		else
+			env -u PGO THREADS=$t OUT=$out ./verilate_headless.sh > $out/build.log 2>&1
+		fi
+	fi
+done
+
+echo
+echo "$CYCLES cycles of $BIOS, best of $RUNS. ($CPUS CPUs)"
+echo
+printf "%8s  %12s  %8s\n" threads cycles/s speedup
+
+base=""
+best_t=""
+best_cps=0
+for t in $THREAD_LIST; do
+	out=out_bench_t$t
+	cps=0
+	for r in $(seq $RUNS); do
+		run=$($out/sim_3do_headless --bios $BIOS --rom2 $ROM2 --cycles $CYCLES 2>&1 >/dev/null | sed -n 's/.*(\([0-9]*\) cycles\/s).*/\1/p')
+		[ -n "$run" ] && [ "$run" -gt "$cps" ] && cps=$run
+	done
+
+	[ -z "$base" ] && base=$cps
+	note=""
+	[ $t -gt $CPUS ] && note="  (more threads than CPUs)"
+	printf "%8s  %12s  %7.2fx%s\n" $t $cps $(echo "$cps $base" | awk '{ print ($2 > 0) ? $1 / $2 : 0 }') "$note"
+
+	if [ $cps -gt $best_cps ]; then
+		best_cps=$cps
+		best_t=$t
+	fi
+done
+
+echo
+echo "Fastest: THREADS=$best_t ($best_cps cycles/s)"
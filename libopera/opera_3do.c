@@ -28,6 +28,7 @@
   *  Felix Lazarev
   */
 
+#include "opera_3do.h"
 #include "opera_arm.h"
 #include "opera_clio.h"
 #include "opera_clock.h"
@@ -134,6 +135,9 @@ opera_3do_internal_frame(uint32_t  cycles_,
                          uint32_t *line_,
                          int       field_)
 {
+  if(opera_arm_idle_get() && opera_clock_push_would_queue(cycles_,opera_clio_timers_running()))
+    opera_arm_idle_break();
+
   opera_clock_push_cycles(cycles_);
   //if(opera_clock_dsp_queued()) io_interface(EXT_DSP_TRIGGER,NULL);
 
@@ -159,6 +163,152 @@ int32_t cnt = 0;
 uint32_t line = 0;
 static int field = 0;
 
+/*
+  One trip round the current idle loop, from each cnt it can start at:
+  the cnt it leaves, and what it puts on the clock on the way. Worked
+  out again only when the loop's cycles change (opera_arm_idle_loop()).
+*/
+typedef struct opera_3do_trip_s opera_3do_trip_t;
+struct opera_3do_trip_s
+{
+  int32_t  cnt;
+  uint32_t pushed;
+};
+
+static opera_3do_trip_t g_TRIPS[32];
+static uint32_t         g_TRIPS_SERIAL;
+
+static
+void
+opera_3do_trips_build(const int32_t  *cycles_,
+                      const uint32_t  n_)
+{
+  uint32_t i;
+  uint32_t pushed;
+  int32_t  c;
+  int32_t  start;
+
+  for(start = 0; start < 32; start++)
+    {
+      c      = start;
+      pushed = 0;
+      for(i = 0; i < n_; i++)
+        {
+          c += cycles_[i];
+          if(c >= 32)
+            {
+              pushed += c;
+              c      -= 32;
+            }
+        }
+
+      g_TRIPS[start].cnt    = c;
+      g_TRIPS[start].pushed = pushed;
+    }
+}
+
+/*
+  The ARM is at the top of a loop that won't get anywhere before the next
+  line, timer tick or DSP sample (opera_arm_idle_loop()). Put whole trips
+  round it on the clock, counted the same way as running them one
+  instruction per call would have, up to the first one that would set
+  something off. That one gets run as usual. Timer ticks don't count
+  while no CLIO timer is counting: they go on the clock along with the
+  rest, and the ones that came due are let go here, as they would have
+  been one per push.
+*/
+static
+void
+opera_3do_idle_skip(const int32_t  *cycles_,
+                    const uint32_t  n_,
+                    const uint32_t  serial_)
+{
+  int      timer;
+  uint32_t ops;
+  uint32_t pushed;
+  int32_t  c;
+  const opera_3do_trip_t *trip;
+
+  if((cnt < 0) || (cnt >= 32))
+    return;
+
+  if(serial_ != g_TRIPS_SERIAL)
+    {
+      opera_3do_trips_build(cycles_,n_);
+      g_TRIPS_SERIAL = serial_;
+    }
+
+  timer  = opera_clio_timers_running();
+  c      = cnt;
+  pushed = 0;
+  ops    = 0;
+  while(c < 32)
+    {
+      trip = &g_TRIPS[c];
+
+      /* (The clock takes 16.16, so no more than 64K at once.) */
+      if(((pushed + trip->pushed) >= 0x8000) ||
+         opera_clock_push_would_queue(pushed + trip->pushed,timer))
+        break;
+
+      c       = trip->cnt;
+      pushed += trip->pushed;
+      ops    += n_;
+    }
+
+  if(ops == 0)
+    return;
+
+  opera_clock_push_cycles(pushed);
+  if(!timer)
+    while(opera_clock_timer_queued());
+  cnt = c;
+  flagtime = (((uint32_t)flagtime > ops) ? (flagtime - (int)ops) : 0);
+}
+
+/*
+  One call's worth of opera_3do_process_frame(): an instruction (or a
+  JIT run of up to 32 cycles), and whatever line / timer tick that
+  brings up. Non-zero if it put cycles on the clock, which is the only
+  time a line or DSP sample can come due.
+*/
+static
+INLINE
+int
+opera_3do_step(void)
+{
+  uint32_t n;
+  uint32_t serial;
+  const int32_t *cycles;
+
+  if(flagtime)
+    flagtime--;
+
+  if(opera_madam_fsm_get() == FSM_INPROCESS)
+    {
+      opera_madam_cel_handle();
+      opera_madam_fsm_set(FSM_IDLE);
+      opera_arm_idle_break();
+    }
+
+  /* NULL unless idle skipping is on, and the ARM is at the top of an idle loop. */
+  cycles = opera_arm_idle_loop(&n,&serial);
+  if(cycles != NULL)
+    opera_3do_idle_skip(cycles,n,serial);
+
+  if(opera_arm_jit_get())
+    cnt += opera_arm_execute_jit(32 - cnt);
+  else
+    cnt += opera_arm_execute();
+  if(cnt < 32)
+    return 0;
+
+  opera_3do_internal_frame(cnt,&line,field);
+  cnt -= 32;
+
+  return 1;
+}
+
 void
 opera_3do_process_frame(uint32_t *opera_line, uint32_t *opera_field)
 {
@@ -167,27 +317,13 @@ opera_3do_process_frame(uint32_t *opera_line, uint32_t *opera_field)
 	//static int field = 0;
 	uint32_t scanlines;
 
-  if(flagtime)
-    flagtime--;
-
   //cnt  = 0;
   //line = 0;
   scanlines = opera_region_scanlines();
   
   //do
     //{
-      if(opera_madam_fsm_get() == FSM_INPROCESS)
-        {
-          opera_madam_cel_handle();
-          opera_madam_fsm_set(FSM_IDLE);
-        }
-
-      cnt += opera_arm_execute();
-      if(cnt >= 32)
-        {
-          opera_3do_internal_frame(cnt,&line,field);
-          cnt -= 32;
-        }
+      opera_3do_step();
     //} while(line < scanlines);
 
 	if (line==scanlines) {
@@ -198,6 +334,69 @@ opera_3do_process_frame(uint32_t *opera_line, uint32_t *opera_field)
 	*opera_field = field;
 }
 
+/*
+  Same as calling opera_3do_process_frame() (and draining the DSP after
+  each call) until lines_ lines have gone by, without going back out to
+  the caller in between. cb_->line gets each line once the VDLP is done
+  with it, and cb_->dsp each DSP sample. Either can be NULL, as can
+  cb_. (The DSP still runs, the samples just get dropped.)
+*/
+uint32_t
+opera_3do_process_lines(const uint32_t              lines_,
+                        const opera_3do_lines_cb_t *cb_,
+                        uint32_t                   *opera_line,
+                        uint32_t                   *opera_field)
+{
+  uint32_t n;
+  uint32_t last;
+  uint32_t sample;
+  uint32_t scanlines;
+
+  n         = 0;
+  scanlines = opera_region_scanlines();
+  while(n < lines_)
+    {
+      last = line;
+      if(!opera_3do_step())
+        continue;
+
+      if(opera_clock_dsp_queued())
+        {
+          sample = opera_dsp_loop();
+          if(cb_ && cb_->dsp)
+            cb_->dsp(cb_->data,sample);
+        }
+
+      if(line == last)
+        continue;
+
+      if(cb_ && cb_->line)
+        cb_->line(cb_->data,last,field);
+
+      if(line == scanlines)
+        {
+          line  = 0;
+          field = !field;
+        }
+
+      n++;
+    }
+
+  *opera_line  = line;
+  *opera_field = field;
+
+  return n;
+}
+
+/* The rest of the current field. */
+uint32_t
+opera_3do_process_field(const opera_3do_lines_cb_t *cb_,
+                        uint32_t                   *opera_line,
+                        uint32_t                   *opera_field)
+{
+  return opera_3do_process_lines((opera_region_scanlines() - line),cb_,opera_line,opera_field);
+}
+
 uint32_t
 opera_3do_state_size(void)
 {
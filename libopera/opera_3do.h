@@ -17,6 +17,24 @@ void     opera_3do_destroy(void);
 
 void     opera_3do_process_frame(uint32_t *opera_line, uint32_t *opera_field);
 //void     opera_3do_process_frame(uint32_t opera_line);
+
+/*
+  Whole lines at a time, instead of one instruction per
+  opera_3do_process_frame() call. Runs exactly the same. See
+  opera_3do.c.
+*/
+typedef struct opera_3do_lines_cb_s opera_3do_lines_cb_t;
+struct opera_3do_lines_cb_s
+{
+  void (*line)(void *data, uint32_t line, uint32_t field);
+  void (*dsp)(void *data, uint32_t sample);
+  void *data;
+};
+
+uint32_t opera_3do_process_lines(const uint32_t lines, const opera_3do_lines_cb_t *cb,
+                                 uint32_t *opera_line, uint32_t *opera_field);
+uint32_t opera_3do_process_field(const opera_3do_lines_cb_t *cb,
+                                 uint32_t *opera_line, uint32_t *opera_field);
 EXTERN_C_END
 
 
@@ -34,10 +34,13 @@
 #include "inline.h"
 #include "opera_arm.h"
 #include "opera_arm_core.h"
+#include "opera_arm_i.h"
 #include "opera_clio.h"
+#include "opera_clock.h"
 #include "opera_core.h"
 #include "opera_diag_port.h"
 #include "opera_fixedpoint_math.h"
+#include "opera_log.h"
 #include "opera_madam.h"
 #include "opera_sport.h"
 #include "opera_swi_hle_0x5XXXX.h"
@@ -48,14 +51,13 @@
 #include <stdlib.h>
 #include <string.h>
 
-uint32_t old_pc;
+static uint32_t old_pc;
 uint16_t old_mode;
-int trace = 0;
+int opera_trace = 0;
 char my_string [100];
 
-FILE *logfile;
-FILE *rom1file;
-FILE *rom2file;
+FILE *opera_logfile;
+uint32_t opera_log_mask = 0;
 
 #define ARM_INITIAL_PC  0x03000000
 
@@ -126,9 +128,133 @@ const static uint16_t cond_flags_cross[]=
 #define NVRAM_SIZE (32 * 1024)
 
 static int        g_SWI_HLE;
-//static arm_core_t CPU;
+arm_core_t CPU;
 static int        CYCLES;	//cycle counter
 
+/*
+  Lazy NZCV. Flag setting ops just note what they did in g_FLAGS, and
+  CPSR bits 28-31 only get worked out when something looks at them:
+  a condition other than AL, MRS / MSR, a mode change or an SPSR save,
+  or anyone outside going through opera_arm_flags_sync(). Most S ops
+  are followed by another one long before a condition check. ARM_GET_C()
+  can get the carry on its own without a full sync.
+*/
+enum arm_flags_e
+  {
+    ARM_FLAGS_NONE,             /* CPSR is up to date */
+    ARM_FLAGS_LOGIC,            /* NZ from res, C is a, V from CPSR */
+    ARM_FLAGS_ADD,              /* res = a + b (+ carry) */
+    ARM_FLAGS_SUB               /* res = a - b (- borrow) */
+  };
+
+typedef struct arm_flags_s arm_flags_t;
+struct arm_flags_s
+{
+  uint32_t kind;
+  uint32_t res;
+  uint32_t a;
+  uint32_t b;
+};
+
+static arm_flags_t g_FLAGS;
+
+static
+INLINE
+uint32_t
+arm_flags_add_cv(const uint32_t res_,
+                 const uint32_t a_,
+                 const uint32_t b_)
+{
+  return (((((a_ & b_) | ((~res_) & (a_ | b_))) & 0x80000000) >> 2) |
+          ((((a_ & (b_ & (~res_))) | ((~a_) & (~b_) & res_)) & 0x80000000) >> 3));
+}
+
+static
+INLINE
+uint32_t
+arm_flags_sub_cv(const uint32_t res_,
+                 const uint32_t a_,
+                 const uint32_t b_)
+{
+  return (((((a_ & (~b_)) | ((~res_) & (a_ | (~b_)))) & 0x80000000) >> 2) |
+          ((((a_ & ((~b_) & (~res_))) | ((~a_) & b_ & res_)) & 0x80000000) >> 3));
+}
+
+static
+INLINE
+void
+arm_flags_sync(void)
+{
+  uint32_t nzcv;
+
+  if(g_FLAGS.kind == ARM_FLAGS_NONE)
+    return;
+
+  nzcv = ((g_FLAGS.res & 0x80000000) | (g_FLAGS.res ? 0 : 0x40000000));
+  switch(g_FLAGS.kind)
+    {
+    case ARM_FLAGS_LOGIC:
+      nzcv |= ((g_FLAGS.a << 29) | (CPU.CPSR & 0x10000000));
+      break;
+    case ARM_FLAGS_ADD:
+      nzcv |= arm_flags_add_cv(g_FLAGS.res,g_FLAGS.a,g_FLAGS.b);
+      break;
+    default:
+      nzcv |= arm_flags_sub_cv(g_FLAGS.res,g_FLAGS.a,g_FLAGS.b);
+      break;
+    }
+
+  CPU.CPSR = ((CPU.CPSR & 0x0fffffff) | nzcv);
+  g_FLAGS.kind = ARM_FLAGS_NONE;
+}
+
+void
+opera_arm_flags_sync(void)
+{
+  arm_flags_sync();
+}
+
+/* NZ from res_, C = c_, V left alone. Which means making V real first if it's still pending. */
+static
+INLINE
+void
+arm_flags_logic(const uint32_t res_,
+                const uint32_t c_)
+{
+  if(g_FLAGS.kind > ARM_FLAGS_LOGIC)
+    arm_flags_sync();
+
+  g_FLAGS.kind = ARM_FLAGS_LOGIC;
+  g_FLAGS.res  = res_;
+  g_FLAGS.a    = (c_ & 1);
+}
+
+static
+INLINE
+void
+arm_flags_add(const uint32_t res_,
+              const uint32_t a_,
+              const uint32_t b_)
+{
+  g_FLAGS.kind = ARM_FLAGS_ADD;
+  g_FLAGS.res  = res_;
+  g_FLAGS.a    = a_;
+  g_FLAGS.b    = b_;
+}
+
+static
+INLINE
+void
+arm_flags_sub(const uint32_t res_,
+              const uint32_t a_,
+              const uint32_t b_)
+{
+  g_FLAGS.kind = ARM_FLAGS_SUB;
+  g_FLAGS.res  = res_;
+  g_FLAGS.a    = a_;
+  g_FLAGS.b    = b_;
+}
+
 static uint32_t readusr(uint32_t rn);
 static void     loadusr(uint32_t rn, uint32_t val);
 static uint32_t mreadb(uint32_t addr);
@@ -136,6 +262,422 @@ static void     mwriteb(uint32_t addr, uint8_t val);
 static uint32_t mreadw(uint32_t addr);
 static void     mwritew(uint32_t addr,uint32_t val);
 
+/*
+  Decoded instruction cache.
+
+  opera_arm_execute() used to fetch every instruction through mreadw(),
+  then pick it apart again with the big switch. Now each word of DRAM or
+  ROM that gets executed is decoded once, into an arm_op_t: the handler
+  for its instruction class, the condition mask, and the register, shift
+  and immediate fields already pulled out. After that it's just the
+  condition check and a call.
+
+  The ops live in 1KB pages (256 instructions each), allocated the first
+  time code runs from them. Dropping a page just bumps its generation, so
+  each op in it gets decoded again on its next fetch.
+
+  DRAM pages are dropped by opera_arm_icache_write() on any write to them,
+  but only once something has been decoded from there (opera_arm_icache_live),
+  so writes to data pages cost a byte test. ROM pages are dropped when the
+  bank is switched, and everything on reset, state load and ROM byteswap.
+
+  VRAM (and anywhere else) is still fetched and decoded every time.
+
+  arm_op_t and the page numbering are in opera_arm_i.h, as the JIT
+  translates from the same ops.
+*/
+
+typedef struct arm_icache_page_s arm_icache_page_t;
+struct arm_icache_page_s
+{
+  uint16_t gen;
+  arm_op_t ops[ICACHE_PAGE_OPS];
+};
+
+static arm_icache_page_t *g_ICACHE[ICACHE_PAGES];
+uint8_t opera_arm_icache_live[OPERA_ARM_ICACHE_DRAM_PAGES];
+
+/*
+  ARM memory map, in 4 KB pages over the bottom 128 MB (there's nothing
+  above that). g_MEM_READ / g_MEM_WRITE have the host address of each
+  page that's plain memory: DRAM, VRAM and ROM for reads, only DRAM for
+  writes. Anything else goes to its g_MEM_IO handler, down by mreadw().
+  VRAM writes go through one as well, for the HIRESMODE copies.
+
+  Rebuilt by arm_mem_map() whenever CPU.ram or CPU.rom change.
+*/
+#define ARM_MEM_PAGE_SHIFT 12
+#define ARM_MEM_PAGE_MASK  ((1 << ARM_MEM_PAGE_SHIFT) - 1)
+#define ARM_MEM_PAGES      ((128 * 1024 * 1024) >> ARM_MEM_PAGE_SHIFT)
+
+enum arm_mem_io_e
+  {
+    ARM_MEM_IO_NONE,
+    ARM_MEM_IO_VRAM,
+    ARM_MEM_IO_SLOW,            /* 0x031xxxxx: Brooktree, NVRAM, diag port */
+    ARM_MEM_IO_SPORT,           /* 0x032xxxxx */
+    ARM_MEM_IO_MADAM,           /* 0x033xxxxx */
+    ARM_MEM_IO_CLIO             /* 0x034xxxxx */
+  };
+
+static uint8_t *g_MEM_READ[ARM_MEM_PAGES];
+static uint8_t *g_MEM_WRITE[ARM_MEM_PAGES];
+static uint8_t  g_MEM_IO[ARM_MEM_PAGES];
+
+static
+void
+arm_mem_map_range(const uint32_t  addr_,
+                  const uint32_t  size_,
+                  uint8_t        *read_,
+                  uint8_t        *write_,
+                  const uint8_t   io_)
+{
+  uint32_t i;
+
+  for(i = 0; i < (size_ >> ARM_MEM_PAGE_SHIFT); i++)
+    {
+      const uint32_t page = ((addr_ >> ARM_MEM_PAGE_SHIFT) + i);
+      const uint32_t offset = (i << ARM_MEM_PAGE_SHIFT);
+
+      g_MEM_READ[page]  = (read_  ? (read_ + offset)  : NULL);
+      g_MEM_WRITE[page] = (write_ ? (write_ + offset) : NULL);
+      g_MEM_IO[page]    = io_;
+    }
+}
+
+static
+void
+arm_mem_map(void)
+{
+  memset(g_MEM_READ,0,sizeof(g_MEM_READ));
+  memset(g_MEM_WRITE,0,sizeof(g_MEM_WRITE));
+  memset(g_MEM_IO,ARM_MEM_IO_NONE,sizeof(g_MEM_IO));
+
+  arm_mem_map_range(0x00000000,DRAM_SIZE,CPU.ram,CPU.ram,ARM_MEM_IO_NONE);
+  arm_mem_map_range(0x00200000,VRAM_SIZE,CPU.ram + DRAM_SIZE,NULL,ARM_MEM_IO_VRAM);
+  arm_mem_map_range(0x03000000,ROM1_SIZE,CPU.rom,NULL,ARM_MEM_IO_NONE);
+  arm_mem_map_range(0x06000000,ROM1_SIZE,CPU.rom,NULL,ARM_MEM_IO_NONE); /* ANVIL */
+  arm_mem_map_range(0x03100000,0x100000,NULL,NULL,ARM_MEM_IO_SLOW);
+  arm_mem_map_range(0x03200000,0x100000,NULL,NULL,ARM_MEM_IO_SPORT);
+  arm_mem_map_range(0x03300000,0x100000,NULL,NULL,ARM_MEM_IO_MADAM);
+  arm_mem_map_range(0x03400000,0x100000,NULL,NULL,ARM_MEM_IO_CLIO);
+}
+
+static int      g_JIT;
+static uint32_t g_JIT_BREAK = 0xFFFFFFFF;
+uint8_t arm_jit_stop;
+
+/*
+  Idle loops (opera_arm_idle_set()). A short loop that writes nothing,
+  and only reads memory and CLIO registers that don't mind being read,
+  can only get anywhere when something outside it changes: a line, a
+  timer tick, the DSP, the CEL engine. So once it comes back round to
+  the top with every register and CPSR the same as last time, and none
+  of that happened in between (opera_arm_idle_break()), it'll keep doing
+  exactly that until something does. opera_3do_process_frame() then
+  puts whole trips round it on the clock without running them.
+
+  Loops that keep changing something (delay loops) get noted in busy,
+  and left alone after ARM_IDLE_MAX_FAILS trips.
+*/
+#define ARM_IDLE_MAX_OPS   8
+#define ARM_IDLE_MAX_FAILS 4
+
+typedef struct arm_idle_s arm_idle_t;
+struct arm_idle_s
+{
+  int      on;
+  int      idle;                /* the last trip round was the same as the one before */
+  int      impure;              /* something happened during this trip */
+  uint32_t head;                /* the loop being watched, 0xFFFFFFFF for none */
+  uint32_t tail;                /* its branch back to head */
+  uint32_t busy;
+  uint32_t fails;
+  uint32_t n;                   /* instructions so far this trip */
+  uint32_t len;                 /* and in the last one, when idle */
+  uint32_t serial;              /* bumped whenever len / loop change */
+  int32_t  cycles[ARM_IDLE_MAX_OPS];
+  int32_t  loop[ARM_IDLE_MAX_OPS];  /* cycles[] of the last idle trip */
+  uint32_t regs[16];
+  uint32_t cpsr;
+};
+
+static arm_idle_t g_IDLE = { .head = 0xFFFFFFFF, .tail = 0xFFFFFFFF, .busy = 0xFFFFFFFF };
+
+static
+INLINE
+int
+arm_idle_watching(const uint32_t pc_)
+{
+  return ((pc_ - g_IDLE.head) <= (g_IDLE.tail - g_IDLE.head));
+}
+
+static
+void
+arm_idle_forget(void)
+{
+  g_IDLE.idle = 0;
+  g_IDLE.head = 0xFFFFFFFF;
+  g_IDLE.tail = 0xFFFFFFFF;
+}
+
+static
+void
+arm_idle_snap(void)
+{
+  arm_flags_sync();
+  memcpy(g_IDLE.regs,CPU.USER,sizeof(g_IDLE.regs));
+  g_IDLE.cpsr   = CPU.CPSR;
+  g_IDLE.n      = 0;
+  g_IDLE.impure = 0;
+}
+
+static
+void
+arm_idle_watch(const uint32_t head_,
+               const uint32_t tail_)
+{
+  g_IDLE.head  = head_;
+  g_IDLE.tail  = tail_;
+  g_IDLE.fails = 0;
+  g_IDLE.idle  = 0;
+  arm_idle_snap();
+}
+
+/* Stores, SWP, and anything that can change CPSR or call out. */
+static
+int
+arm_idle_writes(const arm_op_t *op_)
+{
+  if((op_->kind == ARM_OP_KIND_END) || (op_->kind == ARM_OP_KIND_BL))
+    return 1;
+
+  switch((op_->cmd >> 25) & 0x7)
+    {
+    case 0x0:
+      return ((op_->cmd & ARM_SDS_MASK) == ARM_SDS_SIGN);
+    case 0x2:
+    case 0x3:
+    case 0x4:
+      return !(op_->cmd & (1 << 20));
+    }
+
+  return 0;
+}
+
+/* Where the loop starting at head_ branches back to it, if it's short and writes nothing. 0 if not. */
+uint32_t
+arm_idle_loop(const uint32_t head_)
+{
+  uint32_t i;
+  uint32_t pc;
+  const arm_op_t *op;
+
+  pc = head_;
+  for(i = 0; i < ARM_IDLE_MAX_OPS; i++)
+    {
+      op = arm_icache_op(pc);
+      if(op == NULL)
+        return 0;
+      if((op->kind == ARM_OP_KIND_B) && ((pc + 4 + op->imm) == head_))
+        return pc;
+      if(arm_idle_writes(op))
+        return 0;
+      pc += 4;
+    }
+
+  return 0;
+}
+
+/* Back at the top. */
+static
+void
+arm_idle_pass(void)
+{
+  arm_flags_sync();
+  if(!g_IDLE.impure &&
+     (g_IDLE.n <= ARM_IDLE_MAX_OPS) &&
+     (g_IDLE.cpsr == CPU.CPSR) &&
+     !memcmp(g_IDLE.regs,CPU.USER,sizeof(g_IDLE.regs)))
+    {
+      if((g_IDLE.len != g_IDLE.n) || memcmp(g_IDLE.loop,g_IDLE.cycles,(g_IDLE.n * sizeof(int32_t))))
+        {
+          memcpy(g_IDLE.loop,g_IDLE.cycles,(g_IDLE.n * sizeof(int32_t)));
+          g_IDLE.len = g_IDLE.n;
+          g_IDLE.serial++;
+        }
+
+      g_IDLE.idle  = 1;
+      g_IDLE.n     = 0;
+      g_IDLE.fails = 0;
+      return;
+    }
+
+  g_IDLE.idle = 0;
+  if(++g_IDLE.fails > ARM_IDLE_MAX_FAILS)
+    {
+      g_IDLE.busy = g_IDLE.head;
+      arm_idle_forget();
+      return;
+    }
+
+  arm_idle_snap();
+}
+
+/* After each instruction the interpreter runs, with pc_ the one it just ran. */
+static
+void
+arm_idle_step(const uint32_t pc_,
+              const int32_t  cycles_)
+{
+  uint32_t tail;
+  const uint32_t to = CPU.USER[15];
+
+  if(arm_idle_watching(pc_))
+    {
+      if(g_IDLE.n < ARM_IDLE_MAX_OPS)
+        g_IDLE.cycles[g_IDLE.n] = cycles_;
+      g_IDLE.n++;
+
+      if((pc_ == g_IDLE.tail) && (to == g_IDLE.head))
+        arm_idle_pass();
+      else if(!arm_idle_watching(to))
+        arm_idle_forget();
+      return;
+    }
+
+  /* Only a branch back a little way starts anything. */
+  if(((pc_ - to) >= (ARM_IDLE_MAX_OPS * 4)) || (to == g_IDLE.busy))
+    return;
+
+  /* Its own branch back, or one from further on that goes back into it. */
+  tail = arm_idle_loop(to);
+  if(tail == 0)
+    {
+      g_IDLE.busy = to;
+      return;
+    }
+
+  arm_idle_watch(to,tail);
+}
+
+/* The JIT wants to run a block that starts an idle loop candidate. 1 if the interpreter should have it instead. */
+int
+arm_idle_claim(const uint32_t head_)
+{
+  uint32_t tail;
+
+  if(!g_IDLE.on || (head_ == g_IDLE.busy))
+    return 0;
+  if(head_ == g_IDLE.head)
+    return 1;
+
+  tail = arm_idle_loop(head_);
+  if(tail == 0)
+    return 0;
+
+  arm_idle_watch(head_,tail);
+  return 1;
+}
+
+void
+opera_arm_idle_set(const int on_)
+{
+  g_IDLE.on   = !!on_;
+  g_IDLE.busy = 0xFFFFFFFF;
+  arm_idle_forget();
+}
+
+int
+opera_arm_idle_get(void)
+{
+  return g_IDLE.on;
+}
+
+const int32_t*
+opera_arm_idle_loop(uint32_t *n_,
+                    uint32_t *serial_)
+{
+  if(!g_IDLE.idle || g_IDLE.n || (CPU.USER[15] != g_IDLE.head))
+    return NULL;
+
+  *n_      = g_IDLE.len;
+  *serial_ = g_IDLE.serial;
+  return g_IDLE.loop;
+}
+
+void
+opera_arm_idle_break(void)
+{
+  g_IDLE.idle   = 0;
+  g_IDLE.impure = 1;
+}
+
+static
+void
+arm_icache_page_drop(arm_icache_page_t *page_)
+{
+  uint32_t i;
+
+  if(++page_->gen)
+    return;
+
+  /* Wrapped. Don't let anything from 65536 drops ago look valid again. */
+  for(i = 0; i < ICACHE_PAGE_OPS; i++)
+    page_->ops[i].gen = 0;
+  page_->gen = 1;
+}
+
+static
+void
+arm_icache_drop_pages(const uint32_t first_,
+                      const uint32_t last_)
+{
+  uint32_t i;
+
+  for(i = first_; i < last_; i++)
+    {
+      if(g_ICACHE[i])
+        arm_icache_page_drop(g_ICACHE[i]);
+      if(i < ICACHE_DRAM_PAGES)
+        opera_arm_icache_live[i] = 0;
+      arm_jit_drop(i);
+    }
+
+  arm_jit_stop = 1;
+}
+
+void
+opera_arm_icache_drop(uint32_t page_)
+{
+  arm_icache_drop_pages(page_,page_ + 1);
+}
+
+void
+opera_arm_icache_flush(void)
+{
+  arm_icache_drop_pages(0,ICACHE_PAGES);
+  arm_jit_flush();
+}
+
+static
+void
+arm_icache_free(void)
+{
+  uint32_t i;
+
+  for(i = 0; i < ICACHE_PAGES; i++)
+    {
+      free(g_ICACHE[i]);
+      g_ICACHE[i] = NULL;
+    }
+
+  memset(opera_arm_icache_live,0,sizeof(opera_arm_icache_live));
+
+  arm_jit_destroy();
+  g_JIT = 0;
+}
+
 uint8_t*
 opera_arm_nvram_get(void)
 {
@@ -170,6 +712,7 @@ opera_arm_rom1_byteswap_if_necessary(void)
   size = opera_arm_rom1_size();
 
   swap32_array_if_little_endian((uint32_t*)rom,(size / sizeof(uint32_t)));
+  opera_arm_icache_flush();
 }
 
 uint8_t*
@@ -194,6 +737,7 @@ opera_arm_rom2_byteswap_if_necessary(void)
   size = opera_arm_rom2_size();
 
   swap32_array_if_little_endian((uint32_t*)rom,(size / sizeof(uint32_t)));
+  opera_arm_icache_flush();
 }
 
 uint8_t*
@@ -229,6 +773,7 @@ opera_arm_state_size(void)
 void
 opera_arm_state_save(void *buf_)
 {
+  arm_flags_sync();
   memcpy(buf_,&CPU,sizeof(arm_core_t));
   memcpy(((uint8_t*)buf_)+sizeof(arm_core_t),CPU.ram,RAM_SIZE);
   memcpy(((uint8_t*)buf_)+sizeof(arm_core_t)+RAM_SIZE,CPU.rom1,ROM1_SIZE);
@@ -239,12 +784,16 @@ void
 opera_arm_state_load(const void *buf_)
 {
   uint8_t i;
+  int rom2_on;
   uint8_t *ram   = CPU.ram;
   uint8_t *rom1  = CPU.rom1;
   uint8_t *rom2  = CPU.rom2;
   uint8_t *nvram = CPU.nvram;
 
   memcpy(&CPU,buf_,sizeof(arm_core_t));
+  g_FLAGS.kind = ARM_FLAGS_NONE;
+  arm_idle_forget();
+  rom2_on = (CPU.rom == CPU.rom2);  /* the saver's pointers, only good for comparing */
   memcpy(ram,((uint8_t*)buf_)+sizeof(arm_core_t),RAM_SIZE);
   memcpy(rom1,((uint8_t*)buf_)+sizeof(arm_core_t)+RAM_SIZE,ROM1_SIZE);
   memcpy(nvram,((uint8_t*)buf_)+sizeof(arm_core_t)+RAM_SIZE+ROM1_SIZE,NVRAM_SIZE);
@@ -257,7 +806,11 @@ opera_arm_state_load(const void *buf_)
   CPU.ram   = ram;
   CPU.rom1  = rom1;
   CPU.rom2  = rom2;
+  CPU.rom   = (rom2_on ? rom2 : rom1);
   CPU.nvram = nvram;
+
+  arm_mem_map();
+  opera_arm_icache_flush();
 }
 
 static
@@ -532,7 +1085,13 @@ ARM_Change_ModeSafe(uint32_t mode_)
 void
 opera_arm_rom_select(int n_)
 {
-  CPU.rom = ((n_ == 0) ? CPU.rom1 : CPU.rom2);
+  uint8_t *rom = ((n_ == 0) ? CPU.rom1 : CPU.rom2);
+
+  if(rom != CPU.rom)
+    arm_icache_drop_pages(ICACHE_DRAM_PAGES,ICACHE_PAGES);
+
+  CPU.rom = rom;
+  arm_mem_map();
 }
 
 static
@@ -540,26 +1099,217 @@ INLINE
 void
 arm_cpsr_set(uint32_t a_)
 {
+  arm_flags_sync();             /* nothing pending can land on top of the new flags */
   a_ |= 0x10;
   ARM_Change_ModeSafe(a_);
   CPU.CPSR = (a_ & 0xf00000df);
 }
 
+/*
+  SWI profile (opera_arm_swi_prof_set()). Each SWI number gets a slot,
+  found by hashing. A call that goes to the kernel is timed from the SWI
+  until the SPSR comes back with the PC on its return address, in clock
+  cycles (opera_clock_now(), so to the nearest push). That covers
+  whatever else ran in the meantime, eg. other tasks while it waited.
+  HLE calls take no time at all.
+*/
+#define SWI_PROF_SLOTS 256
+#define SWI_PROF_OPEN  8
+
+typedef struct arm_swi_open_s arm_swi_open_t;
+struct arm_swi_open_s
+{
+  uint32_t slot;
+  uint32_t ret;
+  uint64_t start;
+};
+
+typedef struct arm_swi_prof_s arm_swi_prof_t;
+struct arm_swi_prof_s
+{
+  int                  on;
+  uint32_t             open_n;
+  arm_swi_open_t       open[SWI_PROF_OPEN];
+  opera_arm_swi_prof_t slots[SWI_PROF_SLOTS];
+};
+
+static arm_swi_prof_t g_SWI_PROF;
 
 static
-INLINE
-void
-SETM(uint32_t a_)
+uint32_t
+arm_swi_prof_bucket(uint64_t cycles_)
 {
-  a_ |= 0x10;
-  ARM_Change_ModeSafe(a_);
-  CPU.CPSR = ((CPU.CPSR & 0xffffffe0) | (a_ & 0x1F));
+  uint32_t b;
+
+  for(b = 0; cycles_ && (b < (OPERA_ARM_SWI_PROF_BUCKETS - 1)); b++)
+    cycles_ >>= 1;
+
+  return b;
 }
 
 static
-INLINE
 void
-SETN(int a_)
+arm_swi_prof_add(const uint32_t slot_,
+                 const uint64_t cycles_)
+{
+  opera_arm_swi_prof_t *p = &g_SWI_PROF.slots[slot_];
+
+  p->cycles += cycles_;
+  p->hist[arm_swi_prof_bucket(cycles_)]++;
+}
+
+/* SWI_PROF_SLOTS if the table's full. */
+static
+uint32_t
+arm_swi_prof_slot(const uint32_t swi_)
+{
+  uint32_t i;
+  uint32_t slot;
+  opera_arm_swi_prof_t *p;
+
+  slot = ((swi_ * 0x9E3779B1) >> 24);
+  for(i = 0; i < SWI_PROF_SLOTS; i++)
+    {
+      p = &g_SWI_PROF.slots[(slot + i) & (SWI_PROF_SLOTS - 1)];
+      if(p->calls && (p->swi != swi_))
+        continue;
+
+      p->swi = swi_;
+      p->calls++;
+
+      return ((slot + i) & (SWI_PROF_SLOTS - 1));
+    }
+
+  return SWI_PROF_SLOTS;
+}
+
+/* Called with the SWI's return address in r14_svc, unless it was HLE'd. */
+static
+void
+arm_swi_prof_enter(const uint32_t swi_,
+                   const int      hle_)
+{
+  uint32_t slot;
+  arm_swi_open_t *o;
+
+  slot = arm_swi_prof_slot(swi_);
+  if(slot == SWI_PROF_SLOTS)
+    return;
+
+  if(hle_)
+    {
+      g_SWI_PROF.slots[slot].hle++;
+      arm_swi_prof_add(slot,0);
+      return;
+    }
+
+  /* Full up with calls that never came back (the task went away). Lose the oldest. */
+  if(g_SWI_PROF.open_n == SWI_PROF_OPEN)
+    {
+      memmove(&g_SWI_PROF.open[0],&g_SWI_PROF.open[1],sizeof(arm_swi_open_t) * (SWI_PROF_OPEN - 1));
+      g_SWI_PROF.open_n--;
+    }
+
+  o = &g_SWI_PROF.open[g_SWI_PROF.open_n++];
+  o->slot  = slot;
+  o->ret   = CPU.USER[14];
+  o->start = opera_clock_now();
+}
+
+/* The SPSR just went back into the CPSR. If the PC's where a call was going back to, that call's done. */
+static
+void
+arm_swi_prof_exit(void)
+{
+  uint32_t i;
+
+  for(i = g_SWI_PROF.open_n; i--;)
+    {
+      if(g_SWI_PROF.open[i].ret != CPU.USER[15])
+        continue;
+
+      arm_swi_prof_add(g_SWI_PROF.open[i].slot,opera_clock_now() - g_SWI_PROF.open[i].start);
+      g_SWI_PROF.open[i] = g_SWI_PROF.open[--g_SWI_PROF.open_n];
+      return;
+    }
+}
+
+static
+INLINE
+void
+arm_spsr_restore(void)
+{
+  arm_cpsr_set(CPU.SPSR[arm_mode_table[CPU.CPSR & 0x1F]]);
+  if(g_SWI_PROF.open_n)
+    arm_swi_prof_exit();
+}
+
+void
+opera_arm_swi_prof_set(const int on_)
+{
+  g_SWI_PROF.on     = !!on_;
+  g_SWI_PROF.open_n = 0;
+}
+
+void
+opera_arm_swi_prof_clear(void)
+{
+  memset(g_SWI_PROF.slots,0,sizeof(g_SWI_PROF.slots));
+  g_SWI_PROF.open_n = 0;
+}
+
+static
+int
+arm_swi_prof_cmp(const void *a_,
+                 const void *b_)
+{
+  const opera_arm_swi_prof_t *a = a_;
+  const opera_arm_swi_prof_t *b = b_;
+
+  if(a->cycles != b->cycles)
+    return ((a->cycles < b->cycles) ? 1 : -1);
+  if(a->calls != b->calls)
+    return ((a->calls < b->calls) ? 1 : -1);
+
+  return ((a->swi > b->swi) - (a->swi < b->swi));
+}
+
+uint32_t
+opera_arm_swi_prof_get(opera_arm_swi_prof_t *prof_,
+                       const uint32_t        max_)
+{
+  uint32_t i;
+  uint32_t n;
+  opera_arm_swi_prof_t all[SWI_PROF_SLOTS];
+
+  n = 0;
+  for(i = 0; i < SWI_PROF_SLOTS; i++)
+    if(g_SWI_PROF.slots[i].calls)
+      all[n++] = g_SWI_PROF.slots[i];
+
+  qsort(all,n,sizeof(opera_arm_swi_prof_t),arm_swi_prof_cmp);
+
+  n = ((n < max_) ? n : max_);
+  memcpy(prof_,all,sizeof(opera_arm_swi_prof_t) * n);
+
+  return n;
+}
+
+
+static
+INLINE
+void
+SETM(uint32_t a_)
+{
+  a_ |= 0x10;
+  ARM_Change_ModeSafe(a_);
+  CPU.CPSR = ((CPU.CPSR & 0xffffffe0) | (a_ & 0x1F));
+}
+
+static
+INLINE
+void
+SETN(int a_)
 {
   CPU.CPSR = (CPU.CPSR & 0x7fffffff) | ((a_ ? 1 << 31 : 0));
 }
@@ -626,14 +1376,10 @@ ROTR(const uint32_t val_,
 void
 opera_arm_init(void)
 {
-   logfile = fopen("c:\\linux_temp\\sim_3do\\out\\opera_trace.txt", "w");
-
-   rom1file = fopen("c:\\linux_temp\\sim_3do\\out\\panafz10.bin", "rb");
-   rom2file = fopen("c:\\linux_temp\\sim_3do\\out\\panafz1-kanji.bin", "rb");
-
   int i;
 
   g_SWI_HLE = 0;
+  g_FLAGS.kind = ARM_FLAGS_NONE;
 
   CYCLES = 0;
   for(i = 0; i < 16; i++)
@@ -652,38 +1398,16 @@ opera_arm_init(void)
     
   CPU.ram   = calloc(RAM_SIZE + 1024*1024*16,1);
   
-  CPU.rom1  = malloc(ROM1_SIZE,1);
-  fread( CPU.rom1, 1, ROM1_SIZE, rom1file);
-  for (int i = 0; i < ROM1_SIZE; i+=4) {
-    uint8_t byte0 = CPU.rom1[i+0];
-    uint8_t byte1 = CPU.rom1[i+1];
-    uint8_t byte2 = CPU.rom1[i+2];
-    uint8_t byte3 = CPU.rom1[i+3];
-
-    CPU.rom1[i+0] = byte3;
-    CPU.rom1[i+1] = byte2;
-    CPU.rom1[i+2] = byte1;
-    CPU.rom1[i+3] = byte0;
-  }
-
+  /* Blank until the caller copies the images in (opera_arm_rom*_get()). */
+  CPU.rom1  = calloc(ROM1_SIZE,1);
   CPU.rom2  = calloc(ROM2_SIZE,1);
-  fread( CPU.rom2, 1, ROM2_SIZE, rom2file);
-  for (int i = 0; i < ROM2_SIZE; i += 4) {
-      uint8_t byte0 = CPU.rom2[i+0];
-      uint8_t byte1 = CPU.rom2[i+1];
-      uint8_t byte2 = CPU.rom2[i+2];
-      uint8_t byte3 = CPU.rom2[i+3];
-
-      CPU.rom2[i+0] = byte3;
-      CPU.rom2[i+1] = byte2;
-      CPU.rom2[i+2] = byte1;
-      CPU.rom2[i+3] = byte0;
-  }
 
   CPU.rom   = CPU.rom1;
 
   CPU.nvram = calloc(NVRAM_SIZE,1);
 
+  arm_mem_map();
+
   CPU.nFIQ = FALSE;
   CPU.MAS_Access_Exept = FALSE;
 
@@ -709,6 +1433,37 @@ opera_arm_destroy(void)
   if(CPU.ram)
     free(CPU.ram);
   CPU.ram = NULL;
+
+  arm_icache_free();
+}
+
+/*
+  Starts opera_trace.txt-style logging of the mask_ regions to path_.
+  Nothing is traced (or opened) until this is called. -1 if path_ can't
+  be created.
+*/
+int
+opera_log_open(const char     *path_,
+               const uint32_t  mask_)
+{
+  opera_log_close();
+
+  opera_logfile = fopen(path_,"w");
+  if(opera_logfile == NULL)
+    return -1;
+
+  opera_log_mask = mask_;
+
+  return 0;
+}
+
+void
+opera_log_close(void)
+{
+  opera_log_mask = 0;
+  if(opera_logfile)
+    fclose(opera_logfile);
+  opera_logfile = NULL;
 }
 
 void
@@ -717,7 +1472,10 @@ opera_arm_reset(void)
   int i;
 
   CYCLES = 0;
+  g_FLAGS.kind = ARM_FLAGS_NONE;
+  arm_idle_forget();
   CPU.rom = CPU.rom1;
+  arm_mem_map();
 
   for(i = 0; i < 16; i++)
     CPU.USER[i] = 0;
@@ -740,6 +1498,8 @@ opera_arm_reset(void)
   CPU.USER[15] = ARM_INITIAL_PC;
   arm_cpsr_set(0x13);
 
+  opera_arm_icache_flush();
+
   opera_clio_reset();
   opera_madam_reset();
 }
@@ -872,7 +1632,7 @@ ldm_accur(uint32_t opc_,
         }
 
       if((opc_ & (1 << 22)) && arm_mode_table[MODE] /*&& !MAS_Access_Exept*/)
-        arm_cpsr_set(CPU.SPSR[arm_mode_table[MODE]]);
+        arm_spsr_restore();
     }
 
   CYCLES -= ((x-1) * SCYCLE + NCYCLE + ICYCLE);
@@ -1005,6 +1765,7 @@ static
 void
 decode_swi_lle(void)
 {
+  arm_flags_sync();
   CPU.SPSR[arm_mode_table[0x13]] = CPU.CPSR;
 
   SETI(1);
@@ -1014,148 +1775,171 @@ decode_swi_lle(void)
   CPU.USER[15] = 0x00000008;
 }
 
-static void decode_swi_hle(const uint32_t op_)
+/* Drops the DRAM pages an HLE call wrote (bytes_ from addr_), not all of them. */
+static
+void
+arm_icache_drop_range(const uint32_t addr_,
+                      const int64_t  bytes_)
+{
+  uint32_t first;
+  uint64_t last;
+
+  if((bytes_ <= 0) || (addr_ >= (ICACHE_DRAM_PAGES << OPERA_ARM_ICACHE_PAGE_SHIFT)))
+    return;
+
+  first = (addr_ >> OPERA_ARM_ICACHE_PAGE_SHIFT);
+  last  = (((uint64_t)addr_ + bytes_ - 1) >> OPERA_ARM_ICACHE_PAGE_SHIFT) + 1;
+
+  arm_icache_drop_pages(first,((last < ICACHE_DRAM_PAGES) ? (uint32_t)last : ICACHE_DRAM_PAGES));
+}
+
+/*
+  The operamath folio SWIs (0x50000 up). They write their results
+  straight to CPU.ram, so whatever they wrote comes out of the icache.
+  The object ones write all over the place, so those drop the lot.
+  0 if it's not one of them, or one that takes its pointers from guest
+  memory (the object calls, 0x50012) and found one outside DRAM/VRAM.
+  The kernel gets those instead.
+*/
+static
+int
+decode_swi_hle(const uint32_t op_)
 {
+  uint32_t r0 = CPU.USER[0];
+  uint32_t r1 = CPU.USER[1];
+  uint32_t r2 = CPU.USER[2];
+  uint32_t r3 = CPU.USER[3];
+
   switch(op_ & 0x000FFFFF)
     {
     case 0x50000:
-      opera_swi_hle_0x50000(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2]);
-      return;
+      opera_swi_hle_0x50000(CPU.ram,r0,r1,r2);
+      arm_icache_drop_range(r0,sizeof(vec3f16));
+      return 1;
     case 0x50001:
-      opera_swi_hle_0x50001(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2]);
-      return;
+      opera_swi_hle_0x50001(CPU.ram,r0,r1,r2);
+      arm_icache_drop_range(r0,sizeof(mat33f16));
+      return 1;
     case 0x50002:
-      opera_swi_hle_0x50002(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2],CPU.USER[3]);
-      return;
+      opera_swi_hle_0x50002(CPU.ram,r0,r1,r2,r3);
+      arm_icache_drop_range(r0,(int64_t)(int32_t)r3 * sizeof(vec3f16));
+      return 1;
     case 0x50003:
-      break;
+      if(!opera_swi_hle_0x50003(CPU.ram,RAM_SIZE,r0,r1,r2))
+        return 0;
+      arm_icache_drop_pages(0,ICACHE_DRAM_PAGES);
+      return 1;
     case 0x50004:
-      break;
+      if(!opera_swi_hle_0x50004(CPU.ram,RAM_SIZE,r0,r1,r2,r3))
+        return 0;
+      arm_icache_drop_pages(0,ICACHE_DRAM_PAGES);
+      return 1;
     case 0x50005:
-      opera_swi_hle_0x50005(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2],CPU.USER[3]);
-      return;
+      opera_swi_hle_0x50005(CPU.ram,r0,r1,r2,r3);
+      arm_icache_drop_range(r0,(int64_t)(int32_t)r3 * sizeof(frac16));
+      return 1;
     case 0x50006:
-      opera_swi_hle_0x50006(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2],CPU.USER[3]);
-      return;
+      opera_swi_hle_0x50006(CPU.ram,r0,r1,r2,r3);
+      arm_icache_drop_range(r0,(int64_t)(int32_t)r3 * sizeof(frac16));
+      return 1;
     case 0x50007:
-      opera_swi_hle_0x50007(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2]);
-      return;
+      opera_swi_hle_0x50007(CPU.ram,r0,r1,r2);
+      arm_icache_drop_range(r0,sizeof(vec4f16));
+      return 1;
     case 0x50008:
-      opera_swi_hle_0x50008(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2]);
-      return;
+      opera_swi_hle_0x50008(CPU.ram,r0,r1,r2);
+      arm_icache_drop_range(r0,sizeof(mat44f16));
+      return 1;
     case 0x50009:
-      opera_swi_hle_0x50009(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2],CPU.USER[3]);
-      return;
+      opera_swi_hle_0x50009(CPU.ram,r0,r1,r2,r3);
+      arm_icache_drop_range(r0,(int64_t)(int32_t)r3 * sizeof(vec4f16));
+      return 1;
     case 0x5000A:
-      break;
+      if(!opera_swi_hle_0x5000A(CPU.ram,RAM_SIZE,r0,r1,r2))
+        return 0;
+      arm_icache_drop_pages(0,ICACHE_DRAM_PAGES);
+      return 1;
     case 0x5000B:
-      break;
+      if(!opera_swi_hle_0x5000B(CPU.ram,RAM_SIZE,r0,r1,r2,r3))
+        return 0;
+      arm_icache_drop_pages(0,ICACHE_DRAM_PAGES);
+      return 1;
     case 0x5000C:
-      CPU.USER[0] = opera_swi_hle_0x5000C(CPU.ram,CPU.USER[0],CPU.USER[1]);
-      return;
+      CPU.USER[0] = opera_swi_hle_0x5000C(CPU.ram,r0,r1);
+      return 1;
+    case 0x5000D:
+      CPU.USER[0] = opera_swi_hle_0x5000D(CPU.ram,r0,r1);
+      return 1;
     case 0x5000E:
-      opera_swi_hle_0x5000E(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2]);
-      return;
+      opera_swi_hle_0x5000E(CPU.ram,r0,r1,r2);
+      arm_icache_drop_range(r0,sizeof(vec3f16));
+      return 1;
     case 0x5000F:
-      CPU.USER[0] = opera_swi_hle_0x5000F(CPU.ram,CPU.USER[0]);
-      return;
+      CPU.USER[0] = opera_swi_hle_0x5000F(CPU.ram,r0);
+      return 1;
     case 0x50010:
-      CPU.USER[0] = opera_swi_hle_0x50010(CPU.ram,CPU.USER[0]);
-      return;
+      CPU.USER[0] = opera_swi_hle_0x50010(CPU.ram,r0);
+      return 1;
     case 0x50011:
-      opera_swi_hle_0x50011(CPU.ram,CPU.USER[0],CPU.USER[1],CPU.USER[2],CPU.USER[3]);
-      return;
+      opera_swi_hle_0x50011(CPU.ram,r0,r1,r2,r3);
+      arm_icache_drop_range(r0,sizeof(vec3f16));
+      return 1;
     case 0x50012:
-      opera_swi_hle_0x50012(CPU.ram,CPU.USER[0]);
-      return;
+      if(!opera_swi_hle_0x50012(CPU.ram,RAM_SIZE,r0))
+        return 0;
+      arm_icache_drop_range(*(uint32_t*)&CPU.ram[r0 + 0x00],(int64_t)*(uint32_t*)&CPU.ram[r0 + 0x10] * sizeof(vec3f16));
+      return 1;
     }
 
-  decode_swi_lle();
+  return 0;
 }
 
 static void decode_swi(const uint32_t op_)
 {
+  int hle;
+
   CYCLES -= (SCYCLE + NCYCLE);  // +2S+1N
 
-  fprintf(logfile, "SWI 0x%08X  (PC: 0x%08X)\n", op_, CPU.USER[15]);
+  if(opera_log_on(OPERA_LOG_MISC))
+    fprintf(opera_logfile, "SWI 0x%08X  (PC: 0x%08X)\n", op_, CPU.USER[15]);
 
-  if(g_SWI_HLE)
-  {
-    decode_swi_hle(op_);
-    return;
-  }
+  hle = (g_SWI_HLE && decode_swi_hle(op_));
+  if(!hle)
+    decode_swi_lle();
 
-  decode_swi_lle();
+  if(g_SWI_PROF.on)
+    arm_swi_prof_enter((op_ & 0x00FFFFFF),hle);
 }
 
 
 static uint32_t carry_out = 0;
 
+/* Only ARM_SHIFT_SC() still sets C on its own. */
 static
 INLINE
 void
 ARM_SET_C(const uint32_t x_)
 {
+  arm_flags_sync();
   CPU.CPSR = ((CPU.CPSR & 0xdfffffff) | ((x_ & 1) << 29));
 }
 
-static
-INLINE
-void
-ARM_SET_Z(const uint32_t x_)
-{
-  CPU.CPSR = ((CPU.CPSR & 0xbfffffff) | (x_ == 0 ? 0x40000000 : 0));
-}
-
-static
-INLINE
-void
-ARM_SET_N(const uint32_t x_)
-{
-  CPU.CPSR = ((CPU.CPSR & 0x7fffffff) | (x_ & 0x80000000));
-}
-
 static
 INLINE
 uint32_t
 ARM_GET_C(void)
 {
-  return ((CPU.CPSR >> 29) & 1);
-}
-
-static
-INLINE
-void
-ARM_SET_ZN(const uint32_t val_)
-{
-  if(val_)
-    CPU.CPSR = ((CPU.CPSR & 0x3fffffff) | (val_ & 0x80000000));
-  else
-    CPU.CPSR = ((CPU.CPSR & 0x3fffffff) | 0x40000000);
-}
-
-static
-INLINE
-void
-ARM_SET_CV(const uint32_t rd_,
-           const uint32_t op1_,
-           const uint32_t op2_)
-{
-  CPU.CPSR = ((CPU.CPSR & 0xcfffffff) |
-              ((((op1_ & op2_) | ((~rd_) & (op1_ | op2_))) & 0x80000000) >> 2) |
-              (((((op1_ & (op2_ & (~rd_))) | ((~op1_) & (~op2_) & rd_))) & 0x80000000) >> 3));
-}
+  switch(g_FLAGS.kind)
+    {
+    case ARM_FLAGS_LOGIC:
+      return g_FLAGS.a;
+    case ARM_FLAGS_ADD:
+      return (((g_FLAGS.a & g_FLAGS.b) | ((~g_FLAGS.res) & (g_FLAGS.a | g_FLAGS.b))) >> 31);
+    case ARM_FLAGS_SUB:
+      return (((g_FLAGS.a & (~g_FLAGS.b)) | ((~g_FLAGS.res) & (g_FLAGS.a | (~g_FLAGS.b)))) >> 31);
+    }
 
-static
-INLINE
-void
-ARM_SET_CV_sub(uint32_t rd_,
-               uint32_t op1_,
-               uint32_t op2_)
-{
-  CPU.CPSR = ((CPU.CPSR & 0xcfffffff) |
-              ((((op1_ & (~op2_)) | ((~rd_) & (op1_ | (~op2_)))) & 0x80000000) >> 2) |
-              (((((op1_ & ((~op2_) & (~rd_))) | ((~op1_) & op2_ & rd_))) & 0x80000000) >> 3));
+  return ((CPU.CPSR >> 29) & 1);
 }
 
 static
@@ -1195,6 +1979,7 @@ ARM_ALU_Exec(uint32_t  inst_,
       break;
     case 16:
     case 20:
+      arm_flags_sync();
       if((inst_ >> 22) & 1)
         CPU.USER[(inst_ >> 12) & 0xF] = CPU.SPSR[arm_mode_table[CPU.CPSR & 0x1F]];
       else
@@ -1202,6 +1987,7 @@ ARM_ALU_Exec(uint32_t  inst_,
       return TRUE;
     case 18:
     case 22:
+      arm_flags_sync();
       if(!((inst_ >> 16) & 0x1) || !(arm_mode_table[MODE]))
         {
           if((inst_ >> 22) & 1)
@@ -1231,74 +2017,66 @@ ARM_ALU_Exec(uint32_t  inst_,
       break;
     case 1:
       *rd_ = op1_ & op2_;
-      ARM_SET_ZN(*rd_);
+      arm_flags_logic(*rd_,carry_out);
       break;
     case 3:
       *rd_ = op1_ ^ op2_;
-      ARM_SET_ZN(*rd_);
+      arm_flags_logic(*rd_,carry_out);
       break;
     case 5:
       *rd_ = op1_ - op2_;
-      ARM_SET_ZN(*rd_);
-      ARM_SET_CV_sub(*rd_,op1_,op2_);
+      arm_flags_sub(*rd_,op1_,op2_);
       break;
     case 7:
       *rd_ = op2_ - op1_;
-      ARM_SET_ZN(*rd_);
-      ARM_SET_CV_sub(*rd_,op2_,op1_);
+      arm_flags_sub(*rd_,op2_,op1_);
       break;
     case 9:
       *rd_ = op1_ + op2_;
-      ARM_SET_ZN(*rd_);
-      ARM_SET_CV(*rd_,op1_,op2_);
+      arm_flags_add(*rd_,op1_,op2_);
       break;
 
     case 11:
       *rd_ = op1_ + op2_ + ARM_GET_C();
-      ARM_SET_ZN(*rd_);
-      ARM_SET_CV(*rd_,op1_,op2_);
+      arm_flags_add(*rd_,op1_,op2_);
       break;
     case 13:
       *rd_ = op1_ - op2_ - (ARM_GET_C()^1);
-      ARM_SET_ZN(*rd_);
-      ARM_SET_CV_sub(*rd_,op1_,op2_);
+      arm_flags_sub(*rd_,op1_,op2_);
       break;
     case 15:
       *rd_ = op2_ - op1_ - (ARM_GET_C()^1);
-      ARM_SET_ZN(*rd_);
-      ARM_SET_CV_sub(*rd_,op2_,op1_);
+      arm_flags_sub(*rd_,op2_,op1_);
       break;//*/
     case 17:
       op1_ &= op2_;
-      ARM_SET_ZN(op1_);
+      arm_flags_logic(op1_,carry_out);
       return TRUE;
     case 19:
       op1_ ^= op2_;
-      ARM_SET_ZN(op1_);
+      arm_flags_logic(op1_,carry_out);
       return TRUE;
     case 21:
-      ARM_SET_CV_sub(op1_ - op2_,op1_,op2_);
-      ARM_SET_ZN(op1_ - op2_);
+      arm_flags_sub(op1_ - op2_,op1_,op2_);
       return TRUE;
     case 23:
-      ARM_SET_CV(op1_ + op2_,op1_,op2_);
-      ARM_SET_ZN(op1_ + op2_);
+      arm_flags_add(op1_ + op2_,op1_,op2_);
       return TRUE;
     case 25:
       *rd_ = op1_ | op2_;
-      ARM_SET_ZN(*rd_);
+      arm_flags_logic(*rd_,carry_out);
       break;
     case 27:
       *rd_ = op2_;
-      ARM_SET_ZN(*rd_);
+      arm_flags_logic(*rd_,carry_out);
       break;
     case 29:
       *rd_ = op1_ & ~op2_;
-      ARM_SET_ZN(*rd_);
+      arm_flags_logic(*rd_,carry_out);
       break;
     case 31:
       *rd_ = ~op2_;
-      ARM_SET_ZN(*rd_);
+      arm_flags_logic(*rd_,carry_out);
       break;
     };
   return FALSE;
@@ -1557,393 +2335,842 @@ calcbits(uint32_t num_)
   return rv;
 }
 
-static const int is_logic[] =
-  {
-    TRUE,TRUE,FALSE,FALSE,
-    FALSE,FALSE,FALSE,FALSE,
-    TRUE,TRUE,FALSE,FALSE,
-    TRUE,TRUE,TRUE,TRUE
-  };
+/*
+  Instruction handlers, one per class the old switch used to pick. They
+  do exactly what its cases did, CPU.USER[15] juggling included, just
+  with the fields taken from the arm_op_t instead of the opcode.
+*/
 
-int32_t
-opera_arm_execute(void)
+static
+void
+arm_op_mul(const arm_op_t *op_)
 {
-  uint32_t op1;
-  uint32_t op2;
-  uint8_t shift;
-  uint8_t shtype;
-  uint32_t cmd;
-  uint32_t pc_tmp;
-  int isexeption;
-
-  /*
-  if ( (CPU.CPSR&0x1F) != old_mode) {
-     uint16_t cpu_mode = arm_mode_table[(CPU.CPSR & 0x1F) | 0x10];
-     char mode_string[4];
-     switch (cpu_mode) {
-     case ARM_MODE_USER: strcpy(mode_string, "USR"); break;
-     case ARM_MODE_FIQ:  strcpy(mode_string, "FIQ"); break;
-     case ARM_MODE_IRQ:  strcpy(mode_string, "IRQ"); break;
-     case ARM_MODE_ABT:  strcpy(mode_string, "ABT"); break;
-     case ARM_MODE_UND:  strcpy(mode_string, "UND"); break;
-     case ARM_MODE_SVC:  strcpy(mode_string, "SVC"); break;
-     default: strcpy(mode_string, "UNK"); break;
-     }
-     fprintf(logfile, "ARM Mode Change!  Mode: %s  (PC: 0x%08X)\n", mode_string, CPU.USER[15]);
-     old_mode = (CPU.CPSR & 0x1F);
-  }
-  */
+  uint32_t res = ((calcbits(CPU.USER[op_->rs])+5)>>1)-1;
+  if(res > 16)
+    CYCLES -= 16;
+  else
+    CYCLES -= res;
 
-  isexeption = FALSE;
-  if((CPU.USER[15] == 0x94D60) &&
-     (CPU.USER[0] == 0x113000) &&
-     (CPU.USER[1] == 0x113000) &&
-     (CNBFIX == 0)             &&
-     (FIXMODE & FIX_BIT_TIMING_1))
+  if(op_->rn == op_->rm)
     {
-      CPU.USER[15] = 0x9E9CC;
-      CNBFIX = 1;
+      if(op_->cmd & (1 << 21))
+        {
+          CPU.USER[15] += 8;
+          res=CPU.USER[op_->rd];
+          CPU.USER[15] -= 8;
+        }
+      else
+        {
+          res = 0;
+        }
+    }
+  else
+    {
+      if(op_->cmd & (1 << 21))
+        {
+          res = CPU.USER[op_->rm] * CPU.USER[op_->rs];
+          CPU.USER[15] += 8;
+          res += CPU.USER[op_->rd];
+          CPU.USER[15] -= 8;
+        }
+      else
+        {
+          res = CPU.USER[op_->rm] * CPU.USER[op_->rs];
+        }
     }
 
-  //if (CPU.USER[15]==0x00000FC4) trace=1;
+  if(op_->cmd & (1 << 20))
+    arm_flags_logic(res,ARM_GET_C());
 
-  /*
-  if (trace) {
-     //if ((CPU.USER[15]>(old_pc+8)) || (CPU.USER[15]<(old_pc-8)) ) {
-     if (CPU.USER[15]!=old_pc) {
-         fprintf(logfile, "PC: 0x%08X \n", CPU.USER[15]);
-         old_pc = CPU.USER[15];
-     }
-  }
-  */
+  CPU.USER[op_->rn] = res;
+}
 
-  cmd = mreadw(CPU.USER[15]);
+static
+void
+arm_op_swap(const arm_op_t *op_)
+{
+  ARM_SWAP(op_->cmd);
+  //if(MAS_Access_Exept)
+  CYCLES -= (2 * NCYCLE + ICYCLE);
+}
 
-  //fprintf(logfile, "(PC: 0x%08X)  cmd: 0x%08X\n", CPU.USER[15], cmd);
+static
+INLINE
+void
+arm_op_alu_exec(const arm_op_t *op_,
+                const uint32_t  op1_,
+                const uint32_t  op2_,
+                const uint32_t  pc_)
+{
+  CPU.USER[15] = pc_;
 
-  CPU.USER[15] += 4;
+  if(ARM_ALU_Exec(op_->cmd,op_->alu,op1_,op2_,&CPU.USER[op_->rd]))
+    return;
 
+  if(op_->rd == 0xF) //destination = pc, take care of cpsr
+    {
+      if(op_->cmd & (1 << 20))
+        arm_spsr_restore();
 
-  CYCLES = -SCYCLE;
-  if((cmd == 0xE5101810) && (CPU.CPSR == 0x80000093))
-    isexeption = TRUE;
+      CYCLES -= (ICYCLE + NCYCLE);
+    }
+}
 
-  if(((cond_flags_cross[cmd >> 28] >> (CPU.CPSR >> 28)) & 1) &&
-     (isexeption == FALSE))
+static
+void
+arm_op_alu_imm(const arm_op_t *op_)
+{
+  uint32_t pc_tmp = CPU.USER[15];
+
+  CPU.USER[15] += 4;
+  arm_op_alu_exec(op_,CPU.USER[op_->rn],op_->imm,pc_tmp);
+}
+
+static
+void
+arm_op_alu_reg(const arm_op_t *op_)
+{
+  uint32_t op1;
+  uint32_t op2;
+  uint32_t pc_tmp = CPU.USER[15];
+
+  CPU.USER[15] += 4;
+  op2 = CPU.USER[op_->rm];
+  op1 = CPU.USER[op_->rn];
+
+  //if((cmd&(1<<20)) && is_logic[((cmd>>21)&0xf)] ) op2=ARM_SHIFT_SC(op2, shift, shtype);
+  //else
+  op2 = ARM_SHIFT_NSC(op2,op_->shift,op_->shtype);
+
+  arm_op_alu_exec(op_,op1,op2,pc_tmp);
+}
+
+static
+void
+arm_op_alu_regshift(const arm_op_t *op_)
+{
+  uint8_t shift;
+  uint32_t op1;
+  uint32_t op2;
+  uint32_t pc_tmp = CPU.USER[15];
+
+  CPU.USER[15] += 4;
+  shift = (CPU.USER[op_->rs] & 0xFF);
+  CPU.USER[15] += 4;
+  op2 = CPU.USER[op_->rm];
+  op1 = CPU.USER[op_->rn];
+  CYCLES -= ICYCLE;
+
+  op2 = ARM_SHIFT_NSC(op2,shift,op_->shtype);
+
+  arm_op_alu_exec(op_,op1,op2,pc_tmp);
+}
+
+/*
+  When none of Rd, Rn and Rm is r15, the PC fiddling above can't be seen,
+  so those get these instead. And the plain ops (no S bit, no shift) get
+  a handler each, skipping ARM_ALU_Exec(). carry_out still gets set the
+  way ARM_SHIFT_NSC() would have, as a later logic op with an immediate
+  picks it up.
+*/
+
+static
+void
+arm_op_alu_imm_nopc(const arm_op_t *op_)
+{
+  ARM_ALU_Exec(op_->cmd,op_->alu,CPU.USER[op_->rn],op_->imm,&CPU.USER[op_->rd]);
+}
+
+static
+void
+arm_op_alu_reg_nopc(const arm_op_t *op_)
+{
+  uint32_t op2;
+
+  op2 = ARM_SHIFT_NSC(CPU.USER[op_->rm],op_->shift,op_->shtype);
+
+  ARM_ALU_Exec(op_->cmd,op_->alu,CPU.USER[op_->rn],op2,&CPU.USER[op_->rd]);
+}
+
+#define ARM_OP_ALU(NAME,EXPR)                           \
+  static void arm_op_##NAME##_imm(const arm_op_t *op_)  \
+  {                                                     \
+    const uint32_t op1 = CPU.USER[op_->rn];             \
+    const uint32_t op2 = op_->imm;                      \
+    CPU.USER[op_->rd] = (EXPR);                         \
+  }                                                     \
+  static void arm_op_##NAME##_reg(const arm_op_t *op_)  \
+  {                                                     \
+    const uint32_t op1 = CPU.USER[op_->rn];             \
+    const uint32_t op2 = CPU.USER[op_->rm];             \
+    carry_out = ARM_GET_C();                            \
+    CPU.USER[op_->rd] = (EXPR);                         \
+  }
+
+/* The same, for MOV / MVN, which have no 1st operand. */
+#define ARM_OP_MOV(NAME,EXPR)                           \
+  static void arm_op_##NAME##_imm(const arm_op_t *op_)  \
+  {                                                     \
+    const uint32_t op2 = op_->imm;                      \
+    CPU.USER[op_->rd] = (EXPR);                         \
+  }                                                     \
+  static void arm_op_##NAME##_reg(const arm_op_t *op_)  \
+  {                                                     \
+    const uint32_t op2 = CPU.USER[op_->rm];             \
+    carry_out = ARM_GET_C();                            \
+    CPU.USER[op_->rd] = (EXPR);                         \
+  }
+
+ARM_OP_ALU(and,op1 & op2)
+ARM_OP_ALU(eor,op1 ^ op2)
+ARM_OP_ALU(sub,op1 - op2)
+ARM_OP_ALU(rsb,op2 - op1)
+ARM_OP_ALU(add,op1 + op2)
+ARM_OP_ALU(adc,op1 + op2 + ARM_GET_C())
+ARM_OP_ALU(sbc,op1 - op2 - (ARM_GET_C() ^ 1))
+ARM_OP_ALU(rsc,op2 - op1 - (ARM_GET_C() ^ 1))
+ARM_OP_ALU(orr,op1 | op2)
+ARM_OP_MOV(mov,op2)
+ARM_OP_ALU(bic,op1 & ~op2)
+ARM_OP_MOV(mvn,~op2)
+
+/* The compares always have the S bit, and never write Rd. */
+#define ARM_OP_CMP(NAME,BODY)                           \
+  static void arm_op_##NAME##_imm(const arm_op_t *op_)  \
+  {                                                     \
+    const uint32_t op1 = CPU.USER[op_->rn];             \
+    const uint32_t op2 = op_->imm;                      \
+    BODY;                                               \
+  }                                                     \
+  static void arm_op_##NAME##_reg(const arm_op_t *op_)  \
+  {                                                     \
+    const uint32_t op1 = CPU.USER[op_->rn];             \
+    const uint32_t op2 = CPU.USER[op_->rm];             \
+    carry_out = ARM_GET_C();                            \
+    BODY;                                               \
+  }
+
+ARM_OP_CMP(tst,arm_flags_logic(op1 & op2,carry_out))
+ARM_OP_CMP(teq,arm_flags_logic(op1 ^ op2,carry_out))
+ARM_OP_CMP(cmp,arm_flags_sub(op1 - op2,op1,op2))
+ARM_OP_CMP(cmn,arm_flags_add(op1 + op2,op1,op2))
+
+/* By (cmd >> 20) & 0x1F. NULL where there's no handler of its own. */
+static const arm_op_handler_t arm_op_alu_imm_table[32] =
+  {
+    arm_op_and_imm, NULL, arm_op_eor_imm, NULL,
+    arm_op_sub_imm, NULL, arm_op_rsb_imm, NULL,
+    arm_op_add_imm, NULL, arm_op_adc_imm, NULL,
+    arm_op_sbc_imm, NULL, arm_op_rsc_imm, NULL,
+    NULL, arm_op_tst_imm, NULL, arm_op_teq_imm,
+    NULL, arm_op_cmp_imm, NULL, arm_op_cmn_imm,
+    arm_op_orr_imm, NULL, arm_op_mov_imm, NULL,
+    arm_op_bic_imm, NULL, arm_op_mvn_imm, NULL
+  };
+
+static const arm_op_handler_t arm_op_alu_reg_table[32] =
+  {
+    arm_op_and_reg, NULL, arm_op_eor_reg, NULL,
+    arm_op_sub_reg, NULL, arm_op_rsb_reg, NULL,
+    arm_op_add_reg, NULL, arm_op_adc_reg, NULL,
+    arm_op_sbc_reg, NULL, arm_op_rsc_reg, NULL,
+    NULL, arm_op_tst_reg, NULL, arm_op_teq_reg,
+    NULL, arm_op_cmp_reg, NULL, arm_op_cmn_reg,
+    arm_op_orr_reg, NULL, arm_op_mov_reg, NULL,
+    arm_op_bic_reg, NULL, arm_op_mvn_reg, NULL
+  };
+
+/* Undefined instructions, and the coprocessor ones too. (No coprocessors.) */
+static
+void
+arm_op_und(const arm_op_t *op_)
+{
+  arm_flags_sync();
+  CPU.SPSR[arm_mode_table[0x1b]] = CPU.CPSR;
+  SETI(1);
+  SETM(0x1b);
+  CPU.USER[14] = CPU.USER[15];
+  CPU.USER[15] = 0x00000004;
+  CYCLES -= (SCYCLE + NCYCLE); // +2S+1N
+}
+
+static
+INLINE
+void
+arm_op_sdt_exec(const arm_op_t *op_,
+                const uint32_t  oper2_,
+                const uint32_t  pc_)
+{
+  uint32_t cmd = op_->cmd;
+  uint32_t base;
+  uint32_t tbas;
+  uint32_t val;
+
+  tbas = base = CPU.USER[op_->rn];
+
+  if(cmd & (1 << 24))
+    tbas = base = (base + oper2_);
+  else
+    base = (base + oper2_);
+
+  if(cmd & (1 << 20)) //load
     {
-      switch((cmd >> 24) & 0xF)
+      if(cmd & (1 << 22)) //bytes
         {
-        case 0x0:               //Multiply
-          if((cmd & ARM_MUL_MASK) == ARM_MUL_SIGN)
-            {
-              uint32_t res = ((calcbits(CPU.USER[(cmd>>8)&0xf])+5)>>1)-1;
-              if(res > 16)
-                CYCLES -= 16;
-              else
-                CYCLES -= res;
+          val = mreadb(tbas);
+        }
+      else //words/halfwords
+        {
+          uint32_t rora;
+
+          rora = tbas & 3;
+          val = mreadw(tbas);
+
+          if(rora)
+            val = ROTR(val,rora*8);
+        }
+
+      if(op_->rd == 0xF)
+        CYCLES -= (SCYCLE + NCYCLE);   // +1S+1N ifR15 load
+
+      CYCLES -= (NCYCLE + ICYCLE);  // +1N+1I
+      CPU.USER[15] = pc_;
+
+      if((cmd & (1 << 21)) || (!(cmd & (1 << 24))))
+        CPU.USER[op_->rn] = base;
+
+      if((cmd & (1 << 21)) && !(cmd & (1 << 24)))
+        loadusr(op_->rd,val);
+      else
+        CPU.USER[op_->rd] = val;
+    }
+  else // store
+    {
+      if((cmd & (1 << 21)) && !(cmd & (1 << 24)))
+        val = readusr(op_->rd);
+      else
+        val = CPU.USER[op_->rd];
+
+      CPU.USER[15] = pc_;
+      CYCLES -= (-SCYCLE + 2 * NCYCLE);  // 2N
+
+      if(cmd & (1 << 22)) //bytes/words
+        mwriteb(tbas,val);
+      else //words/halfwords
+        mwritew(tbas,val);
+
+      if((cmd & (1 << 21)) || !(cmd & (1 << 24)))
+        CPU.USER[op_->rn] = base;
+    }
+}
+
+static
+void
+arm_op_sdt_imm(const arm_op_t *op_)
+{
+  uint32_t pc_tmp = CPU.USER[15];
+
+  CPU.USER[15] += 4;
+  arm_op_sdt_exec(op_,op_->imm,pc_tmp);
+}
+
+static
+void
+arm_op_sdt_reg(const arm_op_t *op_)
+{
+  uint32_t oper2;
+  uint32_t pc_tmp = CPU.USER[15];
+
+  CPU.USER[15] += 4;
+  oper2 = ARM_SHIFT_NSC(CPU.USER[op_->rm],op_->shift,op_->shtype);
+
+  if(!(op_->cmd & (1 << 23)))
+    oper2 = (0 - oper2);
+
+  arm_op_sdt_exec(op_,oper2,pc_tmp);
+}
+
+static
+void
+arm_op_sdt_regshift(const arm_op_t *op_)
+{
+  uint8_t shift;
+  uint32_t oper2;
+  uint32_t pc_tmp = CPU.USER[15];
+
+  CPU.USER[15] += 4;
+  shift = (CPU.USER[op_->rs] & 0xFF);
+  CPU.USER[15] += 4;
+  oper2 = ARM_SHIFT_NSC(CPU.USER[op_->rm],shift,op_->shtype);
+
+  if(!(op_->cmd & (1 << 23)))
+    oper2 = (0 - oper2);
+
+  arm_op_sdt_exec(op_,oper2,pc_tmp);
+}
+
+/* LDR r1,[r0,#-0x810] isn't executed at all in SVC mode with just N set. */
+static
+void
+arm_op_sdt_e5101810(const arm_op_t *op_)
+{
+  arm_flags_sync();
+  if(CPU.CPSR == 0x80000093)
+    return;
+
+  arm_op_sdt_imm(op_);
+}
+
+static
+void
+arm_op_bdt(const arm_op_t *op_)
+{
+  bdt_core(op_->cmd);
+}
+
+static
+void
+arm_op_b(const arm_op_t *op_)
+{
+  CPU.USER[15] += op_->imm;
+
+  CYCLES -= (SCYCLE + NCYCLE); //2S+1N
+}
+
+static
+void
+arm_op_bl(const arm_op_t *op_)
+{
+  CPU.USER[14] = CPU.USER[15];
+  CPU.USER[15] += op_->imm;
+
+  CYCLES -= (SCYCLE + NCYCLE); //2S+1N
+}
+
+static
+void
+arm_op_swi(const arm_op_t *op_)
+{
+  decode_swi(op_->cmd);
+}
+
+/* ADC, SBC and RSC. (Without the S bit, as they come out of the fast tables.) */
+static
+INLINE
+int
+arm_alu_uses_c(const uint8_t alu_)
+{
+  return ((alu_ == 0x0A) || (alu_ == 0x0C) || (alu_ == 0x0E));
+}
+
+/* LSL #0 is no shift, but LSR / ASR #0 mean #32, and ROR #0 is RRX. */
+static
+INLINE
+void
+arm_decode_shift(arm_op_t *op_)
+{
+  op_->shtype = ((op_->cmd >> 5) & 0x3);
+  op_->shift  = ((op_->cmd >> 7) & 0x1F);
+
+  if(!op_->shift)
+    {
+      if(op_->shtype)
+        {
+          if(op_->shtype == 3)
+            op_->shtype++;
+          else
+            op_->shift = 32;
+        }
+    }
+}
 
-              if(((cmd >> 16) & 0xF) == (cmd & 0xF))
+/* Same tests, in the same order (fall-throughs and all), as the switch this replaced. */
+static
+void
+arm_decode(const uint32_t  cmd_,
+           arm_op_t       *op_)
+{
+  op_->cmd    = cmd_;
+  op_->cond   = cond_flags_cross[cmd_ >> 28];
+  op_->rn     = ((cmd_ >> 16) & 0xF);
+  op_->rd     = ((cmd_ >> 12) & 0xF);
+  op_->rs     = ((cmd_ >>  8) & 0xF);
+  op_->rm     = (cmd_ & 0xF);
+  op_->alu    = ((cmd_ >> 20) & 0x1F);
+  op_->shtype = ((cmd_ >> 5) & 0x3);
+  op_->shift  = 0;
+  op_->imm    = 0;
+  op_->kind   = ARM_OP_KIND_CALL;
+
+  switch((cmd_ >> 24) & 0xF)
+    {
+    case 0x0:               //Multiply
+      if((cmd_ & ARM_MUL_MASK) == ARM_MUL_SIGN)
+        {
+          op_->handler = arm_op_mul;
+          return;
+        }
+    case 0x1:               //Single Data Swap
+      if((cmd_ & ARM_SDS_MASK) == ARM_SDS_SIGN)
+        {
+          op_->handler = arm_op_swap;
+          return;
+        }
+    case 0x2:               //ALU
+    case 0x3:
+      if((cmd_ & 0x2000090) != 0x90)
+        {
+          if(cmd_ & (1 << 25))
+            {
+              op_->imm     = ROTR(cmd_ & 0xFF,((cmd_ >> 7) & 0x1E));
+              op_->handler = arm_op_alu_imm;
+              if((op_->rd != 0xF) && (op_->rn != 0xF))
                 {
-                  if(cmd & (1 << 21))
-                    {
-                      CPU.USER[15] += 8;
-                      res=CPU.USER[(cmd >> 12) & 0xF];
-                      CPU.USER[15] -= 8;
-                    }
-                  else
-                    {
-                      res = 0;
-                    }
+                  op_->handler = arm_op_alu_imm_table[op_->alu];
+                  if(op_->handler == NULL)
+                    op_->handler = arm_op_alu_imm_nopc;
+                  else if(!arm_alu_uses_c(op_->alu))
+                    op_->kind = ARM_OP_KIND_ALU_IMM;
                 }
-              else
+            }
+          else if(cmd_ & (1 << 4))
+            {
+              op_->handler = arm_op_alu_regshift;
+            }
+          else
+            {
+              arm_decode_shift(op_);
+              op_->handler = arm_op_alu_reg;
+              if((op_->rd != 0xF) && (op_->rn != 0xF) && (op_->rm != 0xF))
                 {
-                  if(cmd & (1 << 21))
-                    {
-                      res = CPU.USER[cmd & 0xF] * CPU.USER[(cmd >> 8) & 0xF];
-                      CPU.USER[15] += 8;
-                      res += CPU.USER[(cmd >> 12) & 0xF];
-                      CPU.USER[15] -= 8;
-                    }
-                  else
-                    {
-                      res = CPU.USER[cmd & 0xF] * CPU.USER[(cmd >> 8) & 0xF];
-                    }
+                  op_->handler = NULL;
+                  if(!op_->shift && !op_->shtype)
+                    op_->handler = arm_op_alu_reg_table[op_->alu];
+                  if(op_->handler == NULL)
+                    op_->handler = arm_op_alu_reg_nopc;
+                  else if(!arm_alu_uses_c(op_->alu))
+                    op_->kind = ARM_OP_KIND_ALU_REG;
                 }
+            }
 
-              if(cmd & (1 << 20))
-                ARM_SET_ZN(res);
+          /* Writes to r15 with S set, and MSR, can change CPSR. */
+          if((op_->rd == 0xF) || (op_->alu == 0x12) || (op_->alu == 0x16))
+            op_->kind = ARM_OP_KIND_END;
+          return;
+        }
+    case 0x6:               //Undefined
+    case 0x7:
+      if((cmd_ & ARM_UND_MASK) == ARM_UND_SIGN)
+        {
+          op_->handler = arm_op_und;
+          op_->kind    = ARM_OP_KIND_END;
+          return;
+        }
+    case 0x4:               //Single Data Transfer
+    case 0x5:
+      if((cmd_ & 0x2000090) == 0x2000090)
+        {
+          /* Was a goto back to the undefined case. (Which always catches these.) */
+          op_->handler = arm_op_und;
+          op_->kind    = ARM_OP_KIND_END;
+          return;
+        }
 
-              CPU.USER[(cmd >> 16) & 0xF] = res;
-              break;
-            }
-        case 0x1:               //Single Data Swap
-          if((cmd & ARM_SDS_MASK) == ARM_SDS_SIGN)
+      if(cmd_ & (1 << 25))
+        {
+          if(cmd_ & (1 << 4))
             {
-              ARM_SWAP(cmd);
-              //if(MAS_Access_Exept)
-              CYCLES -= (2 * NCYCLE + ICYCLE);
-              break;
+              op_->handler = arm_op_sdt_regshift;
             }
-        case 0x2:               //ALU
-        case 0x3:
-          {
-            if((cmd & 0x2000090) != 0x90)
-              {
-                /* SHIFT */
-                pc_tmp = CPU.USER[15];
-                CPU.USER[15] += 4;
-                if(cmd & (1 << 25))
-                  {
-                    op2 = cmd & 0xFF;
-                    if(((cmd >> 7) & 0x1E))
-                      {
-                        op2 = ROTR(op2,((cmd >> 7) & 0x1E));
-                        //if((cmd&(1<<20))) SETC(((cmd&0xff)>>(((cmd>>7)&0x1e)-1))&1);
-                      }
-                    op1 = CPU.USER[(cmd >> 16) & 0xF];
-                  }
-                else
-                  {
-                    shtype = ((cmd >> 5) & 0x3);
-                    if(cmd & (1 << 4))
-                      {
-                        shift = ((cmd >> 8) & 0xF);
-                        shift = (CPU.USER[shift] & 0xFF);
-                        CPU.USER[15] += 4;
-                        op2 = CPU.USER[cmd & 0xF];
-                        op1 = CPU.USER[(cmd >> 16) & 0xF];
-                        CYCLES -= ICYCLE;
-                      }
-                    else
-                      {
-                        shift = ((cmd >> 7) & 0x1F);
-
-                        if(!shift)
-                          {
-                            if(shtype)
-                              {
-                                if(shtype == 3)
-                                  shtype++;
-                                else
-                                  shift=32;
-                              }
-                          }
-
-                        op2 = CPU.USER[cmd & 0xF];
-                        op1 = CPU.USER[(cmd >> 16) & 0xF];
-                      }
-
-                    //if((cmd&(1<<20)) && is_logic[((cmd>>21)&0xf)] ) op2=ARM_SHIFT_SC(op2, shift, shtype);
-                    //else
-                    op2 = ARM_SHIFT_NSC(op2,shift,shtype);
-                  }
-
-                CPU.USER[15] = pc_tmp;
-
-                if((cmd & (1 << 20)) && is_logic[((cmd >> 21) & 0xF)])
-                  ARM_SET_C(carry_out);
-
-                if(ARM_ALU_Exec(cmd,((cmd >> 20) & 0x1F),op1,op2,&CPU.USER[(cmd >> 12) & 0xF]))
-                  break;
-
-                if(((cmd >> 12) & 0xF) == 0xF) //destination = pc, take care of cpsr
-                  {
-                    if(cmd & (1 << 20))
-                      arm_cpsr_set(CPU.SPSR[arm_mode_table[MODE]]);
-
-                    CYCLES -= (ICYCLE + NCYCLE);
-                  }
-                break;
-              }
-          }
-        case 0x6:               //Undefined
-        case 0x7:
-        Undefine:
-          if((cmd & ARM_UND_MASK) == ARM_UND_SIGN)
+          else
             {
-              CPU.SPSR[arm_mode_table[0x1b]] = CPU.CPSR;
-              SETI(1);
-              SETM(0x1b);
-              CPU.USER[14] = CPU.USER[15];
-              CPU.USER[15] = 0x00000004;
-              CYCLES -= (SCYCLE + NCYCLE); // +2S+1N
-              break;
+              arm_decode_shift(op_);
+              op_->handler = arm_op_sdt_reg;
             }
-        case 0x4:               //Single Data Transfer
-        case 0x5:
-          if((cmd & 0x2000090) != 0x2000090)
-            {
-              uint32_t base;
-              uint32_t tbas;
-              uint32_t oper2;
-              uint32_t val;
-              uint32_t rora;
-
-              pc_tmp = CPU.USER[15];
-              CPU.USER[15] += 4;
-              if(cmd & (1 << 25))
-                {
-                  shtype = ((cmd >> 5) & 0x3);
-                  if(cmd & (1 << 4))
-                    {
-                      shift = ((cmd >> 8) & 0xF);
-                      shift = (CPU.USER[shift] & 0xFF);
-                      CPU.USER[15] += 4;
-                    }
-                  else
-                    {
-                      shift = ((cmd >> 7) & 0x1F);
-                      if(!shift)
-                        {
-                          if(shtype)
-                            {
-                              if(shtype == 3)
-                                shtype++;
-                              else
-                                shift = 32;
-                            }
-                        }
-                    }
+        }
+      else
+        {
+          op_->imm = (cmd_ & 0x0FFF);
+          if(!(cmd_ & (1 << 23)))
+            op_->imm = (0 - op_->imm);
 
-                  oper2 = ARM_SHIFT_NSC(CPU.USER[cmd & 0xF],shift,shtype);
-                }
-              else
-                {
-                  oper2 = (cmd & 0x0FFF);
-                }
+          op_->handler = ((cmd_ == 0xE5101810) ? arm_op_sdt_e5101810 : arm_op_sdt_imm);
+        }
+      return;
+
+    case 0x8:               //Block Data Transfer
+    case 0x9:
+      op_->handler = arm_op_bdt;
+      if(cmd_ & (1 << 22))
+        op_->kind = ARM_OP_KIND_END;
+      return;
+
+    case 0xa:               //BRANCH
+    case 0xb:
+      op_->imm     = ((((cmd_ & 0x00FFFFFF) | ((cmd_ & 0x00800000) ? 0xFF000000 : 0)) << 2) + 4);
+      op_->handler = ((cmd_ & (1 << 24)) ? arm_op_bl : arm_op_b);
+      op_->kind    = ((cmd_ & (1 << 24)) ? ARM_OP_KIND_BL : ARM_OP_KIND_B);
+      return;
+
+    case 0xf:               //SWI
+      op_->handler = arm_op_swi;
+      op_->kind    = ARM_OP_KIND_END;
+      return;
+
+    default:                //coprocessor
+      op_->handler = arm_op_und;
+      op_->kind    = ARM_OP_KIND_END;
+      return;
+    }
+}
+
+/* The cached op for addr_ (word aligned), decoded again if it's stale. NULL if it can't be cached. */
+static
+INLINE
+arm_op_t*
+arm_icache_get(const uint32_t addr_)
+{
+  uint32_t page;
+  arm_op_t *op;
+  arm_icache_page_t *p;
+
+  page = arm_icache_page(addr_);
+  if(page == ICACHE_PAGES)
+    return NULL;
+
+  p = g_ICACHE[page];
+  if(p == NULL)
+    {
+      p = calloc(1,sizeof(arm_icache_page_t));
+      if(p == NULL)
+        return NULL;
+
+      p->gen = 1;
+      g_ICACHE[page] = p;
+    }
+
+  op = &p->ops[(addr_ >> 2) & (ICACHE_PAGE_OPS - 1)];
+  if(op->gen != p->gen)
+    {
+      arm_decode(mreadw(addr_),op);
+      op->gen = p->gen;
+      if(page < ICACHE_DRAM_PAGES)
+        opera_arm_icache_live[page] = 1;
+    }
+
+  return op;
+}
+
+/* The op for the instruction at CPU.USER[15]. tmp_ gets used when it can't be cached. */
+static
+INLINE
+const arm_op_t*
+arm_icache_fetch(arm_op_t *tmp_)
+{
+  const arm_op_t *op;
+
+  /* opera_trace wants every fetch to go through mreadw(). */
+  op = NULL;
+  if(!opera_trace)
+    op = arm_icache_get(CPU.USER[15] & ~3);
+
+  if(op == NULL)
+    {
+      arm_decode(mreadw(CPU.USER[15]),tmp_);
+      return tmp_;
+    }
+
+  return op;
+}
+
+const arm_op_t*
+arm_icache_op(const uint32_t addr_)
+{
+  return arm_icache_get(addr_ & ~3);
+}
+
+int32_t*
+arm_cycles_ptr(void)
+{
+  return &CYCLES;
+}
+
+uint32_t*
+arm_carry_out_ptr(void)
+{
+  return &carry_out;
+}
+
+/* Taken after every instruction, if it's wanted and not masked. */
+static
+INLINE
+void
+arm_fiq_check(void)
+{
+  if(!ISF && opera_clio_fiq_needed()/*CPU.nFIQ*/)
+    {
+      if(opera_log_on(OPERA_LOG_MISC))
+        fprintf(opera_logfile, "FIQ triggered!  (PC: 0x%08X)\n", CPU.USER[15]);
+      //Set_madam_FSM(FSM_SUSPENDED);
+      CPU.nFIQ = FALSE;
+      arm_flags_sync();
+      CPU.SPSR[arm_mode_table[0x11]] = CPU.CPSR;
+      SETF(1);
+      SETI(1);
+      SETM(0x11);
+      CPU.USER[14] = (CPU.USER[15] + 4);  // Save return address?
+      CPU.USER[15] = 0x0000001C;          // Set PC to FIQ vector.
+    }
+}
+
+int32_t
+opera_arm_execute(void)
+{
+  arm_op_t tmp;
+  const arm_op_t *op;
+  uint32_t pc;
+
+  /*
+  if ( (CPU.CPSR&0x1F) != old_mode) {
+     uint16_t cpu_mode = arm_mode_table[(CPU.CPSR & 0x1F) | 0x10];
+     char mode_string[4];
+     switch (cpu_mode) {
+     case ARM_MODE_USER: strcpy(mode_string, "USR"); break;
+     case ARM_MODE_FIQ:  strcpy(mode_string, "FIQ"); break;
+     case ARM_MODE_IRQ:  strcpy(mode_string, "IRQ"); break;
+     case ARM_MODE_ABT:  strcpy(mode_string, "ABT"); break;
+     case ARM_MODE_UND:  strcpy(mode_string, "UND"); break;
+     case ARM_MODE_SVC:  strcpy(mode_string, "SVC"); break;
+     default: strcpy(mode_string, "UNK"); break;
+     }
+     fprintf(opera_logfile, "ARM Mode Change!  Mode: %s  (PC: 0x%08X)\n", mode_string, CPU.USER[15]);
+     old_mode = (CPU.CPSR & 0x1F);
+  }
+  */
+
+  if((CPU.USER[15] == 0x94D60) &&
+     (CPU.USER[0] == 0x113000) &&
+     (CPU.USER[1] == 0x113000) &&
+     (CNBFIX == 0)             &&
+     (FIXMODE & FIX_BIT_TIMING_1))
+    {
+      CPU.USER[15] = 0x9E9CC;
+      CNBFIX = 1;
+    }
+
+  //if (CPU.USER[15]==0x00000FC4) opera_trace=1;
+
+  /*
+  if (opera_trace) {
+     //if ((CPU.USER[15]>(old_pc+8)) || (CPU.USER[15]<(old_pc-8)) ) {
+     if (CPU.USER[15]!=old_pc) {
+         fprintf(opera_logfile, "PC: 0x%08X \n", CPU.USER[15]);
+         old_pc = CPU.USER[15];
+     }
+  }
+  */
 
-              tbas = base = CPU.USER[((cmd >> 16) & 0xF)];
+  op = arm_icache_fetch(&tmp);
 
-              if(!(cmd & (1 << 23)))
-                oper2 = (0 - oper2);
+  //fprintf(opera_logfile, "(PC: 0x%08X)  cmd: 0x%08X\n", CPU.USER[15], op->cmd);
 
-              if(cmd & (1 << 24))
-                tbas = base = (base + oper2);
-              else
-                base = (base + oper2);
+  pc = CPU.USER[15];
+  CPU.USER[15] += 4;
 
-              if(cmd & (1 << 20)) //load
-                {
-                  if(cmd & (1 << 22)) //bytes
-                    {
-                      val = mreadb(tbas);
-                    }
-                  else //words/halfwords
-                    {
-                      uint32_t rora;
+  CYCLES = -SCYCLE;
+  if(op->cond != 0xFFFF)
+    arm_flags_sync();
+  if((op->cond >> (CPU.CPSR >> 28)) & 1)
+    op->handler(op);
 
-                      rora = tbas & 3;
-                      val = mreadw(tbas);
+  arm_fiq_check();
 
-                      if(rora)
-                        val = ROTR(val,rora*8);
-                    }
+  if(g_IDLE.on)
+    arm_idle_step(pc,-CYCLES);
 
-                  if(((cmd >> 12) & 0xF) == 0xF)
-                    CYCLES -= (SCYCLE + NCYCLE);   // +1S+1N ifR15 load
+  return -CYCLES;
+}
 
-                  CYCLES -= (NCYCLE + ICYCLE);  // +1N+1I
-                  CPU.USER[15] = pc_tmp;
+/*
+  Same as calling opera_arm_execute() until the cycles add up to budget_,
+  only through translated blocks (opera_arm_jit.c). Stops early on I/O,
+  so the caller gets to see to MADAM before the next instruction, the
+  same as it would have with opera_arm_execute(). And at the top of an
+  idle loop, so it gets the chance to skip it.
+
+  FIQs can only turn up through I/O, or in between calls, so checking
+  after each block is the same as checking after each instruction. One
+  that came in since the last call gets one instruction first, as usual.
+  The CNBFIX PC, trace mode, idle loops (which the interpreter has to
+  watch), and whatever can't be translated go through opera_arm_execute().
+*/
+int32_t
+opera_arm_execute_jit(const int32_t budget_)
+{
+  int32_t n;
+  int32_t cycles;
 
-                  if((cmd & (1 << 21)) || (!(cmd & (1 << 24))))
-                    CPU.USER[(cmd >> 16) & 0xF] = base;
+  if(!g_JIT || (!ISF && opera_clio_fiq_needed()))
+    return opera_arm_execute();
 
-                  if((cmd & (1 << 21)) && !(cmd & (1 << 24)))
-                    loadusr((cmd >> 12) & 0xF,val);
-                  else
-                    CPU.USER[(cmd >> 12) & 0xF] = val;
-                }
-              else // store
-                {
-                  if((cmd & (1 << 21)) && !(cmd & (1 << 24)))
-                    val = readusr((cmd >> 12) & 0xF);
-                  else
-                    val = CPU.USER[(cmd >> 12) & 0xF];
+  cycles = 0;
+  arm_jit_stop = 0;
+  do
+    {
+      n = -1;
+      if((CPU.USER[15] != 0x94D60) && !opera_trace && !arm_idle_watching(CPU.USER[15]))
+        {
+          arm_flags_sync();     /* translated code works on CPSR directly */
+          n = arm_jit_run(CPU.USER[15],g_JIT_BREAK,budget_ - cycles);
+        }
 
-                  CPU.USER[15] = pc_tmp;
-                  CYCLES -= (-SCYCLE + 2 * NCYCLE);  // 2N
+      if(n < 0)
+        {
+          cycles += opera_arm_execute();
+        }
+      else
+        {
+          cycles += n;
+          arm_fiq_check();
+        }
+    }
+  while((cycles < budget_) && !arm_jit_stop && (CPU.USER[15] != g_JIT_BREAK) && !g_IDLE.idle);
 
-                  if(cmd & (1 << 22)) //bytes/words
-                    mwriteb(tbas,val);
-                  else //words/halfwords
-                    mwritew(tbas,val);
+  return cycles;
+}
 
-                  if((cmd & (1 << 21)) || !(cmd & (1 << 24)))
-                    CPU.USER[(cmd >> 16) & 0xF] = base;
-                }
+int
+opera_arm_jit_set(const int on_)
+{
+  if(on_ && !g_JIT)
+    g_JIT = arm_jit_init();
+  else if(!on_)
+    g_JIT = 0;
 
-              //if(MAS_Access_Exept)
-              break;
-            }
-          else
-            {
-              goto Undefine;
-            }
+  return g_JIT;
+}
 
-        case 0x8:               //Block Data Transfer
-        case 0x9:
-          bdt_core(cmd);
-          /*if(MAS_Access_Exept)
-            {
-            //sprintf(str,"*PC: 0x%8.8X DataAbort!!!\n",CPU.USER[15]);
-            //CDebug::DPrint(str);
-            //!!Exeption!!
-
-            CPU.SPSR[arm_mode_table[0x17]]=CPU.CPSR;
-            SETI(1);
-            SETM(0x17);
-            CPU.USER[14] = (CPU.USER[15] + 4);
-            CPU.USER[15] = 0x00000010;
-            CYCLES-=SCYCLE+NCYCLE;
-            MAS_Access_Exept=FALSE;
-            break;
-            } */
-          break;
-
-        case 0xa:               //BRANCH
-        case 0xb:
-          if(cmd & (1 << 24))
-            CPU.USER[14] = CPU.USER[15];
-          CPU.USER[15] += ((((cmd & 0x00FFFFFF) | ((cmd & 0x00800000) ? 0xFF000000 : 0)) << 2) + 4);
-
-          CYCLES -= (SCYCLE + NCYCLE); //2S+1N
-          break;
-
-        case 0xf:               //SWI
-          decode_swi(cmd);
-          break;
-
-        default:                //coprocessor
-          CPU.SPSR[arm_mode_table[0x1b]] = CPU.CPSR;
-          SETI(1);
-          SETM(0x1b);
-          CPU.USER[14] = CPU.USER[15];
-          CPU.USER[15] = 0x00000004;
-          CYCLES -= (SCYCLE + NCYCLE);
-          break;
-        }
-    }
+int
+opera_arm_jit_get(void)
+{
+  return g_JIT;
+}
 
-  if(!ISF && opera_clio_fiq_needed()/*CPU.nFIQ*/)
-    {
-      fprintf(logfile, "FIQ triggered!  (PC: 0x%08X)\n", CPU.USER[15]);
-      //Set_madam_FSM(FSM_SUSPENDED);
-      CPU.nFIQ = FALSE;
-      CPU.SPSR[arm_mode_table[0x11]] = CPU.CPSR;
-      SETF(1);
-      SETI(1);
-      SETM(0x11);
-      CPU.USER[14] = (CPU.USER[15] + 4);  // Save return address?
-      CPU.USER[15] = 0x0000001C;          // Set PC to FIQ vector.
-    }
+void
+opera_arm_jit_break(const uint32_t pc_)
+{
+  if(pc_ == g_JIT_BREAK)
+    return;
 
-  return -CYCLES;
+  g_JIT_BREAK = pc_;
+  arm_jit_flush();
 }
 
 void
 opera_mem_write8(uint32_t addr_,
                  uint8_t  val_)
 {
+  opera_arm_icache_write(addr_);
   CPU.ram[addr_] = val_;
   if(!HIRESMODE || (addr_ < 0x200000))
     return;
@@ -1956,6 +3183,7 @@ void
 opera_mem_write16(uint32_t addr_,
                   uint16_t val_)
 {
+  opera_arm_icache_write(addr_);
   *((uint16_t*)&CPU.ram[addr_]) = val_;
   if(!HIRESMODE || (addr_ < 0x200000))
     return;
@@ -1968,6 +3196,7 @@ void
 opera_mem_write32(uint32_t addr_,
                   uint32_t val_)
 {
+  opera_arm_icache_write(addr_);
   *((uint32_t*)&CPU.ram[addr_]) = val_;
   if(!HIRESMODE || (addr_ < 0x200000))
     return;
@@ -1996,447 +3225,611 @@ opera_mem_read8(uint32_t addr_)
 
 void print_to_log(uint32_t addr_, uint32_t val_, uint8_t write, uint32_t cur_pc) {
 
-		if (addr_>=0x03100000 && addr_<=0x0313FFFF) fprintf(logfile, "Brooktree       ");
-   else if (addr_>=0x03140000 && addr_<=0x0315FFFF) fprintf(logfile, "NVRAM           ");
-   else if (addr_==0x03180000) fprintf(logfile, "DiagPort        ");
-   else if (addr_>=0x03180004 && addr_<=0x031BFFFF) fprintf(logfile, "Slow Bus        ");
+		if (addr_>=0x03100000 && addr_<=0x0313FFFF) fprintf(opera_logfile, "Brooktree       ");
+   else if (addr_>=0x03140000 && addr_<=0x0315FFFF) fprintf(opera_logfile, "NVRAM           ");
+   else if (addr_==0x03180000) fprintf(opera_logfile, "DiagPort        ");
+   else if (addr_>=0x03180004 && addr_<=0x031BFFFF) fprintf(opera_logfile, "Slow Bus        ");
 
-   else if (addr_>=0x03200000 && addr_<=0x03200FFF && write==0) fprintf(logfile, "VRAM SVF Source ");
-   else if (addr_>=0x03200000 && addr_<=0x03200FFF && write==1) fprintf(logfile, "VRAM SVF Copy   ");
-   else if (addr_>=0x03202000 && addr_<=0x03202FFF) fprintf(logfile, "VRAM SVF Color  ");
-   else if (addr_>=0x03204000 && addr_<=0x03204FFF) fprintf(logfile, "VRAM SVF Flash  ");
-   else if (addr_>=0x03206000 && addr_<=0x03206FFF) fprintf(logfile, "VRAM SVF Refresh");
-   else if (addr_>=0x032F0000 && addr_<=0x032FFFFF) fprintf(logfile, "Unknown         ");
+   else if (addr_>=0x03200000 && addr_<=0x03200FFF && write==0) fprintf(opera_logfile, "VRAM SVF Source ");
+   else if (addr_>=0x03200000 && addr_<=0x03200FFF && write==1) fprintf(opera_logfile, "VRAM SVF Copy   ");
+   else if (addr_>=0x03202000 && addr_<=0x03202FFF) fprintf(opera_logfile, "VRAM SVF Color  ");
+   else if (addr_>=0x03204000 && addr_<=0x03204FFF) fprintf(opera_logfile, "VRAM SVF Flash  ");
+   else if (addr_>=0x03206000 && addr_<=0x03206FFF) fprintf(opera_logfile, "VRAM SVF Refresh");
+   else if (addr_>=0x032F0000 && addr_<=0x032FFFFF) fprintf(opera_logfile, "Unknown         ");
 
    // MADAM...
    if (addr_>=0x03300000 && addr_<=0x033FFFFF) {
       switch (addr_) {
-         case 0x03300000: { if (write) fprintf(logfile, "MADAM Print     ");
-                                  else fprintf(logfile, "MADAM Revision  "); break; }
-         case 0x03300004: { fprintf(logfile, "MADAM msysbits  "); break; }
-         case 0x03300008: { fprintf(logfile, "MADAM mctl      "); break; }
-         case 0x0330000C: { fprintf(logfile, "MADAM sltime    "); break; }
-         case 0x03300010: { fprintf(logfile, "MADAM MultiChip "); break; } // todo: 0x10 - 0x1f ?
-         case 0x03300020: { fprintf(logfile, "MADAM Abortbits "); break; }
-		 case 0x03300218: { fprintf(logfile, "MADAM Fence ?   "); break; }
-		 case 0x0330021c: { fprintf(logfile, "MADAM Fence ?   "); break; }
-		 case 0x03300238: { fprintf(logfile, "MADAM Fence ?   "); break; }
-		 case 0x0330023c: { fprintf(logfile, "MADAM Fence ?   "); break; }
-         case 0x03300570: { fprintf(logfile, "MADAM PBUS dst  "); break; }
-         case 0x03300574: { fprintf(logfile, "MADAM PBUS len  "); break; }
-         case 0x03300578: { fprintf(logfile, "MADAM PBUS src  "); break; }
-         case 0x03300580: { fprintf(logfile, "MADAM vdl_addr! "); break; }
-         default: { fprintf(logfile, "MADAM UNKNOWN   "); break; }
+         case 0x03300000: {
+            if (write) fprintf(opera_logfile, "MADAM Print     ");
+            else fprintf(opera_logfile, "MADAM Revision  ");
+            break;
+         }
+         case 0x03300004: { fprintf(opera_logfile, "MADAM msysbits  "); break; }
+         case 0x03300008: { fprintf(opera_logfile, "MADAM mctl      "); break; }
+         case 0x0330000C: { fprintf(opera_logfile, "MADAM sltime    "); break; }
+         case 0x03300010: { fprintf(opera_logfile, "MADAM MultiChip "); break; } // todo: 0x10 - 0x1f ?
+         case 0x03300020: { fprintf(opera_logfile, "MADAM Abortbits "); break; }
+		 case 0x03300218: { fprintf(opera_logfile, "MADAM Fence ?   "); break; }
+		 case 0x0330021c: { fprintf(opera_logfile, "MADAM Fence ?   "); break; }
+		 case 0x03300238: { fprintf(opera_logfile, "MADAM Fence ?   "); break; }
+		 case 0x0330023c: { fprintf(opera_logfile, "MADAM Fence ?   "); break; }
+         case 0x03300570: { fprintf(opera_logfile, "MADAM PBUS dst  "); break; }
+         case 0x03300574: { fprintf(opera_logfile, "MADAM PBUS len  "); break; }
+         case 0x03300578: { fprintf(opera_logfile, "MADAM PBUS src  "); break; }
+         case 0x03300580: { fprintf(opera_logfile, "MADAM vdl_addr! "); break; }
+         default: { fprintf(opera_logfile, "MADAM UNKNOWN   "); break; }
       }
    }
 
    // CLIO...
    if (addr_ >= 0x03400000 && addr_ <= 0x034FFFFF) {
       if (addr_== 0x03400034)  ; // Disable vcnt printfs
-      else if (addr_ >= 0x034005c0 && addr_ <= 0x034005ff) fprintf(logfile, "CLIO DataFIFO   ");
-      else if (addr_ >= 0x03401800 && addr_ <= 0x03401fff) fprintf(logfile, "CLIO DSPP  N 32 ");
-      else if (addr_ >= 0x03402000 && addr_ <= 0x03402fff) fprintf(logfile, "CLIO DSPP  N 16 ");
-      else if (addr_ >= 0x03403000 && addr_ <= 0x034031ff) fprintf(logfile, "CLIO DSPP EI 32 ");
-      else if (addr_ >= 0x03403400 && addr_ <= 0x034037ff) fprintf(logfile, "CLIO DSPP EI 16 ");
-      else if (addr_ >= 0x0340C000 && addr_ <= 0x0340C000) fprintf(logfile, "CLIO unc_rev    ");
-      else if (addr_ >= 0x0340C000 && addr_ <= 0x0340C004) fprintf(logfile, "CLIO unc_soft_rv");
-      else if (addr_ >= 0x0340C000 && addr_ <= 0x0340C008) fprintf(logfile, "CLIO unc_addr   ");
-      else if (addr_ >= 0x0340C000 && addr_ <= 0x0340C00C) fprintf(logfile, "CLIO unc_rom    ");
+      else if (addr_ >= 0x034005c0 && addr_ <= 0x034005ff) fprintf(opera_logfile, "CLIO DataFIFO   ");
+      else if (addr_ >= 0x03401800 && addr_ <= 0x03401fff) fprintf(opera_logfile, "CLIO DSPP  N 32 ");
+      else if (addr_ >= 0x03402000 && addr_ <= 0x03402fff) fprintf(opera_logfile, "CLIO DSPP  N 16 ");
+      else if (addr_ >= 0x03403000 && addr_ <= 0x034031ff) fprintf(opera_logfile, "CLIO DSPP EI 32 ");
+      else if (addr_ >= 0x03403400 && addr_ <= 0x034037ff) fprintf(opera_logfile, "CLIO DSPP EI 16 ");
+      else if (addr_ >= 0x0340C000 && addr_ <= 0x0340C000) fprintf(opera_logfile, "CLIO unc_rev    ");
+      else if (addr_ >= 0x0340C000 && addr_ <= 0x0340C004) fprintf(opera_logfile, "CLIO unc_soft_rv");
+      else if (addr_ >= 0x0340C000 && addr_ <= 0x0340C008) fprintf(opera_logfile, "CLIO unc_addr   ");
+      else if (addr_ >= 0x0340C000 && addr_ <= 0x0340C00C) fprintf(opera_logfile, "CLIO unc_rom    ");
       else switch (addr_) {
-         case 0x03400000: { fprintf(logfile, "CLIO Revision   "); break; }
-         case 0x03400004: { fprintf(logfile, "CLIO csysbits   "); break; }
-
-         case 0x03400008: { fprintf(logfile, "CLIO vint0      "); break; }
-         case 0x0340000C: { fprintf(logfile, "CLIO vint1      "); break; }
-
-         case 0x03400010: { fprintf(logfile, "CLIO DigVidEnc  "); break; }
-         case 0x03400014: { fprintf(logfile, "CLIO SbusState  "); break; }
-
-         case 0x03400020: { fprintf(logfile, "CLIO audin      "); break; }
-         case 0x03400024: { fprintf(logfile, "CLIO audout     "); break; }
-
-         case 0x03400028: { fprintf(logfile, "CLIO cstatbits  "); break; }
-         case 0x0340002c: { fprintf(logfile, "CLIO WatchDog   "); break; }
-
-         case 0x03400030: { fprintf(logfile, "CLIO hcnt       "); break; }
-         case 0x03400034: { fprintf(logfile, "CLIO vcnt       "); break; }
-
-         case 0x03400038: { fprintf(logfile, "CLIO RandSeed   "); break; }
-         case 0x0340003c: { fprintf(logfile, "CLIO RandSample "); break; }
-
-         case 0x03400040: { fprintf(logfile, "CLIO irq0 set   "); break; }
-         case 0x03400044: { fprintf(logfile, "CLIO irq0 clear "); break; }
-         case 0x03400048: { fprintf(logfile, "CLIO mask0 set  "); break; }
-         case 0x0340004c: { fprintf(logfile, "CLIO mask0 clear"); break; }
-
-         case 0x03400050: { fprintf(logfile, "CLIO SetMode    "); break; }
-         case 0x03400054: { fprintf(logfile, "CLIO ClrMode    "); break; }
-
-         case 0x03400058: { fprintf(logfile, "CLIO BadBits    "); break; }
-         case 0x0340005c: { fprintf(logfile, "CLIO Spare      "); break; }
-
-         case 0x03400060: { fprintf(logfile, "CLIO irq1 set   "); break; }
-         case 0x03400064: { fprintf(logfile, "CLIO irq1 clear "); break; }
-         case 0x03400068: { fprintf(logfile, "CLIO mask1 set  "); break; }
-         case 0x0340006c: { fprintf(logfile, "CLIO mask1 clear"); break; }
-
-         case 0x03400080: { fprintf(logfile, "CLIO hdelay     "); break; }
-         case 0x03400084: { fprintf(logfile, "CLIO adbio      "); break; }
-         case 0x03400088: { fprintf(logfile, "CLIO adbctl     "); break; }
-
-         case 0x03400100: { fprintf(logfile, "CLIO tmr_cnt_0  "); break; }
-         case 0x03400108: { fprintf(logfile, "CLIO tmr_cnt_1  "); break; }
-         case 0x03400110: { fprintf(logfile, "CLIO tmr_cnt_2  "); break; }
-         case 0x03400118: { fprintf(logfile, "CLIO tmr_cnt_3  "); break; }
-         case 0x03400120: { fprintf(logfile, "CLIO tmr_cnt_4  "); break; }
-         case 0x03400128: { fprintf(logfile, "CLIO tmr_cnt_5  "); break; }
-         case 0x03400130: { fprintf(logfile, "CLIO tmr_cnt_6  "); break; }
-         case 0x03400138: { fprintf(logfile, "CLIO tmr_cnt_7  "); break; }
-         case 0x03400140: { fprintf(logfile, "CLIO tmr_cnt_8  "); break; }
-         case 0x03400148: { fprintf(logfile, "CLIO tmr_cnt_9  "); break; }
-         case 0x03400150: { fprintf(logfile, "CLIO tmr_cnt_10 "); break; }
-         case 0x03400158: { fprintf(logfile, "CLIO tmr_cnt_11 "); break; }
-         case 0x03400160: { fprintf(logfile, "CLIO tmr_cnt_12 "); break; }
-         case 0x03400168: { fprintf(logfile, "CLIO tmr_cnt_13 "); break; }
-         case 0x03400170: { fprintf(logfile, "CLIO tmr_cnt_14 "); break; }
-         case 0x03400178: { fprintf(logfile, "CLIO tmr_cnt_15 "); break; }
-
-         case 0x03400104: { fprintf(logfile, "CLIO tmr_bkp_0  "); break; }
-         case 0x0340010c: { fprintf(logfile, "CLIO tmr_bkp_1  "); break; }
-         case 0x03400114: { fprintf(logfile, "CLIO tmr_bkp_2  "); break; }
-         case 0x0340011c: { fprintf(logfile, "CLIO tmr_bkp_3  "); break; }
-         case 0x03400124: { fprintf(logfile, "CLIO tmr_bkp_4  "); break; }
-         case 0x0340012c: { fprintf(logfile, "CLIO tmr_bkp_5  "); break; }
-         case 0x03400134: { fprintf(logfile, "CLIO tmr_bkp_6  "); break; }
-         case 0x0340013c: { fprintf(logfile, "CLIO tmr_bkp_7  "); break; }
-         case 0x03400144: { fprintf(logfile, "CLIO tmr_bkp_8  "); break; }
-         case 0x0340014c: { fprintf(logfile, "CLIO tmr_bkp_9  "); break; }
-         case 0x03400154: { fprintf(logfile, "CLIO tmr_bkp_10 "); break; }
-         case 0x0340015c: { fprintf(logfile, "CLIO tmr_bkp_11 "); break; }
-         case 0x03400164: { fprintf(logfile, "CLIO tmr_bkp_12 "); break; }
-         case 0x0340016c: { fprintf(logfile, "CLIO tmr_bkp_13 "); break; }
-         case 0x03400174: { fprintf(logfile, "CLIO tmr_bkp_14 "); break; }
-         case 0x0340017c: { fprintf(logfile, "CLIO tmr_bkp_15 "); break; }
-
-         case 0x03400200: { fprintf(logfile, "CLIO tmr_set_l  "); break; }
-         case 0x03400204: { fprintf(logfile, "CLIO tmr_clr_l  "); break; }
-         case 0x03400208: { fprintf(logfile, "CLIO tmr_set_u  "); break; }
-         case 0x0340020C: { fprintf(logfile, "CLIO tmr_clr_u  "); break; }
-
-         case 0x03400220: { fprintf(logfile, "CLIO TmrSlack   "); break; }
-         case 0x03400304: { fprintf(logfile, "CLIO SetDMAEna  "); break; }
-         case 0x03400308: { fprintf(logfile, "CLIO ClrDMAEna  "); break; }
-
-         case 0x03400380: { fprintf(logfile, "CLIO DMA DSPP0  "); break; }
-         case 0x03400384: { fprintf(logfile, "CLIO DMA DSPP1  "); break; }
-         case 0x03400388: { fprintf(logfile, "CLIO DMA DSPP2  "); break; }
-         case 0x0340038c: { fprintf(logfile, "CLIO DMA DSPP3  "); break; }
-         case 0x03400390: { fprintf(logfile, "CLIO DMA DSPP4  "); break; }
-         case 0x03400394: { fprintf(logfile, "CLIO DMA DSPP5  "); break; }
-         case 0x03400398: { fprintf(logfile, "CLIO DMA DSPP6  "); break; }
-         case 0x0340039c: { fprintf(logfile, "CLIO DMA DSPP7  "); break; }
-         case 0x034003a0: { fprintf(logfile, "CLIO DMA DSPP8  "); break; }
-         case 0x034003a4: { fprintf(logfile, "CLIO DMA DSPP9  "); break; }
-         case 0x034003a8: { fprintf(logfile, "CLIO DMA DSPP10 "); break; }
-         case 0x034003ac: { fprintf(logfile, "CLIO DMA DSPP11 "); break; }
-         case 0x034003b0: { fprintf(logfile, "CLIO DMA DSPP12 "); break; }
-         case 0x034003b4: { fprintf(logfile, "CLIO DMA DSPP13 "); break; }
-         case 0x034003b8: { fprintf(logfile, "CLIO DMA DSPP14 "); break; }
-         case 0x034003bc: { fprintf(logfile, "CLIO DMA DSPP15 "); break; }
+         case 0x03400000: { fprintf(opera_logfile, "CLIO Revision   "); break; }
+         case 0x03400004: { fprintf(opera_logfile, "CLIO csysbits   "); break; }
+
+         case 0x03400008: { fprintf(opera_logfile, "CLIO vint0      "); break; }
+         case 0x0340000C: { fprintf(opera_logfile, "CLIO vint1      "); break; }
+
+         case 0x03400010: { fprintf(opera_logfile, "CLIO DigVidEnc  "); break; }
+         case 0x03400014: { fprintf(opera_logfile, "CLIO SbusState  "); break; }
+
+         case 0x03400020: { fprintf(opera_logfile, "CLIO audin      "); break; }
+         case 0x03400024: { fprintf(opera_logfile, "CLIO audout     "); break; }
+
+         case 0x03400028: { fprintf(opera_logfile, "CLIO cstatbits  "); break; }
+         case 0x0340002c: { fprintf(opera_logfile, "CLIO WatchDog   "); break; }
+
+         case 0x03400030: { fprintf(opera_logfile, "CLIO hcnt       "); break; }
+         case 0x03400034: { fprintf(opera_logfile, "CLIO vcnt       "); break; }
+
+         case 0x03400038: { fprintf(opera_logfile, "CLIO RandSeed   "); break; }
+         case 0x0340003c: { fprintf(opera_logfile, "CLIO RandSample "); break; }
+
+         case 0x03400040: { fprintf(opera_logfile, "CLIO irq0 set   "); break; }
+         case 0x03400044: { fprintf(opera_logfile, "CLIO irq0 clear "); break; }
+         case 0x03400048: { fprintf(opera_logfile, "CLIO mask0 set  "); break; }
+         case 0x0340004c: { fprintf(opera_logfile, "CLIO mask0 clear"); break; }
+
+         case 0x03400050: { fprintf(opera_logfile, "CLIO SetMode    "); break; }
+         case 0x03400054: { fprintf(opera_logfile, "CLIO ClrMode    "); break; }
+
+         case 0x03400058: { fprintf(opera_logfile, "CLIO BadBits    "); break; }
+         case 0x0340005c: { fprintf(opera_logfile, "CLIO Spare      "); break; }
+
+         case 0x03400060: { fprintf(opera_logfile, "CLIO irq1 set   "); break; }
+         case 0x03400064: { fprintf(opera_logfile, "CLIO irq1 clear "); break; }
+         case 0x03400068: { fprintf(opera_logfile, "CLIO mask1 set  "); break; }
+         case 0x0340006c: { fprintf(opera_logfile, "CLIO mask1 clear"); break; }
+
+         case 0x03400080: { fprintf(opera_logfile, "CLIO hdelay     "); break; }
+         case 0x03400084: { fprintf(opera_logfile, "CLIO adbio      "); break; }
+         case 0x03400088: { fprintf(opera_logfile, "CLIO adbctl     "); break; }
+
+         case 0x03400100: { fprintf(opera_logfile, "CLIO tmr_cnt_0  "); break; }
+         case 0x03400108: { fprintf(opera_logfile, "CLIO tmr_cnt_1  "); break; }
+         case 0x03400110: { fprintf(opera_logfile, "CLIO tmr_cnt_2  "); break; }
+         case 0x03400118: { fprintf(opera_logfile, "CLIO tmr_cnt_3  "); break; }
+         case 0x03400120: { fprintf(opera_logfile, "CLIO tmr_cnt_4  "); break; }
+         case 0x03400128: { fprintf(opera_logfile, "CLIO tmr_cnt_5  "); break; }
+         case 0x03400130: { fprintf(opera_logfile, "CLIO tmr_cnt_6  "); break; }
+         case 0x03400138: { fprintf(opera_logfile, "CLIO tmr_cnt_7  "); break; }
+         case 0x03400140: { fprintf(opera_logfile, "CLIO tmr_cnt_8  "); break; }
+         case 0x03400148: { fprintf(opera_logfile, "CLIO tmr_cnt_9  "); break; }
+         case 0x03400150: { fprintf(opera_logfile, "CLIO tmr_cnt_10 "); break; }
+         case 0x03400158: { fprintf(opera_logfile, "CLIO tmr_cnt_11 "); break; }
+         case 0x03400160: { fprintf(opera_logfile, "CLIO tmr_cnt_12 "); break; }
+         case 0x03400168: { fprintf(opera_logfile, "CLIO tmr_cnt_13 "); break; }
+         case 0x03400170: { fprintf(opera_logfile, "CLIO tmr_cnt_14 "); break; }
+         case 0x03400178: { fprintf(opera_logfile, "CLIO tmr_cnt_15 "); break; }
+
+         case 0x03400104: { fprintf(opera_logfile, "CLIO tmr_bkp_0  "); break; }
+         case 0x0340010c: { fprintf(opera_logfile, "CLIO tmr_bkp_1  "); break; }
+         case 0x03400114: { fprintf(opera_logfile, "CLIO tmr_bkp_2  "); break; }
+         case 0x0340011c: { fprintf(opera_logfile, "CLIO tmr_bkp_3  "); break; }
+         case 0x03400124: { fprintf(opera_logfile, "CLIO tmr_bkp_4  "); break; }
+         case 0x0340012c: { fprintf(opera_logfile, "CLIO tmr_bkp_5  "); break; }
+         case 0x03400134: { fprintf(opera_logfile, "CLIO tmr_bkp_6  "); break; }
+         case 0x0340013c: { fprintf(opera_logfile, "CLIO tmr_bkp_7  "); break; }
+         case 0x03400144: { fprintf(opera_logfile, "CLIO tmr_bkp_8  "); break; }
+         case 0x0340014c: { fprintf(opera_logfile, "CLIO tmr_bkp_9  "); break; }
+         case 0x03400154: { fprintf(opera_logfile, "CLIO tmr_bkp_10 "); break; }
+         case 0x0340015c: { fprintf(opera_logfile, "CLIO tmr_bkp_11 "); break; }
+         case 0x03400164: { fprintf(opera_logfile, "CLIO tmr_bkp_12 "); break; }
+         case 0x0340016c: { fprintf(opera_logfile, "CLIO tmr_bkp_13 "); break; }
+         case 0x03400174: { fprintf(opera_logfile, "CLIO tmr_bkp_14 "); break; }
+         case 0x0340017c: { fprintf(opera_logfile, "CLIO tmr_bkp_15 "); break; }
+
+         case 0x03400200: { fprintf(opera_logfile, "CLIO tmr_set_l  "); break; }
+         case 0x03400204: { fprintf(opera_logfile, "CLIO tmr_clr_l  "); break; }
+         case 0x03400208: { fprintf(opera_logfile, "CLIO tmr_set_u  "); break; }
+         case 0x0340020C: { fprintf(opera_logfile, "CLIO tmr_clr_u  "); break; }
+
+         case 0x03400220: { fprintf(opera_logfile, "CLIO TmrSlack   "); break; }
+         case 0x03400304: { fprintf(opera_logfile, "CLIO SetDMAEna  "); break; }
+         case 0x03400308: { fprintf(opera_logfile, "CLIO ClrDMAEna  "); break; }
+
+         case 0x03400380: { fprintf(opera_logfile, "CLIO DMA DSPP0  "); break; }
+         case 0x03400384: { fprintf(opera_logfile, "CLIO DMA DSPP1  "); break; }
+         case 0x03400388: { fprintf(opera_logfile, "CLIO DMA DSPP2  "); break; }
+         case 0x0340038c: { fprintf(opera_logfile, "CLIO DMA DSPP3  "); break; }
+         case 0x03400390: { fprintf(opera_logfile, "CLIO DMA DSPP4  "); break; }
+         case 0x03400394: { fprintf(opera_logfile, "CLIO DMA DSPP5  "); break; }
+         case 0x03400398: { fprintf(opera_logfile, "CLIO DMA DSPP6  "); break; }
+         case 0x0340039c: { fprintf(opera_logfile, "CLIO DMA DSPP7  "); break; }
+         case 0x034003a0: { fprintf(opera_logfile, "CLIO DMA DSPP8  "); break; }
+         case 0x034003a4: { fprintf(opera_logfile, "CLIO DMA DSPP9  "); break; }
+         case 0x034003a8: { fprintf(opera_logfile, "CLIO DMA DSPP10 "); break; }
+         case 0x034003ac: { fprintf(opera_logfile, "CLIO DMA DSPP11 "); break; }
+         case 0x034003b0: { fprintf(opera_logfile, "CLIO DMA DSPP12 "); break; }
+         case 0x034003b4: { fprintf(opera_logfile, "CLIO DMA DSPP13 "); break; }
+         case 0x034003b8: { fprintf(opera_logfile, "CLIO DMA DSPP14 "); break; }
+         case 0x034003bc: { fprintf(opera_logfile, "CLIO DMA DSPP15 "); break; }
 
          // Only the first FOUR FIFO Status DSPP-to-DMA regs are used in clio.h in the Portfolio/Opera (OS) source?
-         case 0x034003c0: { fprintf(logfile, "CLIO DSPP DMA0  "); break; }
-         case 0x034003c4: { fprintf(logfile, "CLIO DSPP DMA1  "); break; }
-         case 0x034003c8: { fprintf(logfile, "CLIO DSPP DMA2  "); break; }
-         case 0x034003cc: { fprintf(logfile, "CLIO DSPP DMA3  "); break; }
-         case 0x034003d0: { fprintf(logfile, "CLIO DSPP DMA4  "); break; }
-         case 0x034003d4: { fprintf(logfile, "CLIO DSPP DMA5  "); break; }
-         case 0x034003d8: { fprintf(logfile, "CLIO DSPP DMA6  "); break; }
-         case 0x034003dc: { fprintf(logfile, "CLIO DSPP DMA7  "); break; }
-         case 0x034003e0: { fprintf(logfile, "CLIO DSPP DMA8  "); break; }
-         case 0x034003e4: { fprintf(logfile, "CLIO DSPP DMA9  "); break; }
-         case 0x034003e8: { fprintf(logfile, "CLIO DSPP DMA10 "); break; }
-         case 0x034003ec: { fprintf(logfile, "CLIO DSPP DMA11 "); break; }
-         case 0x034003f0: { fprintf(logfile, "CLIO DSPP DMA12 "); break; }
-         case 0x034003f4: { fprintf(logfile, "CLIO DSPP DMA13 "); break; }
-         case 0x034003f8: { fprintf(logfile, "CLIO DSPP DMA14 "); break; }
-         case 0x034003fc: { fprintf(logfile, "CLIO DSPP DMA15 "); break; }
-
-         case 0x03400400: { fprintf(logfile, "CLIO expctl_set "); break; }
-         case 0x03400404: { fprintf(logfile, "CLIO expctl_clr "); break; }
-         case 0x03400408: { fprintf(logfile, "CLIO type0_4    "); break; }
-         case 0x03400410: { fprintf(logfile, "CLIO dipir1     "); break; }
-         case 0x03400414: { fprintf(logfile, "CLIO dipir2     "); break; }
-
-         case 0x03400500: { fprintf(logfile, "CLIO sel0       "); break; }
-         case 0x03400504: { fprintf(logfile, "CLIO sel1       "); break; }
-         case 0x03400508: { fprintf(logfile, "CLIO sel2       "); break; }
-         case 0x0340050c: { fprintf(logfile, "CLIO sel3       "); break; }
-         case 0x03400510: { fprintf(logfile, "CLIO sel4       "); break; }
-         case 0x03400514: { fprintf(logfile, "CLIO sel5       "); break; }
-         case 0x03400518: { fprintf(logfile, "CLIO sel6       "); break; }
-         case 0x0340051c: { fprintf(logfile, "CLIO sel7       "); break; }
-         case 0x03400520: { fprintf(logfile, "CLIO sel8       "); break; }
-         case 0x03400524: { fprintf(logfile, "CLIO sel9       "); break; }
-         case 0x03400528: { fprintf(logfile, "CLIO sel10      "); break; }
-         case 0x0340052c: { fprintf(logfile, "CLIO sel11      "); break; }
-         case 0x03400530: { fprintf(logfile, "CLIO sel12      "); break; }
-         case 0x03400534: { fprintf(logfile, "CLIO sel13      "); break; }
-         case 0x03400538: { fprintf(logfile, "CLIO sel14      "); break; }
-         case 0x0340053c: { fprintf(logfile, "CLIO sel15      "); break; }
-
-         case 0x03400540: { fprintf(logfile, "CLIO poll0      "); break; }
-         case 0x03400544: { fprintf(logfile, "CLIO poll1      "); break; }
-         case 0x03400548: { fprintf(logfile, "CLIO poll2      "); break; }
-         case 0x0340054c: { fprintf(logfile, "CLIO poll3      "); break; }
-         case 0x03400550: { fprintf(logfile, "CLIO poll4      "); break; }
-         case 0x03400554: { fprintf(logfile, "CLIO poll5      "); break; }
-         case 0x03400558: { fprintf(logfile, "CLIO poll6      "); break; }
-         case 0x0340055c: { fprintf(logfile, "CLIO poll7      "); break; }
-         case 0x03400560: { fprintf(logfile, "CLIO poll8      "); break; }
-         case 0x03400564: { fprintf(logfile, "CLIO poll9      "); break; }
-         case 0x03400568: { fprintf(logfile, "CLIO poll10     "); break; }
-         case 0x0340056c: { fprintf(logfile, "CLIO poll11     "); break; }
-         case 0x03400570: { fprintf(logfile, "CLIO poll12     "); break; }
-         case 0x03400574: { fprintf(logfile, "CLIO poll13     "); break; }
-         case 0x03400578: { fprintf(logfile, "CLIO poll14     "); break; }
-         case 0x0340057c: { fprintf(logfile, "CLIO poll15     "); break; }
-
-         case 0x03400580: { fprintf(logfile, "CLIO CmdStFIFO  "); break; }
-
-         case 0x034017d0: { fprintf(logfile, "CLIO sema       "); break; }
-         case 0x034017d4: { fprintf(logfile, "CLIO semaack    "); break; }
-         case 0x034017e0: { fprintf(logfile, "CLIO dspdma     "); break; }
-         case 0x034017e4: { fprintf(logfile, "CLIO dspprst0   "); break; }
-         case 0x034017e8: { fprintf(logfile, "CLIO dspprst1   "); break; }
-         case 0x034017f4: { fprintf(logfile, "CLIO dspppc     "); break; }
-         case 0x034017f8: { fprintf(logfile, "CLIO dsppnr     "); break; }
-         case 0x034017fc: { fprintf(logfile, "CLIO dsppgw     "); break; }
-         case 0x034039dc: { fprintf(logfile, "CLIO dsppclkreld"); break; }
-         default: { fprintf(logfile, "CLIO UNKNOWN    "); break; }
+         case 0x034003c0: { fprintf(opera_logfile, "CLIO DSPP DMA0  "); break; }
+         case 0x034003c4: { fprintf(opera_logfile, "CLIO DSPP DMA1  "); break; }
+         case 0x034003c8: { fprintf(opera_logfile, "CLIO DSPP DMA2  "); break; }
+         case 0x034003cc: { fprintf(opera_logfile, "CLIO DSPP DMA3  "); break; }
+         case 0x034003d0: { fprintf(opera_logfile, "CLIO DSPP DMA4  "); break; }
+         case 0x034003d4: { fprintf(opera_logfile, "CLIO DSPP DMA5  "); break; }
+         case 0x034003d8: { fprintf(opera_logfile, "CLIO DSPP DMA6  "); break; }
+         case 0x034003dc: { fprintf(opera_logfile, "CLIO DSPP DMA7  "); break; }
+         case 0x034003e0: { fprintf(opera_logfile, "CLIO DSPP DMA8  "); break; }
+         case 0x034003e4: { fprintf(opera_logfile, "CLIO DSPP DMA9  "); break; }
+         case 0x034003e8: { fprintf(opera_logfile, "CLIO DSPP DMA10 "); break; }
+         case 0x034003ec: { fprintf(opera_logfile, "CLIO DSPP DMA11 "); break; }
+         case 0x034003f0: { fprintf(opera_logfile, "CLIO DSPP DMA12 "); break; }
+         case 0x034003f4: { fprintf(opera_logfile, "CLIO DSPP DMA13 "); break; }
+         case 0x034003f8: { fprintf(opera_logfile, "CLIO DSPP DMA14 "); break; }
+         case 0x034003fc: { fprintf(opera_logfile, "CLIO DSPP DMA15 "); break; }
+
+         case 0x03400400: { fprintf(opera_logfile, "CLIO expctl_set "); break; }
+         case 0x03400404: { fprintf(opera_logfile, "CLIO expctl_clr "); break; }
+         case 0x03400408: { fprintf(opera_logfile, "CLIO type0_4    "); break; }
+         case 0x03400410: { fprintf(opera_logfile, "CLIO dipir1     "); break; }
+         case 0x03400414: { fprintf(opera_logfile, "CLIO dipir2     "); break; }
+
+         case 0x03400500: { fprintf(opera_logfile, "CLIO sel0       "); break; }
+         case 0x03400504: { fprintf(opera_logfile, "CLIO sel1       "); break; }
+         case 0x03400508: { fprintf(opera_logfile, "CLIO sel2       "); break; }
+         case 0x0340050c: { fprintf(opera_logfile, "CLIO sel3       "); break; }
+         case 0x03400510: { fprintf(opera_logfile, "CLIO sel4       "); break; }
+         case 0x03400514: { fprintf(opera_logfile, "CLIO sel5       "); break; }
+         case 0x03400518: { fprintf(opera_logfile, "CLIO sel6       "); break; }
+         case 0x0340051c: { fprintf(opera_logfile, "CLIO sel7       "); break; }
+         case 0x03400520: { fprintf(opera_logfile, "CLIO sel8       "); break; }
+         case 0x03400524: { fprintf(opera_logfile, "CLIO sel9       "); break; }
+         case 0x03400528: { fprintf(opera_logfile, "CLIO sel10      "); break; }
+         case 0x0340052c: { fprintf(opera_logfile, "CLIO sel11      "); break; }
+         case 0x03400530: { fprintf(opera_logfile, "CLIO sel12      "); break; }
+         case 0x03400534: { fprintf(opera_logfile, "CLIO sel13      "); break; }
+         case 0x03400538: { fprintf(opera_logfile, "CLIO sel14      "); break; }
+         case 0x0340053c: { fprintf(opera_logfile, "CLIO sel15      "); break; }
+
+         case 0x03400540: { fprintf(opera_logfile, "CLIO poll0      "); break; }
+         case 0x03400544: { fprintf(opera_logfile, "CLIO poll1      "); break; }
+         case 0x03400548: { fprintf(opera_logfile, "CLIO poll2      "); break; }
+         case 0x0340054c: { fprintf(opera_logfile, "CLIO poll3      "); break; }
+         case 0x03400550: { fprintf(opera_logfile, "CLIO poll4      "); break; }
+         case 0x03400554: { fprintf(opera_logfile, "CLIO poll5      "); break; }
+         case 0x03400558: { fprintf(opera_logfile, "CLIO poll6      "); break; }
+         case 0x0340055c: { fprintf(opera_logfile, "CLIO poll7      "); break; }
+         case 0x03400560: { fprintf(opera_logfile, "CLIO poll8      "); break; }
+         case 0x03400564: { fprintf(opera_logfile, "CLIO poll9      "); break; }
+         case 0x03400568: { fprintf(opera_logfile, "CLIO poll10     "); break; }
+         case 0x0340056c: { fprintf(opera_logfile, "CLIO poll11     "); break; }
+         case 0x03400570: { fprintf(opera_logfile, "CLIO poll12     "); break; }
+         case 0x03400574: { fprintf(opera_logfile, "CLIO poll13     "); break; }
+         case 0x03400578: { fprintf(opera_logfile, "CLIO poll14     "); break; }
+         case 0x0340057c: { fprintf(opera_logfile, "CLIO poll15     "); break; }
+
+         case 0x03400580: { fprintf(opera_logfile, "CLIO CmdStFIFO  "); break; }
+
+         case 0x034017d0: { fprintf(opera_logfile, "CLIO sema       "); break; }
+         case 0x034017d4: { fprintf(opera_logfile, "CLIO semaack    "); break; }
+         case 0x034017e0: { fprintf(opera_logfile, "CLIO dspdma     "); break; }
+         case 0x034017e4: { fprintf(opera_logfile, "CLIO dspprst0   "); break; }
+         case 0x034017e8: { fprintf(opera_logfile, "CLIO dspprst1   "); break; }
+         case 0x034017f4: { fprintf(opera_logfile, "CLIO dspppc     "); break; }
+         case 0x034017f8: { fprintf(opera_logfile, "CLIO dsppnr     "); break; }
+         case 0x034017fc: { fprintf(opera_logfile, "CLIO dsppgw     "); break; }
+         case 0x034039dc: { fprintf(opera_logfile, "CLIO dsppclkreld"); break; }
+         default: { fprintf(opera_logfile, "CLIO UNKNOWN    "); break; }
       }
    }
 }
 
-uint32_t old_pc = 0;
+/*
+  I/O side of the memory map. g_MEM_IO picks the handler for any page
+  that isn't straight host memory. The bus trace lives out here too, as
+  nothing below 0x03100000 ever gets traced (see opera_log_region()).
+*/
 
-static void mwritew(uint32_t addr_, uint32_t val_)
+/* "Addr: 0x... <name>", ahead of the access. Compiled out with OPERA_LOG_ENABLE 0. */
+static
+INLINE
+void
+arm_io_log_addr(const uint32_t addr_,
+                const uint32_t val_,
+                const uint8_t  write_)
 {
-   uint32_t index;
-   addr_ &= ~3;
+#if OPERA_LOG_ENABLE
+  if(addr_ != 0x03400034)
+    fprintf(opera_logfile,"Addr: 0x%08X ",addr_);
+  print_to_log(addr_,val_,write_,CPU.USER[15]); // Address, Value, 0=read, 1=write.
+#endif
+}
 
-   //if (addr_==0x03400084 && val_==0x00000022) trace = 1;
-   
-   if (trace) {
-      if (CPU.USER[15] != old_pc) {
-         fprintf(logfile, "PC: 0x%08X \n", CPU.USER[15]);
-         old_pc = CPU.USER[15];
-      }
-   }
+/* opera_trace: the PC of each instruction that does a word access, once. */
+static
+INLINE
+void
+arm_io_log_pc(void)
+{
+#if OPERA_LOG_ENABLE
+  if(opera_trace && (CPU.USER[15] != old_pc))
+    {
+      fprintf(opera_logfile,"PC: 0x%08X \n",CPU.USER[15]);
+      old_pc = CPU.USER[15];
+    }
+#endif
+}
 
-   if (addr_ >= 0x03100000 && addr_ <= 0x034FFFFF && addr_!=0x03400034) fprintf(logfile, "Addr: 0x%08X ", addr_);
-   print_to_log(addr_, val_, 1, CPU.USER[15]); // Address, Value, 0=read, 1=write.
-   if (addr_ >= 0x03100000 && addr_ <= 0x034FFFFF && addr_!=0x03400034) fprintf(logfile, "Write: 0x%08X  (PC: 0x%08X)\n", val_, CPU.USER[15]);
+static
+uint32_t
+arm_io_readw_none(const uint32_t addr_)
+{
+  /* MAS_Access_Exept = TRUE; */
+  return 0xBADACCE5;
+}
 
-   //if (addr_ == 0x03300580) trace = 0;
+static
+uint32_t
+arm_io_readw_slow(const uint32_t addr_)
+{
+  const uint32_t index = (addr_ ^ 0x03100000);
 
-   if(addr_ < 0x00300000)
-   {
-      opera_mem_write32(addr_,val_);
-      return;
-   }
+  if(index & 0x80000)
+    return opera_diag_port_get();
+  if(index & 0x40000)
+    return CPU.nvram[(index >> 2) & 0x7FFF];
 
-   index = (addr_ ^ 0x03300000);
-   if(!(index & ~0x7FF))
-   {
-      opera_madam_poke(index,val_);
-      return;
-   }
+  return 0x0000006a;	// Brooktree. TESTING !! (gets to the logo faster.)
+}
 
-   index = (addr_ ^ 0x03400000);
-   if(!(index & ~0xFFFF))
-   {
-      //if (addr_==0x03400084 && val_==0x00000022) trace = 1;
+static
+uint32_t
+arm_io_readw_sport(const uint32_t addr_)
+{
+  const uint32_t index = (addr_ ^ 0x03200000);
 
-      if(opera_clio_poke(index,val_))
-         CPU.USER[15] += 4;  /* ??? */
-      return;
-   }
+  if(!(index & ~0x1FFF))
+    {
+      opera_sport_set_source(index);
+      return 0;
+    }
 
-   index = (addr_ ^ 0x03200000);
-   if(!(index & ~0xFFFFF))
-   {
-      opera_sport_write_access(index,val_);
-      return;
-   }
+  return 0xBADACCE5;
+}
 
-   index = (addr_ ^ 0x03100000);
-   if(!(index & ~0xFFFFF))
-   {
-      if(index & 0x80000) opera_diag_port_send(val_);
-      else if(index & 0x40000) CPU.nvram[(index >> 2) & 0x7FFF] = (uint8_t)val_;
-   }
+static
+uint32_t
+arm_io_readw_madam(const uint32_t addr_)
+{
+  return opera_madam_peek(addr_ ^ 0x03300000);
 }
 
 static
 uint32_t
-mreadw(uint32_t addr_)
+arm_io_readw_clio(const uint32_t addr_)
 {
-  int32_t index;
-  addr_ &= ~3;
+  return opera_clio_peek(addr_ ^ 0x03400000);
+}
 
-  if (trace) {
-     if (CPU.USER[15] != old_pc) {
-        fprintf(logfile, "PC: 0x%08X \n", CPU.USER[15]);
-        old_pc = CPU.USER[15];
-     }
-  }
+static
+void
+arm_io_writew_none(const uint32_t addr_,
+                   const uint32_t val_)
+{
+}
 
-  //if (addr_==0x03400084) trace = 1;
+/* Not straight to host memory, for the HIRESMODE copies. */
+static
+void
+arm_io_writew_vram(const uint32_t addr_,
+                   const uint32_t val_)
+{
+  opera_mem_write32(addr_,val_);
+}
 
+static
+void
+arm_io_writew_slow(const uint32_t addr_,
+                   const uint32_t val_)
+{
+  const uint32_t index = (addr_ ^ 0x03100000);
 
-  // Can't easily grab read_write before the return, so the fprintf's below will handle printing the read value to the logfile.
-  if (addr_>=0x03100000 && addr_<=0x034FFFFF && addr_!=0x03400034) fprintf(logfile, "Addr: 0x%08X ", addr_);
-  print_to_log(addr_, 0x00000000, 0, CPU.USER[15]); // Address, Value, 0=read, 1=write.
+  if(index & 0x80000)
+    opera_diag_port_send(val_);
+  else if(index & 0x40000)
+    CPU.nvram[(index >> 2) & 0x7FFF] = (uint8_t)val_;
+}
 
-   if(addr_ < 0x00300000) {
-      uint32_t read_word = opera_mem_read32(addr_);
-	   if (addr_>=0x03100000 && addr_<=0x034FFFFF) fprintf(logfile, " Read: 0x%08X  (PC: 0x%08X)\n", read_word, CPU.USER[15]);
-      return read_word;
-   }
+static
+void
+arm_io_writew_sport(const uint32_t addr_,
+                    const uint32_t val_)
+{
+  opera_sport_write_access(addr_ ^ 0x03200000,val_);
+}
 
-   index = (addr_ ^ 0x03300000);
-   if (!(index & ~0xFFFFF)) {
-      uint32_t read_word = opera_madam_peek(index);
-	   if (addr_>=0x03100000 && addr_<=0x034FFFFF) fprintf(logfile, " Read: 0x%08X  (PC: 0x%08X)\n", read_word, CPU.USER[15]);
-      return read_word;
-   }
-    
+static
+void
+arm_io_writew_madam(const uint32_t addr_,
+                    const uint32_t val_)
+{
+  const uint32_t index = (addr_ ^ 0x03300000);
 
-   index = (addr_ ^ 0x03400000);
-   if(!(index & ~0xFFFFF)) {
-      uint32_t read_word = opera_clio_peek(index);
-	   if (addr_>=0x03100000 && addr_<=0x034FFFFF && addr_!=0x03400034) fprintf(logfile, " Read: 0x%08X  (PC: 0x%08X)\n", read_word, CPU.USER[15]);
-      return read_word;
-   }
+  if(!(index & ~0x7FF))
+    opera_madam_poke(index,val_);
+}
 
-   index = (addr_ ^ 0x03200000);
-   if(!(index & ~0xFFFFF))
-   {
-      if(!(index & ~0x1FFF)) {
-         uint32_t read_word = (opera_sport_set_source(index),0);
-         if (addr_>=0x03100000 && addr_<=0x034FFFFF) fprintf(logfile, " Read: 0x%08X  (PC: 0x%08X)\n", read_word, CPU.USER[15]);
-         return read_word;
-      }
-      else {
-         uint32_t read_word = 0xBADACCE5;
-         if (addr_>=0x03100000 && addr_<=0x034FFFFF) fprintf(logfile, " Read: 0x%08X  (PC: 0x%08X)\n", read_word, CPU.USER[15]);
-         return read_word;
-      }
-   }
+static
+void
+arm_io_writew_clio(const uint32_t addr_,
+                   const uint32_t val_)
+{
+  const uint32_t index = (addr_ ^ 0x03400000);
 
-   /* Standard ROM */
-   index = (addr_ ^ 0x03000000);
-   if(!(index & ~0xFFFFF))
-      return *(uint32_t*)&CPU.rom[index];
-
-   /* ANVIL ROM */
-   index = (addr_ ^ 0x06000000);
-   if(!(index & ~0xFFFFF))
-      return *(uint32_t*)&CPU.rom[index];
-
-   index = (addr_ ^ 0x03100000);
-   if(!(index & ~0xFFFFF)) {
-      if(index & 0x80000) {
-         uint32_t read_word = opera_diag_port_get(); fprintf(logfile, " Read: 0x%08X  (PC: 0x%08X)\n", read_word, CPU.USER[15]);
-         return read_word;
-      }
-      else if(index & 0x40000) {
-         uint32_t read_word = CPU.nvram[(index >> 2) & 0x7FFF]; fprintf(logfile, " Read: 0x%08X  (PC: 0x%08X)\n", read_word, CPU.USER[15]);
-         return read_word;
-      }
-      else {	// Brooktree.
-		fprintf(logfile, " Read: 0x%08X  (PC: 0x%08X)\n", 0x0000006a, CPU.USER[15]);
-		return 0x0000006a;	// TESTING !! (gets to the logo faster.)
-	  }
-   }
+  //if (addr_==0x03400084 && val_==0x00000022) opera_trace = 1;
+
+  if(!(index & ~0xFFFF) && opera_clio_poke(index,val_))
+    CPU.USER[15] += 4;  /* ??? */
+}
+
+typedef uint32_t (*arm_io_readw_t)(const uint32_t addr_);
+typedef void (*arm_io_writew_t)(const uint32_t addr_, const uint32_t val_);
+
+/* In arm_mem_io_e order. */
+static const arm_io_readw_t g_IO_READW[] =
+  {
+    arm_io_readw_none,
+    arm_io_readw_none,          /* VRAM reads are direct */
+    arm_io_readw_slow,
+    arm_io_readw_sport,
+    arm_io_readw_madam,
+    arm_io_readw_clio
+  };
+
+static const arm_io_writew_t g_IO_WRITEW[] =
+  {
+    arm_io_writew_none,
+    arm_io_writew_vram,
+    arm_io_writew_slow,
+    arm_io_writew_sport,
+    arm_io_writew_madam,
+    arm_io_writew_clio
+  };
+
+static
+INLINE
+uint32_t
+arm_mem_io(const uint32_t addr_)
+{
+  const uint32_t page = (addr_ >> ARM_MEM_PAGE_SHIFT);
+
+  return ((page < ARM_MEM_PAGES) ? g_MEM_IO[page] : ARM_MEM_IO_NONE);
+}
+
+static
+uint32_t
+arm_io_readw(const uint32_t addr_)
+{
+  uint32_t val;
+  const uint32_t io = arm_mem_io(addr_);
+  const int log = opera_log_on(opera_log_region(addr_));
+
+  arm_jit_stop = 1;	// Anything that isn't host memory is I/O.
+
+  // Of that, an idle loop can only poll CLIO below XBUS (vcnt, the IRQ bits, the timers...). See arm_idle_loop().
+  if((io != ARM_MEM_IO_NONE) && ((io != ARM_MEM_IO_CLIO) || ((addr_ & 0xFFFFF) >= 0x500)))
+    g_IDLE.impure = 1;
+
+  // The name goes out before the access, the value after.
+  if(log)
+    arm_io_log_addr(addr_,0x00000000,0);
+
+  val = g_IO_READW[io](addr_);
+
+  if(log && (addr_ != 0x03400034))
+    fprintf(opera_logfile," Read: 0x%08X  (PC: 0x%08X)\n",val,CPU.USER[15]);
+
+  return val;
+}
+
+static
+void
+arm_io_writew(const uint32_t addr_,
+              const uint32_t val_)
+{
+  const uint32_t io = arm_mem_io(addr_);
+
+  if(io != ARM_MEM_IO_VRAM)
+    arm_jit_stop = 1;
+
+  if(opera_log_on(opera_log_region(addr_)))
+    {
+      arm_io_log_addr(addr_,val_,1);
+      if(addr_ != 0x03400034)
+        fprintf(opera_logfile,"Write: 0x%08X  (PC: 0x%08X)\n",val_,CPU.USER[15]);
+    }
+
+  //if (addr_ == 0x03300580) opera_trace = 0;
+
+  g_IO_WRITEW[io](addr_,val_);
+}
+
+static
+uint32_t
+arm_io_readb(const uint32_t addr_)
+{
+  const uint32_t region = opera_log_region(addr_);
+  const int log = opera_log_on(region);
+
+  arm_jit_stop = 1;
+
+  if(log)
+    arm_io_log_addr(addr_,0x00000000,0);
+
+  // Only NVRAM has anything for byte reads.
+  if(arm_mem_io(addr_) == ARM_MEM_IO_SLOW)
+    {
+      const uint32_t index = (addr_ ^ 0x03100003);
+
+      if(index & 0x40000)
+        return CPU.nvram[(index >> 2) & 0x7FFF];
+      if(log)
+        fprintf(opera_logfile,"\n");
+    }
 
   /* MAS_Access_Exept = TRUE; */
 
-  //if (addr_>=0x03100000 && addr_<=0x034FFFFF) fprintf(logfile, " Read: 0x%08X  (PC: 0x%08X)  addr: 0x%08X\n", 0xBADACCE5, CPU.USER[15], addr_);
+  if(opera_log_on(region ? region : OPERA_LOG_MISC))
+    fprintf(opera_logfile,"Addr: 0x%08X ",addr_);
+
   return 0xBADACCE5;
 }
 
-static void mwriteb(uint32_t addr_, uint8_t  val_)
+static
+void
+arm_io_writeb(const uint32_t addr_,
+              const uint8_t  val_)
 {
-  int32_t index;
+  const uint32_t io = arm_mem_io(addr_);
+  const int log = opera_log_on(opera_log_region(addr_));
 
-  if (addr_>=0x03100000 && addr_<=0x034FFFFF && addr_!=0x03400034) fprintf(logfile, "Addr: 0x%08X ", addr_);
-  print_to_log(addr_, val_, 1, CPU.USER[15]); // Address, Value, 0=read, 1=write.
-  if (addr_ >= 0x03100000 && addr_ <= 0x034FFFFF && addr_!=0x03400034) fprintf(logfile, "Write: 0x%08X  (PC: 0x%08X)\n", val_, CPU.USER[15]);
+  if(io == ARM_MEM_IO_VRAM)
+    {
+      opera_mem_write8(addr_ ^ 3,val_);
+      return;
+    }
 
-  if(addr_ < 0x00300000)
-  {
-    //fprintf(logfile, "Addr: 0x%08X ", addr_);
-    //fprintf(logfile, "???          Write byte: 0x%08X \n", val_);
-    opera_mem_write8(addr_ ^ 3,val_);
-    return;
-  }
+  arm_jit_stop = 1;
 
-  index = (addr_ ^ 0x03100003);
-  if(!(index & ~0xFFFFF))
-  {
-     if((index & 0x40000) == 0x40000)
-     {
-        fprintf(logfile, "Addr: 0x%08X ", addr_); /*fprintf(logfile, "NVRAM            Write byte: 0x%08X  (PC: 0x%08X)\n", val_, CPU.USER[15]);*/
-        CPU.nvram[(index >> 2) & 0x7FFF] = val_;
-        return;
-     }
-     else fprintf(logfile, "\n");
-  }
+  if(log)
+    {
+      arm_io_log_addr(addr_,val_,1);
+      if(addr_ != 0x03400034)
+        fprintf(opera_logfile,"Write: 0x%08X  (PC: 0x%08X)\n",val_,CPU.USER[15]);
+    }
+
+  if(io == ARM_MEM_IO_SLOW)
+    {
+      const uint32_t index = (addr_ ^ 0x03100003);
+
+      if(index & 0x40000)
+        {
+          if(log)
+            fprintf(opera_logfile,"Addr: 0x%08X ",addr_);
+          CPU.nvram[(index >> 2) & 0x7FFF] = val_;
+        }
+      else if(log)
+        {
+          fprintf(opera_logfile,"\n");
+        }
+    }
 }
 
+/*
+  The fast paths: one table lookup, and host memory for DRAM, VRAM
+  (reads) and ROM. Words are native endian in host memory, bytes are
+  at addr ^ 3, same as opera_mem_*().
+*/
 static
+INLINE
 uint32_t
-mreadb(uint32_t addr_)
+mreadw(uint32_t addr_)
 {
-  int32_t index;
+  const uint8_t *host;
+  const uint32_t page = (addr_ >> ARM_MEM_PAGE_SHIFT);
 
-  // Can't easily grab read_wrote before the return, so the fprintf's below will handle printing the read value to the logfile.
-  if (addr_>=0x03100000 && addr_<=0x034FFFFF && addr_!=0x03400034) fprintf(logfile, "Addr: 0x%08X ", addr_);
-  print_to_log(addr_, 0x00000000, 0, CPU.USER[15]); // 0=read, 1=write.
+  addr_ &= ~3;
+  arm_io_log_pc();
 
-  if (addr_ < 0x00300000) {
-    uint32_t byte_word = opera_mem_read8(addr_ ^ 3);
-    //fprintf(logfile, "Addr: 0x%08X ", addr_); fprintf(logfile, "???          Read byte: 0x%02X  (PC: 0x%08X)\n", byte_word, CPU.USER[15]);
-    return byte_word;
-  }
+  host = ((page < ARM_MEM_PAGES) ? g_MEM_READ[page] : NULL);
+  if(host)
+    return *(const uint32_t*)&host[addr_ & ARM_MEM_PAGE_MASK];
+
+  return arm_io_readw(addr_);
+}
 
-  /* Standard ROM */
-  index = (addr_ ^ 0x03000003);
-  if(!(index & ~0xFFFFF))
-    return CPU.rom[index];
+static
+INLINE
+void
+mwritew(uint32_t addr_,
+        uint32_t val_)
+{
+  uint8_t *host;
+  const uint32_t page = (addr_ >> ARM_MEM_PAGE_SHIFT);
 
-  /* ANVIL ROM */
-  index = (addr_ ^ 0x06000003);
-  if(!(index & ~0xFFFFF))
-    return CPU.rom[index];
+  addr_ &= ~3;
+  arm_io_log_pc();
 
-  index = (addr_ ^ 0x03100003);
-  if(!(index & ~0xFFFFF))
+  host = ((page < ARM_MEM_PAGES) ? g_MEM_WRITE[page] : NULL);
+  if(host)
     {
-     if ((index & 0x40000) == 0x40000) {
-         uint32_t byte_word = CPU.nvram[(index >> 2) & 0x7FFF];
-         //fprintf(logfile, "Addr: 0x%08X ", addr_); fprintf(logfile, "???          Read byte: 0x%02X  (PC: 0x%08X)\n", byte_word, CPU.USER[15]);
-         return byte_word;
-     }
-      else fprintf(logfile, "\n");
+      opera_arm_icache_write(addr_);
+      *(uint32_t*)&host[addr_ & ARM_MEM_PAGE_MASK] = val_;
+      return;
     }
 
-  /* MAS_Access_Exept = TRUE; */
+  arm_io_writew(addr_,val_);
+}
 
-  fprintf(logfile, "Addr: 0x%08X ", addr_); /*fprintf(logfile, "???          Read byte: 0x%02X  (PC: 0x%08X)\n", 0xBADACCE5, CPU.USER[15]);*/
-  return 0xBADACCE5;
+static
+INLINE
+uint32_t
+mreadb(uint32_t addr_)
+{
+  const uint8_t *host;
+  const uint32_t page = (addr_ >> ARM_MEM_PAGE_SHIFT);
+
+  host = ((page < ARM_MEM_PAGES) ? g_MEM_READ[page] : NULL);
+  if(host)
+    return host[(addr_ & ARM_MEM_PAGE_MASK) ^ 3];
+
+  return arm_io_readb(addr_);
+}
+
+static
+INLINE
+void
+mwriteb(uint32_t addr_,
+        uint8_t  val_)
+{
+  uint8_t *host;
+  const uint32_t page = (addr_ >> ARM_MEM_PAGE_SHIFT);
+
+  host = ((page < ARM_MEM_PAGES) ? g_MEM_WRITE[page] : NULL);
+  if(host)
+    {
+      opera_arm_icache_write(addr_);
+      host[(addr_ & ARM_MEM_PAGE_MASK) ^ 3] = val_;
+      return;
+    }
+
+  arm_io_writeb(addr_,val_);
 }
 
 static
@@ -35,6 +35,7 @@
 #include <stdio.h>
 
 #include "extern_c.h"
+#include "inline.h"
 
 #include "opera_arm_core.h"
 
@@ -44,7 +45,7 @@ EXTERN_C_BEGIN
 
 static uint32_t* g_VIDEO_BUFFER;
 
-arm_core_t CPU;
+extern arm_core_t CPU;
 
 int32_t  opera_arm_execute(void);
 void     opera_arm_init(void);
@@ -87,6 +88,90 @@ uint64_t opera_arm_vram_size(void);
 void     opera_arm_swi_hle_set(const int hle);
 int      opera_arm_swi_hle_get(void);
 
+/*
+  Per-SWI call counts and timings, sorted busiest first (by cycles).
+  hist[n] counts calls that took under 2^n cycles (and at least
+  2^(n-1)), the last one everything over. HLE'd calls count as 0.
+*/
+#define OPERA_ARM_SWI_PROF_BUCKETS 24
+
+typedef struct opera_arm_swi_prof_s opera_arm_swi_prof_t;
+struct opera_arm_swi_prof_s
+{
+  uint32_t swi;
+  uint32_t calls;
+  uint32_t hle;
+  uint64_t cycles;
+  uint32_t hist[OPERA_ARM_SWI_PROF_BUCKETS];
+};
+
+void     opera_arm_swi_prof_set(const int on);
+void     opera_arm_swi_prof_clear(void);
+uint32_t opera_arm_swi_prof_get(opera_arm_swi_prof_t *prof, const uint32_t max);
+
+/*
+  The core works the NZCV bits of CPU.CPSR out lazily. Call this before
+  reading CPU.CPSR from outside the core.
+*/
+void     opera_arm_flags_sync(void);
+
+/*
+  Idle loop skipping. With it on, the interpreter watches short loops
+  that write nothing and only read memory and the quiet CLIO registers
+  (vcnt, the IRQ bits, the timers). When the core is at the top of one
+  that came back round unchanged last time, opera_arm_idle_loop() gives
+  the cycles each instruction of that trip took, n_ of them, and those
+  trips can go straight on the clock: nothing changes until a line,
+  timer tick, DSP sample or CEL list, which have to call
+  opera_arm_idle_break(). NULL the rest of the time, and always with
+  idle skipping off. serial_ only changes when the cycles do, so
+  anything worked out from them can be kept until it does.
+*/
+void           opera_arm_idle_set(const int on_);
+int            opera_arm_idle_get(void);
+const int32_t *opera_arm_idle_loop(uint32_t *n_, uint32_t *serial_);
+void           opera_arm_idle_break(void);
+
+/*
+  x86-64 JIT (opera_arm_jit.c). opera_arm_execute_jit() runs ARM code
+  until at least budget_ cycles have gone, or it touches I/O, with the
+  same results as calling opera_arm_execute() that many times. It just
+  falls back to opera_arm_execute() while the JIT is off, and
+  opera_arm_jit_set() says whether it could be turned on. (Not in builds
+  with OPERA_ARM_JIT 0, or without executable memory.)
+
+  opera_arm_jit_break() makes it stop whenever the PC gets to pc_.
+  0xFFFFFFFF for none.
+*/
+int32_t  opera_arm_execute_jit(const int32_t budget_);
+int      opera_arm_jit_set(const int on_);
+int      opera_arm_jit_get(void);
+void     opera_arm_jit_break(const uint32_t pc_);
+
+/*
+  Decoded instruction cache (see opera_arm.c). Anything that writes
+  DRAM without going through opera_mem_write*() has to call
+  opera_arm_icache_write(), so code it overwrites gets decoded again.
+*/
+#define OPERA_ARM_ICACHE_PAGE_SHIFT 10
+#define OPERA_ARM_ICACHE_DRAM_PAGES ((2 * 1024 * 1024) >> OPERA_ARM_ICACHE_PAGE_SHIFT)
+
+extern uint8_t opera_arm_icache_live[OPERA_ARM_ICACHE_DRAM_PAGES];
+
+void     opera_arm_icache_drop(uint32_t page_);
+void     opera_arm_icache_flush(void);
+
+static
+INLINE
+void
+opera_arm_icache_write(const uint32_t addr_)
+{
+  const uint32_t page = (addr_ >> OPERA_ARM_ICACHE_PAGE_SHIFT);
+
+  if((page < OPERA_ARM_ICACHE_DRAM_PAGES) && opera_arm_icache_live[page])
+    opera_arm_icache_drop(page);
+}
+
 EXTERN_C_END
 
 #endif /* LIBOPERA_ARM_H_INCLUDED */
@@ -0,0 +1,81 @@
+#ifndef LIBOPERA_ARM_I_H_INCLUDED
+#define LIBOPERA_ARM_I_H_INCLUDED
+
+#include "inline.h"
+#include "opera_arm.h"
+
+#include <stdint.h>
+
+/*
+  What opera_arm.c shares with the JIT (opera_arm_jit.c): the decoded
+  instruction cache, and the few bits of core state the translated code
+  pokes directly.
+*/
+
+#define ICACHE_PAGE_OPS   (1 << (OPERA_ARM_ICACHE_PAGE_SHIFT - 2))
+#define ICACHE_DRAM_PAGES OPERA_ARM_ICACHE_DRAM_PAGES
+#define ICACHE_ROM_PAGES  ((1024 * 1024) >> OPERA_ARM_ICACHE_PAGE_SHIFT)
+#define ICACHE_PAGES      (ICACHE_DRAM_PAGES + ICACHE_ROM_PAGES)
+
+/* What the JIT can do with an op, worked out along with the rest of it in arm_decode(). */
+enum arm_op_kind_e
+  {
+    ARM_OP_KIND_CALL,           /* call the handler, carry on unless it touched I/O or the PC */
+    ARM_OP_KIND_END,            /* call the handler, then back to the dispatcher (may change CPSR) */
+    ARM_OP_KIND_ALU_IMM,        /* AND / EOR / SUB / RSB / ADD / ORR / MOV / BIC / MVN, or a compare, */
+    ARM_OP_KIND_ALU_REG,        /* with an immediate or an unshifted register. No r15 anywhere. */
+    ARM_OP_KIND_B,
+    ARM_OP_KIND_BL
+  };
+
+typedef struct arm_op_s arm_op_t;
+typedef void (*arm_op_handler_t)(const arm_op_t *op_);
+
+struct arm_op_s
+{
+  arm_op_handler_t handler;
+  uint32_t cmd;
+  uint32_t imm;                 /* rotated ALU immediate, signed SDT offset, or branch offset */
+  uint16_t gen;                 /* valid while it matches its page's gen */
+  uint16_t cond;                /* cond_flags_cross[] entry */
+  uint8_t  rn;                  /* bits 16-19 */
+  uint8_t  rd;                  /* bits 12-15 */
+  uint8_t  rs;                  /* bits 8-11 */
+  uint8_t  rm;                  /* bits 0-3 */
+  uint8_t  shift;               /* immediate shift amount and type, #0 cases sorted out */
+  uint8_t  shtype;
+  uint8_t  alu;                 /* ALU opcode and S bit, bits 20-24 */
+  uint8_t  kind;                /* arm_op_kind_e */
+};
+
+/* Which icache page addr_ is in. ICACHE_PAGES if it's not DRAM or ROM. */
+static
+INLINE
+uint32_t
+arm_icache_page(const uint32_t addr_)
+{
+  if(addr_ < (ICACHE_DRAM_PAGES << OPERA_ARM_ICACHE_PAGE_SHIFT))
+    return (addr_ >> OPERA_ARM_ICACHE_PAGE_SHIFT);
+  if(!((addr_ ^ 0x03000000) & ~0xFFFFF) || !((addr_ ^ 0x06000000) & ~0xFFFFF))
+    return (ICACHE_DRAM_PAGES + ((addr_ & 0xFFFFF) >> OPERA_ARM_ICACHE_PAGE_SHIFT));
+  return ICACHE_PAGES;
+}
+
+/* opera_arm.c */
+const arm_op_t *arm_icache_op(const uint32_t addr_);
+int32_t        *arm_cycles_ptr(void);
+uint32_t       *arm_carry_out_ptr(void);
+uint32_t        arm_idle_loop(const uint32_t head_);
+int             arm_idle_claim(const uint32_t head_);
+
+/* Set by anything the translated code has to stop for: I/O, and dropped icache pages. */
+extern uint8_t arm_jit_stop;
+
+/* opera_arm_jit.c */
+int             arm_jit_init(void);
+void            arm_jit_destroy(void);
+void            arm_jit_drop(const uint32_t page_);
+void            arm_jit_flush(void);
+int32_t         arm_jit_run(const uint32_t pc_, const uint32_t break_, const int32_t budget_);
+
+#endif /* LIBOPERA_ARM_I_H_INCLUDED */
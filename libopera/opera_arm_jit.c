@@ -0,0 +1,1020 @@
+/*
+  x86-64 JIT for the ARM60 core.
+
+  Translates straight runs of ARM code from the decoded instruction cache
+  (up to an unconditional branch or anything else that always leaves,
+  the end of the icache page, or ARM_JIT_MAX_OPS instructions) into host
+  code. Nothing clever: the ARM registers and CPSR stay in CPU, and most
+  instructions are still a call to their arm_op_t handler. The flags are
+  always kept real in CPSR in here: the interpreter's lazy ones get synced
+  on the way in, and after any handler that might have left some pending. What goes is
+  the fetch, the dispatch and the condition check, and the simple ALU
+  ops, the compares and the branches are done inline.
+
+  Cycles are counted as opera_arm_execute() does: CYCLES is set to
+  -SCYCLE before each handler, and whatever it ends up at gets added on.
+  The budget is checked after every instruction, so a block stops on
+  exactly the instruction the interpreter loop would have.
+
+  Blocks are kept per icache page, and dropped along with it. After each
+  handler the block checks arm_jit_stop (set on I/O, and on any page
+  drop) and the PC, and leaves if either says so. So a store into the
+  block's own code takes effect from the next instruction, same as in
+  the interpreter. Pages that keep getting written to in between being
+  run (code and data sharing a page, or self-modifying code) get left
+  to the interpreter.
+
+  Registers inside translated code:
+    rbx   &CPU.USER[0]
+    rbp   &arm_jit_stop
+    r12d  cycles so far
+    r13d  budget
+    r14   &CYCLES
+    r15   &carry_out
+*/
+
+#include "opera_arm.h"
+#include "opera_arm_core.h"
+#include "opera_arm_i.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef OPERA_ARM_JIT
+#if defined(__x86_64__) || defined(_M_X64)
+#define OPERA_ARM_JIT 1
+#else
+#define OPERA_ARM_JIT 0
+#endif
+#endif
+
+#if OPERA_ARM_JIT
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#define ARM_JIT_CODE_SIZE (16 * 1024 * 1024)
+#define ARM_JIT_MAX_OPS   128
+#define ARM_JIT_OP_BYTES  160   /* more than any one op needs */
+#define ARM_JIT_MAX_SMC   8     /* drops of a page with live blocks, before it's left to the interpreter */
+#define ARM_JIT_THRASH    (4 * (uint64_t)ARM_JIT_CODE_SIZE)   /* fewer cycles than this per buffer-full... */
+#define ARM_JIT_BACKOFF   (16 * 1024 * 1024)                  /* ...and this many instructions get interpreted */
+
+#define NCYCLE 4
+#define SCYCLE 1
+
+typedef struct arm_jit_block_s arm_jit_block_t;
+struct arm_jit_block_s
+{
+  const uint8_t *code;
+  uint32_t       pc;
+  uint32_t       gen;
+  uint32_t       idle;          /* starts a loop the interpreter might want to watch (arm_idle_loop()) */
+};
+
+typedef struct arm_jit_page_s arm_jit_page_t;
+struct arm_jit_page_s
+{
+  uint32_t        gen;
+  uint32_t        smc;
+  uint32_t        live;         /* anything translated since the last drop */
+  arm_jit_block_t blocks[ICACHE_PAGE_OPS];
+};
+
+typedef int32_t (*arm_jit_enter_t)(int32_t budget_, const uint8_t *code_);
+
+static arm_jit_page_t  *g_JIT_PAGES[ICACHE_PAGES];
+static uint8_t         *g_JIT_CODE;
+static uint8_t         *g_JIT_START;   /* first block, after the entry / exit code */
+static uint8_t         *g_JIT_PTR;     /* where the next one goes */
+static uint8_t         *g_JIT_EXIT;
+static uint64_t         g_JIT_CYCLES;  /* run in translated code since the buffer was last full */
+static uint32_t         g_JIT_COLD;    /* arm_jit_run() calls left to turn down */
+static arm_jit_enter_t  g_JIT_ENTER;
+
+//--------------------------x86-64 encoding--------------------------------------
+
+enum x64_reg_e
+  {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8,  R9,  R10, R11, R12, R13, R14, R15
+  };
+
+#ifdef _WIN32
+#define ARG0   RCX
+#define ARG1   RDX
+#define SHADOW 32
+#else
+#define ARG0   RDI
+#define ARG1   RSI
+#define SHADOW 0
+#endif
+
+/* "reg, r/m" opcodes, and their 0x81 group numbers for the immediate forms. */
+#define X64_ADD 0x03
+#define X64_OR  0x0B
+#define X64_AND 0x23
+#define X64_SUB 0x2B
+#define X64_XOR 0x33
+#define X64_CMP 0x3B
+#define X64_MOV 0x8B
+
+#define X64_ADD_I 0
+#define X64_OR_I  1
+#define X64_AND_I 4
+#define X64_SUB_I 5
+#define X64_XOR_I 6
+#define X64_CMP_I 7
+
+/* Condition codes. */
+#define X64_O  0x0
+#define X64_B  0x2
+#define X64_AE 0x3
+#define X64_E  0x4
+#define X64_NE 0x5
+#define X64_S  0x8
+#define X64_L  0xC
+
+#define REG(n_)  ((int32_t)((n_) * 4))
+#define CPSR_OFS ((int32_t)(offsetof(arm_core_t,CPSR) - offsetof(arm_core_t,USER)))
+
+static
+INLINE
+void
+x64_u8(const uint8_t v_)
+{
+  *g_JIT_PTR++ = v_;
+}
+
+static
+INLINE
+void
+x64_u32(const uint32_t v_)
+{
+  memcpy(g_JIT_PTR,&v_,4);
+  g_JIT_PTR += 4;
+}
+
+static
+INLINE
+void
+x64_u64(const uint64_t v_)
+{
+  memcpy(g_JIT_PTR,&v_,8);
+  g_JIT_PTR += 8;
+}
+
+/* REX, if one's needed. w_ for 64 bit, r_ the ModRM reg field, b_ the r/m or base. */
+static
+void
+x64_rex(const int w_,
+        const int r_,
+        const int b_)
+{
+  const uint8_t rex = (0x40 | (w_ ? 8 : 0) | ((r_ & 8) ? 4 : 0) | ((b_ & 8) ? 1 : 0));
+
+  if(rex != 0x40)
+    x64_u8(rex);
+}
+
+/* ModRM for [base_ + disp_]. No SIB, so base_ can't be rsp or r12. */
+static
+void
+x64_mem(const int     r_,
+        const int     base_,
+        const int32_t disp_)
+{
+  if((disp_ == 0) && ((base_ & 7) != 5))
+    {
+      x64_u8(((r_ & 7) << 3) | (base_ & 7));
+    }
+  else if((disp_ >= -128) && (disp_ <= 127))
+    {
+      x64_u8(0x40 | ((r_ & 7) << 3) | (base_ & 7));
+      x64_u8((uint8_t)disp_);
+    }
+  else
+    {
+      x64_u8(0x80 | ((r_ & 7) << 3) | (base_ & 7));
+      x64_u32((uint32_t)disp_);
+    }
+}
+
+static
+void
+x64_modrm_reg(const int r_,
+              const int rm_)
+{
+  x64_u8(0xC0 | ((r_ & 7) << 3) | (rm_ & 7));
+}
+
+/* op r32, [base_ + disp_] */
+static
+void
+x64_op_load(const uint8_t op_,
+            const int     r_,
+            const int     base_,
+            const int32_t disp_)
+{
+  x64_rex(0,r_,base_);
+  x64_u8(op_);
+  x64_mem(r_,base_,disp_);
+}
+
+/* op r32, r32 */
+static
+void
+x64_op_reg(const uint8_t op_,
+           const int     r_,
+           const int     rm_)
+{
+  x64_rex(0,r_,rm_);
+  x64_u8(op_);
+  x64_modrm_reg(r_,rm_);
+}
+
+/* op r32, imm32 */
+static
+void
+x64_op_imm(const int      ext_,
+           const int      r_,
+           const uint32_t imm_)
+{
+  x64_rex(0,0,r_);
+  x64_u8(0x81);
+  x64_modrm_reg(ext_,r_);
+  x64_u32(imm_);
+}
+
+/* mov [base_ + disp_], r32 */
+static
+void
+x64_store(const int     base_,
+          const int32_t disp_,
+          const int     r_)
+{
+  x64_rex(0,r_,base_);
+  x64_u8(0x89);
+  x64_mem(r_,base_,disp_);
+}
+
+/* mov dword [base_ + disp_], imm32 */
+static
+void
+x64_store_imm(const int      base_,
+              const int32_t  disp_,
+              const uint32_t imm_)
+{
+  x64_rex(0,0,base_);
+  x64_u8(0xC7);
+  x64_mem(0,base_,disp_);
+  x64_u32(imm_);
+}
+
+/* cmp byte [base_ + disp_], imm8 */
+static
+void
+x64_cmp8_imm(const int     base_,
+             const int32_t disp_,
+             const uint8_t imm_)
+{
+  x64_rex(0,0,base_);
+  x64_u8(0x80);
+  x64_mem(7,base_,disp_);
+  x64_u8(imm_);
+}
+
+/* cmp dword [base_ + disp_], imm32 */
+static
+void
+x64_cmp_imm(const int      base_,
+            const int32_t  disp_,
+            const uint32_t imm_)
+{
+  x64_rex(0,0,base_);
+  x64_u8(0x81);
+  x64_mem(7,base_,disp_);
+  x64_u32(imm_);
+}
+
+static
+void
+x64_mov_imm(const int      r_,
+            const uint32_t imm_)
+{
+  x64_rex(0,0,r_);
+  x64_u8(0xB8 | (r_ & 7));
+  x64_u32(imm_);
+}
+
+static
+void
+x64_mov_imm64(const int      r_,
+              const uint64_t imm_)
+{
+  x64_rex(1,0,r_);
+  x64_u8(0xB8 | (r_ & 7));
+  x64_u64(imm_);
+}
+
+static
+void
+x64_not(const int r_)
+{
+  x64_rex(0,0,r_);
+  x64_u8(0xF7);
+  x64_modrm_reg(2,r_);
+}
+
+static
+void
+x64_shl(const int     r_,
+        const uint8_t n_)
+{
+  x64_rex(0,0,r_);
+  x64_u8(0xC1);
+  x64_modrm_reg(4,r_);
+  x64_u8(n_);
+}
+
+static
+void
+x64_shr(const int     r_,
+        const uint8_t n_)
+{
+  x64_rex(0,0,r_);
+  x64_u8(0xC1);
+  x64_modrm_reg(5,r_);
+  x64_u8(n_);
+}
+
+/* setcc r8, then movzx r32 of it. (Only ever al, cl, dl or r8b, so no REX needed for the byte regs.) */
+static
+void
+x64_setcc(const int cc_,
+          const int r_)
+{
+  x64_rex(0,0,r_);
+  x64_u8(0x0F);
+  x64_u8(0x90 | cc_);
+  x64_modrm_reg(0,r_);
+}
+
+static
+void
+x64_movzx8(const int r_)
+{
+  x64_rex(0,r_,r_);
+  x64_u8(0x0F);
+  x64_u8(0xB6);
+  x64_modrm_reg(r_,r_);
+}
+
+/* bt r_, bit_ */
+static
+void
+x64_bt(const int r_,
+       const int bit_)
+{
+  x64_rex(0,bit_,r_);
+  x64_u8(0x0F);
+  x64_u8(0xA3);
+  x64_modrm_reg(bit_,r_);
+}
+
+static
+void
+x64_call(const int r_)
+{
+  x64_rex(0,0,r_);
+  x64_u8(0xFF);
+  x64_modrm_reg(2,r_);
+}
+
+static
+void
+x64_push(const int r_)
+{
+  x64_rex(0,0,r_);
+  x64_u8(0x50 | (r_ & 7));
+}
+
+static
+void
+x64_pop(const int r_)
+{
+  x64_rex(0,0,r_);
+  x64_u8(0x58 | (r_ & 7));
+}
+
+/* jmp / jcc rel32. They return where the rel32 is, for x64_patch(). */
+static
+uint8_t*
+x64_jmp(void)
+{
+  uint8_t *rel;
+
+  x64_u8(0xE9);
+  rel = g_JIT_PTR;
+  x64_u32(0);
+
+  return rel;
+}
+
+static
+uint8_t*
+x64_jcc(const int cc_)
+{
+  uint8_t *rel;
+
+  x64_u8(0x0F);
+  x64_u8(0x80 | cc_);
+  rel = g_JIT_PTR;
+  x64_u32(0);
+
+  return rel;
+}
+
+static
+void
+x64_patch(uint8_t       *rel_,
+          const uint8_t *to_)
+{
+  const int32_t d = (int32_t)(to_ - (rel_ + 4));
+
+  memcpy(rel_,&d,4);
+}
+
+static
+void
+x64_jmp_to(const uint8_t *to_)
+{
+  x64_patch(x64_jmp(),to_);
+}
+
+static
+void
+x64_jcc_to(const int      cc_,
+           const uint8_t *to_)
+{
+  x64_patch(x64_jcc(cc_),to_);
+}
+
+//--------------------------Translation------------------------------------------
+
+/* Back to the dispatcher with the PC at pc_. */
+static
+void
+arm_jit_leave(const uint32_t pc_)
+{
+  x64_store_imm(RBX,REG(15),pc_);
+  x64_jmp_to(g_JIT_EXIT);
+}
+
+/* After every instruction: leave if the budget's gone. */
+static
+void
+arm_jit_budget(const uint32_t next_)
+{
+  uint8_t *more;
+
+  x64_op_reg(X64_CMP,R12,R13);
+  more = x64_jcc(X64_L);
+  arm_jit_leave(next_);
+  x64_patch(more,g_JIT_PTR);
+}
+
+/* NZCV into CPSR, off the x86 flags of a cmp (c_ = X64_AE) or add (X64_B). */
+static
+void
+arm_jit_nzcv(const int c_)
+{
+  x64_setcc(X64_S,RAX);
+  x64_setcc(X64_E,RCX);
+  x64_setcc(c_,RDX);
+  x64_setcc(X64_O,R8);
+  x64_movzx8(RAX);
+  x64_shl(RAX,31);
+  x64_movzx8(RCX);
+  x64_shl(RCX,30);
+  x64_op_reg(X64_OR,RAX,RCX);
+  x64_movzx8(RDX);
+  x64_shl(RDX,29);
+  x64_op_reg(X64_OR,RAX,RDX);
+  x64_movzx8(R8);
+  x64_shl(R8,28);
+  x64_op_reg(X64_OR,RAX,R8);
+  x64_op_load(X64_MOV,RCX,RBX,CPSR_OFS);
+  x64_op_imm(X64_AND_I,RCX,0x0FFFFFFF);
+  x64_op_reg(X64_OR,RCX,RAX);
+  x64_store(RBX,CPSR_OFS,RCX);
+}
+
+/* NZ off the x86 flags of an and / xor, and C from carry_out, as TST / TEQ do. */
+static
+void
+arm_jit_nz(void)
+{
+  x64_setcc(X64_S,RAX);
+  x64_setcc(X64_E,RCX);
+  x64_movzx8(RAX);
+  x64_shl(RAX,31);
+  x64_movzx8(RCX);
+  x64_shl(RCX,30);
+  x64_op_reg(X64_OR,RAX,RCX);
+  x64_op_load(X64_MOV,RCX,RBX,CPSR_OFS);
+  x64_op_imm(X64_AND_I,RCX,0x1FFFFFFF);
+  x64_op_load(X64_MOV,RDX,R15,0);
+  x64_op_imm(X64_AND_I,RDX,1);
+  x64_shl(RDX,29);
+  x64_op_reg(X64_OR,RCX,RDX);
+  x64_op_reg(X64_OR,RCX,RAX);
+  x64_store(RBX,CPSR_OFS,RCX);
+}
+
+/* The ARM_OP_KIND_ALU_* ops. Same as their arm_op_alu_*_table handlers. */
+static
+void
+arm_jit_alu(const arm_op_t *op_)
+{
+  int op;
+  int ext;
+  const int imm = (op_->kind == ARM_OP_KIND_ALU_IMM);
+
+  /* carry_out = C, as ARM_SHIFT_NSC() would have. */
+  if(!imm)
+    {
+      x64_op_load(X64_MOV,RCX,RBX,CPSR_OFS);
+      x64_shr(RCX,29);
+      x64_op_imm(X64_AND_I,RCX,1);
+      x64_store(R15,0,RCX);
+    }
+
+  switch(op_->alu)
+    {
+    case 0x1A:                  /* MOV */
+      if(imm)
+        {
+          x64_store_imm(RBX,REG(op_->rd),op_->imm);
+          return;
+        }
+      x64_op_load(X64_MOV,RAX,RBX,REG(op_->rm));
+      break;
+    case 0x1E:                  /* MVN */
+      if(imm)
+        {
+          x64_store_imm(RBX,REG(op_->rd),~op_->imm);
+          return;
+        }
+      x64_op_load(X64_MOV,RAX,RBX,REG(op_->rm));
+      x64_not(RAX);
+      break;
+    case 0x06:                  /* RSB */
+      if(imm)
+        x64_mov_imm(RAX,op_->imm);
+      else
+        x64_op_load(X64_MOV,RAX,RBX,REG(op_->rm));
+      x64_op_load(X64_SUB,RAX,RBX,REG(op_->rn));
+      break;
+    case 0x1C:                  /* BIC */
+      if(imm)
+        {
+          x64_op_load(X64_MOV,RAX,RBX,REG(op_->rn));
+          x64_op_imm(X64_AND_I,RAX,~op_->imm);
+        }
+      else
+        {
+          x64_op_load(X64_MOV,RAX,RBX,REG(op_->rm));
+          x64_not(RAX);
+          x64_op_load(X64_AND,RAX,RBX,REG(op_->rn));
+        }
+      break;
+    default:
+      switch(op_->alu)
+        {
+        case 0x00: op = X64_AND; ext = X64_AND_I; break;
+        case 0x02: op = X64_XOR; ext = X64_XOR_I; break;
+        case 0x04: op = X64_SUB; ext = X64_SUB_I; break;
+        case 0x08: op = X64_ADD; ext = X64_ADD_I; break;
+        case 0x18: op = X64_OR;  ext = X64_OR_I;  break;
+        case 0x11: op = X64_AND; ext = X64_AND_I; break;    /* TST */
+        case 0x13: op = X64_XOR; ext = X64_XOR_I; break;    /* TEQ */
+        case 0x15: op = X64_CMP; ext = X64_CMP_I; break;    /* CMP */
+        default:   op = X64_ADD; ext = X64_ADD_I; break;    /* CMN */
+        }
+
+      x64_op_load(X64_MOV,RAX,RBX,REG(op_->rn));
+      if(imm)
+        x64_op_imm(ext,RAX,op_->imm);
+      else
+        x64_op_load(op,RAX,RBX,REG(op_->rm));
+
+      switch(op_->alu)
+        {
+        case 0x11:
+        case 0x13:
+          arm_jit_nz();
+          return;
+        case 0x15:
+          arm_jit_nzcv(X64_AE);
+          return;
+        case 0x17:
+          arm_jit_nzcv(X64_B);
+          return;
+        }
+      break;
+    }
+
+  x64_store(RBX,REG(op_->rd),RAX);
+}
+
+/* Data processing and multiplies with the S bit. */
+static
+INLINE
+int
+arm_jit_sets_flags(const uint32_t cmd_)
+{
+  return (((cmd_ & 0x0C000000) == 0) && (cmd_ & (1 << 20)));
+}
+
+/*
+  One instruction at pc_. loop_ is where a branch back to the start of the
+  block can go straight to, NULL if it can't. Returns 1 if the block always
+  leaves here, so there's no point going on.
+*/
+static
+int
+arm_jit_op(const arm_op_t *op_,
+           const uint32_t  pc_,
+           const uint32_t  start_,
+           const uint8_t  *loop_)
+{
+  uint8_t *fail;
+  uint8_t *done;
+  uint32_t target;
+  const int always = (op_->cond == 0xFFFF);
+
+  if(op_->cond == 0x0000)
+    {
+      x64_op_imm(X64_ADD_I,R12,SCYCLE);
+      arm_jit_budget(pc_ + 4);
+      return 0;
+    }
+
+  fail = NULL;
+  if(!always)
+    {
+      x64_op_load(X64_MOV,RAX,RBX,CPSR_OFS);
+      x64_shr(RAX,28);
+      x64_mov_imm(RCX,op_->cond);
+      x64_bt(RCX,RAX);
+      fail = x64_jcc(X64_AE);
+    }
+
+  switch(op_->kind)
+    {
+    case ARM_OP_KIND_ALU_IMM:
+    case ARM_OP_KIND_ALU_REG:
+      arm_jit_alu(op_);
+      if(fail)
+        x64_patch(fail,g_JIT_PTR);
+      x64_op_imm(X64_ADD_I,R12,SCYCLE);
+      arm_jit_budget(pc_ + 4);
+      return 0;
+
+    case ARM_OP_KIND_B:
+    case ARM_OP_KIND_BL:
+      if(op_->kind == ARM_OP_KIND_BL)
+        x64_store_imm(RBX,REG(14),pc_ + 4);
+      x64_op_imm(X64_ADD_I,R12,SCYCLE + SCYCLE + NCYCLE);
+      target = (pc_ + 4 + op_->imm);
+      if(loop_ && (target == start_))
+        {
+          x64_op_reg(X64_CMP,R12,R13);
+          x64_jcc_to(X64_L,loop_);
+        }
+      arm_jit_leave(target);
+      break;
+
+    default:
+      x64_store_imm(RBX,REG(15),pc_ + 4);
+      x64_store_imm(R14,0,(uint32_t)-SCYCLE);
+      x64_mov_imm64(ARG0,(uint64_t)(uintptr_t)op_);
+      x64_mov_imm64(RAX,(uint64_t)(uintptr_t)op_->handler);
+      x64_call(RAX);
+      x64_op_load(X64_SUB,R12,R14,0);
+      if(arm_jit_sets_flags(op_->cmd) && (op_->kind != ARM_OP_KIND_END))
+        {
+          /* The handler only noted the flags. The rest of the block wants them in CPSR. */
+          x64_mov_imm64(RAX,(uint64_t)(uintptr_t)opera_arm_flags_sync);
+          x64_call(RAX);
+        }
+      if(op_->kind == ARM_OP_KIND_END)
+        {
+          x64_jmp_to(g_JIT_EXIT);
+          break;
+        }
+
+      x64_cmp8_imm(RBP,0,0);
+      x64_jcc_to(X64_NE,g_JIT_EXIT);
+      x64_cmp_imm(RBX,REG(15),pc_ + 4);
+      x64_jcc_to(X64_NE,g_JIT_EXIT);
+      if(fail)
+        {
+          done = x64_jmp();
+          x64_patch(fail,g_JIT_PTR);
+          x64_op_imm(X64_ADD_I,R12,SCYCLE);
+          x64_patch(done,g_JIT_PTR);
+        }
+      arm_jit_budget(pc_ + 4);
+      return 0;
+    }
+
+  /* Branches and ARM_OP_KIND_END. Carry on from here if the condition failed. */
+  if(always)
+    return 1;
+
+  x64_patch(fail,g_JIT_PTR);
+  x64_op_imm(X64_ADD_I,R12,SCYCLE);
+  arm_jit_budget(pc_ + 4);
+
+  return 0;
+}
+
+static
+const uint8_t*
+arm_jit_translate(const uint32_t pc_,
+                  const uint32_t break_)
+{
+  uint32_t pc;
+  uint32_t n;
+  uint8_t *start;
+  const uint8_t *loop;
+  const arm_op_t *op;
+
+  start = g_JIT_PTR;
+  loop  = ((pc_ != break_) ? start : NULL);
+
+  pc = pc_;
+  for(n = 0; n < ARM_JIT_MAX_OPS; n++)
+    {
+      if(n && ((pc == break_) ||
+               (pc == 0x94D60) ||
+               !(pc & ((1 << OPERA_ARM_ICACHE_PAGE_SHIFT) - 1))))
+        break;
+
+      op = arm_icache_op(pc);
+      if(op == NULL)
+        break;
+
+      if(arm_jit_op(op,pc,pc_,loop))
+        return start;
+
+      pc += 4;
+    }
+
+  if(n == 0)
+    {
+      g_JIT_PTR = start;
+      return NULL;
+    }
+
+  arm_jit_leave(pc);
+
+  return start;
+}
+
+//--------------------------Blocks-----------------------------------------------
+
+static
+void
+arm_jit_pages_free(void)
+{
+  uint32_t i;
+
+  for(i = 0; i < ICACHE_PAGES; i++)
+    {
+      free(g_JIT_PAGES[i]);
+      g_JIT_PAGES[i] = NULL;
+    }
+}
+
+/* Entry: int32_t enter(int32_t budget_, const uint8_t *code_), and the exit every block jumps to. */
+static
+void
+arm_jit_entry(void)
+{
+  g_JIT_ENTER = (arm_jit_enter_t)(uintptr_t)g_JIT_PTR;
+
+  x64_push(RBP);
+  x64_push(RBX);
+  x64_push(R12);
+  x64_push(R13);
+  x64_push(R14);
+  x64_push(R15);
+  x64_u8(0x48);                 /* sub rsp, 8 + SHADOW (16 byte aligned for the calls) */
+  x64_u8(0x83);
+  x64_u8(0xEC);
+  x64_u8(8 + SHADOW);
+  x64_op_reg(X64_MOV,R13,ARG0);
+  x64_op_reg(X64_XOR,R12,R12);
+  x64_mov_imm64(RBX,(uint64_t)(uintptr_t)&CPU.USER[0]);
+  x64_mov_imm64(RBP,(uint64_t)(uintptr_t)&arm_jit_stop);
+  x64_mov_imm64(R14,(uint64_t)(uintptr_t)arm_cycles_ptr());
+  x64_mov_imm64(R15,(uint64_t)(uintptr_t)arm_carry_out_ptr());
+  x64_rex(0,0,ARG1);            /* jmp ARG1 */
+  x64_u8(0xFF);
+  x64_modrm_reg(4,ARG1);
+
+  g_JIT_EXIT = g_JIT_PTR;
+
+  x64_op_reg(X64_MOV,RAX,R12);
+  x64_u8(0x48);                 /* add rsp, 8 + SHADOW */
+  x64_u8(0x83);
+  x64_u8(0xC4);
+  x64_u8(8 + SHADOW);
+  x64_pop(R15);
+  x64_pop(R14);
+  x64_pop(R13);
+  x64_pop(R12);
+  x64_pop(RBX);
+  x64_pop(RBP);
+  x64_u8(0xC3);
+
+  g_JIT_START = g_JIT_PTR;
+}
+
+int
+arm_jit_init(void)
+{
+  if(g_JIT_CODE)
+    return 1;
+
+#ifdef _WIN32
+  g_JIT_CODE = VirtualAlloc(NULL,ARM_JIT_CODE_SIZE,MEM_COMMIT | MEM_RESERVE,PAGE_EXECUTE_READWRITE);
+#else
+  g_JIT_CODE = mmap(NULL,ARM_JIT_CODE_SIZE,PROT_READ | PROT_WRITE | PROT_EXEC,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+  if(g_JIT_CODE == MAP_FAILED)
+    g_JIT_CODE = NULL;
+#endif
+  if(g_JIT_CODE == NULL)
+    return 0;
+
+  g_JIT_PTR = g_JIT_CODE;
+  arm_jit_entry();
+
+  return 1;
+}
+
+void
+arm_jit_destroy(void)
+{
+  arm_jit_pages_free();
+
+  if(g_JIT_CODE == NULL)
+    return;
+
+#ifdef _WIN32
+  VirtualFree(g_JIT_CODE,0,MEM_RELEASE);
+#else
+  munmap(g_JIT_CODE,ARM_JIT_CODE_SIZE);
+#endif
+  g_JIT_CODE = NULL;
+}
+
+void
+arm_jit_drop(const uint32_t page_)
+{
+  arm_jit_page_t *p;
+
+  p = g_JIT_PAGES[page_];
+  if(p == NULL)
+    return;
+
+  /* Once per drop of translated code, however many writes it took. */
+  p->gen++;
+  if(p->live)
+    p->smc++;
+  p->live = 0;
+}
+
+/* Everything goes. Only ever from outside translated code, as the blocks get written over. */
+void
+arm_jit_flush(void)
+{
+  arm_jit_pages_free();
+
+  if(g_JIT_CODE)
+    g_JIT_PTR = g_JIT_START;
+}
+
+int32_t
+arm_jit_run(const uint32_t pc_,
+            const uint32_t break_,
+            const int32_t  budget_)
+{
+  int32_t n;
+  uint32_t page;
+  arm_jit_page_t *p;
+  arm_jit_block_t *b;
+
+  if((g_JIT_CODE == NULL) || (pc_ & 3))
+    return -1;
+
+  page = arm_icache_page(pc_);
+  if(page == ICACHE_PAGES)
+    return -1;
+
+  p = g_JIT_PAGES[page];
+  if(p == NULL)
+    {
+      p = calloc(1,sizeof(arm_jit_page_t));
+      if(p == NULL)
+        return -1;
+
+      p->gen = 1;
+      g_JIT_PAGES[page] = p;
+    }
+
+  if(p->smc > ARM_JIT_MAX_SMC)
+    return -1;
+
+  b = &p->blocks[(pc_ >> 2) & (ICACHE_PAGE_OPS - 1)];
+  if((b->gen != p->gen) || (b->pc != pc_))
+    {
+      if(g_JIT_COLD)
+        {
+          g_JIT_COLD--;
+          return -1;
+        }
+
+      /*
+        Full. If what's in there hardly got run before it filled up, the
+        code is just passing through (a sweep over a few MB of it), and
+        translating it all again is slower than interpreting it.
+      */
+      if((g_JIT_PTR + (ARM_JIT_MAX_OPS * ARM_JIT_OP_BYTES)) > (g_JIT_CODE + ARM_JIT_CODE_SIZE))
+        {
+          if(g_JIT_CYCLES < ARM_JIT_THRASH)
+            g_JIT_COLD = ARM_JIT_BACKOFF;
+          g_JIT_CYCLES = 0;
+          arm_jit_flush();
+          return arm_jit_run(pc_,break_,budget_);
+        }
+
+      b->code = arm_jit_translate(pc_,break_);
+      if(b->code == NULL)
+        return -1;
+
+      b->pc   = pc_;
+      b->gen  = p->gen;
+      b->idle = (arm_idle_loop(pc_) != 0);
+      p->live = 1;
+    }
+
+  if(b->idle && arm_idle_claim(pc_))
+    return -1;
+
+  n = g_JIT_ENTER(budget_,b->code);
+  g_JIT_CYCLES += n;
+
+  return n;
+}
+
+#else
+
+int
+arm_jit_init(void)
+{
+  return 0;
+}
+
+void
+arm_jit_destroy(void)
+{
+}
+
+void
+arm_jit_drop(const uint32_t page_)
+{
+}
+
+void
+arm_jit_flush(void)
+{
+}
+
+int32_t
+arm_jit_run(const uint32_t pc_,
+            const uint32_t break_,
+            const int32_t  budget_)
+{
+  return -1;
+}
+
+#endif
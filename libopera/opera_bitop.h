@@ -25,26 +25,109 @@
 #define BITOPCLASS_DEFINITION_HEADER
 
 #include <stdint.h>
+#include <string.h>
 
+#include "endianness.h"
 #include "extern_c.h"
+#include "inline.h"
 
 EXTERN_C_BEGIN
 
+/*
+  Reads big endian bitfields out of CEL data in DRAM. Byte k of the
+  data is at buf + (k ^ 3), so each data word is a host word, and a
+  field of up to 32 bits always fits in the 64 bits made of the word
+  it starts in and the one after. Those get loaded in one go and
+  shifted down, with no loop or byte by byte assembly.
+
+  buf has to be word aligned (PDATA always is). As with the old reader,
+  a buf of 0 reads as zeros.
+*/
 struct BitReaderBig
 {
-  uint32_t buf;
-  uint32_t point;
-  int32_t bitpoint;
-  int32_t bitset;
+  const uint8_t *mem;   /* DRAM + buf */
+  uint32_t       buf;
+  uint32_t       pos;   /* bits read so far */
+  uint32_t       live;  /* ~0, or 0 when buf is 0 */
 };
 
-uint32_t BitReaderBig_Read(struct BitReaderBig *bit, uint8_t bits);
+void BitReaderBig_AttachBuffer(struct BitReaderBig *bit, const uint8_t *dram, uint32_t buff);
+
+/* The 64 bits starting at the word pos is in, first bit in bit 63. */
+static
+INLINE
+uint64_t
+BitReaderBig_Window(const struct BitReaderBig *bit_)
+{
+  uint64_t w;
+
+  memcpy(&w,&bit_->mem[(bit_->pos >> 5) << 2],sizeof(w));
+
+#if IS_BIG_ENDIAN
+  return (((uint64_t)SWAP32((uint32_t)(w >> 32)) << 32) | SWAP32((uint32_t)w));
+#else
+  return ((w << 32) | (w >> 32));
+#endif
+}
+
+/* The next bits_ (1 - 32) bits, without reading them. */
+static
+INLINE
+uint32_t
+BitReaderBig_Peek(const struct BitReaderBig *bit_,
+                  const uint32_t             bits_)
+{
+  return ((uint32_t)((BitReaderBig_Window(bit_) << (bit_->pos & 31)) >> (64 - bits_)) & bit_->live);
+}
+
+static
+INLINE
+void
+BitReaderBig_Consume(struct BitReaderBig *bit_,
+                     const uint32_t       bits_)
+{
+  bit_->pos += bits_;
+}
+
+static
+INLINE
+uint32_t
+BitReaderBig_Read(struct BitReaderBig *bit_,
+                  const uint32_t       bits_)
+{
+  uint32_t rv;
+
+  rv = BitReaderBig_Peek(bit_,bits_);
+  BitReaderBig_Consume(bit_,bits_);
 
-void BitReaderBig_AttachBuffer(struct BitReaderBig *bit, uint32_t buff);
+  return rv;
+}
 
-void BitReaderBig_SetBitRate(struct BitReaderBig *bit, uint8_t bits);
+static
+INLINE
+void
+BitReaderBig_Skip(struct BitReaderBig *bit_,
+                  const uint32_t       bits_)
+{
+  bit_->pos += bits_;
+}
+
+/* Byte offset from buf of the next bit, and the bit in that byte. */
+static
+INLINE
+uint32_t
+BitReaderBig_Point(const struct BitReaderBig *bit_)
+{
+  return (bit_->pos >> 3);
+}
 
-void BitReaderBig_Skip(struct BitReaderBig *bit, uint32_t bits);
+static
+INLINE
+uint32_t
+BitReaderBig_BitPoint(const struct BitReaderBig *bit_)
+{
+  return (bit_->pos & 7);
+}
 
 EXTERN_C_END
 
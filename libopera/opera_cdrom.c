@@ -47,6 +47,8 @@ opera_cdrom_get_size_cb_t    CDROM_GET_SIZE;
 opera_cdrom_set_sector_cb_t  CDROM_SET_SECTOR;
 opera_cdrom_read_sector_cb_t CDROM_READ_SECTOR;
 
+volatile uint32_t CDIMAGE_SECTOR;
+
 static
 INLINE
 void
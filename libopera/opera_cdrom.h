@@ -147,7 +147,7 @@ enum CDROM_Commands
 
 EXTERN_C_BEGIN
 
-volatile uint32_t   CDIMAGE_SECTOR;
+extern volatile uint32_t CDIMAGE_SECTOR;
 
 struct toc_entry_s
 {
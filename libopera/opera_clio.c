@@ -121,6 +121,12 @@ opera_clio_timer_clear(uint32_t v204_,
   (void) v20C_;
 }
 
+uint32_t*
+opera_clio_registers(void)
+{
+  return CLIO.regs;
+}
+
 uint32_t
 opera_clio_line_vint0(void)
 {
@@ -600,6 +606,13 @@ timer_disable(const uint32_t timer_)
   CLIO.regs[((timer_ < 8) ? 0x200 : 0x208)] &= ~(DECREMENT << ((timer_ << 2)));
 }
 
+/* Whether opera_clio_timer_execute() would do anything. */
+int
+opera_clio_timers_running(void)
+{
+  return !!((CLIO.regs[0x200] | CLIO.regs[0x208]) & (DECREMENT * 0x11111111));
+}
+
 void
 opera_clio_timer_execute(void)
 {
@@ -40,6 +40,8 @@ EXTERN_C_BEGIN
 void     opera_clio_init(int reason_);
 void     opera_clio_reset(void);
 
+uint32_t *opera_clio_registers(void);
+
 uint32_t opera_clio_line_vint0(void);
 uint32_t opera_clio_line_vint1(void);
 
@@ -61,6 +63,7 @@ void     opera_clio_vcnt_update(int line_, int half_frame_);
 
 uint32_t opera_clio_timer_get_delay(void);
 void     opera_clio_timer_execute(void);
+int      opera_clio_timers_running(void);
 
 uint32_t opera_clio_state_size(void);
 void     opera_clio_state_save(void *buf_);
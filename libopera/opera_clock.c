@@ -24,6 +24,7 @@ struct opera_clock_s
   int32_t  cycles_per_snd;
   int32_t  cycles_per_scanline;
   int32_t  cycles_per_timer;
+  uint64_t now;
 };
 
 static opera_clock_t g_CLOCK;
@@ -146,6 +147,7 @@ opera_clock_init(void)
   g_CLOCK.timer_delay = 0x150;  /* same as the OS will set */
   g_CLOCK.field_size  = NTSC_FIELD_SIZE;
   g_CLOCK.field_rate  = NTSC_FIELD_RATE_1616;
+  g_CLOCK.now         = 0;
 
   recalculate_cycles_per();
 }
@@ -186,6 +188,23 @@ opera_clock_timer_queued(void)
   return 0;
 }
 
+/*
+  Whether pushing clks_ more would queue up a line, a timer tick or a DSP
+  sample. A DSP sample that's already waiting counts too. Timer ticks
+  only count with timer_ set. (They do nothing while no CLIO timer is
+  counting.)
+*/
+int
+opera_clock_push_would_queue(const uint32_t clks_,
+                             const int      timer_)
+{
+  const int64_t clks1616 = ((int64_t)clks_ << 16);
+
+  return (((g_CLOCK.vdl_acc   + clks1616) >= g_CLOCK.cycles_per_scanline) ||
+          (timer_ && ((g_CLOCK.timer_acc + clks1616) >= g_CLOCK.cycles_per_timer)) ||
+          ((g_CLOCK.dsp_acc   + clks1616) >= g_CLOCK.cycles_per_snd));
+}
+
 void
 opera_clock_push_cycles(const uint32_t clks_)
 {
@@ -195,6 +214,14 @@ opera_clock_push_cycles(const uint32_t clks_)
   g_CLOCK.dsp_acc   += clks1616;
   g_CLOCK.vdl_acc   += clks1616;
   g_CLOCK.timer_acc += clks1616;
+  g_CLOCK.now       += clks_;
+}
+
+/* CPU cycles pushed since opera_clock_init(). */
+uint64_t
+opera_clock_now(void)
+{
+  return g_CLOCK.now;
 }
 
 void
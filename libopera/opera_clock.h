@@ -14,6 +14,8 @@ int      opera_clock_dsp_queued(void);
 int      opera_clock_timer_queued(void);
 
 void     opera_clock_push_cycles(const uint32_t clks);
+int      opera_clock_push_would_queue(const uint32_t clks, const int timer);
+uint64_t opera_clock_now(void);
 
 void     opera_clock_cpu_set_freq(const uint32_t freq);
 void     opera_clock_cpu_set_freq_mul(const float mul);
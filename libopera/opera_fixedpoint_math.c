@@ -1,5 +1,21 @@
+#include "inline.h"
 #include "opera_fixedpoint_math.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+  Dumps every MulMat33Mat33_F16() to stdout. It's called from the
+  object SWIs once per object, so it's off unless asked for.
+*/
+#ifndef OPERA_FIXEDPOINT_LOG
+#define OPERA_FIXEDPOINT_LOG 0
+#endif
+
+#if OPERA_FIXEDPOINT_LOG
+#include <stdio.h>
+#endif
+
 static
 frac16
 sqrt_frac16(frac16 x_)
@@ -31,6 +47,550 @@ sqrt_frac16(frac16 x_)
   return root;
 }
 
+/*
+  The Many calls get through a lot of vertices (whole objects at a time,
+  from the object calls), so they have batch versions. The matrix is
+  loaded once, and SSE4.1 / AVX2 do the 32x32->64 multiplies (pmuldq)
+  for a whole row at a time, four vertices per trip.
+
+  Results are the same as the plain loops, bit for bit. The sums wrap
+  the same way, and the low 32 bits of sum >> 16 don't care whether the
+  shift was arithmetic or logical, so no 64-bit arithmetic shift is
+  needed.
+
+  The batches read a block of vertices before writing any of it back,
+  and keep the matrix in registers. That's fine when dest is src, or
+  nowhere near it. Anything else (dest part way into src, or over the
+  matrix) goes one vertex at a time, as before.
+*/
+
+#ifndef OPERA_FIXEDPOINT_SIMD
+#if defined(__x86_64__) || defined(_M_X64)
+#define OPERA_FIXEDPOINT_SIMD 1
+#else
+#define OPERA_FIXEDPOINT_SIMD 0
+#endif
+#endif
+
+#if OPERA_FIXEDPOINT_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET(T_)
+#else
+#define TARGET(T_) __attribute__((target(T_)))
+#endif
+#endif
+
+#define BATCH_SEQ -1
+
+static int g_SIMD_CPU   = -1;
+static int g_SIMD_LEVEL = -1;
+
+static
+int
+simd_detect(void)
+{
+#if OPERA_FIXEDPOINT_SIMD
+#ifdef _MSC_VER
+  int info[4];
+
+  __cpuid(info,0);
+  if(info[0] < 7)
+    return OPERA_FIXEDPOINT_SIMD_NONE;
+
+  __cpuid(info,1);
+  if(!(info[2] & (1 << 19)))
+    return OPERA_FIXEDPOINT_SIMD_NONE;
+  /* AVX2 also needs the OS to save the YMM registers */
+  if(!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || ((_xgetbv(0) & 6) != 6))
+    return OPERA_FIXEDPOINT_SIMD_SSE41;
+
+  __cpuidex(info,7,0);
+  if(info[1] & (1 << 5))
+    return OPERA_FIXEDPOINT_SIMD_AVX2;
+  return OPERA_FIXEDPOINT_SIMD_SSE41;
+#else
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2"))
+    return OPERA_FIXEDPOINT_SIMD_AVX2;
+  if(__builtin_cpu_supports("sse4.1"))
+    return OPERA_FIXEDPOINT_SIMD_SSE41;
+  return OPERA_FIXEDPOINT_SIMD_NONE;
+#endif
+#else
+  return OPERA_FIXEDPOINT_SIMD_NONE;
+#endif
+}
+
+int
+opera_fixedpoint_simd_get(void)
+{
+  if(g_SIMD_LEVEL < 0)
+    g_SIMD_LEVEL = g_SIMD_CPU = simd_detect();
+
+  return g_SIMD_LEVEL;
+}
+
+int
+opera_fixedpoint_simd_set(const int level_)
+{
+  opera_fixedpoint_simd_get();
+
+  g_SIMD_LEVEL = ((level_ < OPERA_FIXEDPOINT_SIMD_NONE) ? OPERA_FIXEDPOINT_SIMD_NONE :
+                  (level_ > g_SIMD_CPU) ? g_SIMD_CPU : level_);
+
+  return g_SIMD_LEVEL;
+}
+
+/* Which version a batch of bytes_ from src_ to dest_ can use. */
+static
+int
+batch_level(const void   *dest_,
+            const void   *src_,
+            const size_t  bytes_,
+            const void   *mat_,
+            const size_t  mat_bytes_)
+{
+  uintptr_t d = (uintptr_t)dest_;
+  uintptr_t s = (uintptr_t)src_;
+  uintptr_t m = (uintptr_t)mat_;
+
+  if((d < (m + mat_bytes_)) && (m < (d + bytes_)))
+    return BATCH_SEQ;
+  if((d != s) && (d < (s + bytes_)) && (s < (d + bytes_)))
+    return OPERA_FIXEDPOINT_SIMD_NONE;
+
+  return opera_fixedpoint_simd_get();
+}
+
+/* The DivZ part of 0x50011 / 0x50012, on a vertex that's been through the matrix. */
+static
+INLINE
+void
+divz(frac16  *dest_,
+     frac16   x_,
+     frac16   y_,
+     frac16   z_,
+     frac16   n_)
+{
+  if(z_ != 0)
+    {
+      int64_t mul;
+
+      mul = (((int64_t)n_ << 16) / (int64_t)z_);
+
+      x_ = (((int64_t)x_ * mul) >> 16);
+      y_ = (((int64_t)y_ * mul) >> 16);
+    }
+
+  dest_[0] = x_;
+  dest_[1] = y_;
+  dest_[2] = z_;
+}
+
+/* Plain C. Only the matrix kept in locals, which the compiler can't do for itself (dest might be it). */
+static
+void
+portable_many_vec3_mat33(vec3f16   *dest_,
+                         vec3f16   *src_,
+                         mat33f16   mat_,
+                         frac16     n_,
+                         const int  divz_,
+                         uint32_t   count_)
+{
+  uint32_t i;
+  const int64_t m00 = mat_[0][0], m01 = mat_[0][1], m02 = mat_[0][2];
+  const int64_t m10 = mat_[1][0], m11 = mat_[1][1], m12 = mat_[1][2];
+  const int64_t m20 = mat_[2][0], m21 = mat_[2][1], m22 = mat_[2][2];
+
+  for(i = 0; i < count_; i++)
+    {
+      const int64_t x = src_[i][0];
+      const int64_t y = src_[i][1];
+      const int64_t z = src_[i][2];
+      frac16 tmp[3];
+
+      tmp[0] = (((x * m00) + (y * m10) + (z * m20)) >> 16);
+      tmp[1] = (((x * m01) + (y * m11) + (z * m21)) >> 16);
+      tmp[2] = (((x * m02) + (y * m12) + (z * m22)) >> 16);
+
+      if(divz_)
+        {
+          divz(dest_[i],tmp[0],tmp[1],tmp[2],n_);
+        }
+      else
+        {
+          dest_[i][0] = tmp[0];
+          dest_[i][1] = tmp[1];
+          dest_[i][2] = tmp[2];
+        }
+    }
+}
+
+static
+void
+portable_many_vec4_mat44(vec4f16  *dest_,
+                         vec4f16  *src_,
+                         mat44f16  mat_,
+                         uint32_t  count_)
+{
+  uint32_t i;
+  const int64_t m00 = mat_[0][0], m01 = mat_[0][1], m02 = mat_[0][2], m03 = mat_[0][3];
+  const int64_t m10 = mat_[1][0], m11 = mat_[1][1], m12 = mat_[1][2], m13 = mat_[1][3];
+  const int64_t m20 = mat_[2][0], m21 = mat_[2][1], m22 = mat_[2][2], m23 = mat_[2][3];
+  const int64_t m30 = mat_[3][0], m31 = mat_[3][1], m32 = mat_[3][2], m33 = mat_[3][3];
+
+  for(i = 0; i < count_; i++)
+    {
+      const int64_t x = src_[i][0];
+      const int64_t y = src_[i][1];
+      const int64_t z = src_[i][2];
+      const int64_t w = src_[i][3];
+      frac16 tmp[4];
+
+      tmp[0] = (((x * m00) + (y * m10) + (z * m20) + (w * m30)) >> 16);
+      tmp[1] = (((x * m01) + (y * m11) + (z * m21) + (w * m31)) >> 16);
+      tmp[2] = (((x * m02) + (y * m12) + (z * m22) + (w * m32)) >> 16);
+      tmp[3] = (((x * m03) + (y * m13) + (z * m23) + (w * m33)) >> 16);
+
+      dest_[i][0] = tmp[0];
+      dest_[i][1] = tmp[1];
+      dest_[i][2] = tmp[2];
+      dest_[i][3] = tmp[3];
+    }
+}
+
+#if OPERA_FIXEDPOINT_SIMD
+
+/*
+  pmuldq multiplies the even 32-bit lanes into 64-bit ones. The matrix
+  rows get sign extended to 64-bit lanes once, and each source element
+  is broadcast to all of them, so a row's worth of products comes out of
+  one multiply (two for SSE4.1). Then >> 16, and the low halves packed
+  back down into a vec.
+*/
+
+/* Four vec3 results ([x y z -] each) written as three stores. Never touches a fifth vertex. */
+static
+INLINE
+TARGET("sse4.1")
+void
+sse41_store_vec3x4(frac16  *dest_,
+                   __m128i  a_,
+                   __m128i  b_,
+                   __m128i  c_,
+                   __m128i  d_)
+{
+  _mm_storeu_si128((__m128i*)&dest_[0],
+                   _mm_blend_epi16(a_,_mm_shuffle_epi32(b_,_MM_SHUFFLE(0,0,0,0)),0xC0));
+  _mm_storeu_si128((__m128i*)&dest_[4],
+                   _mm_blend_epi16(_mm_shuffle_epi32(b_,_MM_SHUFFLE(0,0,2,1)),
+                                   _mm_shuffle_epi32(c_,_MM_SHUFFLE(1,0,0,0)),0xF0));
+  _mm_storeu_si128((__m128i*)&dest_[8],
+                   _mm_blend_epi16(_mm_shuffle_epi32(c_,_MM_SHUFFLE(0,0,0,2)),
+                                   _mm_shuffle_epi32(d_,_MM_SHUFFLE(2,1,0,0)),0xFC));
+}
+
+static
+INLINE
+TARGET("sse4.1")
+void
+sse41_store_vec3(frac16  *dest_,
+                 __m128i  r_)
+{
+  _mm_storel_epi64((__m128i*)&dest_[0],r_);
+  dest_[2] = _mm_extract_epi32(r_,2);
+}
+
+static
+INLINE
+TARGET("sse4.1")
+void
+sse41_divz(frac16  *dest_,
+           __m128i  r_,
+           frac16   n_)
+{
+  divz(dest_,_mm_cvtsi128_si32(r_),_mm_extract_epi32(r_,1),_mm_extract_epi32(r_,2),n_);
+}
+
+/* Two 64-bit sums per register: lanes 0 and 1 of lo_, then hi_. */
+static
+INLINE
+TARGET("sse4.1")
+__m128i
+sse41_pack(__m128i lo_,
+           __m128i hi_)
+{
+  lo_ = _mm_shuffle_epi32(_mm_srli_epi64(lo_,16),_MM_SHUFFLE(3,3,2,0));
+  hi_ = _mm_shuffle_epi32(_mm_srli_epi64(hi_,16),_MM_SHUFFLE(3,3,2,0));
+
+  return _mm_unpacklo_epi64(lo_,hi_);
+}
+
+static
+INLINE
+TARGET("sse4.1")
+__m128i
+sse41_vec3(const frac16  *v_,
+           const __m128i *m01_,
+           const __m128i *m2_)
+{
+  __m128i x = _mm_set1_epi32(v_[0]);
+  __m128i y = _mm_set1_epi32(v_[1]);
+  __m128i z = _mm_set1_epi32(v_[2]);
+  __m128i lo;
+  __m128i hi;
+
+  lo = _mm_add_epi64(_mm_add_epi64(_mm_mul_epi32(x,m01_[0]),
+                                   _mm_mul_epi32(y,m01_[1])),
+                     _mm_mul_epi32(z,m01_[2]));
+  hi = _mm_add_epi64(_mm_add_epi64(_mm_mul_epi32(x,m2_[0]),
+                                   _mm_mul_epi32(y,m2_[1])),
+                     _mm_mul_epi32(z,m2_[2]));
+
+  return sse41_pack(lo,hi);
+}
+
+static
+INLINE
+TARGET("sse4.1")
+__m128i
+sse41_vec4(const frac16  *v_,
+           const __m128i *m01_,
+           const __m128i *m23_)
+{
+  __m128i x = _mm_set1_epi32(v_[0]);
+  __m128i y = _mm_set1_epi32(v_[1]);
+  __m128i z = _mm_set1_epi32(v_[2]);
+  __m128i w = _mm_set1_epi32(v_[3]);
+  __m128i lo;
+  __m128i hi;
+
+  lo = _mm_add_epi64(_mm_add_epi64(_mm_mul_epi32(x,m01_[0]),_mm_mul_epi32(y,m01_[1])),
+                     _mm_add_epi64(_mm_mul_epi32(z,m01_[2]),_mm_mul_epi32(w,m01_[3])));
+  hi = _mm_add_epi64(_mm_add_epi64(_mm_mul_epi32(x,m23_[0]),_mm_mul_epi32(y,m23_[1])),
+                     _mm_add_epi64(_mm_mul_epi32(z,m23_[2]),_mm_mul_epi32(w,m23_[3])));
+
+  return sse41_pack(lo,hi);
+}
+
+static
+TARGET("sse4.1")
+void
+sse41_many_vec3_mat33(vec3f16   *dest_,
+                      vec3f16   *src_,
+                      mat33f16   mat_,
+                      frac16     n_,
+                      const int  divz_,
+                      uint32_t   count_)
+{
+  int k;
+  uint32_t i;
+  __m128i m01[3];
+  __m128i m2[3];
+
+  for(k = 0; k < 3; k++)
+    {
+      m01[k] = _mm_cvtepi32_epi64(_mm_loadl_epi64((const __m128i*)&mat_[k][0]));
+      m2[k]  = _mm_cvtepi32_epi64(_mm_cvtsi32_si128(mat_[k][2]));
+    }
+
+  for(i = 0; (i + 4) <= count_; i += 4)
+    {
+      __m128i a = sse41_vec3(src_[i + 0],m01,m2);
+      __m128i b = sse41_vec3(src_[i + 1],m01,m2);
+      __m128i c = sse41_vec3(src_[i + 2],m01,m2);
+      __m128i d = sse41_vec3(src_[i + 3],m01,m2);
+
+      if(divz_)
+        {
+          sse41_divz(dest_[i + 0],a,n_);
+          sse41_divz(dest_[i + 1],b,n_);
+          sse41_divz(dest_[i + 2],c,n_);
+          sse41_divz(dest_[i + 3],d,n_);
+        }
+      else
+        {
+          sse41_store_vec3x4(dest_[i],a,b,c,d);
+        }
+    }
+
+  for(; i < count_; i++)
+    {
+      __m128i a = sse41_vec3(src_[i],m01,m2);
+
+      if(divz_)
+        sse41_divz(dest_[i],a,n_);
+      else
+        sse41_store_vec3(dest_[i],a);
+    }
+}
+
+static
+TARGET("sse4.1")
+void
+sse41_many_vec4_mat44(vec4f16  *dest_,
+                      vec4f16  *src_,
+                      mat44f16  mat_,
+                      uint32_t  count_)
+{
+  int k;
+  uint32_t i;
+  __m128i m01[4];
+  __m128i m23[4];
+
+  for(k = 0; k < 4; k++)
+    {
+      m01[k] = _mm_cvtepi32_epi64(_mm_loadl_epi64((const __m128i*)&mat_[k][0]));
+      m23[k] = _mm_cvtepi32_epi64(_mm_loadl_epi64((const __m128i*)&mat_[k][2]));
+    }
+
+  for(i = 0; (i + 4) <= count_; i += 4)
+    {
+      __m128i a = sse41_vec4(src_[i + 0],m01,m23);
+      __m128i b = sse41_vec4(src_[i + 1],m01,m23);
+      __m128i c = sse41_vec4(src_[i + 2],m01,m23);
+      __m128i d = sse41_vec4(src_[i + 3],m01,m23);
+
+      _mm_storeu_si128((__m128i*)dest_[i + 0],a);
+      _mm_storeu_si128((__m128i*)dest_[i + 1],b);
+      _mm_storeu_si128((__m128i*)dest_[i + 2],c);
+      _mm_storeu_si128((__m128i*)dest_[i + 3],d);
+    }
+
+  for(; i < count_; i++)
+    _mm_storeu_si128((__m128i*)dest_[i],sse41_vec4(src_[i],m01,m23));
+}
+
+/* AVX2 gets a whole row of 64-bit products from one multiply. */
+static
+INLINE
+TARGET("avx2")
+__m128i
+avx2_pack(__m256i r_,
+          __m256i idx_)
+{
+  return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_srli_epi64(r_,16),idx_));
+}
+
+static
+INLINE
+TARGET("avx2")
+__m128i
+avx2_vec3(const frac16  *v_,
+          const __m256i *m_,
+          __m256i        idx_)
+{
+  __m256i r;
+
+  r = _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epi32(_mm256_set1_epi32(v_[0]),m_[0]),
+                                        _mm256_mul_epi32(_mm256_set1_epi32(v_[1]),m_[1])),
+                       _mm256_mul_epi32(_mm256_set1_epi32(v_[2]),m_[2]));
+
+  return avx2_pack(r,idx_);
+}
+
+static
+INLINE
+TARGET("avx2")
+__m128i
+avx2_vec4(const frac16  *v_,
+          const __m256i *m_,
+          __m256i        idx_)
+{
+  __m256i r;
+
+  r = _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epi32(_mm256_set1_epi32(v_[0]),m_[0]),
+                                        _mm256_mul_epi32(_mm256_set1_epi32(v_[1]),m_[1])),
+                       _mm256_add_epi64(_mm256_mul_epi32(_mm256_set1_epi32(v_[2]),m_[2]),
+                                        _mm256_mul_epi32(_mm256_set1_epi32(v_[3]),m_[3])));
+
+  return avx2_pack(r,idx_);
+}
+
+static
+TARGET("avx2")
+void
+avx2_many_vec3_mat33(vec3f16   *dest_,
+                     vec3f16   *src_,
+                     mat33f16   mat_,
+                     frac16     n_,
+                     const int  divz_,
+                     uint32_t   count_)
+{
+  int k;
+  uint32_t i;
+  __m256i m[3];
+  __m256i idx = _mm256_setr_epi32(0,2,4,6,0,2,4,6);
+
+  for(k = 0; k < 3; k++)
+    m[k] = _mm256_cvtepi32_epi64(_mm_setr_epi32(mat_[k][0],mat_[k][1],mat_[k][2],0));
+
+  for(i = 0; (i + 4) <= count_; i += 4)
+    {
+      __m128i a = avx2_vec3(src_[i + 0],m,idx);
+      __m128i b = avx2_vec3(src_[i + 1],m,idx);
+      __m128i c = avx2_vec3(src_[i + 2],m,idx);
+      __m128i d = avx2_vec3(src_[i + 3],m,idx);
+
+      if(divz_)
+        {
+          sse41_divz(dest_[i + 0],a,n_);
+          sse41_divz(dest_[i + 1],b,n_);
+          sse41_divz(dest_[i + 2],c,n_);
+          sse41_divz(dest_[i + 3],d,n_);
+        }
+      else
+        {
+          sse41_store_vec3x4(dest_[i],a,b,c,d);
+        }
+    }
+
+  for(; i < count_; i++)
+    {
+      __m128i a = avx2_vec3(src_[i],m,idx);
+
+      if(divz_)
+        sse41_divz(dest_[i],a,n_);
+      else
+        sse41_store_vec3(dest_[i],a);
+    }
+}
+
+static
+TARGET("avx2")
+void
+avx2_many_vec4_mat44(vec4f16  *dest_,
+                     vec4f16  *src_,
+                     mat44f16  mat_,
+                     uint32_t  count_)
+{
+  int k;
+  uint32_t i;
+  __m256i m[4];
+  __m256i idx = _mm256_setr_epi32(0,2,4,6,0,2,4,6);
+
+  for(k = 0; k < 4; k++)
+    m[k] = _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)&mat_[k][0]));
+
+  for(i = 0; (i + 4) <= count_; i += 4)
+    {
+      __m128i a = avx2_vec4(src_[i + 0],m,idx);
+      __m128i b = avx2_vec4(src_[i + 1],m,idx);
+      __m128i c = avx2_vec4(src_[i + 2],m,idx);
+      __m128i d = avx2_vec4(src_[i + 3],m,idx);
+
+      _mm256_storeu_si256((__m256i*)dest_[i + 0],_mm256_inserti128_si256(_mm256_castsi128_si256(a),b,1));
+      _mm256_storeu_si256((__m256i*)dest_[i + 2],_mm256_inserti128_si256(_mm256_castsi128_si256(c),d,1));
+    }
+
+  for(; i < count_; i++)
+    _mm_storeu_si128((__m128i*)dest_[i],avx2_vec4(src_[i],m,idx));
+}
+
+#endif /* OPERA_FIXEDPOINT_SIMD */
+
 /* swi 0x50000 */
 void
 MulVec3Mat33_F16(vec3f16  dest_,
@@ -104,6 +664,7 @@ MulMat33Mat33_F16(mat33f16 dest_,
   dest_[2][1] = tmp[2][1];
   dest_[2][2] = tmp[2][2];
 
+#if OPERA_FIXEDPOINT_LOG
   printf("MulMat33Mat33_F16\n");
   printf("src1_00: 0x%08X  src1_01: 0x%08X  src1_02: 0x%08X\n", src1_[0][0], src1_[0][1], src1_[0][2]);
   printf("src1_10: 0x%08X  src1_11: 0x%08X  src1_12: 0x%08X\n", src1_[1][0], src1_[1][1], src1_[1][2]);
@@ -120,6 +681,7 @@ MulMat33Mat33_F16(mat33f16 dest_,
   printf("dest_00: 0x%08X  dest_01: 0x%08X  dest_02: 0x%08X\n", dest_[0][0], dest_[0][1], dest_[0][2]);
   printf("dest_10: 0x%08X  dest_11: 0x%08X  dest_12: 0x%08X\n", dest_[1][0], dest_[1][1], dest_[1][2]);
   printf("dest_20: 0x%08X  dest_21: 0x%08X  dest_22: 0x%08X\n\n", dest_[2][0], dest_[2][1], dest_[2][2]);
+#endif
 }
 
 /* swi 0x50002 */
@@ -132,6 +694,24 @@ MulManyVec3Mat33_F16(vec3f16  *dest_,
   int32_t i;
   vec3f16 tmp;
 
+  if(count_ <= 0)
+    return;
+
+  switch(batch_level(dest_,src_,(count_ * sizeof(vec3f16)),mat_,sizeof(mat33f16)))
+    {
+#if OPERA_FIXEDPOINT_SIMD
+    case OPERA_FIXEDPOINT_SIMD_AVX2:
+      avx2_many_vec3_mat33(dest_,src_,mat_,0,0,count_);
+      return;
+    case OPERA_FIXEDPOINT_SIMD_SSE41:
+      sse41_many_vec3_mat33(dest_,src_,mat_,0,0,count_);
+      return;
+#endif
+    case OPERA_FIXEDPOINT_SIMD_NONE:
+      portable_many_vec3_mat33(dest_,src_,mat_,0,0,count_);
+      return;
+    }
+
   for(i = 0; i < count_; i++)
     {
       tmp[0] = ((((int64_t)src_[i][0] * (int64_t)mat_[0][0]) +
@@ -316,6 +896,24 @@ MulManyVec4Mat44_F16(vec4f16  *dest_,
   int32_t i;
   vec4f16 tmp;
 
+  if(count_ <= 0)
+    return;
+
+  switch(batch_level(dest_,src_,(count_ * sizeof(vec4f16)),mat_,sizeof(mat44f16)))
+    {
+#if OPERA_FIXEDPOINT_SIMD
+    case OPERA_FIXEDPOINT_SIMD_AVX2:
+      avx2_many_vec4_mat44(dest_,src_,mat_,count_);
+      return;
+    case OPERA_FIXEDPOINT_SIMD_SSE41:
+      sse41_many_vec4_mat44(dest_,src_,mat_,count_);
+      return;
+#endif
+    case OPERA_FIXEDPOINT_SIMD_NONE:
+      portable_many_vec4_mat44(dest_,src_,mat_,count_);
+      return;
+    }
+
   for(i = 0; i < count_; i++)
     {
       tmp[0] = ((((int64_t)src_[i][0] * (int64_t)mat_[0][0]) +
@@ -465,6 +1063,22 @@ MulManyVec3Mat33DivZ_F16(vec3f16  *dest_,
                          uint32_t  count_)
 {
   uint32_t i;
+
+  switch(batch_level(dest_,src_,(count_ * sizeof(vec3f16)),mat_,sizeof(mat33f16)))
+    {
+#if OPERA_FIXEDPOINT_SIMD
+    case OPERA_FIXEDPOINT_SIMD_AVX2:
+      avx2_many_vec3_mat33(dest_,src_,*mat_,n_,1,count_);
+      return;
+    case OPERA_FIXEDPOINT_SIMD_SSE41:
+      sse41_many_vec3_mat33(dest_,src_,*mat_,n_,1,count_);
+      return;
+#endif
+    case OPERA_FIXEDPOINT_SIMD_NONE:
+      portable_many_vec3_mat33(dest_,src_,*mat_,n_,1,count_);
+      return;
+    }
+
   for(i = 0; i < count_; i++)
     MulVec3Mat33DivZ_F16(dest_[i],src_[i],*mat_,n_);
 }
@@ -71,5 +71,16 @@ void MulVec3Mat33DivZ_F16(vec3f16 dest, vec3f16 vec, mat33f16 mat, frac16 n);
 /* swi 0x50012 */
 void MulManyVec3Mat33DivZ_F16(vec3f16 *dest, vec3f16 *src, mat33f16 *mat, frac16 n, uint32_t count_);
 
+/*
+  Which kernels the Many calls (0x50002, 0x50009, 0x50012, and the
+  object calls on top of them) use. The best one the CPU has, unless
+  set lower. All of them give the same results.
+*/
+#define OPERA_FIXEDPOINT_SIMD_NONE  0
+#define OPERA_FIXEDPOINT_SIMD_SSE41 1
+#define OPERA_FIXEDPOINT_SIMD_AVX2  2
+
+int opera_fixedpoint_simd_get(void);
+int opera_fixedpoint_simd_set(const int level);
 
 #endif
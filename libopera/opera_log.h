@@ -0,0 +1,100 @@
+/*
+  www.freedo.org
+  The first working 3DO multiplayer emulator.
+
+  The FreeDO licensed under modified GNU LGPL, with following notes:
+
+  *   The owners and original authors of the FreeDO have full right to
+  *   develop closed source derivative work.
+
+  *   Any non-commercial uses of the FreeDO sources or any knowledge
+  *   obtained by studying or reverse engineering of the sources, or
+  *   any other material published by FreeDO have to be accompanied
+  *   with full credits.
+
+  *   Any commercial uses of FreeDO sources or any knowledge obtained
+  *   by studying or reverse engineering of the sources, or any other
+  *   material published by FreeDO is strictly forbidden without
+  *   owners approval.
+
+  The above notes are taking precedence over GNU LGPL in conflicting
+  situations.
+
+  Project authors:
+  *  Alexander Troosh
+  *  Maxim Grishin
+  *  Allen Wright
+  *  John Sammons
+  *  Felix Lazarev
+*/
+
+#ifndef LIBOPERA_LOG_H_INCLUDED
+#define LIBOPERA_LOG_H_INCLUDED
+
+#include "extern_c.h"
+#include "inline.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+  opera_trace.txt switches.
+
+  OPERA_LOG_ENABLE=0 compiles every bus trace fprintf out. Otherwise
+  opera_log_mask picks the regions at runtime, once opera_log_open()
+  has somewhere to put them. The bits are the same as the sim_log.h
+  regions, so one --logmask means the same thing on both sides of the
+  sim.
+*/
+
+#ifndef OPERA_LOG_ENABLE
+#define OPERA_LOG_ENABLE 1
+#endif
+
+#define OPERA_LOG_MADAM 0x01
+#define OPERA_LOG_CLIO  0x02
+#define OPERA_LOG_XBUS  0x04
+#define OPERA_LOG_SVF   0x08
+#define OPERA_LOG_DIAG  0x10
+#define OPERA_LOG_SLOW  0x20
+#define OPERA_LOG_MISC  0x40
+#define OPERA_LOG_ALL   0x7F
+
+EXTERN_C_BEGIN
+
+extern FILE     *opera_logfile;
+extern uint32_t  opera_log_mask;
+
+int  opera_log_open(const char *path, const uint32_t mask);
+void opera_log_close(void);
+
+EXTERN_C_END
+
+/* Zero for anything outside 0x03100000 - 0x034FFFFF, which never gets traced. */
+static INLINE
+uint32_t
+opera_log_region(const uint32_t addr_)
+{
+  switch(addr_ >> 20)
+    {
+    case 0x031:
+      return (((addr_ >> 2) == (0x03180000 >> 2)) ? OPERA_LOG_DIAG : OPERA_LOG_SLOW);
+    case 0x032:
+      return OPERA_LOG_SVF;
+    case 0x033:
+      return OPERA_LOG_MADAM;
+    case 0x034:
+      return (((addr_ >> 8) == (0x03400500 >> 8)) ? OPERA_LOG_XBUS : OPERA_LOG_CLIO);
+    }
+
+  return 0;
+}
+
+static INLINE
+int
+opera_log_on(const uint32_t region_)
+{
+  return (OPERA_LOG_ENABLE && (opera_log_mask & region_));
+}
+
+#endif /* LIBOPERA_LOG_H_INCLUDED */
@@ -36,6 +36,7 @@
 #include "opera_bitop.h"
 #include "opera_clio.h"
 #include "opera_core.h"
+#include "opera_log.h"
 #include "opera_madam.h"
 #include "opera_pbus.h"
 #include "opera_vdlp.h"
@@ -45,7 +46,27 @@
 #include <stdio.h>
 #include <string.h>
 
-extern FILE *logfile;
+/*
+  SSE4.1 / AVX2 path for literal CELs drawn 1:1. See LiteralRow().
+  Build with OPERA_MADAM_SIMD=0 to leave it out.
+*/
+#ifndef OPERA_MADAM_SIMD
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(MSB_FIRST)
+#define OPERA_MADAM_SIMD 1
+#else
+#define OPERA_MADAM_SIMD 0
+#endif
+#endif
+
+#if OPERA_MADAM_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET(T_)
+#else
+#define TARGET(T_) __attribute__((target(T_)))
+#endif
+#endif
 
 static struct BitReaderBig bitoper;
 
@@ -424,6 +445,65 @@ opera_madam_me_mode_software(void)
   ME_MODE = ME_MODE_SOFTWARE;
 }
 
+static int g_SIMD_CPU   = -1;
+static int g_SIMD_LEVEL = -1;
+
+static
+int
+simd_detect(void)
+{
+#if OPERA_MADAM_SIMD
+#ifdef _MSC_VER
+  int info[4];
+
+  __cpuid(info,0);
+  if(info[0] < 7)
+    return OPERA_MADAM_SIMD_NONE;
+
+  __cpuid(info,1);
+  if(!(info[2] & (1 << 19)))
+    return OPERA_MADAM_SIMD_NONE;
+  /* AVX2 also needs the OS to save the YMM registers */
+  if(!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || ((_xgetbv(0) & 6) != 6))
+    return OPERA_MADAM_SIMD_SSE41;
+
+  __cpuidex(info,7,0);
+  if(info[1] & (1 << 5))
+    return OPERA_MADAM_SIMD_AVX2;
+  return OPERA_MADAM_SIMD_SSE41;
+#else
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2"))
+    return OPERA_MADAM_SIMD_AVX2;
+  if(__builtin_cpu_supports("sse4.1"))
+    return OPERA_MADAM_SIMD_SSE41;
+  return OPERA_MADAM_SIMD_NONE;
+#endif
+#else
+  return OPERA_MADAM_SIMD_NONE;
+#endif
+}
+
+int
+opera_madam_simd_get(void)
+{
+  if(g_SIMD_LEVEL < 0)
+    g_SIMD_LEVEL = g_SIMD_CPU = simd_detect();
+
+  return g_SIMD_LEVEL;
+}
+
+int
+opera_madam_simd_set(const int level_)
+{
+  opera_madam_simd_get();
+
+  g_SIMD_LEVEL = ((level_ < OPERA_MADAM_SIMD_NONE) ? OPERA_MADAM_SIMD_NONE :
+                  (level_ > g_SIMD_CPU) ? g_SIMD_CPU : level_);
+
+  return g_SIMD_LEVEL;
+}
+
 uint32_t
 opera_madam_fsm_get(void)
 {
@@ -467,6 +547,7 @@ static void     DrawLiteralCel_New(void);
 static void     DrawLRCel_New(void);
 static void     HandleDMA8(void);
 static void     DMAPBus(void);
+static void     PPROC_Select(void);
 
 /* general 3D vertex class */
 
@@ -488,6 +569,40 @@ static struct
   int      Transparent;
 } pproj;
 
+/*
+  PPROC kernels. PPROC_Select() picks one for each half of PIXC (the
+  P bit picks the half, pixel by pixel) when the CCB is loaded.
+*/
+#define PPROC_GENERIC   0 /* anything else, PPROC_Generic() */
+#define PPROC_SCALE     1 /* 1st source only. (opaque) */
+#define PPROC_ADD_CONST 2 /* 1st source + the AV constant */
+#define PPROC_ADD_FRAME 3 /* 1st source + frame buffer. (50% average, additive) */
+
+struct pproc_mode_s
+{
+  uint32_t       kernel;
+  uint32_t       s1;
+  uint32_t       dv2;
+  uint32_t       av;
+  const uint8_t *scale;
+  uint32_t       mul;   /* scale[i] is (i * mul) >> shift */
+  uint32_t       shift;
+};
+
+typedef struct pproc_mode_s pproc_mode_t;
+
+static pproc_mode_t pproc[2];
+
+/* What pproc[] was last worked out from. */
+static struct
+{
+  int      valid;
+  uint32_t pixc;
+  uint32_t flags;
+} pproc_key;
+
+static opera_madam_ccb_stats_t CCBSTATS;
+
 static uint8_t  *DRAM;
 static uint32_t  retuval;
 static uint32_t  BITADDR;
@@ -643,6 +758,14 @@ static int64_t tmpMO3;
 #define Nfrac16 (((int64_t)MADAM.mregs[0x680]<<32) | \
                  (uint32_t)MADAM.mregs[0x684])
 
+/*
+  Dumps every matrix op to stdout. Handy against rtl/matrix_engine.v,
+  but it's most of the time a matrix op takes, so it's off by default.
+*/
+#ifndef MADAM_MATRIX_LOG
+#define MADAM_MATRIX_LOG 0
+#endif
+
 static
 INLINE
 void
@@ -653,9 +776,11 @@ madam_matrix_copy(void)
   MO2 = tmpMO2;
   MO3 = tmpMO3;
 
+#if MADAM_MATRIX_LOG
   printf("mat_copy\n");
   printf("tmpMO0: 0x%08X  tmpMO1: 0x%08X  tmpMO2: 0x%08X  tmpMO3: 0x%08X\n", tmpMO0, tmpMO1, tmpMO2, tmpMO3);
   printf("MO0: 0x%08X  M01: 0x%08X  M02: 0x%08X  MO3: 0x%08X\n", MO0, MO1, MO2, MO3);
+#endif
 }
 
 /*
@@ -678,10 +803,12 @@ madam_matrix_mul3x3(void)
              (MI21 * MV1) +
              (MI22 * MV2)) >> 16);
 
+#if MADAM_MATRIX_LOG
   printf("mul3x3\n");
   printf("MI00: 0x%08X  MI01: 0x%08X  MI02: 0x%08X  MI10: 0x%08X  MI11: 0x%08X  MI12: 0x%08X  MI20: 0x%08X  MI21: 0x%08X  MI22: 0x%08X\n", MI00, MI01, MI02, MI10, MI11, MI12, MI20, MI21, MI22);
   printf(" MV0: 0x%08X   MV1: 0x%08X   MV2: 0x%08X\n", MV0, MV1, MV2);
   printf("tmpMO0: 0x%08X  tmpMO1: 0x%08X  tmpMO2: 0x%08X\n\n", tmpMO0, tmpMO1, tmpMO2);
+#endif
 }
 
 /*
@@ -718,10 +845,12 @@ madam_matrix_mul3x3_nz(void)
   tmpMO0 = ((tmpMO0 * M) >> 32);
   tmpMO1 = ((tmpMO1 * M) >> 32);
 
+#if MADAM_MATRIX_LOG
   printf("mul3x3_nz\n");
   printf("MI00: 0x%08X  MI01: 0x%08X  MI02: 0x%08X  MI10: 0x%08X  MI11: 0x%08X  MI12: 0x%08X  MI20: 0x%08X  MI21: 0x%08X  MI22: 0x%08X\n", MI00, MI01, MI02, MI10, MI11, MI12, MI20, MI21, MI22);
   printf(" MV0: 0x%08X   MV1: 0x%08X  MV2: 0x%08X\n", MV0, MV1, MV2);
   printf("tmpMO0: 0x%08X  tmpMO1: 0x%08X\n\n", tmpMO0, tmpMO1);
+#endif
 }
 
 /*
@@ -751,11 +880,13 @@ madam_matrix_mul4x4(void)
              (MI32 * MV2) +
              (MI33 * MV3)) >> 16);
 
+#if MADAM_MATRIX_LOG
   printf("mul4x4\n");
   printf("MI00: 0x%08X  MI01: 0x%08X  MI02: 0x%08X  MI03: 0x%08X  MI10: 0x%08X  MI11: 0x%08X  MI12: 0x%08X  MI13: 0x%08X\n", MI00, MI01, MI02, MI03, MI10, MI11, MI12, MI13);
   printf("MI20: 0x%08X  MI21: 0x%08X  MI22: 0x%08X  MI23: 0x%08X  MI30: 0x%08X  MI31: 0x%08X  MI32: 0x%08X  MI33: 0x%08X\n", MI20, MI21, MI22, MI23, MI30, MI31, MI32, MI33);
   printf(" MV0: 0x%08X   MV1: 0x%08X   MV2: 0x%08X\n", MV0, MV1, MV2);
   printf("tmpMO0: 0x%08X  tmpMO1: 0x%08X  tmpMO2: 0x%08X  tmpMO3: 0x%08X\n\n", tmpMO0, tmpMO1, tmpMO2, tmpMO3);
+#endif
 }
 
 void
@@ -868,21 +999,44 @@ static int32_t  TEXEL_INCY;
 static int32_t  TEXTURE_WI_LIM;
 static int32_t  TEXTURE_HI_LIM;
 
+/*
+  A word (two entries) at a time, straight out of DRAM, rather than an
+  opera_mem_read16() call an entry: it's done for every CCB with
+  CCB_LDPLUT, and was most of the time taken to load one. pnt_ is word
+  aligned (PLUTDATA always is), and n_ even.
+*/
 static
 void
 LoadPLUT(uint32_t pnt_,
          int32_t  n_)
 {
-  int i;
+  CCBSTATS.pluts++;
 
-  for(i = 0; i < n_; i++)
-    {
 #ifdef MSB_FIRST
-      MADAM.PLUT[i] = opera_mem_read16((((pnt_ >> 1) + i)) << 1);
+  memcpy(MADAM.PLUT,&DRAM[pnt_],(n_ << 1));
 #else
-      MADAM.PLUT[i] = opera_mem_read16((((pnt_ >> 1) + i)^1) << 1);
-#endif
+  int i;
+  uint32_t w;
+
+  for(i = 0; i < n_; i += 2)
+    {
+      w = mread32(pnt_ + (i << 1));
+      w = ((w << 16) | (w >> 16));
+      memcpy(&MADAM.PLUT[i],&w,sizeof(w));
     }
+#endif
+}
+
+void
+opera_madam_ccb_stats_get(opera_madam_ccb_stats_t *stats_)
+{
+  *stats_ = CCBSTATS;
+}
+
+void
+opera_madam_ccb_stats_clear(void)
+{
+  memset(&CCBSTATS,0,sizeof(CCBSTATS));
 }
 
 void
@@ -910,6 +1064,8 @@ opera_madam_cel_handle(void)
 
       //printf("CURRENTCCB: 0x%08X\n", CURRENTCCB);
 
+      CCBSTATS.ccbs++;
+
       CCBFLAGS    = mread32(CURRENTCCB);
       CURRENTCCB += 4;
 
@@ -1084,6 +1240,8 @@ opera_madam_cel_handle(void)
         pproj.pmodeANDmask = ((pproj.pmode != PMODE_ZERO) ? 0xFFFF : 0x7FFF);
       }
 
+      PPROC_Select();
+
       /* load PLUT */
       if ((CCBFLAGS & CCB_LDPLUT) && !PLUTF)
         {
@@ -1162,7 +1320,8 @@ DMAPBus(void)
   uint32_t len_bkp = MADAM.mregs[0x574];
   uint32_t src_bkp = MADAM.mregs[0x578];
 
-  fprintf(logfile, "PBUS DMA  dst: 0x%08X  len: 0x%08X  src: 0x%08X\n", MADAM.mregs[0x570], MADAM.mregs[0x574], MADAM.mregs[0x578]);
+  if(opera_log_on(OPERA_LOG_MISC))
+    fprintf(opera_logfile, "PBUS DMA  dst: 0x%08X  len: 0x%08X  src: 0x%08X\n", MADAM.mregs[0x570], MADAM.mregs[0x574], MADAM.mregs[0x578]);
 
   pbus_buf  = opera_pbus_buf();
   pbus_size = opera_pbus_size();
@@ -1188,20 +1347,20 @@ DMAPBus(void)
 
    /*
    for (int i=0; i<len_bkp; i+=16) {
-      fprintf(logfile, "0x%08X: ", dst_bkp+i);   
-      fprintf(logfile, "0x%08X ",   opera_io_read( dst_bkp+i+0x0 ) );
-      fprintf(logfile, "0x%08X ",   opera_io_read( dst_bkp+i+0x4 ) );
-      fprintf(logfile, "0x%08X ",   opera_io_read( dst_bkp+i+0x8 ) );
-      fprintf(logfile, "0x%08X \n", opera_io_read( dst_bkp+i+0xC ) );
+      fprintf(opera_logfile, "0x%08X: ", dst_bkp+i);   
+      fprintf(opera_logfile, "0x%08X ",   opera_io_read( dst_bkp+i+0x0 ) );
+      fprintf(opera_logfile, "0x%08X ",   opera_io_read( dst_bkp+i+0x4 ) );
+      fprintf(opera_logfile, "0x%08X ",   opera_io_read( dst_bkp+i+0x8 ) );
+      fprintf(opera_logfile, "0x%08X \n", opera_io_read( dst_bkp+i+0xC ) );
    }
   */
 
    for (int i=0x2340; i<0x2440; i+=16) {
-      fprintf(logfile, "0x%08X: ", i);   
-      fprintf(logfile, "0x%08X ",   opera_io_read( i+0x0 ) );
-      fprintf(logfile, "0x%08X ",   opera_io_read( i+0x4 ) );
-      fprintf(logfile, "0x%08X ",   opera_io_read( i+0x8 ) );
-      fprintf(logfile, "0x%08X \n", opera_io_read( i+0xC ) );
+      fprintf(opera_logfile, "0x%08X: ", i);   
+      fprintf(opera_logfile, "0x%08X ",   opera_io_read( i+0x0 ) );
+      fprintf(opera_logfile, "0x%08X ",   opera_io_read( i+0x4 ) );
+      fprintf(opera_logfile, "0x%08X ",   opera_io_read( i+0x8 ) );
+      fprintf(opera_logfile, "0x%08X \n", opera_io_read( i+0xC ) );
    }
 }
 
@@ -1216,7 +1375,7 @@ opera_madam_init(uint8_t *mem_)
 
   DRAM = mem_;
 
-  bitoper.bitset = 1;
+  pproc_key.valid = 0;
 
   MADAM.FSM = FSM_IDLE;
 
@@ -1270,11 +1429,16 @@ mread32(uint32_t addr_)
   return *((uint32_t*)&DRAM[addr_]);
 }
 
+/*
+  mwrite16() with HIRESMODE passed in, so the span loops can pass a
+  constant and lose the test.
+*/
 static
-INLINE
+FORCEINLINE
 void
-mwrite16(const uint32_t addr_,
-         const uint16_t val_)
+mwrite16_mode(const uint32_t addr_,
+              const uint16_t val_,
+              const int      hires_)
 {
 #ifdef MSB_FIRST
   const uint32_t addr = addr_;
@@ -1282,14 +1446,24 @@ mwrite16(const uint32_t addr_,
   const uint32_t addr = addr_ ^ 2;
 #endif
 
+  opera_arm_icache_write(addr);
   *((uint16_t*)&DRAM[addr]) = val_;
-  if (!HIRESMODE || (addr < 0x200000))
+  if (!hires_ || (addr < 0x200000))
     return;
   *((uint16_t*)&DRAM[addr + 1*1024*1024]) = val_;
   *((uint16_t*)&DRAM[addr + 2*1024*1024]) = val_;
   *((uint16_t*)&DRAM[addr + 3*1024*1024]) = val_;
 }
 
+static
+INLINE
+void
+mwrite16(const uint32_t addr_,
+         const uint16_t val_)
+{
+  mwrite16_mode(addr_,val_,HIRESMODE);
+}
+
 static
 INLINE
 uint16_t
@@ -1485,11 +1659,12 @@ clamp_i8(const int8_t x_,
           ((x_ > max_) ? max_ : x_));
 }
 
+/* pixel_ has already had PMODE applied. See PPROC(). */
 static
 uint32_t
-PPROC(uint32_t pixel_,
-      uint32_t fpix_,
-      uint32_t amv_)
+PPROC_Generic(uint32_t pixel_,
+              uint32_t fpix_,
+              uint32_t amv_)
 {
   AVS_t AV;
   PXC_t pixc;
@@ -1512,14 +1687,6 @@ PPROC(uint32_t pixel_,
   } color1, color2, AOP, BOP;
 #pragma pack(pop)
 
-  /*
-    Set PMODE according to the values set up in the CCBFLAGS word.
-    (This merely uses masks here because it's faster).
-    This is a duty of the PROJECTOR, but we'll do it here because its
-    easier.
-  */
-  pixel_ = ((pixel_ | pproj.pmodeORmask) & pproj.pmodeANDmask);
-
   pixc.raw = (PIXC & 0xFFFF);
   if (pixel_ & 0x8000)
     pixc.raw = (PIXC >> 16);
@@ -1665,6 +1832,163 @@ PPROC(uint32_t pixel_,
   return out.raw;
 }
 
+/*
+  One colour of the PPROC_SCALE / _ADD_CONST / _ADD_FRAME kernels. It's
+  PPROC_Generic() with AV all zero and no PXOR: AOP is the scaled 1st
+  source, BOP the 2nd source, and the sum goes through int8 (a big
+  enough sum wraps negative and clips to 0, the same as it does there).
+*/
+static
+FORCEINLINE
+uint32_t
+pproc_channel(const uint32_t      in_,
+              const uint32_t      fpix_,
+              const uint32_t      shift_,
+              const pproc_mode_t *m_,
+              const int           kernel_)
+{
+  int32_t c;
+
+  c = m_->scale[(in_ >> shift_) & 0x1F];
+  if (kernel_ == PPROC_ADD_CONST)
+    c += m_->av;
+  else if (kernel_ == PPROC_ADD_FRAME)
+    c += ((fpix_ >> shift_) & 0x1F);
+
+  c = (int8_t)(c >> m_->dv2);
+  c = ((c < 0) ? 0 : ((c > 31) ? 31 : c));
+
+  return (c << shift_);
+}
+
+/* kernel_ is a constant at each call, so each gets its own copy. */
+static
+FORCEINLINE
+uint32_t
+pproc_kernel(const uint32_t      pixel_,
+             const uint32_t      fpix_,
+             const pproc_mode_t *m_,
+             const int           kernel_)
+{
+  uint32_t in;
+  uint32_t out;
+
+  in  = (m_->s1 ? fpix_ : pixel_);
+  out = (pproc_channel(in,fpix_,0,m_,kernel_)  |
+         pproc_channel(in,fpix_,5,m_,kernel_)  |
+         pproc_channel(in,fpix_,10,m_,kernel_));
+
+  if (!(CCBFLAGS & CCB_NOBLK) && (out == 0))
+    out = (1 << 10);
+
+  return out;
+}
+
+/*
+  Work out which kernel each half of PIXC can use. Called for each
+  CCB, once CCBFLAGS, PIXC and PXOR1/2 are loaded. Anything using AV,
+  PXOR, the AMV multiplier (MS 1) or the 1st source's own multiplier
+  (MS 2), or the 1st source as the 2nd source (S2 3), stays on
+  PPROC_Generic().
+
+  The CCBs in a list mostly share a PIXC, so it's only worked out again
+  when PIXC, or the flags it depends on, change.
+*/
+static
+void
+PPROC_Select(void)
+{
+  int i;
+  const uint32_t flags = (CCBFLAGS & (CCB_PXOR | CCB_USEAV));
+
+  if (pproc_key.valid && (pproc_key.pixc == PIXC) && (pproc_key.flags == flags))
+    {
+      CCBSTATS.pixc_hits++;
+      return;
+    }
+
+  pproc_key.valid = 1;
+  pproc_key.pixc  = PIXC;
+  pproc_key.flags = flags;
+  CCBSTATS.pixc_misses++;
+
+  for(i = 0; i < 2; i++)
+    {
+      PXC_t pixc;
+      pproc_mode_t *m = &pproc[i];
+
+      pixc.raw  = (i ? (PIXC >> 16) : (PIXC & 0xFFFF));
+      m->kernel = PPROC_GENERIC;
+      m->s1     = pixc.meaning.s1;
+      m->dv2    = pixc.meaning.dv2;
+      m->av     = pixc.meaning.av;
+
+      if ((PXOR1 != 0xFFFFFFFF) || (PXOR2 != 0))
+        continue;
+      if ((CCBFLAGS & CCB_USEAV) && pixc.meaning.av)
+        continue;
+
+      switch(pixc.meaning.ms)
+        {
+        case 0:
+          m->scale = PSCALAR[pixc.meaning.mxf][pixc.meaning.dv1];
+          m->mul   = (pixc.meaning.mxf + 1);
+          break;
+        case 3:
+          m->scale = PSCALAR[4][pixc.meaning.dv1];
+          m->mul   = 5;
+          break;
+        default:
+          continue;
+        }
+
+      m->shift = PDV(pixc.meaning.dv1);
+
+      switch(pixc.meaning.s2)
+        {
+        case 0:
+          m->kernel = PPROC_SCALE;
+          break;
+        case 1:
+          m->kernel = PPROC_ADD_CONST;
+          break;
+        case 2:
+          m->kernel = PPROC_ADD_FRAME;
+          break;
+        }
+    }
+}
+
+static
+uint32_t
+PPROC(uint32_t pixel_,
+      uint32_t fpix_,
+      uint32_t amv_)
+{
+  const pproc_mode_t *m;
+
+  /*
+    Set PMODE according to the values set up in the CCBFLAGS word.
+    (This merely uses masks here because it's faster).
+    This is a duty of the PROJECTOR, but we'll do it here because its
+    easier.
+  */
+  pixel_ = ((pixel_ | pproj.pmodeORmask) & pproj.pmodeANDmask);
+
+  m = &pproc[(pixel_ >> 15) & 1];
+  switch(m->kernel)
+    {
+    case PPROC_SCALE:
+      return pproc_kernel(pixel_,fpix_,m,PPROC_SCALE);
+    case PPROC_ADD_CONST:
+      return pproc_kernel(pixel_,fpix_,m,PPROC_ADD_CONST);
+    case PPROC_ADD_FRAME:
+      return pproc_kernel(pixel_,fpix_,m,PPROC_ADD_FRAME);
+    default:
+      return PPROC_Generic(pixel_,fpix_,amv_);
+    }
+}
+
 
 static
 INLINE
@@ -1683,6 +2007,486 @@ process_pixel(int32_t x_,
   mwrite16(REGCTL3 + XY2OFF(x_,y_,MADAM.wmod),p);
 }
 
+/*
+  Literal CELs drawn 1:1 through the line map (FMV, full screen
+  backgrounds) go 8 (SSE4.1) or 16 (AVX2) pixels at a time. A group is
+  decoded, 16 bit uncoded pixels straight from the CEL data and the
+  rest through the same tables PDEC() uses. It then goes through the
+  PPROC kernel PPROC_Select() picked and PPROJ_OUTPUT(), and is merged
+  into the frame buffer, leaving the transparent pixels alone. The
+  results are the same as PDEC() and process_pixel() give, bit for bit.
+
+  PPROC_Generic() modes, HIRESMODE, and rows where the write would land
+  on frame buffer pixels or CEL data the group still has to read, stay
+  on the pixel at a time loop.
+*/
+#if OPERA_MADAM_SIMD
+static struct
+{
+  int            level;
+  uint32_t       coded;
+  uint16_t       pmode_or;
+  uint16_t       pmode_and;
+  uint16_t       tmask;
+  uint16_t       blk;
+  int            vh_pres;
+  int            swap;
+  uint16_t       vh_const;
+  uint16_t       vh_and;
+  uint16_t       vh_or;
+  uint16_t       vh_ppmp;
+  const pproc_mode_t *m[2];
+} LIT;
+
+/* Called for each literal line map CEL. LIT.level is 0 if it can't use the SIMD rows. */
+static
+void
+LiteralRow_Init(void)
+{
+  LIT.level = OPERA_MADAM_SIMD_NONE;
+
+  if ((HDX1616 != 0x10000) || (HDY1616 != 0) || HIRESMODE)
+    return;
+  if ((bpp != 8) && (bpp != 16))
+    return;
+
+  /* The halves of PIXC the P bit can pick, after PMODE. */
+  LIT.m[0] = &pproc[(pproj.pmodeORmask & 0x8000) ? 1 : 0];
+  LIT.m[1] = &pproc[(pproj.pmodeANDmask & 0x8000) ? 1 : 0];
+  if ((LIT.m[0]->kernel == PPROC_GENERIC) || (LIT.m[1]->kernel == PPROC_GENERIC))
+    return;
+
+  /* Mostly both halves are the same, and only need doing once. */
+  if ((LIT.m[0]->kernel == LIT.m[1]->kernel) &&
+      (LIT.m[0]->s1     == LIT.m[1]->s1)     &&
+      (LIT.m[0]->dv2    == LIT.m[1]->dv2)    &&
+      (LIT.m[0]->av     == LIT.m[1]->av)     &&
+      (LIT.m[0]->mul    == LIT.m[1]->mul)    &&
+      (LIT.m[0]->shift  == LIT.m[1]->shift))
+    LIT.m[1] = LIT.m[0];
+
+  LIT.coded     = !(PRE0 & PRE0_LINEAR);
+  LIT.pmode_or  = pproj.pmodeORmask;
+  LIT.pmode_and = pproj.pmodeANDmask;
+  LIT.tmask     = (pdec.tmask ? 0xFFFF : 0);
+  LIT.blk       = ((CCBFLAGS & CCB_NOBLK) ? 0 : (1 << 10));
+
+  /* PPROJ_OUTPUT()'s VH bits, as masks. */
+  LIT.vh_pres  = !!(CCBFLAGS & CCB_PLUTPOS);
+  LIT.vh_const = CEL_ORIGIN_VH_VALUE;
+  LIT.swap     = ((CCBCTL0 & SWAPHV) && !(PRE1 & PRE1_NOSWAP));
+  LIT.vh_and   = 0xFFFF;
+  LIT.vh_or    = 0;
+  LIT.vh_ppmp  = 0;
+
+  switch(CCBCTL0 & B15POS_MASK)
+    {
+    case B15POS_0:
+      LIT.vh_and &= ~0x8000;
+      break;
+    case B15POS_1:
+      LIT.vh_or |= 0x8000;
+      break;
+    }
+
+  switch(CCBCTL0 & B0POS_MASK)
+    {
+    case B0POS_PPMP:
+      LIT.vh_and &= ~0x1;
+      LIT.vh_ppmp = 0x1;
+      break;
+    case B0POS_0:
+      LIT.vh_and &= ~0x1;
+      break;
+    case B0POS_1:
+      LIT.vh_or |= 0x1;
+      break;
+    }
+
+  LIT.level = opera_madam_simd_get();
+}
+
+/* PDEC() for n_ pixels from byte src_ of the CEL data (word aligned), for the table lookup cases. */
+static
+INLINE
+void
+literal_decode(uint16_t       *pres_,
+               const uint32_t  src_,
+               const int       n_)
+{
+  int i;
+
+  for(i = 0; i < n_; i++)
+    {
+      uint32_t p;
+
+      if (bpp == 16)
+        {
+          p = *((uint16_t*)&DRAM[(src_ + (i << 1)) ^ 2]);
+          pres_[i] = ((MADAM.PLUT[p & 0x1F] & 0x7FFF) | (p & 0x8000));
+        }
+      else
+        {
+          p = DRAM[(src_ + i) ^ 3];
+          pres_[i] = (LIT.coded ? MADAM.PLUT[p & 0x1F] : MAPu8b[p]);
+        }
+    }
+}
+
+/*
+  The ICache pages the writes of a group land in, for the pixels that
+  aren't transparent. keep_ has two bits per pixel (movemask of the 16
+  bit lanes), and a group never spans more than two pages.
+*/
+static
+INLINE
+void
+literal_icache(const uint32_t wr_,
+               const uint32_t keep_,
+               const int      n_)
+{
+  uint32_t last = (wr_ + ((n_ - 1) << 2));
+  uint32_t split;
+
+  if (!keep_)
+    return;
+
+  if ((wr_ >> OPERA_ARM_ICACHE_PAGE_SHIFT) == (last >> OPERA_ARM_ICACHE_PAGE_SHIFT))
+    {
+      opera_arm_icache_write(wr_);
+      return;
+    }
+
+  split = (((last & ~((1 << OPERA_ARM_ICACHE_PAGE_SHIFT) - 1)) - wr_) >> 1);
+  if (keep_ & ((1 << split) - 1))
+    opera_arm_icache_write(wr_);
+  if (keep_ >> split)
+    opera_arm_icache_write(last);
+}
+
+static
+INLINE
+TARGET("sse4.1")
+__m128i
+pproc_sse41(const __m128i       pix_,
+            const __m128i       fp_,
+            const pproc_mode_t *m_)
+{
+  int i;
+  __m128i out = _mm_setzero_si128();
+  const __m128i in    = (m_->s1 ? fp_ : pix_);
+  const __m128i c31   = _mm_set1_epi16(0x1F);
+  const __m128i c127  = _mm_set1_epi16(127);
+  const __m128i mul   = _mm_set1_epi16(m_->mul);
+  const __m128i av    = _mm_set1_epi16(m_->av);
+  const __m128i shift = _mm_cvtsi32_si128(m_->shift);
+  const __m128i dv2   = _mm_cvtsi32_si128(m_->dv2);
+
+  for(i = 0; i < 15; i += 5)
+    {
+      const __m128i sh = _mm_cvtsi32_si128(i);
+      __m128i c;
+
+      c = _mm_and_si128(_mm_srl_epi16(in,sh),c31);
+      c = _mm_srl_epi16(_mm_mullo_epi16(c,mul),shift);
+      if (m_->kernel == PPROC_ADD_CONST)
+        c = _mm_add_epi16(c,av);
+      else if (m_->kernel == PPROC_ADD_FRAME)
+        c = _mm_add_epi16(c,_mm_and_si128(_mm_srl_epi16(fp_,sh),c31));
+
+      /* through int8, then clipped to 0 - 31 */
+      c = _mm_srl_epi16(c,dv2);
+      c = _mm_andnot_si128(_mm_cmpgt_epi16(c,c127),_mm_min_epu16(c,c31));
+
+      out = _mm_or_si128(out,_mm_sll_epi16(c,sh));
+    }
+
+  return _mm_or_si128(out,_mm_and_si128(_mm_cmpeq_epi16(out,_mm_setzero_si128()),
+                                        _mm_set1_epi16(LIT.blk)));
+}
+
+/* n_ pixels (a multiple of 8) of a row, CEL data at byte src_, frame buffer at rd_ / wr_. */
+static
+TARGET("sse4.1")
+uint32_t
+literal_row_sse41(uint32_t  src_,
+                  uint32_t  rd_,
+                  uint32_t  wr_,
+                  int32_t   n_)
+{
+  uint32_t keep = 0;
+  uint16_t buf[8];
+  const __m128i lo16  = _mm_set1_epi32(0xFFFF);
+  const __m128i rdsh  = _mm_cvtsi32_si128((rd_ & 2) << 3);
+  const __m128i wrsh  = _mm_cvtsi32_si128((wr_ & 2) << 3);
+  const __m128i wrmsk = _mm_sll_epi32(lo16,wrsh);
+
+  rd_ &= ~3;
+  wr_ &= ~3;
+  for(; n_ > 0; n_ -= 8, rd_ += 32, wr_ += 32)
+    {
+      __m128i pres;
+      __m128i pix;
+      __m128i fp;
+      __m128i out;
+      __m128i vh;
+      __m128i v0;
+      __m128i v1;
+      __m128i w0;
+      __m128i w1;
+      __m128i k0;
+      __m128i k1;
+      __m128i kept;
+
+      if ((bpp == 16) && !LIT.coded)
+        {
+          pres = _mm_loadu_si128((__m128i*)&DRAM[src_]);
+          pres = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pres,0xB1),0xB1);
+        }
+      else
+        {
+          literal_decode(buf,src_,8);
+          pres = _mm_loadu_si128((__m128i*)buf);
+        }
+      src_ += bpp;
+
+      v0 = _mm_loadu_si128((__m128i*)&DRAM[rd_]);
+      v1 = _mm_loadu_si128((__m128i*)&DRAM[rd_ + 16]);
+      fp = _mm_packus_epi32(_mm_and_si128(_mm_srl_epi32(v0,rdsh),lo16),
+                            _mm_and_si128(_mm_srl_epi32(v1,rdsh),lo16));
+
+      pix = _mm_and_si128(_mm_or_si128(pres,_mm_set1_epi16(LIT.pmode_or)),
+                          _mm_set1_epi16(LIT.pmode_and));
+      out = pproc_sse41(pix,fp,LIT.m[0]);
+      if (LIT.m[1] != LIT.m[0])
+        out = _mm_blendv_epi8(out,pproc_sse41(pix,fp,LIT.m[1]),_mm_srai_epi16(pix,15));
+
+      /* PPROJ_OUTPUT() */
+      vh = (LIT.vh_pres ?
+            _mm_and_si128(pres,_mm_set1_epi16(0x8001)) :
+            _mm_set1_epi16(LIT.vh_const));
+      if (LIT.swap)
+        vh = _mm_or_si128(_mm_srli_epi16(vh,15),_mm_slli_epi16(vh,15));
+      vh  = _mm_or_si128(_mm_and_si128(vh,_mm_set1_epi16(LIT.vh_and)),_mm_set1_epi16(LIT.vh_or));
+      vh  = _mm_or_si128(vh,_mm_and_si128(out,_mm_set1_epi16(LIT.vh_ppmp)));
+      out = _mm_or_si128(_mm_and_si128(out,_mm_set1_epi16(0x7FFE)),vh);
+
+      /* Everything but the transparent pixels. */
+      kept = _mm_andnot_si128(_mm_and_si128(_mm_cmpeq_epi16(_mm_and_si128(pres,_mm_set1_epi16(0x7FFF)),
+                                                            _mm_setzero_si128()),
+                                            _mm_set1_epi16(LIT.tmask)),
+                              _mm_set1_epi16(-1));
+      keep = _mm_movemask_epi8(kept);
+      literal_icache(wr_,keep,8);
+
+      k0 = _mm_and_si128(_mm_cvtepi16_epi32(kept),wrmsk);
+      k1 = _mm_and_si128(_mm_cvtepi16_epi32(_mm_srli_si128(kept,8)),wrmsk);
+      v0 = _mm_sll_epi32(_mm_cvtepu16_epi32(out),wrsh);
+      v1 = _mm_sll_epi32(_mm_cvtepu16_epi32(_mm_srli_si128(out,8)),wrsh);
+      w0 = _mm_loadu_si128((__m128i*)&DRAM[wr_]);
+      w1 = _mm_loadu_si128((__m128i*)&DRAM[wr_ + 16]);
+      w0 = _mm_xor_si128(w0,_mm_and_si128(_mm_xor_si128(w0,v0),k0));
+      w1 = _mm_xor_si128(w1,_mm_and_si128(_mm_xor_si128(w1,v1),k1));
+      _mm_storeu_si128((__m128i*)&DRAM[wr_],w0);
+      _mm_storeu_si128((__m128i*)&DRAM[wr_ + 16],w1);
+    }
+
+  return keep;
+}
+
+static
+INLINE
+TARGET("avx2")
+__m256i
+pproc_avx2(const __m256i       pix_,
+           const __m256i       fp_,
+           const pproc_mode_t *m_)
+{
+  int i;
+  __m256i out = _mm256_setzero_si256();
+  const __m256i in    = (m_->s1 ? fp_ : pix_);
+  const __m256i c31   = _mm256_set1_epi16(0x1F);
+  const __m256i c127  = _mm256_set1_epi16(127);
+  const __m256i mul   = _mm256_set1_epi16(m_->mul);
+  const __m256i av    = _mm256_set1_epi16(m_->av);
+  const __m128i shift = _mm_cvtsi32_si128(m_->shift);
+  const __m128i dv2   = _mm_cvtsi32_si128(m_->dv2);
+
+  for(i = 0; i < 15; i += 5)
+    {
+      const __m128i sh = _mm_cvtsi32_si128(i);
+      __m256i c;
+
+      c = _mm256_and_si256(_mm256_srl_epi16(in,sh),c31);
+      c = _mm256_srl_epi16(_mm256_mullo_epi16(c,mul),shift);
+      if (m_->kernel == PPROC_ADD_CONST)
+        c = _mm256_add_epi16(c,av);
+      else if (m_->kernel == PPROC_ADD_FRAME)
+        c = _mm256_add_epi16(c,_mm256_and_si256(_mm256_srl_epi16(fp_,sh),c31));
+
+      c = _mm256_srl_epi16(c,dv2);
+      c = _mm256_andnot_si256(_mm256_cmpgt_epi16(c,c127),_mm256_min_epu16(c,c31));
+
+      out = _mm256_or_si256(out,_mm256_sll_epi16(c,sh));
+    }
+
+  return _mm256_or_si256(out,_mm256_and_si256(_mm256_cmpeq_epi16(out,_mm256_setzero_si256()),
+                                              _mm256_set1_epi16(LIT.blk)));
+}
+
+/* The same 16 pixels at a time. The packs work within each 128 bit half, hence the permutes. */
+static
+TARGET("avx2")
+uint32_t
+literal_row_avx2(uint32_t  src_,
+                 uint32_t  rd_,
+                 uint32_t  wr_,
+                 int32_t   n_)
+{
+  uint32_t keep = 0;
+  uint16_t buf[16];
+  const __m256i lo16  = _mm256_set1_epi32(0xFFFF);
+  const __m128i rdsh  = _mm_cvtsi32_si128((rd_ & 2) << 3);
+  const __m128i wrsh  = _mm_cvtsi32_si128((wr_ & 2) << 3);
+  const __m256i wrmsk = _mm256_sll_epi32(lo16,wrsh);
+
+  rd_ &= ~3;
+  wr_ &= ~3;
+  for(; n_ > 0; n_ -= 16, rd_ += 64, wr_ += 64)
+    {
+      __m256i pres;
+      __m256i pix;
+      __m256i fp;
+      __m256i out;
+      __m256i vh;
+      __m256i v0;
+      __m256i v1;
+      __m256i w0;
+      __m256i w1;
+      __m256i k0;
+      __m256i k1;
+      __m256i kept;
+
+      if ((bpp == 16) && !LIT.coded)
+        {
+          pres = _mm256_loadu_si256((__m256i*)&DRAM[src_]);
+          pres = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pres,0xB1),0xB1);
+        }
+      else
+        {
+          literal_decode(buf,src_,16);
+          pres = _mm256_loadu_si256((__m256i*)buf);
+        }
+      src_ += (bpp << 1);
+
+      v0 = _mm256_loadu_si256((__m256i*)&DRAM[rd_]);
+      v1 = _mm256_loadu_si256((__m256i*)&DRAM[rd_ + 32]);
+      fp = _mm256_packus_epi32(_mm256_and_si256(_mm256_srl_epi32(v0,rdsh),lo16),
+                               _mm256_and_si256(_mm256_srl_epi32(v1,rdsh),lo16));
+      fp = _mm256_permute4x64_epi64(fp,0xD8);
+
+      pix = _mm256_and_si256(_mm256_or_si256(pres,_mm256_set1_epi16(LIT.pmode_or)),
+                             _mm256_set1_epi16(LIT.pmode_and));
+      out = pproc_avx2(pix,fp,LIT.m[0]);
+      if (LIT.m[1] != LIT.m[0])
+        out = _mm256_blendv_epi8(out,pproc_avx2(pix,fp,LIT.m[1]),_mm256_srai_epi16(pix,15));
+
+      vh = (LIT.vh_pres ?
+            _mm256_and_si256(pres,_mm256_set1_epi16(0x8001)) :
+            _mm256_set1_epi16(LIT.vh_const));
+      if (LIT.swap)
+        vh = _mm256_or_si256(_mm256_srli_epi16(vh,15),_mm256_slli_epi16(vh,15));
+      vh  = _mm256_or_si256(_mm256_and_si256(vh,_mm256_set1_epi16(LIT.vh_and)),_mm256_set1_epi16(LIT.vh_or));
+      vh  = _mm256_or_si256(vh,_mm256_and_si256(out,_mm256_set1_epi16(LIT.vh_ppmp)));
+      out = _mm256_or_si256(_mm256_and_si256(out,_mm256_set1_epi16(0x7FFE)),vh);
+
+      kept = _mm256_andnot_si256(_mm256_and_si256(_mm256_cmpeq_epi16(_mm256_and_si256(pres,_mm256_set1_epi16(0x7FFF)),
+                                                                     _mm256_setzero_si256()),
+                                                  _mm256_set1_epi16(LIT.tmask)),
+                                 _mm256_set1_epi16(-1));
+      keep = _mm256_movemask_epi8(kept);
+      literal_icache(wr_,keep,16);
+
+      k0 = _mm256_and_si256(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(kept)),wrmsk);
+      k1 = _mm256_and_si256(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(kept,1)),wrmsk);
+      v0 = _mm256_sll_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(out)),wrsh);
+      v1 = _mm256_sll_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(out,1)),wrsh);
+      w0 = _mm256_loadu_si256((__m256i*)&DRAM[wr_]);
+      w1 = _mm256_loadu_si256((__m256i*)&DRAM[wr_ + 32]);
+      w0 = _mm256_xor_si256(w0,_mm256_and_si256(_mm256_xor_si256(w0,v0),k0));
+      w1 = _mm256_xor_si256(w1,_mm256_and_si256(_mm256_xor_si256(w1,v1),k1));
+      _mm256_storeu_si256((__m256i*)&DRAM[wr_],w0);
+      _mm256_storeu_si256((__m256i*)&DRAM[wr_ + 32],w1);
+    }
+
+  return keep;
+}
+
+/*
+  Draws as much of a 1:1 literal row at x_,y_ as it can, up to n_
+  pixels, and returns how many it did. The loop in
+  DrawLiteralCel_New() does the rest.
+*/
+static
+int32_t
+LiteralRow(int32_t x_,
+           int32_t y_,
+           int32_t n_)
+{
+  int32_t  d;
+  int32_t  done;
+  int32_t  group;
+  uint32_t rd;
+  uint32_t wr;
+  uint32_t src;
+  uint32_t keep;
+  uint16_t CURPIX;
+  uint16_t LAMV;
+
+  group = ((LIT.level == OPERA_MADAM_SIMD_AVX2) ? 16 : 8);
+  if (!bitoper.buf || BitReaderBig_BitPoint(&bitoper) || (n_ < (group + 3)))
+    return 0;
+
+  rd = (REGCTL2 + XY2OFF(x_,y_,MADAM.rmod));
+  wr = (REGCTL3 + XY2OFF(x_,y_,MADAM.wmod));
+  if ((rd | wr) & 1)
+    return 0;
+
+  /* A write that lands on a pixel a later one in the same group reads. */
+  d = (int32_t)(rd - wr);
+  if ((d < 0) && (d > -(group << 2)))
+    return 0;
+
+  /* Or on the CEL data. */
+  src = (bitoper.buf + BitReaderBig_Point(&bitoper));
+  if ((src < ((wr & ~3) + (n_ << 2))) && ((wr & ~3) < (src + ((n_ * bpp) >> 3) + 4)))
+    return 0;
+
+  /* Up to a word boundary in the CEL data, a pixel at a time. */
+  for(done = 0; (bitoper.buf + BitReaderBig_Point(&bitoper)) & 3; done++, x_++)
+    {
+      CURPIX = PDEC(BitReaderBig_Read(&bitoper,bpp),&LAMV);
+      if (!pproj.Transparent)
+        process_pixel(x_,y_,CURPIX,LAMV);
+    }
+
+  n_  = ((n_ - done) & ~(group - 1));
+  src = (bitoper.buf + BitReaderBig_Point(&bitoper));
+  rd  = ((REGCTL2 + XY2OFF(x_,y_,MADAM.rmod)) ^ 2);
+  wr  = ((REGCTL3 + XY2OFF(x_,y_,MADAM.wmod)) ^ 2);
+
+  if (group == 16)
+    keep = literal_row_avx2(src,rd,wr,n_);
+  else
+    keep = literal_row_sse41(src,rd,wr,n_);
+
+  BitReaderBig_Skip(&bitoper,(n_ * bpp));
+  pproj.Transparent = !(keep >> ((group << 1) - 1));
+
+  return (done + n_);
+}
+#endif /* OPERA_MADAM_SIMD */
+
 uint32_t*
 opera_madam_registers(void)
 {
@@ -1732,7 +2536,7 @@ DrawPackedCel_New(void)
           int wcnt;
           int scipw;
 
-          BitReaderBig_AttachBuffer(&bitoper,start);
+          BitReaderBig_AttachBuffer(&bitoper,DRAM,start);
           offset = BitReaderBig_Read(&bitoper,(offsetl << 3));
 
           lastaddr  = (start + ((offset + 2) << 2));
@@ -1756,7 +2560,7 @@ DrawPackedCel_New(void)
           while(!eor)
             {
               type = BitReaderBig_Read(&bitoper,2);
-              if ((int32_t)(bitoper.point + start) >= (lastaddr))
+              if ((int32_t)(BitReaderBig_Point(&bitoper) + start) >= (lastaddr))
                 type = 0;
 
               pixcount = BitReaderBig_Read(&bitoper,6) + 1;
@@ -1847,7 +2651,7 @@ DrawPackedCel_New(void)
 
       for(row = 0; row < SPRHI; row++)
         {
-          BitReaderBig_AttachBuffer(&bitoper,start);
+          BitReaderBig_AttachBuffer(&bitoper,DRAM,start);
           offset = BitReaderBig_Read(&bitoper,(offsetl << 3));
 
           lastaddr = (start + ((offset + 2) << 2));
@@ -1865,7 +2669,7 @@ DrawPackedCel_New(void)
               int32_t __pix;
 
               type = BitReaderBig_Read(&bitoper,2);
-              if ((bitoper.point + start) >= lastaddr) type = 0;
+              if ((BitReaderBig_Point(&bitoper) + start) >= lastaddr) type = 0;
 
               __pix = (BitReaderBig_Read(&bitoper,6) + 1);
 
@@ -1932,7 +2736,7 @@ DrawPackedCel_New(void)
       int row;
       for(row = 0; row < SPRHI; row++)
         {
-          BitReaderBig_AttachBuffer(&bitoper,start);
+          BitReaderBig_AttachBuffer(&bitoper,DRAM,start);
           offset = BitReaderBig_Read(&bitoper,(offsetl << 3));
 
           lastaddr = (start + ((offset + 2) << 2));
@@ -1958,7 +2762,7 @@ DrawPackedCel_New(void)
               int32_t __pix;
 
               type = BitReaderBig_Read(&bitoper,2);
-              if ((bitoper.point + start) >= lastaddr)
+              if ((BitReaderBig_Point(&bitoper) + start) >= lastaddr)
                 type = 0;
 
               __pix = (BitReaderBig_Read(&bitoper,6) + 1);
@@ -2081,11 +2885,15 @@ DrawLiteralCel_New(void)
         if (SPRWI > TEXTURE_WI_LIM)
           SPRWI = TEXTURE_WI_LIM;
 
+#if OPERA_MADAM_SIMD
+        LiteralRow_Init();
+#endif
+
         for(i = TEXTURE_HI_START; i < TEXTURE_HI_LIM; i++)
           {
             uint32_t j;
 
-            BitReaderBig_AttachBuffer(&bitoper,PDATA);
+            BitReaderBig_AttachBuffer(&bitoper,DRAM,PDATA);
             xcur = (xvert + TEXTURE_WI_START * HDX1616);
             ycur = (yvert + TEXTURE_WI_START * HDY1616);
             BitReaderBig_Skip(&bitoper,(bpp * (((PRE0 >> 24) & 0xF))));
@@ -2095,7 +2903,19 @@ DrawLiteralCel_New(void)
             xvert += VDX1616;
             yvert += VDY1616;
 
-            for(j = TEXTURE_WI_START; j < SPRWI; j++)
+            j = TEXTURE_WI_START;
+#if OPERA_MADAM_SIMD
+            if (LIT.level && ((int32_t)j < SPRWI))
+              {
+                int32_t done;
+
+                done  = LiteralRow(xcur >> 16,ycur >> 16,SPRWI - j);
+                j    += done;
+                xcur += (done << 16);
+              }
+#endif
+
+            for(; j < SPRWI; j++)
               {
                 CURPIX = PDEC(BitReaderBig_Read(&bitoper,bpp),&LAMV);
 
@@ -2123,7 +2943,7 @@ DrawLiteralCel_New(void)
 
         for(i = 0; i < SPRHI; i++)
           {
-            BitReaderBig_AttachBuffer(&bitoper,PDATA);
+            BitReaderBig_AttachBuffer(&bitoper,DRAM,PDATA);
             xcur   = xvert;
             ycur   = yvert;
             xvert += VDX1616;
@@ -2161,7 +2981,7 @@ DrawLiteralCel_New(void)
         SPRWI -= ((PRE0 >> 24) & 0xF);
         for(i = 0; i < SPRHI; i++)
           {
-            BitReaderBig_AttachBuffer(&bitoper,PDATA);
+            BitReaderBig_AttachBuffer(&bitoper,DRAM,PDATA);
 
             xcur = xvert;
             ycur = yvert;
@@ -2762,47 +3582,139 @@ TexelDraw_Line(uint16_t CURPIX_,
     }
 }
 
+/*
+  One row of the scale map: n_ pixels from x_, going dir_ (+1 or -1),
+  already clipped. The same as process_pixel() on each, but with the
+  XY2OFF() done once, and PPROC() only run again when the frame buffer
+  pixel changes. (it only depends on that while a CEL is drawing, the
+  same as TexelDraw_Line() and TexelDraw_Arbitrary() rely on)
+*/
 static
-INLINE
-uint16_t
-readPIX(int32_t x_,
-        int32_t y_)
-{
-  uint32_t src = REGCTL2;
-
-  if (HIRESMODE)
-    {
-      src += XY2OFF(x_ >> 1,y_ >> 1,MADAM.rmod);
-      src += ((((y_ & 1) << 1) + (x_ & 1)) * 1024 * 1024);
-    }
-  else
+FORCEINLINE
+void
+scale_span(const int32_t   x_,
+           const int32_t   y_,
+           int32_t         n_,
+           const int32_t   dir_,
+           const uint32_t  curpix_,
+           const uint32_t  lamv_,
+           uint32_t       *curr_,
+           uint32_t       *pixel_,
+           const int       hires_)
+{
+  uint32_t rd;
+  uint32_t wr;
+  const int32_t step = (dir_ << 2);
+
+  rd = (REGCTL2 + XY2OFF(x_,y_,MADAM.rmod));
+  wr = (REGCTL3 + XY2OFF(x_,y_,MADAM.wmod));
+  for(; n_ > 0; n_--, rd += step, wr += step)
     {
-      src += XY2OFF(x_,y_,MADAM.rmod);
-    }
+      uint32_t next;
 
-  return *((uint16_t*)&DRAM[src ^ 2]);
+      next = mread16(rd);
+      if (next != *curr_)
+        {
+          *curr_  = next;
+          *pixel_ = PPROC(curpix_,next,lamv_);
+          *pixel_ = PPROJ_OUTPUT(curpix_,*pixel_,next);
+        }
+
+      mwrite16_mode(wr,*pixel_,hires_);
+    }
 }
 
+/*
+  hires_ is a constant at each call, so there's a copy for each without
+  the HIRESMODE test in the loop.
+*/
 static
-INLINE
+FORCEINLINE
 void
-writePIX(int32_t  x_,
-         int32_t  y_,
-         uint16_t p_)
+scale_rows(const int32_t  x_,
+           const int32_t  n_,
+           int32_t        y_,
+           const int32_t  endy_,
+           const uint32_t curpix_,
+           const uint32_t lamv_,
+           const int      hires_)
 {
-  uint32_t src = REGCTL3;
+  uint32_t curr;
+  uint32_t pixel;
 
-  if (HIRESMODE)
+  curr  = 0xFFFFFFFF;
+  pixel = 0;
+  for(; y_ != endy_; y_ += TEXEL_INCY)
     {
-      src += XY2OFF(x_ >> 1,y_ >> 1,MADAM.wmod);
-      src += ((((y_ & 1) << 1) + (x_ & 1)) * 1024 * 1024);
+      if ((uint32_t)y_ > MADAM.clipy)
+        continue;
+
+      scale_span(x_,y_,n_,TEXEL_INCX,curpix_,lamv_,&curr,&pixel,hires_);
+    }
+}
+
+/*
+  One span of the arbitrary map, x_ up to maxx_, already clipped. In
+  HIRESMODE, bit 0 of x and y pick which of the four 1MB planes the
+  pixel is in, and the rest is the address within it. (the same as
+  readPIX() / writePIX() used to work out for every pixel)
+*/
+static
+FORCEINLINE
+void
+arbitrary_span(int32_t         x_,
+               const int32_t   maxx_,
+               const int32_t   y_,
+               const uint32_t  curpix_,
+               const uint32_t  lamv_,
+               uint32_t       *curr_,
+               uint32_t       *pixel_,
+               const int       hires_)
+{
+  uint32_t rd;
+  uint32_t wr;
+
+  if (hires_)
+    {
+      rd = (REGCTL2 + XY2OFF(0,y_ >> 1,MADAM.rmod) + ((y_ & 1) << 1) * 1024 * 1024);
+      wr = (REGCTL3 + XY2OFF(0,y_ >> 1,MADAM.wmod) + ((y_ & 1) << 1) * 1024 * 1024);
     }
   else
     {
-      src += XY2OFF(x_,y_,MADAM.wmod);
+      rd = (REGCTL2 + XY2OFF(x_,y_,MADAM.rmod));
+      wr = (REGCTL3 + XY2OFF(x_,y_,MADAM.wmod));
     }
 
-  *((uint16_t*)&DRAM[src ^ 2]) = p_;
+  for(; x_ < maxx_; x_++)
+    {
+      uint32_t src;
+      uint32_t dst;
+      uint32_t next;
+
+      if (hires_)
+        {
+          src = (rd + ((x_ >> 1) << 2) + ((x_ & 1) * 1024 * 1024));
+          dst = (wr + ((x_ >> 1) << 2) + ((x_ & 1) * 1024 * 1024));
+        }
+      else
+        {
+          src = rd;
+          dst = wr;
+          rd += 4;
+          wr += 4;
+        }
+
+      next = *((uint16_t*)&DRAM[src ^ 2]);
+      if (next != *curr_)
+        {
+          *curr_  = next;
+          *pixel_ = PPROC(curpix_,next,lamv_);
+          *pixel_ = PPROJ_OUTPUT(curpix_,*pixel_,next);
+        }
+
+      opera_arm_icache_write(dst);
+      *((uint16_t*)&DRAM[dst ^ 2]) = *pixel_;
+    }
 }
 
 static
@@ -2816,8 +3728,7 @@ TexelDraw_Scale(uint16_t CURPIX_,
 {
   int32_t x;
   int32_t y;
-  uint32_t pixel;
-  uint32_t framePixel;
+  int32_t n;
 
   if (FIXMODE & FIX_BIT_TIMING_3)
     {
@@ -2837,17 +3748,46 @@ TexelDraw_Scale(uint16_t CURPIX_,
   if (xcur_ == deltax_)
     return 0;
 
-  for(y = ycur_; y != deltay_; y += TEXEL_INCY)
+  /*
+    If deltax is behind xcur, x goes the long way round. Leave that to
+    the pixel at a time loop.
+  */
+  if ((TEXEL_INCX > 0) ? (deltax_ < xcur_) : (deltax_ > xcur_))
     {
-      for(x = xcur_; x != deltax_; x += TEXEL_INCX)
+      for(y = ycur_; y != deltay_; y += TEXEL_INCY)
         {
-          if (!TESTCLIP(x,y))
-            continue;
+          for(x = xcur_; x != deltax_; x += TEXEL_INCX)
+            {
+              if (!TESTCLIP(x,y))
+                continue;
 
-          process_pixel(x,y,CURPIX_,LAMV_);
+              process_pixel(x,y,CURPIX_,LAMV_);
+            }
         }
+
+      return 0;
+    }
+
+  /* Every row covers the same x, so clip that once. */
+  if (TEXEL_INCX > 0)
+    {
+      x = ((xcur_ < 0) ? 0 : xcur_);
+      n = (((deltax_ - 1) > MADAM.clipx) ? MADAM.clipx : (deltax_ - 1)) - x + 1;
+    }
+  else
+    {
+      x = ((xcur_ > MADAM.clipx) ? MADAM.clipx : xcur_);
+      n = x - (((deltax_ + 1) < 0) ? 0 : (deltax_ + 1)) + 1;
     }
 
+  if (n <= 0)
+    return 0;
+
+  if (HIRESMODE)
+    scale_rows(x,n,ycur_,deltay_,CURPIX_,LAMV_,1);
+  else
+    scale_rows(x,n,ycur_,deltay_,CURPIX_,LAMV_,0);
+
   return 0;
 }
 
@@ -2873,12 +3813,12 @@ TexelDraw_Arbitrary(uint16_t CURPIX_,
   int32_t maxyt;
   int32_t tmp;
   uint32_t curr;
-  uint32_t next;
   uint32_t pixel;
   int32_t xpoints[4];
   int32_t updowns[4];
 
-  curr = -1;
+  curr  = -1;
+  pixel = 0;
   xA_ >>= (16 - HIRESMODE);
   xB_ >>= (16 - HIRESMODE);
   xC_ >>= (16 - HIRESMODE);
@@ -3007,17 +3947,10 @@ TexelDraw_Arbitrary(uint16_t CURPIX_,
                   if (maxx > maxxt)
                     maxx = maxxt;
 
-                  for(; x < maxx; x++)
-                    {
-                      next = readPIX(x,y);
-                      if (next != curr)
-                        {
-                          curr  = next;
-                          pixel = PPROC(CURPIX_,next,LAMV_);
-                          pixel = PPROJ_OUTPUT(CURPIX_,pixel,next);
-                        }
-                      /*if (x == 0 || x == maxx - 1) writePIX(x, y, 0xFF00FF00); else*/ writePIX(x, y, pixel);
-                    }
+                  if (HIRESMODE)
+                    arbitrary_span(x,maxx,y,CURPIX_,LAMV_,&curr,&pixel,1);
+                  else
+                    arbitrary_span(x,maxx,y,CURPIX_,LAMV_,&curr,&pixel,0);
                 }
             }
 
@@ -3032,17 +3965,10 @@ TexelDraw_Arbitrary(uint16_t CURPIX_,
               if (maxx > maxxt)
                 maxx = maxxt;
 
-              for(; x < maxx; x++)
-                {
-                  next = readPIX(x,y);
-                  if (next != curr)
-                    {
-                      curr  = next;
-                      pixel = PPROC(CURPIX_,next,LAMV_);
-                      pixel = PPROJ_OUTPUT(CURPIX_,pixel,next);
-                    }
-                  /*if (x == 0 || x==maxx-1) writePIX(x, y, 0xFF00FF00); else*/ writePIX(x, y, pixel);
-                }
+              if (HIRESMODE)
+                arbitrary_span(x,maxx,y,CURPIX_,LAMV_,&curr,&pixel,1);
+              else
+                arbitrary_span(x,maxx,y,CURPIX_,LAMV_,&curr,&pixel,0);
             }
         }
     }
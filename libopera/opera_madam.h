@@ -57,6 +57,34 @@ void      opera_madam_kprint_disable(void);
 void      opera_madam_me_mode_software(void);
 void      opera_madam_me_mode_hardware(void);
 
+/*
+  Which version literal CELs drawn 1:1 use. The best one the CPU has,
+  unless set lower. All of them give the same results.
+*/
+#define OPERA_MADAM_SIMD_NONE  0
+#define OPERA_MADAM_SIMD_SSE41 1
+#define OPERA_MADAM_SIMD_AVX2  2
+
+int       opera_madam_simd_get(void);
+int       opera_madam_simd_set(const int level_);
+
+/*
+  What the CEL engine has been given since the last clear. CCBs in a
+  list mostly share a PIXC, and the PPROC setup for it is used again
+  (pixc_hits) until it changes (pixc_misses).
+*/
+typedef struct opera_madam_ccb_stats_s opera_madam_ccb_stats_t;
+struct opera_madam_ccb_stats_s
+{
+  uint64_t ccbs;
+  uint64_t pluts;
+  uint64_t pixc_hits;
+  uint64_t pixc_misses;
+};
+
+void      opera_madam_ccb_stats_get(opera_madam_ccb_stats_t *stats_);
+void      opera_madam_ccb_stats_clear(void);
+
 uint32_t  opera_madam_state_size(void);
 void      opera_madam_state_save(void *buf_);
 void      opera_madam_state_load(const void *buf_);
@@ -57,29 +57,151 @@ opera_swi_hle_0x50002(uint8_t *ram_,
   MulManyVec3Mat33_F16(dest,src,*mat,count);
 }
 
-/* void MulObjectVec3Mat33_F16(void *objectlist[], ObjOffset1 *offsetstruct, int32 count); */
+/*
+  The object calls: objectlist is an array of pointers to objects, and
+  offsetstruct says where in each object to find things. Pointers to the
+  dest and source arrays, and the count, for ObjOffset1. The matrices
+  themselves, for ObjOffset2. count is the number of objects.
+
+  Every one of those pointers comes out of guest memory, so they're all
+  checked against ram_ (DRAM then VRAM, size_ bytes) before anything is
+  written. If any is out, the call returns 0 and goes to the kernel
+  instead. The objects get checked again on the way through, in case
+  one of them overwrote the list; that stops where it went wrong.
+*/
 static
 INLINE
-void
-opera_swi_hle_0x50003(char    *ram_,
-                      uint8_t  r0_,
-                      uint8_t  r1_,
-                      uint8_t  r2_)
+int
+opera_swi_hle_in_ram(const uint32_t size_,
+                     const uint32_t addr_,
+                     const uint64_t bytes_)
+{
+  return (((uint64_t)addr_ + bytes_) <= size_);
+}
+
+static
+INLINE
+int
+opera_swi_hle_obj1_ok(const uint8_t    *ram_,
+                      const uint32_t    size_,
+                      const uint32_t    obj_,
+                      const ObjOffset1 *oo_,
+                      const uint32_t    vec_,
+                      const uint32_t    mat_)
 {
+  uint32_t dest = (obj_ + oo_->oo1_DestArrayPtrOffset);
+  uint32_t src  = (obj_ + oo_->oo1_SrcArrayPtrOffset);
+  uint32_t cnt  = (obj_ + oo_->oo1_CountOffset);
+  int32_t  count;
+
+  if(!opera_swi_hle_in_ram(size_,dest,4) ||
+     !opera_swi_hle_in_ram(size_,src,4)  ||
+     !opera_swi_hle_in_ram(size_,cnt,4)  ||
+     !opera_swi_hle_in_ram(size_,(obj_ + oo_->oo1_MatOffset),mat_))
+    return 0;
+
+  count = *(const int32_t*)&ram_[cnt];
+  if(count <= 0)
+    return 1;
+
+  return (opera_swi_hle_in_ram(size_,*(const uint32_t*)&ram_[dest],(uint64_t)count * vec_) &&
+          opera_swi_hle_in_ram(size_,*(const uint32_t*)&ram_[src],(uint64_t)count * vec_));
+}
 
+static
+INLINE
+int
+opera_swi_hle_obj2_ok(const uint32_t    size_,
+                      const uint32_t    obj_,
+                      const ObjOffset2 *oo_,
+                      const uint32_t    mat_)
+{
+  return (opera_swi_hle_in_ram(size_,(obj_ + oo_->oo2_DestMatOffset),mat_) &&
+          opera_swi_hle_in_ram(size_,(obj_ + oo_->oo2_SrcMatOffset),mat_));
+}
+
+/* void MulObjectVec3Mat33_F16(void *objectlist[], ObjOffset1 *offsetstruct, int32 count); */
+static
+INLINE
+int
+opera_swi_hle_0x50003(uint8_t  *ram_,
+                      uint32_t  size_,
+                      uint32_t  r0_,
+                      uint32_t  r1_,
+                      uint32_t  r2_)
+{
+  int32_t i;
+  uint32_t obj;
+  const ObjOffset1 *oo = (const ObjOffset1*)&ram_[r1_];
+
+  if((int32_t)r2_ <= 0)
+    return 1;
+  if(!opera_swi_hle_in_ram(size_,r1_,sizeof(ObjOffset1)) ||
+     !opera_swi_hle_in_ram(size_,r0_,(uint64_t)r2_ << 2))
+    return 0;
+
+  for(i = 0; i < (int32_t)r2_; i++)
+    {
+      obj = *(uint32_t*)&ram_[r0_ + (i << 2)];
+      if(!opera_swi_hle_obj1_ok(ram_,size_,obj,oo,sizeof(vec3f16),sizeof(mat33f16)))
+        return 0;
+    }
+
+  for(i = 0; i < (int32_t)r2_; i++)
+    {
+      obj = *(uint32_t*)&ram_[r0_ + (i << 2)];
+      if(!opera_swi_hle_obj1_ok(ram_,size_,obj,oo,sizeof(vec3f16),sizeof(mat33f16)))
+        break;
+      MulManyVec3Mat33_F16((vec3f16*)&ram_[*(uint32_t*)&ram_[obj + oo->oo1_DestArrayPtrOffset]],
+                           (vec3f16*)&ram_[*(uint32_t*)&ram_[obj + oo->oo1_SrcArrayPtrOffset]],
+                           *(mat33f16*)&ram_[obj + oo->oo1_MatOffset],
+                           *(int32_t*)&ram_[obj + oo->oo1_CountOffset]);
+    }
+
+  return 1;
 }
 
 /* void MulObjectMat33_F16(void *objectlist[], ObjOffset2 *offsetstruct, mat33f16 mat, int32 count); */
 static
 INLINE
-void
-opera_swi_hle_0x50004(char     *ram_,
+int
+opera_swi_hle_0x50004(uint8_t  *ram_,
+                      uint32_t  size_,
                       uint32_t  r0_,
                       uint32_t  r1_,
                       uint32_t  r2_,
                       uint32_t  r3_)
 {
+  int32_t i;
+  uint32_t obj;
+  const ObjOffset2 *oo = (const ObjOffset2*)&ram_[r1_];
+  mat33f16 *mat = (mat33f16*)&ram_[r2_];
 
+  if((int32_t)r3_ <= 0)
+    return 1;
+  if(!opera_swi_hle_in_ram(size_,r1_,sizeof(ObjOffset2)) ||
+     !opera_swi_hle_in_ram(size_,r2_,sizeof(mat33f16))   ||
+     !opera_swi_hle_in_ram(size_,r0_,(uint64_t)r3_ << 2))
+    return 0;
+
+  for(i = 0; i < (int32_t)r3_; i++)
+    {
+      obj = *(uint32_t*)&ram_[r0_ + (i << 2)];
+      if(!opera_swi_hle_obj2_ok(size_,obj,oo,sizeof(mat33f16)))
+        return 0;
+    }
+
+  for(i = 0; i < (int32_t)r3_; i++)
+    {
+      obj = *(uint32_t*)&ram_[r0_ + (i << 2)];
+      if(!opera_swi_hle_obj2_ok(size_,obj,oo,sizeof(mat33f16)))
+        break;
+      MulMat33Mat33_F16(*(mat33f16*)&ram_[obj + oo->oo2_DestMatOffset],
+                        *(mat33f16*)&ram_[obj + oo->oo2_SrcMatOffset],
+                        *mat);
+    }
+
+  return 1;
 }
 
 /* void MulManyF16(frac16 *dest, frac16 *src1, frac16 *src2, int32 count); */
@@ -168,29 +290,88 @@ opera_swi_hle_0x50009(uint8_t *ram_,
   MulManyVec4Mat44_F16(dest,src,*mat,count);
 }
 
-/* void MulObjectVec4Mat44_F16(void *objectlist[], ObjeOffset1 *offsetstruct, int32 count);  */
+/* void MulObjectVec4Mat44_F16(void *objectlist[], ObjOffset1 *offsetstruct, int32 count); */
 static
 INLINE
-void
-opera_swi_hle_0x5000A(char     *ram_,
+int
+opera_swi_hle_0x5000A(uint8_t  *ram_,
+                      uint32_t  size_,
                       uint32_t  r0_,
                       uint32_t  r1_,
                       uint32_t  r2_)
 {
-
+  int32_t i;
+  uint32_t obj;
+  const ObjOffset1 *oo = (const ObjOffset1*)&ram_[r1_];
+
+  if((int32_t)r2_ <= 0)
+    return 1;
+  if(!opera_swi_hle_in_ram(size_,r1_,sizeof(ObjOffset1)) ||
+     !opera_swi_hle_in_ram(size_,r0_,(uint64_t)r2_ << 2))
+    return 0;
+
+  for(i = 0; i < (int32_t)r2_; i++)
+    {
+      obj = *(uint32_t*)&ram_[r0_ + (i << 2)];
+      if(!opera_swi_hle_obj1_ok(ram_,size_,obj,oo,sizeof(vec4f16),sizeof(mat44f16)))
+        return 0;
+    }
+
+  for(i = 0; i < (int32_t)r2_; i++)
+    {
+      obj = *(uint32_t*)&ram_[r0_ + (i << 2)];
+      if(!opera_swi_hle_obj1_ok(ram_,size_,obj,oo,sizeof(vec4f16),sizeof(mat44f16)))
+        break;
+      MulManyVec4Mat44_F16((vec4f16*)&ram_[*(uint32_t*)&ram_[obj + oo->oo1_DestArrayPtrOffset]],
+                           (vec4f16*)&ram_[*(uint32_t*)&ram_[obj + oo->oo1_SrcArrayPtrOffset]],
+                           *(mat44f16*)&ram_[obj + oo->oo1_MatOffset],
+                           *(int32_t*)&ram_[obj + oo->oo1_CountOffset]);
+    }
+
+  return 1;
 }
 
-/* void MulObjectMat44_F16(void *objectlist[], ObjOffset2 *offsetstruct, mat44f16 mat, int32 count);  */
+/* void MulObjectMat44_F16(void *objectlist[], ObjOffset2 *offsetstruct, mat44f16 mat, int32 count); */
 static
 INLINE
-void
-opera_swi_hle_0x5000B(char     *ram_,
+int
+opera_swi_hle_0x5000B(uint8_t  *ram_,
+                      uint32_t  size_,
                       uint32_t  r0_,
                       uint32_t  r1_,
                       uint32_t  r2_,
                       uint32_t  r3_)
 {
-
+  int32_t i;
+  uint32_t obj;
+  const ObjOffset2 *oo = (const ObjOffset2*)&ram_[r1_];
+  mat44f16 *mat = (mat44f16*)&ram_[r2_];
+
+  if((int32_t)r3_ <= 0)
+    return 1;
+  if(!opera_swi_hle_in_ram(size_,r1_,sizeof(ObjOffset2)) ||
+     !opera_swi_hle_in_ram(size_,r2_,sizeof(mat44f16))   ||
+     !opera_swi_hle_in_ram(size_,r0_,(uint64_t)r3_ << 2))
+    return 0;
+
+  for(i = 0; i < (int32_t)r3_; i++)
+    {
+      obj = *(uint32_t*)&ram_[r0_ + (i << 2)];
+      if(!opera_swi_hle_obj2_ok(size_,obj,oo,sizeof(mat44f16)))
+        return 0;
+    }
+
+  for(i = 0; i < (int32_t)r3_; i++)
+    {
+      obj = *(uint32_t*)&ram_[r0_ + (i << 2)];
+      if(!opera_swi_hle_obj2_ok(size_,obj,oo,sizeof(mat44f16)))
+        break;
+      MulMat44Mat44_F16(*(mat44f16*)&ram_[obj + oo->oo2_DestMatOffset],
+                        *(mat44f16*)&ram_[obj + oo->oo2_SrcMatOffset],
+                        *mat);
+    }
+
+  return 1;
 }
 
 /* frac16 Dot3_F16(vec3f16 v1, vec3f16 v2); */
@@ -211,7 +392,7 @@ opera_swi_hle_0x5000C(uint8_t *ram_,
 static
 INLINE
 uint32_t
-opera_swi_hle_0x5000D(char     *ram_,
+opera_swi_hle_0x5000D(uint8_t  *ram_,
                       uint32_t  r0_,
                       uint32_t  r1_)
 {
@@ -279,20 +460,44 @@ opera_swi_hle_0x50011(uint8_t *ram_,
   MulVec3Mat33DivZ_F16(*dest,*vec,*mat,n);
 }
 
-/* void MulManyVec3Mat33DivZ_F16(mmv3m33d *s);  */
+/*
+  void MulManyVec3Mat33DivZ_F16(mmv3m33d *s);
+  Its pointers come out of guest memory too, so they get the same check.
+*/
 static
 INLINE
-void
-opera_swi_hle_0x50012(uint8_t     *ram_,
+int
+opera_swi_hle_0x50012(uint8_t  *ram_,
+                      uint32_t  size_,
                       uint32_t  r0_)
 {
-  vec3f16 *dest  = (vec3f16*)&ram_[*(uint32_t*)&ram_[r0_ + 0x00]];
-  vec3f16 *src   = (vec3f16*)&ram_[*(uint32_t*)&ram_[r0_ + 0x04]];
-  mat33f16 *mat  = (mat33f16*)&ram_[*(uint32_t*)&ram_[r0_ + 0x08]];
-  frac16 n       = *(frac16*)&ram_[r0_ + 0x0C];
-  uint32_t count = *(uint32_t*)&ram_[r0_ + 0x10];
-
-  MulManyVec3Mat33DivZ_F16(dest,src,mat,n,count);
+  uint32_t dest;
+  uint32_t src;
+  uint32_t mat;
+  frac16   n;
+  uint32_t count;
+
+  if(!opera_swi_hle_in_ram(size_,r0_,0x14))
+    return 0;
+
+  dest  = *(uint32_t*)&ram_[r0_ + 0x00];
+  src   = *(uint32_t*)&ram_[r0_ + 0x04];
+  mat   = *(uint32_t*)&ram_[r0_ + 0x08];
+  n     = *(frac16*)&ram_[r0_ + 0x0C];
+  count = *(uint32_t*)&ram_[r0_ + 0x10];
+
+  if(!opera_swi_hle_in_ram(size_,dest,(uint64_t)count * sizeof(vec3f16)) ||
+     !opera_swi_hle_in_ram(size_,src,(uint64_t)count * sizeof(vec3f16))  ||
+     !opera_swi_hle_in_ram(size_,mat,sizeof(mat33f16)))
+    return 0;
+
+  MulManyVec3Mat33DivZ_F16((vec3f16*)&ram_[dest],
+                           (vec3f16*)&ram_[src],
+                           (mat33f16*)&ram_[mat],
+                           n,
+                           count);
+
+  return 1;
 }
 
 #endif
@@ -19,6 +19,7 @@
 */
 
 extern vdlp_t   g_VDLP          = {0};
+uint32_t        opera_vdlp_bmp_origin;
 
 static uint8_t *g_VRAM          = NULL;
 static void    *g_BUF           = NULL;
@@ -24,7 +24,7 @@ typedef enum vdlp_pixel_format_e vdlp_pixel_format_e;
 
 EXTERN_C_BEGIN
 
-uint32_t opera_vdlp_bmp_origin;
+extern uint32_t opera_vdlp_bmp_origin;
 
 void     opera_vdlp_init(uint8_t *vram_);
 
@@ -0,0 +1,24 @@
+# Profile-guided build of the headless runner, using Verilator's --prof-pgo flow.
+#
+# 1. PGO=gen build. The model records how long each of its thread tasks takes, and GCC / Clang record the branches.
+# 2. Training run. A plain BIOS boot, with the Verilator profile written to $OUT/profile.vlt.
+# 3. PGO=use build. Verilator rebalances the threads from profile.vlt, and the compiler lays the code out from its own profile.
+#
+# The profile only fits the thread count it was made with, so keep THREADS the same for all three steps (this script does).
+#
+# Usage: ./pgo_headless.sh     (BIOS / ROM2 / CYCLES pick the training run. THREADS / TRACE / OUT / CC / CXX as for verilate_headless.sh)
+
+set -e
+
+BIOS=${BIOS:-panafz10.bin}
+ROM2=${ROM2:-panafz1-kanji.bin}
+CYCLES=${CYCLES:-20000000}
+OUT=${OUT:-out_headless}
+export OUT
+
+PGO=gen ./verilate_headless.sh
+
+echo "Training run: $CYCLES cycles of $BIOS"
+$OUT/sim_3do_headless --bios $BIOS --rom2 $ROM2 --cycles $CYCLES +verilator+prof+vlt+file+$OUT/profile.vlt
+
+PGO=use ./verilate_headless.sh
@@ -0,0 +1,460 @@
+// Address decoder tables for verilate(). See sim_bus.h. ElectronAsh.
+//
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim_bus.h"
+
+typedef struct sim_bus_reg_t {
+	uint32_t start;		// First byte address.
+	uint32_t end;		// Last byte address. (inclusive, same as the old compares)
+	const char* rd_name;
+	const char* wr_name;
+	uint8_t rd_op;
+	uint8_t wr_op;
+} sim_bus_reg_t;
+
+#define BUS_REG(addr_, name_)			{ addr_, addr_, name_, name_, SIM_BUS_NONE, SIM_BUS_NONE }
+#define BUS_RANGE(start_, end_, name_)	{ start_, end_, name_, name_, SIM_BUS_NONE, SIM_BUS_NONE }
+
+static const sim_bus_reg_t sim_bus_regs[] = {
+	// Host-side memories and slow-bus devices...
+	{ 0x00200000, 0x003FFFFF, NULL, NULL, SIM_BUS_VRAM, SIM_BUS_VRAM },
+	{ 0x03000000, 0x030FFFFF, NULL, NULL, SIM_BUS_BIOS, SIM_BUS_BIOS },
+	{ 0x03100000, 0x0313FFFF, "Brooktree       ", "Brooktree       ", SIM_BUS_BROOKTREE, SIM_BUS_BROOKTREE },
+	{ 0x03140000, 0x0315FFFF, "NVRAM           ", "NVRAM           ", SIM_BUS_NVRAM, SIM_BUS_NVRAM },
+	{ 0x03180000, 0x03180000, "DiagPort        ", "DiagPort        ", SIM_BUS_DIAG_GET, SIM_BUS_DIAG_SEND },
+	{ 0x03180004, 0x031BFFFF, "Slow Bus        ", "Slow Bus        ", SIM_BUS_ZERO, SIM_BUS_ZERO },
+
+	{ 0x03200000, 0x03200FFF, "VRAM SVF Source ", "VRAM SVF Copy   ", SIM_BUS_SVF_SOURCE, SIM_BUS_SVF_COPY },
+	{ 0x03202000, 0x03202FFF, NULL, "VRAM SVF Color  ", SIM_BUS_NONE, SIM_BUS_SVF_COLOR },
+	{ 0x03204000, 0x03204FFF, NULL, "VRAM SVF Flash  ", SIM_BUS_NONE, SIM_BUS_SVF_FLASH },
+	{ 0x03206000, 0x03206FFF, "VRAM SVF Refresh", "VRAM SVF Refresh", SIM_BUS_BADACCE5, SIM_BUS_BADACCE5 },
+
+	{ 0x032F0000, 0x032FFFFF, "Unknown         ", "Unknown         ", SIM_BUS_BADACCE5, SIM_BUS_BADACCE5 },
+
+	// Every access from here down gets its data from the Verilog MADAM / CLIO, unless there's an op.
+	//
+	// MADAM...
+	{ 0x03300000, 0x03300000, "MADAM Revision  ", "MADAM Print     ", SIM_BUS_NONE, SIM_BUS_MADAM_PRINT },
+
+	BUS_REG( 0x03300004, "MADAM msysbits  " ),
+	BUS_REG( 0x03300008, "MADAM mctl      " ),
+	BUS_REG( 0x0330000C, "MADAM sltime    " ),
+	BUS_RANGE( 0x03300010, 0x0330001F, "MADAM MultiChip " ),
+
+	BUS_REG( 0x03300020, "MADAM Abortbits " ),
+	BUS_REG( 0x03300024, "MADAM Privbits  " ),
+	BUS_REG( 0x03300028, "MADAM StatBits  " ),
+	BUS_REG( 0x0330002C, "MADAM Rsrvd 2c  " ),
+
+	BUS_REG( 0x03300030, "MADAM Rsrvd 30  " ),
+	BUS_REG( 0x03300040, "MADAM Diag/hcnt " ),
+	BUS_REG( 0x03300044, "MADAM Spare 44  " ),
+	BUS_REG( 0x03300048, "MADAM Rsrvd 48  " ),
+	BUS_REG( 0x03300080, "MADAM Rsrvd 80  " ),
+
+	BUS_REG( 0x03300100, "MADAM CELStart  " ),
+	BUS_REG( 0x03300104, "MADAM CELStop   " ),
+	BUS_REG( 0x03300108, "MADAM CELCont   " ),
+	BUS_REG( 0x0330010C, "MADAM CELPause  " ),
+	BUS_REG( 0x03300110, "MADAM CCBCtl0   " ),
+	BUS_REG( 0x03300114, "MADAM Rsrvd 114 " ),
+	BUS_REG( 0x03300120, "MADAM CCB_PIXC  " ),
+
+	BUS_REG( 0x03300130, "MADAM RegisCtl0 " ),
+	BUS_REG( 0x03300134, "MADAM RegisCtl1 " ),
+	BUS_REG( 0x03300138, "MADAM RegisCtl2 " ),
+	BUS_REG( 0x0330013C, "MADAM RegisCtl3 " ),
+
+	BUS_REG( 0x03300140, "MADAM XYPosH    " ),
+	BUS_REG( 0x03300144, "MADAM XYPosL    " ),
+	BUS_REG( 0x03300148, "MADAM Line_dXYH " ),
+	BUS_REG( 0x0330014C, "MADAM Line_dXYL " ),
+	BUS_REG( 0x03300150, "MADAM dXYH      " ),
+	BUS_REG( 0x03300154, "MADAM dXYL      " ),
+	BUS_REG( 0x03300158, "MADAM ddXYH     " ),
+	BUS_REG( 0x0330015C, "MADAM ddXYL     " ),
+	BUS_REG( 0x03300160, "MADAM Rsrvd 160 " ),
+
+	BUS_RANGE( 0x03300180, 0x033001FF, "MADAM PLUT      " ),
+
+	BUS_REG( 0x03300218, "MADAM Fence0    " ),
+	BUS_REG( 0x0330021C, "MADAM Fence1    " ),
+	BUS_REG( 0x03300238, "MADAM Fence2    " ),
+	BUS_REG( 0x0330023C, "MADAM Fence3    " ),
+
+	BUS_REG( 0x03300400, "MADAM DMA00 Adr " ),	// RamToDSPP0
+	BUS_REG( 0x03300404, "MADAM DMA00 Len " ),
+	BUS_REG( 0x03300408, "MADAM DMA00 NAd " ),
+	BUS_REG( 0x0330040C, "MADAM DMA00 NLn " ),
+
+	BUS_REG( 0x03300410, "MADAM DMA01 Adr " ),	// RamToDSPP1
+	BUS_REG( 0x03300414, "MADAM DMA01 Len " ),
+	BUS_REG( 0x03300418, "MADAM DMA01 NAd " ),
+	BUS_REG( 0x0330041C, "MADAM DMA01 NLn " ),
+
+	BUS_REG( 0x03300420, "MADAM DMA02 Adr " ),	// RamToDSPP2
+	BUS_REG( 0x03300424, "MADAM DMA02 Len " ),
+	BUS_REG( 0x03300428, "MADAM DMA02 NAd " ),
+	BUS_REG( 0x0330042C, "MADAM DMA02 NLn " ),
+
+	BUS_REG( 0x03300430, "MADAM DMA03 Adr " ),	// RamToDSPP3
+	BUS_REG( 0x03300434, "MADAM DMA03 Len " ),
+	BUS_REG( 0x03300438, "MADAM DMA03 NAd " ),
+	BUS_REG( 0x0330043C, "MADAM DMA03 NLn " ),
+
+	BUS_REG( 0x03300440, "MADAM DMA04 Adr " ),	// RamToDSPP4
+	BUS_REG( 0x03300444, "MADAM DMA04 Len " ),
+	BUS_REG( 0x03300448, "MADAM DMA04 NAd " ),
+	BUS_REG( 0x0330044C, "MADAM DMA04 NLn " ),
+
+	BUS_REG( 0x03300450, "MADAM DMA05 Adr " ),	// RamToDSPP5
+	BUS_REG( 0x03300454, "MADAM DMA05 Len " ),
+	BUS_REG( 0x03300458, "MADAM DMA05 NAd " ),
+	BUS_REG( 0x0330045C, "MADAM DMA05 NLn " ),
+
+	BUS_REG( 0x03300460, "MADAM DMA06 Adr " ),	// RamToDSPP6
+	BUS_REG( 0x03300464, "MADAM DMA06 Len " ),
+	BUS_REG( 0x03300468, "MADAM DMA06 NAd " ),
+	BUS_REG( 0x0330046C, "MADAM DMA06 NLn " ),
+
+	BUS_REG( 0x03300470, "MADAM DMA07 Adr " ),	// RamToDSPP7
+	BUS_REG( 0x03300474, "MADAM DMA07 Len " ),
+	BUS_REG( 0x03300478, "MADAM DMA07 NAd " ),
+	BUS_REG( 0x0330047C, "MADAM DMA07 NLn " ),
+
+	BUS_REG( 0x03300480, "MADAM DMA08 Adr " ),	// RamToDSPP8
+	BUS_REG( 0x03300484, "MADAM DMA08 Len " ),
+	BUS_REG( 0x03300488, "MADAM DMA08 NAd " ),
+	BUS_REG( 0x0330048C, "MADAM DMA08 NLn " ),
+
+	BUS_REG( 0x03300490, "MADAM DMA09 Adr " ),	// RamToDSPP9
+	BUS_REG( 0x03300494, "MADAM DMA09 Len " ),
+	BUS_REG( 0x03300498, "MADAM DMA09 NAd " ),
+	BUS_REG( 0x0330049C, "MADAM DMA09 NLn " ),
+
+	BUS_REG( 0x033004A0, "MADAM DMA10 Adr " ),	// RamToDSPP10
+	BUS_REG( 0x033004A4, "MADAM DMA10 Len " ),
+	BUS_REG( 0x033004A8, "MADAM DMA10 NAd " ),
+	BUS_REG( 0x033004AC, "MADAM DMA10 NLn " ),
+
+	BUS_REG( 0x033004B0, "MADAM DMA11 Adr " ),	// RamToDSPP11
+	BUS_REG( 0x033004B4, "MADAM DMA11 Len " ),
+	BUS_REG( 0x033004B8, "MADAM DMA11 NAd " ),
+	BUS_REG( 0x033004BC, "MADAM DMA11 NLn " ),
+
+	BUS_REG( 0x033004C0, "MADAM DMA12 Adr " ),	// RamToDSPP12
+	BUS_REG( 0x033004C4, "MADAM DMA12 Len " ),
+	BUS_REG( 0x033004C8, "MADAM DMA12 NAd " ),
+	BUS_REG( 0x033004CC, "MADAM DMA12 NLn " ),
+
+	BUS_REG( 0x033004D0, "MADAM DMA13 Adr " ),	// RamToUncle
+	BUS_REG( 0x033004D4, "MADAM DMA13 Len " ),
+	BUS_REG( 0x033004D8, "MADAM DMA13 NAd " ),
+	BUS_REG( 0x033004DC, "MADAM DMA13 NLn " ),
+
+	BUS_REG( 0x033004E0, "MADAM DMA14 Adr " ),	// RamToExternal
+	BUS_REG( 0x033004E4, "MADAM DMA14 Len " ),
+	BUS_REG( 0x033004E8, "MADAM DMA14 NAd " ),
+	BUS_REG( 0x033004EC, "MADAM DMA14 NLn " ),
+
+	BUS_REG( 0x033004F0, "MADAM DMA15 Adr " ),	// RamToDSPPNStack
+	BUS_REG( 0x033004F4, "MADAM DMA15 Len " ),
+	BUS_REG( 0x033004F8, "MADAM DMA15 NAd " ),
+	BUS_REG( 0x033004FC, "MADAM DMA15 NLn " ),
+
+	BUS_REG( 0x03300500, "MADAM DMA16 Adr " ),	// DSPPToRam0
+	BUS_REG( 0x03300504, "MADAM DMA16 Len " ),
+	BUS_REG( 0x03300508, "MADAM DMA16 NAd " ),
+	BUS_REG( 0x0330050C, "MADAM DMA16 NLn " ),
+
+	BUS_REG( 0x03300510, "MADAM DMA10 Adr " ),	// DSPPToRam1
+	BUS_REG( 0x03300514, "MADAM DMA10 Len " ),
+	BUS_REG( 0x03300518, "MADAM DMA10 NAd " ),
+	BUS_REG( 0x0330051C, "MADAM DMA10 NLn " ),
+
+	BUS_REG( 0x03300520, "MADAM DMA11 Adr " ),	// DSPPToRam2
+	BUS_REG( 0x03300524, "MADAM DMA11 Len " ),
+	BUS_REG( 0x03300528, "MADAM DMA11 NAd " ),
+	BUS_REG( 0x0330052C, "MADAM DMA11 NLn " ),
+
+	BUS_REG( 0x03300530, "MADAM DMA12 Adr " ),	// DSPPToRam3
+	BUS_REG( 0x03300534, "MADAM DMA12 Len " ),
+	BUS_REG( 0x03300538, "MADAM DMA12 NAd " ),
+	BUS_REG( 0x0330053C, "MADAM DMA12 NLn " ),
+
+	BUS_REG( 0x03300540, "MADAM XBus Adr  " ),	// DMAExpo
+	BUS_REG( 0x03300544, "MADAM XBus Len  " ),
+	BUS_REG( 0x03300548, "MADAM XBus NAd  " ),
+	BUS_REG( 0x0330054C, "MADAM XBus NLn  " ),
+
+	BUS_REG( 0x03300550, "MADAM DMA14 Adr " ),	// UncleToRam
+	BUS_REG( 0x03300554, "MADAM DMA14 Len " ),
+	BUS_REG( 0x03300558, "MADAM DMA14 NAd " ),
+	BUS_REG( 0x0330055C, "MADAM DMA14 NLn " ),
+
+	BUS_REG( 0x03300560, "MADAM DMA15 Adr " ),	// ExternalToRam
+	BUS_REG( 0x03300564, "MADAM DMA15 Len " ),
+	BUS_REG( 0x03300568, "MADAM DMA15 NAd " ),
+	BUS_REG( 0x0330056C, "MADAM DMA15 NLn " ),
+
+	BUS_REG( 0x03300570, "MADAM PbToRam   " ),	// ControlPort (PlayerBus)
+	BUS_REG( 0x03300574, "MADAM PbLength  " ),
+	BUS_REG( 0x03300578, "MADAM PbFromRam " ),
+	BUS_REG( 0x0330057C, "MADAM PbRefresh " ),
+
+	BUS_REG( 0x03300580, "MADAM vdl_addr! " ),
+	BUS_REG( 0x03300584, "MADAM CLUT Vid  " ),
+	BUS_REG( 0x03300588, "MADAM CLUT Mid  " ),
+	BUS_REG( 0x0330058C, "MADAM CMID Rsvd " ),
+
+	BUS_REG( 0x03300590, "MADAM VID Prev  " ),	// Video_MID
+	BUS_REG( 0x03300594, "MADAM VID Curr  " ),
+	BUS_REG( 0x03300598, "MADAM VID PrevM " ),
+	BUS_REG( 0x0330059C, "MADAM VID CurrM " ),
+
+	BUS_REG( 0x033005A0, "MADAM currentccb" ),	// CELControl
+	BUS_REG( 0x033005A4, "MADAM FirstCCB  " ),
+	BUS_REG( 0x033005A8, "MADAM CL PLUT   " ),
+	BUS_REG( 0x033005AC, "MADAM CL DStart " ),
+
+	BUS_REG( 0x033005B0, "MADAM engafetch " ),	// CELData
+	BUS_REG( 0x033005B4, "MADAM engalen   " ),
+	BUS_REG( 0x033005B8, "MADAM engbfetch " ),
+	BUS_REG( 0x033005BC, "MADAM engblen   " ),
+
+	BUS_REG( 0x033005C0, "MADAM DMA21 Adr " ),	// Commandgrabber
+	BUS_REG( 0x033005C4, "MADAM DMA21 Len " ),
+	BUS_REG( 0x033005C8, "MADAM DMA21 NAd " ),
+	BUS_REG( 0x033005CC, "MADAM DMA21 NLn " ),
+
+	BUS_REG( 0x033005D0, "MADAM DMA22 Adr " ),	// Framegrabber
+	BUS_REG( 0x033005D4, "MADAM DMA22 Len " ),
+	BUS_REG( 0x033005D8, "MADAM DMA22 NAd " ),
+	BUS_REG( 0x033005DC, "MADAM DMA22 NLn " ),
+
+	BUS_RANGE( 0x03300600, 0x0330063F, "MADAM Matrix    " ),
+	BUS_RANGE( 0x03300640, 0x0330069C, "MADAM B0_B1     " ),
+
+	BUS_REG( 0x033006A0, "MADAM Rsrvd 6a0 " ),
+	BUS_REG( 0x03300700, "MADAM Rsrvd 700 " ),
+
+	BUS_REG( 0x033007F0, "MADAM Math Set  " ),
+	BUS_REG( 0x033007F4, "MADAM Math Clr  " ),
+	BUS_REG( 0x033007F8, "MADAM Math Stat " ),
+	BUS_REG( 0x033007FC, "MADAM Math Start" ),
+
+	// CLIO...
+	BUS_REG( 0x03400000, "CLIO Revision   " ),
+	BUS_REG( 0x03400004, "CLIO csysbits   " ),
+	BUS_REG( 0x03400008, "CLIO vint0      " ),
+	BUS_REG( 0x0340000C, "CLIO vint1      " ),
+	BUS_REG( 0x03400024, "CLIO audout     " ),
+	BUS_REG( 0x03400028, "CLIO cstatbits  " ),
+	BUS_REG( 0x0340002C, "CLIO WatchDog   " ),
+	BUS_REG( 0x03400038, "CLIO RandSeed   " ),
+
+	{ 0x0340003C, 0x0340003C, "CLIO RandSample?", "CLIO RandSample?", SIM_BUS_ZERO, SIM_BUS_ZERO },
+
+	{ 0x03400040, 0x03400040, "CLIO irq0 pend  ", "CLIO irq0 set   ", SIM_BUS_NONE, SIM_BUS_NONE },
+	{ 0x03400044, 0x03400044, "CLIO irq0 pend  ", "CLIO irq0 clear ", SIM_BUS_NONE, SIM_BUS_NONE },
+	{ 0x03400048, 0x03400048, "CLIO mask0 read ", "CLIO mask0 set  ", SIM_BUS_NONE, SIM_BUS_NONE },
+	{ 0x0340004C, 0x0340004C, "CLIO mask0 read ", "CLIO mask0 clear", SIM_BUS_NONE, SIM_BUS_NONE },
+
+	{ 0x03400050, 0x03400050, NULL, "CLIO SetMode    ", SIM_BUS_NONE, SIM_BUS_NONE },
+	{ 0x03400054, 0x03400054, NULL, "CLIO ClrMode    ", SIM_BUS_NONE, SIM_BUS_NONE },
+	{ 0x03400058, 0x03400058, NULL, "CLIO BadBits    ", SIM_BUS_NONE, SIM_BUS_NONE },
+	{ 0x0340005C, 0x0340005C, NULL, "CLIO Spare      ", SIM_BUS_NONE, SIM_BUS_NONE },
+
+	{ 0x03400060, 0x03400060, "CLIO irq1 pend  ", "CLIO irq1 set   ", SIM_BUS_NONE, SIM_BUS_NONE },
+	{ 0x03400064, 0x03400064, "CLIO irq1 pend  ", "CLIO irq1 clear ", SIM_BUS_NONE, SIM_BUS_NONE },
+	{ 0x03400068, 0x03400068, "CLIO mask1 read ", "CLIO mask1 set  ", SIM_BUS_NONE, SIM_BUS_NONE },
+	{ 0x0340006C, 0x0340006C, "CLIO mask1 read ", "CLIO mask1 clear", SIM_BUS_NONE, SIM_BUS_NONE },
+
+	BUS_REG( 0x03400080, "CLIO hdelay     " ),
+	{ 0x03400084, 0x03400084, "CLIO adbio      ", "CLIO adbio      ", SIM_BUS_NONE, SIM_BUS_CLIO_ADBIO },
+	BUS_REG( 0x03400088, "CLIO adbctl     " ),
+
+	BUS_REG( 0x03400100, "CLIO tmr_cnt_0  " ),
+	BUS_REG( 0x03400108, "CLIO tmr_cnt_1  " ),
+	BUS_REG( 0x03400110, "CLIO tmr_cnt_2  " ),
+	BUS_REG( 0x03400118, "CLIO tmr_cnt_3  " ),
+	BUS_REG( 0x03400120, "CLIO tmr_cnt_4  " ),
+	BUS_REG( 0x03400128, "CLIO tmr_cnt_5  " ),
+	BUS_REG( 0x03400130, "CLIO tmr_cnt_6  " ),
+	BUS_REG( 0x03400138, "CLIO tmr_cnt_7  " ),
+	BUS_REG( 0x03400140, "CLIO tmr_cnt_8  " ),
+	BUS_REG( 0x03400148, "CLIO tmr_cnt_9  " ),
+	BUS_REG( 0x03400150, "CLIO tmr_cnt_10 " ),
+	BUS_REG( 0x03400158, "CLIO tmr_cnt_11 " ),
+	BUS_REG( 0x03400160, "CLIO tmr_cnt_12 " ),
+	BUS_REG( 0x03400168, "CLIO tmr_cnt_13 " ),
+	BUS_REG( 0x03400170, "CLIO tmr_cnt_14 " ),
+	BUS_REG( 0x03400178, "CLIO tmr_cnt_15 " ),
+
+	BUS_REG( 0x03400104, "CLIO tmr_bkp_0  " ),
+	BUS_REG( 0x0340010C, "CLIO tmr_bkp_1  " ),
+	BUS_REG( 0x03400114, "CLIO tmr_bkp_2  " ),
+	BUS_REG( 0x0340011C, "CLIO tmr_bkp_3  " ),
+	BUS_REG( 0x03400124, "CLIO tmr_bkp_4  " ),
+	BUS_REG( 0x0340012C, "CLIO tmr_bkp_5  " ),
+	BUS_REG( 0x03400134, "CLIO tmr_bkp_6  " ),
+	BUS_REG( 0x0340013C, "CLIO tmr_bkp_7  " ),
+	BUS_REG( 0x03400144, "CLIO tmr_bkp_8  " ),
+	BUS_REG( 0x0340014C, "CLIO tmr_bkp_9  " ),
+	BUS_REG( 0x03400154, "CLIO tmr_bkp_10 " ),
+	BUS_REG( 0x0340015C, "CLIO tmr_bkp_11 " ),
+	BUS_REG( 0x03400164, "CLIO tmr_bkp_12 " ),
+	BUS_REG( 0x0340016C, "CLIO tmr_bkp_13 " ),
+	BUS_REG( 0x03400174, "CLIO tmr_bkp_14 " ),
+	BUS_REG( 0x0340017C, "CLIO tmr_bkp_15 " ),
+
+	BUS_REG( 0x03400200, "CLIO tmr_set_l  " ),
+	BUS_REG( 0x03400204, "CLIO tmr_clr_l  " ),
+	BUS_REG( 0x03400208, "CLIO tmr_set_u  " ),
+	BUS_REG( 0x0340020C, "CLIO tmr_clr_u  " ),
+
+	BUS_REG( 0x03400220, "CLIO TmrSlack   " ),
+	{ 0x03400304, 0x03400304, "CLIO dmactrl    ", "CLIO dmactrl    ", SIM_BUS_NONE, SIM_BUS_CLIO_DMACTRL },
+	BUS_REG( 0x03400308, "CLIO ClrDMAEna  " ),
+
+	BUS_REG( 0x03400380, "CLIO DMA DSPP0  " ),
+	BUS_REG( 0x03400384, "CLIO DMA DSPP1  " ),
+	BUS_REG( 0x03400388, "CLIO DMA DSPP2  " ),
+	BUS_REG( 0x0340038C, "CLIO DMA DSPP3  " ),
+	BUS_REG( 0x03400390, "CLIO DMA DSPP4  " ),
+	BUS_REG( 0x03400394, "CLIO DMA DSPP5  " ),
+	BUS_REG( 0x03400398, "CLIO DMA DSPP6  " ),
+	BUS_REG( 0x0340039C, "CLIO DMA DSPP7  " ),
+	BUS_REG( 0x034003A0, "CLIO DMA DSPP8  " ),
+	BUS_REG( 0x034003A4, "CLIO DMA DSPP9  " ),
+	BUS_REG( 0x034003A8, "CLIO DMA DSPP10 " ),
+	BUS_REG( 0x034003AC, "CLIO DMA DSPP11 " ),
+	BUS_REG( 0x034003B0, "CLIO DMA DSPP12 " ),
+	BUS_REG( 0x034003B4, "CLIO DMA DSPP13 " ),
+	BUS_REG( 0x034003B8, "CLIO DMA DSPP14 " ),
+	BUS_REG( 0x034003BC, "CLIO DMA DSPP15 " ),
+
+	BUS_REG( 0x034003C0, "CLIO DSPP DMA0  " ),
+	BUS_REG( 0x034003C4, "CLIO DSPP DMA1  " ),
+	BUS_REG( 0x034003C8, "CLIO DSPP DMA2  " ),
+	BUS_REG( 0x034003CC, "CLIO DSPP DMA3  " ),
+	BUS_REG( 0x034003D0, "CLIO DSPP DMA4  " ),
+	BUS_REG( 0x034003D4, "CLIO DSPP DMA5  " ),
+	BUS_REG( 0x034003D8, "CLIO DSPP DMA6  " ),
+	BUS_REG( 0x034003DC, "CLIO DSPP DMA7  " ),
+	BUS_REG( 0x034003E0, "CLIO DSPP DMA8  " ),
+	BUS_REG( 0x034003E4, "CLIO DSPP DMA9  " ),
+	BUS_REG( 0x034003E8, "CLIO DSPP DMA10 " ),
+	BUS_REG( 0x034003EC, "CLIO DSPP DMA11 " ),
+	BUS_REG( 0x034003F0, "CLIO DSPP DMA12 " ),
+	BUS_REG( 0x034003F4, "CLIO DSPP DMA13 " ),
+	BUS_REG( 0x034003F8, "CLIO DSPP DMA14 " ),
+	BUS_REG( 0x034003FC, "CLIO DSPP DMA15 " ),
+
+	BUS_REG( 0x03400400, "CLIO expctl_set " ),
+	BUS_REG( 0x03400404, "CLIO expctl_clr " ),
+	BUS_REG( 0x03400408, "CLIO type0_4    " ),
+	BUS_REG( 0x03400410, "CLIO dipir1     " ),
+	{ 0x03400414, 0x03400414, "CLIO dipir2     ", "CLIO dipir2     ", SIM_BUS_CLIO_DIPIR2, SIM_BUS_CLIO_DIPIR2 },	// TO CHECK!!! requested by CDROMDIPIR.
+
+	// Handle Xbus reads...
+	{ 0x03400500, 0x0340053F, "CLIO sel        ", "CLIO sel        ", SIM_BUS_XBUS_RES, SIM_BUS_XBUS_SEL },
+	{ 0x03400540, 0x0340057F, "CLIO poll       ", "CLIO poll       ", SIM_BUS_XBUS_POLL_RD, SIM_BUS_XBUS_POLL_WR },
+	{ 0x03400580, 0x034005BF, "CLIO CmdStFIFO  ", "CLIO CmdStFIFO  ", SIM_BUS_XBUS_STATUS, SIM_BUS_XBUS_CMD },
+	{ 0x034005C0, 0x034005FF, "CLIO Data FIFO  ", "CLIO Data FIFO  ", SIM_BUS_XBUS_DATA_RD, SIM_BUS_XBUS_DATA_WR },
+
+	// DSP...
+	BUS_REG( 0x034017D0, "CLIO sema       " ),
+	BUS_REG( 0x034017D4, "CLIO semaack    " ),
+	BUS_REG( 0x034017E0, "CLIO dspdma     " ),
+	BUS_REG( 0x034017E4, "CLIO dspprst0   " ),
+	BUS_REG( 0x034017E8, "CLIO dspprst1   " ),
+
+	BUS_REG( 0x034017F0, "CLIO fastrand   " ),
+
+	BUS_REG( 0x034017F4, "CLIO dspppc     " ),
+	BUS_REG( 0x034017F8, "CLIO dsppnr     " ),
+	BUS_REG( 0x034017FC, "CLIO dsppgw     " ),
+	BUS_REG( 0x034039DC, "CLIO dsppclkreload" ),
+
+	BUS_RANGE( 0x03401800, 0x03401FFF, "CLIO DSPP  N 32 " ),
+	BUS_RANGE( 0x03402000, 0x03402FFF, "CLIO DSPP  N 16 " ),
+	BUS_RANGE( 0x03403000, 0x034031FF, "CLIO DSPP EI 32 " ),
+	BUS_RANGE( 0x03403400, 0x034037FF, "CLIO DSPP EI 16 " ),
+
+	// Uncle spoofing stuff handled in clio.v now. ElectronAsh...
+	BUS_REG( 0x0340C000, "CLIO unc_rev    " ),
+	BUS_REG( 0x0340C004, "CLIO unc_soft_rv" ),
+	BUS_REG( 0x0340C008, "CLIO unc_addr   " ),
+	BUS_REG( 0x0340C00C, "CLIO unc_rom    " ),
+};
+
+#define SIM_BUS_PAGE_WORDS (1 << (SIM_BUS_PAGE_SHIFT - 2))
+
+sim_bus_page_t sim_bus_pages[SIM_BUS_PAGE_COUNT];
+
+const sim_bus_entry_t sim_bus_none[2] = { { NULL, SIM_BUS_NONE, 0 }, { NULL, SIM_BUS_NONE, 0 } };
+
+// Give a page its own per-word table (filled with whatever the page decoded to before), so single registers can be set.
+static sim_bus_entry_t* sim_bus_split_page(uint32_t page_) {
+	sim_bus_page_t* page = &sim_bus_pages[page_];
+
+	if (page->word_mask == 0) {
+		sim_bus_entry_t* words = (sim_bus_entry_t*)malloc(SIM_BUS_PAGE_WORDS * 2 * sizeof(sim_bus_entry_t));
+		for (int i = 0; i < SIM_BUS_PAGE_WORDS; i++) {
+			words[(i << 1) | 0] = page->entries[0];
+			words[(i << 1) | 1] = page->entries[1];
+		}
+		page->entries = words;
+		page->word_mask = SIM_BUS_PAGE_WORDS - 1;
+	}
+
+	return (sim_bus_entry_t*)page->entries;
+}
+
+// Build the page tables from sim_bus_regs[]. Only does the work once, so it's safe to call on every reset.
+void sim_bus_init() {
+	static bool built = 0;
+	if (built) return;
+	built = 1;
+
+	for (int i = 0; i < SIM_BUS_PAGE_COUNT; i++) {
+		sim_bus_pages[i].entries = sim_bus_none;
+		sim_bus_pages[i].word_mask = 0;
+	}
+
+	for (size_t i = 0; i < sizeof(sim_bus_regs) / sizeof(sim_bus_regs[0]); i++) {
+		const sim_bus_reg_t* reg = &sim_bus_regs[i];
+		sim_bus_entry_t* whole = NULL;
+
+		uint32_t addr = reg->start;
+		while (addr <= reg->end) {
+			uint32_t page = addr >> SIM_BUS_PAGE_SHIFT;
+			uint32_t page_end = ((page + 1) << SIM_BUS_PAGE_SHIFT) - 1;
+
+			if ((addr & ((1 << SIM_BUS_PAGE_SHIFT) - 1)) == 0 && reg->end >= page_end) {
+				// Covers the whole page, so all of its pages can share one entry pair.
+				if (whole == NULL) {
+					whole = (sim_bus_entry_t*)malloc(2 * sizeof(sim_bus_entry_t));
+					whole[0] = { reg->rd_name, reg->rd_op, 0 };
+					whole[1] = { reg->wr_name, reg->wr_op, 0 };
+				}
+				sim_bus_pages[page].entries = whole;
+				sim_bus_pages[page].word_mask = 0;
+				addr = page_end + 1;
+			}
+			else {
+				// A word that's only partly covered came from a "mem_addr == reg" compare, so it only matches aligned.
+				sim_bus_entry_t* words = sim_bus_split_page(page);
+				uint32_t word = (addr >> 2) & (SIM_BUS_PAGE_WORDS - 1);
+				uint8_t aligned = (reg->end - addr) < 3;
+
+				words[(word << 1) | 0] = { reg->rd_name, reg->rd_op, aligned };
+				words[(word << 1) | 1] = { reg->wr_name, reg->wr_op, aligned };
+				addr = (addr & ~3) + 4;
+			}
+		}
+	}
+}
@@ -0,0 +1,81 @@
+#ifndef SIM_BUS_H_INCLUDED
+#define SIM_BUS_H_INCLUDED
+
+// Address decoder for the bus glue in verilate().
+//
+// This used to be a few hundred "if (top->mem_addr == 0x033004xx)" compares on every acknowledged bus cycle,
+// just to find the trace name, plus the range checks for the Brooktree / NVRAM / DiagPort / SVF handlers.
+// Now mem_addr is split into 4KB pages (mem_addr >> 12). Each page points at one entry for the whole page,
+// or a per-word table for the pages with MADAM / CLIO registers in them, so a decode is a single lookup.
+//
+#include <stdint.h>
+
+// What verilate() does for an access, on top of the default RAM / BIOS read data.
+enum sim_bus_op_e {
+	SIM_BUS_NONE = 0,		// Nothing. Data comes from the Verilog MADAM / CLIO (or the default).
+	SIM_BUS_VRAM,			// i_wb_dat = VRAM word.
+	SIM_BUS_BIOS,			// i_wb_dat = BIOS or Kanji ROM word (rom2_select).
+	SIM_BUS_BROOKTREE,		// i_wb_dat = 0x0000006A.
+	SIM_BUS_NVRAM,			// i_wb_dat = NVRAM byte.
+	SIM_BUS_DIAG_SEND,		// sim_diag_port_send().
+	SIM_BUS_DIAG_GET,		// i_wb_dat = sim_diag_port_get().
+	SIM_BUS_ZERO,			// i_wb_dat = 0x00000000.
+	SIM_BUS_BADACCE5,		// i_wb_dat = 0xBADACCE5.
+	SIM_BUS_SVF_SOURCE,		// svf_set_source(), i_wb_dat = 0x00000000.
+	SIM_BUS_SVF_COPY,		// svf_page_copy().
+	SIM_BUS_SVF_COLOR,		// svf_set_color().
+	SIM_BUS_SVF_FLASH,		// svf_flash_write().
+	SIM_BUS_MADAM_PRINT,	// BIOS debug character out.
+	SIM_BUS_CLIO_ADBIO,		// rom2_select, handle_adbio_write().
+	SIM_BUS_CLIO_DMACTRL,	// sim_clio_handle_dma().
+	SIM_BUS_CLIO_DIPIR2,	// i_wb_dat = 0x4000.
+	SIM_BUS_XBUS_SEL,		// sim_xbus_set_sel().
+	SIM_BUS_XBUS_RES,		// i_wb_dat = sim_xbus_get_res().
+	SIM_BUS_XBUS_POLL_WR,	// sim_xbus_set_poll().
+	SIM_BUS_XBUS_POLL_RD,	// i_wb_dat = sim_xbus_get_poll().
+	SIM_BUS_XBUS_CMD,		// sim_xbus_fifo_set_cmd().
+	SIM_BUS_XBUS_STATUS,	// i_wb_dat = sim_xbus_fifo_get_status().
+	SIM_BUS_XBUS_DATA_WR,	// sim_xbus_fifo_set_data().
+	SIM_BUS_XBUS_DATA_RD	// i_wb_dat = sim_xbus_fifo_get_data().
+};
+
+// The ops above that always set i_wb_dat, so verilate() needn't fetch the default RAM / BIOS word first.
+#define SIM_BUS_DATA_OPS ((1u << SIM_BUS_VRAM) | (1u << SIM_BUS_BIOS) | (1u << SIM_BUS_BROOKTREE) | (1u << SIM_BUS_NVRAM) | \
+	(1u << SIM_BUS_DIAG_GET) | (1u << SIM_BUS_ZERO) | (1u << SIM_BUS_BADACCE5) | (1u << SIM_BUS_SVF_SOURCE) | (1u << SIM_BUS_CLIO_DIPIR2) | \
+	(1u << SIM_BUS_XBUS_RES) | (1u << SIM_BUS_XBUS_POLL_RD) | (1u << SIM_BUS_XBUS_STATUS) | (1u << SIM_BUS_XBUS_DATA_RD))
+
+static inline bool sim_bus_op_has_data(uint8_t op_) {
+	return (SIM_BUS_DATA_OPS >> op_) & 1;
+}
+
+typedef struct sim_bus_entry_t {
+	const char* name;	// Name for sim_trace.txt (16 chars), or NULL.
+	uint8_t op;			// sim_bus_op_e.
+	uint8_t aligned;	// Only matches a word-aligned mem_addr. (the old "mem_addr == reg" compares)
+} sim_bus_entry_t;
+
+typedef struct sim_bus_page_t {
+	const sim_bus_entry_t* entries;	// [word][we], or just [we] if word_mask is zero.
+	uint32_t word_mask;
+} sim_bus_page_t;
+
+// Everything from 0x03500000 up decodes to nothing.
+#define SIM_BUS_PAGE_SHIFT 12
+#define SIM_BUS_PAGE_COUNT (0x03500000 >> SIM_BUS_PAGE_SHIFT)
+
+extern sim_bus_page_t sim_bus_pages[SIM_BUS_PAGE_COUNT];
+extern const sim_bus_entry_t sim_bus_none[2];
+
+void sim_bus_init();
+
+static inline const sim_bus_entry_t* sim_bus_decode(uint32_t addr_, bool we_) {
+	if (addr_ >= (SIM_BUS_PAGE_COUNT << SIM_BUS_PAGE_SHIFT)) return &sim_bus_none[0];
+
+	const sim_bus_page_t* page = &sim_bus_pages[addr_ >> SIM_BUS_PAGE_SHIFT];
+	const sim_bus_entry_t* entry = &page->entries[(((addr_ >> 2) & page->word_mask) << 1) | we_];
+
+	if (entry->aligned && (addr_ & 3)) return &sim_bus_none[0];
+	return entry;
+}
+
+#endif /* SIM_BUS_H_INCLUDED */
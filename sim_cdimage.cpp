@@ -0,0 +1,205 @@
+// Memory-mapped CD images. See sim_cdimage.h. ElectronAsh.
+//
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "sim_cdimage.h"
+#include "sim_chd.h"
+
+#ifdef _WIN32
+int sim_cdimage_map_file(const char* path_, sim_cdimage_map_t* map_) {
+	HANDLE file = CreateFileA(path_, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) return -1;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) { CloseHandle(file); return -1; }
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);	// The mapping keeps the file open.
+	if (mapping == NULL) return -1;
+
+	const uint8_t* base = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (base == NULL) { CloseHandle(mapping); return -1; }
+
+	map_->base = base;
+	map_->size = (uint64_t)size.QuadPart;
+	map_->handle = mapping;
+	return 0;
+}
+
+void sim_cdimage_unmap_file(sim_cdimage_map_t* map_) {
+	UnmapViewOfFile(map_->base);
+	CloseHandle((HANDLE)map_->handle);
+	map_->base = NULL;
+	map_->size = 0;
+	map_->handle = NULL;
+}
+
+// Windows reads ahead on its own for mapped files opened with FILE_FLAG_SEQUENTIAL_SCAN.
+void sim_cdimage_advise(const sim_cdimage_map_t* map_, uint64_t start_, uint64_t len_) {
+}
+#else
+int sim_cdimage_map_file(const char* path_, sim_cdimage_map_t* map_) {
+	int fd = open(path_, O_RDONLY);
+	if (fd < 0) return -1;
+
+	struct stat st;
+	if (fstat(fd, &st) || st.st_size == 0) { close(fd); return -1; }
+
+	void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);	// The mapping keeps the file open.
+	if (base == MAP_FAILED) return -1;
+
+	madvise(base, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+	map_->base = (const uint8_t*)base;
+	map_->size = (uint64_t)st.st_size;
+	map_->handle = NULL;
+	return 0;
+}
+
+void sim_cdimage_unmap_file(sim_cdimage_map_t* map_) {
+	munmap((void*)map_->base, (size_t)map_->size);
+	map_->base = NULL;
+	map_->size = 0;
+}
+
+void sim_cdimage_advise(const sim_cdimage_map_t* map_, uint64_t start_, uint64_t len_) {
+	static const uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+
+	uint64_t aligned = start_ & ~(page - 1);
+	madvise((void*)(map_->base + aligned), (size_t)(len_ + start_ - aligned), MADV_WILLNEED);
+}
+#endif
+
+
+// Flat .iso / .bin images.
+
+// Every raw sector starts with this.
+static const uint8_t sim_cdimage_sync[12] = { 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00 };
+
+static const sim_cdimage_map_t* sim_flat_map = NULL;
+static uint32_t sim_flat_count = 0;
+static uint16_t sim_flat_stride = SIM_CDIMAGE_USER_SIZE;
+static uint16_t sim_flat_offset = 0;	// Where the user data starts, within each sector.
+
+// The sectors the last madvise() covered.
+static uint32_t sim_flat_ahead_start = 0;
+static uint32_t sim_flat_ahead_end = 0;
+
+static int sim_flat_open(const sim_cdimage_map_t* map_, sim_cdimage_info_t* info_) {
+	// Raw images give themselves away with the sync pattern. The mode byte says where the user data is.
+	if (map_->size >= SIM_CDIMAGE_RAW_SIZE && !memcmp(map_->base, sim_cdimage_sync, sizeof(sim_cdimage_sync))) {
+		sim_flat_stride = SIM_CDIMAGE_RAW_SIZE;
+		sim_flat_offset = (map_->base[15] == 2) ? 24 : 16;
+	}
+	else {
+		sim_flat_stride = SIM_CDIMAGE_USER_SIZE;
+		sim_flat_offset = 0;
+	}
+
+	sim_flat_map = map_;
+	sim_flat_count = (uint32_t)(map_->size / sim_flat_stride);
+	sim_flat_ahead_start = 0;
+	sim_flat_ahead_end = 0;
+
+	info_->sectors = sim_flat_count;
+	info_->sector_size = sim_flat_stride;
+	return 0;
+}
+
+static void sim_flat_close() {
+	sim_flat_map = NULL;
+	sim_flat_count = 0;
+}
+
+static const uint8_t* sim_flat_sector(uint32_t lba_) {
+	if (lba_ >= sim_flat_count) return NULL;
+
+	// Start the next window once the drive is halfway through this one, or has seeked out of it.
+	if (lba_ < sim_flat_ahead_start || (lba_ + SIM_CDIMAGE_READAHEAD / 2 >= sim_flat_ahead_end && sim_flat_ahead_end < sim_flat_count)) {
+		uint32_t end = lba_ + SIM_CDIMAGE_READAHEAD;
+		if (end > sim_flat_count) end = sim_flat_count;
+
+		sim_cdimage_advise(sim_flat_map, (uint64_t)lba_ * sim_flat_stride, (uint64_t)(end - lba_) * sim_flat_stride);
+		sim_flat_ahead_start = lba_;
+		sim_flat_ahead_end = end;
+	}
+
+	return sim_flat_map->base + (uint64_t)lba_ * sim_flat_stride + sim_flat_offset;
+}
+
+static const sim_cdimage_format_t sim_flat_format = { "flat", sim_flat_open, sim_flat_close, sim_flat_sector };
+
+
+// In the order they get asked.
+static const sim_cdimage_format_t* sim_cdimage_formats[] = { &sim_chd_format, &sim_flat_format };
+
+static sim_cdimage_map_t sim_cdimage_file = { NULL, 0, NULL };
+static sim_cdimage_info_t sim_cdimage_info = { 0, SIM_CDIMAGE_USER_SIZE };
+static const sim_cdimage_format_t* sim_cdimage_cur = NULL;
+
+int sim_cdimage_open(const char* path_) {
+	sim_cdimage_close();
+
+	if (sim_cdimage_map_file(path_, &sim_cdimage_file)) {
+		fprintf(stderr, "Could not open %s\n", path_);
+		return -1;
+	}
+
+	for (size_t i = 0; i < sizeof(sim_cdimage_formats) / sizeof(sim_cdimage_formats[0]); i++) {
+		int ret = sim_cdimage_formats[i]->open(&sim_cdimage_file, &sim_cdimage_info);
+		if (ret == 1) continue;
+
+		if (ret) {
+			fprintf(stderr, "Could not open %s as %s\n", path_, sim_cdimage_formats[i]->name);
+			break;
+		}
+		sim_cdimage_cur = sim_cdimage_formats[i];
+		return 0;
+	}
+
+	sim_cdimage_unmap_file(&sim_cdimage_file);
+	return -1;
+}
+
+void sim_cdimage_close() {
+	if (sim_cdimage_cur == NULL) return;
+
+	sim_cdimage_cur->close();
+	sim_cdimage_cur = NULL;
+	sim_cdimage_unmap_file(&sim_cdimage_file);
+	sim_cdimage_info.sectors = 0;
+}
+
+uint32_t sim_cdimage_sectors() {
+	return sim_cdimage_info.sectors;
+}
+
+uint16_t sim_cdimage_sector_size() {
+	return sim_cdimage_info.sector_size;
+}
+
+uint64_t sim_cdimage_file_size() {
+	return sim_cdimage_file.size;
+}
+
+const char* sim_cdimage_format() {
+	return sim_cdimage_cur ? sim_cdimage_cur->name : NULL;
+}
+
+const uint8_t* sim_cdimage_sector(uint32_t lba_) {
+	if (sim_cdimage_cur == NULL) return NULL;
+	return sim_cdimage_cur->sector(lba_);
+}
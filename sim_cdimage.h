@@ -0,0 +1,63 @@
+#ifndef SIM_CDIMAGE_H_INCLUDED
+#define SIM_CDIMAGE_H_INCLUDED
+
+// CD image backend for the Opera CD-ROM callbacks.
+//
+// cdimage_read_sector() used to fseek() + fread() every sector the drive asked for, which is two syscalls per 2KB
+// while an FMV is streaming. Now the whole image is memory-mapped once, and a sector is just a pointer into the mapping.
+// The OS gets told the reads are sequential, and the next SIM_CDIMAGE_READAHEAD sectors get prefetched (madvise) as
+// the drive moves through them, so the page faults mostly hit the page cache.
+//
+// The format of the image is picked from its contents, by asking each sim_cdimage_format_t in turn:
+//   chd   Compressed hunks, through a cache. (sim_chd.cpp)
+//   flat  Plain .iso / .bin, read straight out of the mapping. This one takes anything, so it goes last.
+//
+// Flat images come in both layouts, also detected from the image itself:
+//   2048  Cooked .iso. Just the user data.
+//   2352  Raw .bin. 12 sync bytes, then the header, then the user data at offset 16 (Mode 1) or 24 (Mode 2 Form 1).
+//
+#include <stdint.h>
+
+#define SIM_CDIMAGE_USER_SIZE 2048
+#define SIM_CDIMAGE_RAW_SIZE  2352
+
+#define SIM_CDIMAGE_READAHEAD 64		// Sectors. (128KB of user data. About half a second at 2x.)
+
+int  sim_cdimage_open(const char* path_);
+void sim_cdimage_close();
+
+uint32_t sim_cdimage_sectors();
+uint16_t sim_cdimage_sector_size();		// 2048 or 2352. (The layout of the data track, not what sim_cdimage_sector() returns)
+uint64_t sim_cdimage_file_size();
+const char* sim_cdimage_format();		// "flat", "chd", or NULL with no image open.
+
+// The 2048 bytes of user data for lba_. NULL past the end of the image (or with none open, or if the sector can't be read).
+// Only valid until the next call.
+const uint8_t* sim_cdimage_sector(uint32_t lba_);
+
+
+// Read-only mapping of a whole file, for the formats to share.
+typedef struct sim_cdimage_map_t {
+	const uint8_t* base;
+	uint64_t size;
+	void* handle;			// The file mapping on Windows. Unused elsewhere.
+} sim_cdimage_map_t;
+
+int  sim_cdimage_map_file(const char* path_, sim_cdimage_map_t* map_);
+void sim_cdimage_unmap_file(sim_cdimage_map_t* map_);
+void sim_cdimage_advise(const sim_cdimage_map_t* map_, uint64_t start_, uint64_t len_);	// Read ahead. (madvise WILLNEED)
+
+typedef struct sim_cdimage_info_t {
+	uint32_t sectors;
+	uint16_t sector_size;
+} sim_cdimage_info_t;
+
+// One image format. open() returns 1 if the image isn't one of its own, so the next format gets a look.
+typedef struct sim_cdimage_format_t {
+	const char* name;
+	int  (*open)(const sim_cdimage_map_t* map_, sim_cdimage_info_t* info_);
+	void (*close)();
+	const uint8_t* (*sector)(uint32_t lba_);
+} sim_cdimage_format_t;
+
+#endif /* SIM_CDIMAGE_H_INCLUDED */
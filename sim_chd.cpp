@@ -0,0 +1,661 @@
+// CHD CD images. See sim_chd.h. ElectronAsh.
+//
+// The file layout follows MAME's chd.cpp / libchdr. Everything in a CHD is big-endian.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_chd.h"
+
+#define SIM_CHD_MAGIC "MComprHD"
+
+#if SIM_CHD_ENABLE
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+#include <lzma.h>
+
+#define SIM_CHD_V5_HEADER_SIZE 124
+
+#define SIM_CHD_FOURCC(a_, b_, c_, d_) (((uint32_t)(a_) << 24) | ((uint32_t)(b_) << 16) | ((uint32_t)(c_) << 8) | (uint32_t)(d_))
+
+#define SIM_CHD_CODEC_ZLIB SIM_CHD_FOURCC('z','l','i','b')
+#define SIM_CHD_CODEC_LZMA SIM_CHD_FOURCC('l','z','m','a')
+#define SIM_CHD_CODEC_CDZL SIM_CHD_FOURCC('c','d','z','l')
+#define SIM_CHD_CODEC_CDLZ SIM_CHD_FOURCC('c','d','l','z')
+
+#define SIM_CHD_META_CHTR SIM_CHD_FOURCC('C','H','T','R')	// Old CD track info.
+#define SIM_CHD_META_CHT2 SIM_CHD_FOURCC('C','H','T','2')	// CD track info, with the pregap fields.
+
+#define SIM_CHD_CD_FRAME   2448		// Sector + subcode. Each CD frame in a CHD is this big.
+#define SIM_CHD_CD_SUBCODE 96
+#define SIM_CHD_CD_PADDING 4		// Each track starts on a multiple of this many frames.
+
+// Hunk types in the v5 map. The ones after SIM_CHD_RLE_LARGE only appear in the compressed map, and get
+// turned back into SELF / PARENT as it's decoded.
+enum sim_chd_type_e {
+	SIM_CHD_TYPE_0 = 0,		// Compressed with codec 0 - 3 from the header.
+	SIM_CHD_TYPE_1,
+	SIM_CHD_TYPE_2,
+	SIM_CHD_TYPE_3,
+	SIM_CHD_NONE,			// Stored as-is.
+	SIM_CHD_SELF,			// Same as an earlier hunk. offset = that hunk.
+	SIM_CHD_PARENT,			// In the parent CHD.
+	SIM_CHD_RLE_SMALL,
+	SIM_CHD_RLE_LARGE,
+	SIM_CHD_SELF_0,
+	SIM_CHD_SELF_1,
+	SIM_CHD_PARENT_SELF,
+	SIM_CHD_PARENT_0,
+	SIM_CHD_PARENT_1,
+	SIM_CHD_ZERO = 0xFF		// Our own. Uncompressed-map hunk that was never written.
+};
+
+typedef struct sim_chd_hunk_t {
+	uint64_t offset;		// File offset, or hunk number for SELF.
+	uint32_t length;		// Compressed length.
+	uint8_t type;			// sim_chd_type_e.
+} sim_chd_hunk_t;
+
+typedef struct sim_chd_track_t {
+	uint32_t lba;			// First sector, as the drive sees it.
+	uint32_t frames;
+	uint32_t frame;			// First frame in the CHD. (Tracks are padded, so this runs ahead of lba)
+	uint16_t offset;		// Where the user data is, within the frame.
+	uint16_t sector_size;	// 2048 or 2352, for sim_cdimage_sector_size().
+} sim_chd_track_t;
+
+static const sim_cdimage_map_t* sim_chd_map = NULL;
+static uint32_t sim_chd_hunkbytes = 0;
+static uint32_t sim_chd_hunkcount = 0;
+static uint32_t sim_chd_codecs[4];
+static std::vector<sim_chd_hunk_t> sim_chd_hunks;
+static std::vector<sim_chd_track_t> sim_chd_tracks;
+static uint32_t sim_chd_sectors = 0;
+static uint32_t sim_chd_last_track = 0;
+
+
+static uint16_t sim_chd_be16(const uint8_t* p_) { return (p_[0] << 8) | p_[1]; }
+static uint32_t sim_chd_be24(const uint8_t* p_) { return (p_[0] << 16) | (p_[1] << 8) | p_[2]; }
+static uint32_t sim_chd_be32(const uint8_t* p_) { return ((uint32_t)p_[0] << 24) | (p_[1] << 16) | (p_[2] << 8) | p_[3]; }
+static uint64_t sim_chd_be48(const uint8_t* p_) { return ((uint64_t)sim_chd_be16(p_) << 32) | sim_chd_be32(p_ + 2); }
+static uint64_t sim_chd_be64(const uint8_t* p_) { return ((uint64_t)sim_chd_be32(p_) << 32) | sim_chd_be32(p_ + 4); }
+
+
+// MSB-first bit reader for the compressed map. Reads past the end come back as zeroes.
+typedef struct sim_chd_bits_t {
+	const uint8_t* buf;
+	uint32_t len;
+	uint32_t pos;			// In bits.
+} sim_chd_bits_t;
+
+static uint32_t sim_chd_peek(const sim_chd_bits_t* bits_, int count_) {
+	uint32_t val = 0;
+	for (int i = 0; i < count_; i++) {
+		uint32_t pos = bits_->pos + i;
+		uint32_t bit = (pos >> 3) < bits_->len ? (bits_->buf[pos >> 3] >> (7 - (pos & 7))) & 1 : 0;
+		val = (val << 1) | bit;
+	}
+	return val;
+}
+
+static uint32_t sim_chd_read(sim_chd_bits_t* bits_, int count_) {
+	uint32_t val = sim_chd_peek(bits_, count_);
+	bits_->pos += count_;
+	return val;
+}
+
+// The map's hunk types are Huffman coded. 16 symbols, codes up to 8 bits, with the code lengths RLE packed up front.
+#define SIM_CHD_HUFF_CODES 16
+#define SIM_CHD_HUFF_BITS  8
+
+typedef struct sim_chd_huff_t {
+	uint16_t lookup[1 << SIM_CHD_HUFF_BITS];	// (symbol << 5) | code length, for every possible next 8 bits.
+} sim_chd_huff_t;
+
+static int sim_chd_huff_import(sim_chd_huff_t* huff_, sim_chd_bits_t* bits_) {
+	uint8_t len[SIM_CHD_HUFF_CODES];
+
+	int node = 0;
+	while (node < SIM_CHD_HUFF_CODES) {
+		int nodebits = sim_chd_read(bits_, 4);
+		if (nodebits != 1) len[node++] = nodebits;
+		else {
+			nodebits = sim_chd_read(bits_, 4);
+			if (nodebits == 1) len[node++] = nodebits;
+			else {
+				int rep = sim_chd_read(bits_, 4) + 3;
+				if (node + rep > SIM_CHD_HUFF_CODES) return -1;
+				while (rep--) len[node++] = nodebits;
+			}
+		}
+	}
+
+	// Canonical codes. Longest codes get the lowest numbers.
+	uint32_t start[33] = { 0 };
+	for (int i = 0; i < SIM_CHD_HUFF_CODES; i++) {
+		if (len[i] > SIM_CHD_HUFF_BITS) return -1;
+		start[len[i]]++;
+	}
+
+	uint32_t cur = 0;
+	for (int bits = 32; bits > 0; bits--) {
+		uint32_t next = (cur + start[bits]) >> 1;
+		if (bits != 1 && next * 2 != cur + start[bits]) return -1;
+		start[bits] = cur;
+		cur = next;
+	}
+
+	memset(huff_->lookup, 0, sizeof(huff_->lookup));
+	for (int i = 0; i < SIM_CHD_HUFF_CODES; i++) {
+		if (len[i] == 0) continue;
+
+		uint32_t code = start[len[i]]++;
+		int shift = SIM_CHD_HUFF_BITS - len[i];
+		for (uint32_t j = code << shift; j < ((code + 1) << shift); j++) huff_->lookup[j] = (i << 5) | len[i];
+	}
+	return 0;
+}
+
+static uint8_t sim_chd_huff_decode(const sim_chd_huff_t* huff_, sim_chd_bits_t* bits_) {
+	uint16_t entry = huff_->lookup[sim_chd_peek(bits_, SIM_CHD_HUFF_BITS)];
+	bits_->pos += entry & 0x1f;
+	return entry >> 5;
+}
+
+static int sim_chd_read_map(const uint8_t* header_) {
+	const uint8_t* file = sim_chd_map->base;
+	uint64_t mapoffset = sim_chd_be64(header_ + 40);
+
+	sim_chd_hunks.assign(sim_chd_hunkcount, sim_chd_hunk_t());
+
+	// Uncompressed map. Just the file offset of each hunk, in units of hunkbytes.
+	if (sim_chd_codecs[0] == 0) {
+		if (mapoffset + (uint64_t)sim_chd_hunkcount * 4 > sim_chd_map->size) return -1;
+
+		for (uint32_t i = 0; i < sim_chd_hunkcount; i++) {
+			uint32_t entry = sim_chd_be32(file + mapoffset + i * 4);
+			sim_chd_hunks[i].type = entry ? SIM_CHD_NONE : SIM_CHD_ZERO;
+			sim_chd_hunks[i].offset = (uint64_t)entry * sim_chd_hunkbytes;
+			sim_chd_hunks[i].length = sim_chd_hunkbytes;
+		}
+		return 0;
+	}
+
+	if (mapoffset + 16 > sim_chd_map->size) return -1;
+
+	const uint8_t* maphdr = file + mapoffset;
+	uint32_t mapbytes = sim_chd_be32(maphdr + 0);
+	uint64_t curoffset = sim_chd_be48(maphdr + 4);
+	int lengthbits = maphdr[12];
+	int selfbits = maphdr[13];
+	int parentbits = maphdr[14];
+
+	if (mapoffset + 16 + mapbytes > sim_chd_map->size) return -1;
+
+	sim_chd_bits_t bits = { maphdr + 16, mapbytes, 0 };
+	sim_chd_huff_t huff;
+	if (sim_chd_huff_import(&huff, &bits)) return -1;
+
+	// First pass, the types. Runs of the same type are RLE coded.
+	uint8_t last = 0;
+	uint32_t rep = 0;
+	for (uint32_t i = 0; i < sim_chd_hunkcount; i++) {
+		if (rep > 0) {
+			sim_chd_hunks[i].type = last;
+			rep--;
+			continue;
+		}
+
+		uint8_t val = sim_chd_huff_decode(&huff, &bits);
+		if (val == SIM_CHD_RLE_SMALL) {
+			sim_chd_hunks[i].type = last;
+			rep = 2 + sim_chd_huff_decode(&huff, &bits);
+		}
+		else if (val == SIM_CHD_RLE_LARGE) {
+			sim_chd_hunks[i].type = last;
+			rep = 2 + 16 + (sim_chd_huff_decode(&huff, &bits) << 4);
+			rep += sim_chd_huff_decode(&huff, &bits);
+		}
+		else sim_chd_hunks[i].type = last = val;
+	}
+
+	// Second pass, the lengths and offsets. (The CRCs get skipped. The codecs catch anything truncated)
+	uint64_t last_self = 0;
+	for (uint32_t i = 0; i < sim_chd_hunkcount; i++) {
+		sim_chd_hunk_t* hunk = &sim_chd_hunks[i];
+		hunk->offset = curoffset;
+		hunk->length = 0;
+
+		switch (hunk->type) {
+			case SIM_CHD_TYPE_0: case SIM_CHD_TYPE_1: case SIM_CHD_TYPE_2: case SIM_CHD_TYPE_3:
+				hunk->length = sim_chd_read(&bits, lengthbits);
+				curoffset += hunk->length;
+				sim_chd_read(&bits, 16);
+				break;
+			case SIM_CHD_NONE:
+				hunk->length = sim_chd_hunkbytes;
+				curoffset += hunk->length;
+				sim_chd_read(&bits, 16);
+				break;
+			case SIM_CHD_SELF:
+				hunk->offset = last_self = sim_chd_read(&bits, selfbits);
+				break;
+			case SIM_CHD_SELF_1:
+				last_self++;
+				// Fall through.
+			case SIM_CHD_SELF_0:
+				hunk->type = SIM_CHD_SELF;
+				hunk->offset = last_self;
+				break;
+			case SIM_CHD_PARENT:
+				sim_chd_read(&bits, parentbits);
+				// Fall through.
+			case SIM_CHD_PARENT_SELF:
+			case SIM_CHD_PARENT_0:
+			case SIM_CHD_PARENT_1:
+				hunk->type = SIM_CHD_PARENT;	// Can't be read anyway, so the parent offset isn't tracked.
+				break;
+			default:
+				return -1;
+		}
+	}
+	return 0;
+}
+
+// "TRACK:1 TYPE:MODE1_RAW SUBTYPE:NONE FRAMES:12345 ..." Anything after FRAMES is ignored, so CHTR and CHT2 both work.
+static int sim_chd_read_tracks(const uint8_t* header_) {
+	const uint8_t* file = sim_chd_map->base;
+	uint64_t meta = sim_chd_be64(header_ + 48);
+
+	sim_chd_tracks.clear();
+	uint32_t lba = 0;
+	uint32_t frame = 0;
+
+	while (meta && meta + 16 <= sim_chd_map->size) {
+		uint32_t tag = sim_chd_be32(file + meta);
+		uint32_t len = sim_chd_be24(file + meta + 5);
+		uint64_t next = sim_chd_be64(file + meta + 8);
+
+		if ((tag == SIM_CHD_META_CHTR || tag == SIM_CHD_META_CHT2) && meta + 16 + len <= sim_chd_map->size && len < 256) {
+			char text[256];
+			memcpy(text, file + meta + 16, len);
+			text[len] = 0;
+
+			int num, frames;
+			char type[32], subtype[32];
+			if (sscanf(text, "TRACK:%d TYPE:%31s SUBTYPE:%31s FRAMES:%d", &num, type, subtype, &frames) != 4) return -1;
+
+			sim_chd_track_t track = { lba, (uint32_t)frames, frame, 0, SIM_CDIMAGE_USER_SIZE };
+			if (!strcmp(type, "MODE1_RAW")) { track.offset = 16; track.sector_size = SIM_CDIMAGE_RAW_SIZE; }
+			else if (!strcmp(type, "MODE2_RAW")) { track.offset = 24; track.sector_size = SIM_CDIMAGE_RAW_SIZE; }
+			else if (!strcmp(type, "MODE2") || !strcmp(type, "MODE2_FORM_MIX")) track.offset = 8;
+			else if (!strcmp(type, "AUDIO")) track.sector_size = SIM_CDIMAGE_RAW_SIZE;
+
+			sim_chd_tracks.push_back(track);
+			lba += frames;
+			frame += (frames + SIM_CHD_CD_PADDING - 1) / SIM_CHD_CD_PADDING * SIM_CHD_CD_PADDING;
+		}
+		meta = next;
+	}
+
+	sim_chd_sectors = lba;
+	return sim_chd_tracks.empty() ? -1 : 0;
+}
+
+
+// Raw deflate, as chdman's zlib codec writes it.
+static int sim_chd_inflate(const uint8_t* src_, uint32_t srclen_, uint8_t* dst_, uint32_t dstlen_) {
+	z_stream strm;
+	memset(&strm, 0, sizeof(strm));
+	if (inflateInit2(&strm, -MAX_WBITS) != Z_OK) return -1;
+
+	strm.next_in = (Bytef*)src_;
+	strm.avail_in = srclen_;
+	strm.next_out = dst_;
+	strm.avail_out = dstlen_;
+	int ret = inflate(&strm, Z_FINISH);
+	inflateEnd(&strm);
+
+	return (ret == Z_STREAM_END || strm.avail_out == 0) ? 0 : -1;
+}
+
+// Raw LZMA, with the properties chdman's encoder settles on for level 9: lc 3, lp 0, pb 2,
+// and the dictionary cut down to the next 2^n or 3 * 2^n above the hunk size.
+// There's no end marker, so it's done once the output is full.
+static int sim_chd_unlzma(const uint8_t* src_, uint32_t srclen_, uint8_t* dst_, uint32_t dstlen_) {
+	lzma_options_lzma opts;
+	memset(&opts, 0, sizeof(opts));
+	opts.lc = 3;
+	opts.lp = 0;
+	opts.pb = 2;
+	opts.dict_size = 1 << 26;
+	for (int i = 11; i <= 30; i++) {
+		if (dstlen_ <= (2u << i)) { opts.dict_size = 2u << i; break; }
+		if (dstlen_ <= (3u << i)) { opts.dict_size = 3u << i; break; }
+	}
+
+	lzma_filter filters[2] = { { LZMA_FILTER_LZMA1, &opts }, { LZMA_VLI_UNKNOWN, NULL } };
+	lzma_stream strm = LZMA_STREAM_INIT;
+	if (lzma_raw_decoder(&strm, filters) != LZMA_OK) return -1;
+
+	strm.next_in = src_;
+	strm.avail_in = srclen_;
+	strm.next_out = dst_;
+	strm.avail_out = dstlen_;
+	lzma_ret ret = lzma_code(&strm, LZMA_RUN);
+	size_t left = strm.avail_out;
+	lzma_end(&strm);
+
+	return ((ret == LZMA_OK || ret == LZMA_STREAM_END) && left == 0) ? 0 : -1;
+}
+
+// The CD codecs store all the sector data first (one stream), then all the subcode (another stream), behind a small
+// header: one bit per frame saying the sync + ECC were stripped, then the length of the sector stream.
+// Only the sector stream gets decoded, and spread back out to SIM_CHD_CD_FRAME strides. The subcode, sync and ECC
+// stay zero, since the drive only ever gets the user data.
+static int sim_chd_decode_cd(uint32_t codec_, const uint8_t* src_, uint32_t srclen_, uint8_t* dst_) {
+	uint32_t frames = sim_chd_hunkbytes / SIM_CHD_CD_FRAME;
+	uint32_t sector_bytes = frames * SIM_CDIMAGE_RAW_SIZE;
+	uint32_t len_bytes = (sim_chd_hunkbytes < 65536) ? 2 : 3;
+	uint32_t ecc_bytes = (frames + 7) / 8;
+	uint32_t header_bytes = ecc_bytes + len_bytes;
+	if (srclen_ < header_bytes) return -1;
+
+	uint32_t base_len = (src_[ecc_bytes] << 8) | src_[ecc_bytes + 1];
+	if (len_bytes > 2) base_len = (base_len << 8) | src_[ecc_bytes + 2];
+	if (header_bytes + base_len > srclen_) return -1;
+
+	int ret = (codec_ == SIM_CHD_CODEC_CDLZ) ? sim_chd_unlzma(src_ + header_bytes, base_len, dst_, sector_bytes)
+		: sim_chd_inflate(src_ + header_bytes, base_len, dst_, sector_bytes);
+	if (ret) return ret;
+
+	// Last frame first, since they only move up.
+	for (int i = frames - 1; i >= 0; i--) {
+		memmove(dst_ + i * SIM_CHD_CD_FRAME, dst_ + i * SIM_CDIMAGE_RAW_SIZE, SIM_CDIMAGE_RAW_SIZE);
+		memset(dst_ + i * SIM_CHD_CD_FRAME + SIM_CDIMAGE_RAW_SIZE, 0, SIM_CHD_CD_SUBCODE);
+	}
+	return 0;
+}
+
+// Safe to call from both threads. Each call sets up its own codec state.
+static int sim_chd_decode(uint32_t hunknum_, uint8_t* dst_, int depth_) {
+	const sim_chd_hunk_t* hunk = &sim_chd_hunks[hunknum_];
+	const uint8_t* src = sim_chd_map->base + hunk->offset;
+
+	switch (hunk->type) {
+		case SIM_CHD_TYPE_0: case SIM_CHD_TYPE_1: case SIM_CHD_TYPE_2: case SIM_CHD_TYPE_3: {
+			if (hunk->offset + hunk->length > sim_chd_map->size) return -1;
+
+			uint32_t codec = sim_chd_codecs[hunk->type];
+			switch (codec) {
+				case SIM_CHD_CODEC_CDZL:
+				case SIM_CHD_CODEC_CDLZ: return sim_chd_decode_cd(codec, src, hunk->length, dst_);
+				case SIM_CHD_CODEC_ZLIB: return sim_chd_inflate(src, hunk->length, dst_, sim_chd_hunkbytes);
+				case SIM_CHD_CODEC_LZMA: return sim_chd_unlzma(src, hunk->length, dst_, sim_chd_hunkbytes);
+			}
+			return -1;	// FLAC, or something newer.
+		}
+		case SIM_CHD_NONE:
+			if (hunk->offset + sim_chd_hunkbytes > sim_chd_map->size) return -1;
+			memcpy(dst_, src, sim_chd_hunkbytes);
+			return 0;
+		case SIM_CHD_ZERO:
+			memset(dst_, 0, sim_chd_hunkbytes);
+			return 0;
+		case SIM_CHD_SELF:
+			// Always points back to an earlier hunk, but don't trust that.
+			if (hunk->offset >= sim_chd_hunkcount || depth_ > 8) return -1;
+			return sim_chd_decode((uint32_t)hunk->offset, dst_, depth_ + 1);
+	}
+	return -1;		// Parent.
+}
+
+
+// Hunk cache. The sim thread and the worker both fill slots. A slot being filled is LOADING, and only the thread that
+// marked it touches its data. The slot the sim thread was last handed is pinned, so the worker can't evict it while
+// the sector is being copied out.
+enum sim_chd_slot_e {
+	SIM_CHD_SLOT_EMPTY = 0,
+	SIM_CHD_SLOT_LOADING,
+	SIM_CHD_SLOT_READY,
+	SIM_CHD_SLOT_BAD
+};
+
+typedef struct sim_chd_slot_t {
+	uint32_t hunk;
+	uint8_t state;
+	uint64_t used;			// LRU stamp.
+	std::vector<uint8_t> data;
+} sim_chd_slot_t;
+
+static sim_chd_slot_t sim_chd_cache[SIM_CHD_CACHE_HUNKS];
+static uint64_t sim_chd_tick = 0;
+static int sim_chd_pinned = -1;
+
+static std::mutex sim_chd_lock;
+static std::condition_variable sim_chd_wake;		// Worker has something to do.
+static std::condition_variable sim_chd_loaded;		// A slot left LOADING.
+static std::thread sim_chd_worker;
+static bool sim_chd_stop = 0;
+
+// Hunks the worker should fill, from next up to end.
+static uint32_t sim_chd_want_next = 0;
+static uint32_t sim_chd_want_end = 0;
+
+static sim_chd_stats_t sim_chd_stats;
+
+// With the lock held.
+static int sim_chd_find(uint32_t hunk_) {
+	for (int i = 0; i < SIM_CHD_CACHE_HUNKS; i++) {
+		if (sim_chd_cache[i].state != SIM_CHD_SLOT_EMPTY && sim_chd_cache[i].hunk == hunk_) return i;
+	}
+	return -1;
+}
+
+// With the lock held. Least recently used slot that isn't pinned or being filled.
+static int sim_chd_victim() {
+	int victim = -1;
+	for (int i = 0; i < SIM_CHD_CACHE_HUNKS; i++) {
+		if (i == sim_chd_pinned || sim_chd_cache[i].state == SIM_CHD_SLOT_LOADING) continue;
+		if (sim_chd_cache[i].state == SIM_CHD_SLOT_EMPTY) return i;
+		if (victim < 0 || sim_chd_cache[i].used < sim_chd_cache[victim].used) victim = i;
+	}
+	return victim;
+}
+
+// Call with the lock held. Drops it while decompressing.
+static void sim_chd_fill(std::unique_lock<std::mutex>& lock_, int slot_, uint32_t hunk_) {
+	sim_chd_slot_t* slot = &sim_chd_cache[slot_];
+	slot->hunk = hunk_;
+	slot->state = SIM_CHD_SLOT_LOADING;
+
+	lock_.unlock();
+	int ret = sim_chd_decode(hunk_, slot->data.data(), 0);
+	lock_.lock();
+
+	slot->state = ret ? SIM_CHD_SLOT_BAD : SIM_CHD_SLOT_READY;
+	slot->used = ++sim_chd_tick;
+	if (ret) sim_chd_stats.errors++;
+	sim_chd_loaded.notify_all();
+}
+
+static void sim_chd_prefetch() {
+	std::unique_lock<std::mutex> lock(sim_chd_lock);
+
+	while (1) {
+		sim_chd_wake.wait(lock, [] { return sim_chd_stop || sim_chd_want_next < sim_chd_want_end; });
+		if (sim_chd_stop) break;
+
+		uint32_t hunk = sim_chd_want_next++;
+		if (sim_chd_find(hunk) >= 0) continue;
+
+		int slot = sim_chd_victim();
+		if (slot < 0) continue;
+
+		sim_chd_fill(lock, slot, hunk);
+		sim_chd_stats.prefetched++;
+	}
+}
+
+static const uint8_t* sim_chd_get_hunk(uint32_t hunk_) {
+	std::unique_lock<std::mutex> lock(sim_chd_lock);
+
+	int slot = sim_chd_find(hunk_);
+	if (slot >= 0) {
+		sim_chd_stats.hits++;
+		sim_chd_loaded.wait(lock, [&] { return sim_chd_cache[slot].state != SIM_CHD_SLOT_LOADING; });
+	}
+	else {
+		sim_chd_stats.misses++;
+		slot = sim_chd_victim();
+		sim_chd_fill(lock, slot, hunk_);
+	}
+
+	sim_chd_cache[slot].used = ++sim_chd_tick;
+	sim_chd_pinned = slot;
+
+	// Keep the worker SIM_CHD_PREFETCH hunks ahead of this one.
+	sim_chd_want_next = hunk_ + 1;
+	sim_chd_want_end = hunk_ + 1 + SIM_CHD_PREFETCH;
+	if (sim_chd_want_end > sim_chd_hunkcount) sim_chd_want_end = sim_chd_hunkcount;
+	sim_chd_wake.notify_one();
+
+	return (sim_chd_cache[slot].state == SIM_CHD_SLOT_READY) ? sim_chd_cache[slot].data.data() : NULL;
+}
+
+
+static int sim_chd_open(const sim_cdimage_map_t* map_, sim_cdimage_info_t* info_) {
+	const uint8_t* header = map_->base;
+	if (map_->size < 16 || memcmp(header, SIM_CHD_MAGIC, 8)) return 1;
+
+	uint32_t version = sim_chd_be32(header + 12);
+	if (version != 5 || map_->size < SIM_CHD_V5_HEADER_SIZE) {
+		fprintf(stderr, "CHD v%u isn't supported. (v5 only. chdman copy will update it)\n", version);
+		return -1;
+	}
+
+	static const uint8_t no_parent[20] = { 0 };
+	if (memcmp(header + 104, no_parent, sizeof(no_parent))) {
+		fprintf(stderr, "CHDs with a parent aren't supported.\n");
+		return -1;
+	}
+
+	sim_chd_map = map_;
+	for (int i = 0; i < 4; i++) sim_chd_codecs[i] = sim_chd_be32(header + 16 + i * 4);
+
+	uint64_t logicalbytes = sim_chd_be64(header + 32);
+	sim_chd_hunkbytes = sim_chd_be32(header + 56);
+	uint32_t unitbytes = sim_chd_be32(header + 60);
+
+	if (unitbytes != SIM_CHD_CD_FRAME || sim_chd_hunkbytes == 0 || sim_chd_hunkbytes % SIM_CHD_CD_FRAME) {
+		fprintf(stderr, "Not a CD CHD.\n");
+		return -1;
+	}
+	sim_chd_hunkcount = (uint32_t)((logicalbytes + sim_chd_hunkbytes - 1) / sim_chd_hunkbytes);
+
+	if (sim_chd_read_map(header)) {
+		fprintf(stderr, "Bad CHD hunk map.\n");
+		return -1;
+	}
+	if (sim_chd_read_tracks(header)) {
+		fprintf(stderr, "No CD track info in the CHD.\n");
+		return -1;
+	}
+	sim_chd_last_track = 0;
+
+	for (int i = 0; i < SIM_CHD_CACHE_HUNKS; i++) {
+		sim_chd_cache[i].state = SIM_CHD_SLOT_EMPTY;
+		sim_chd_cache[i].used = 0;
+		sim_chd_cache[i].data.assign(sim_chd_hunkbytes, 0);
+	}
+	sim_chd_tick = 0;
+	sim_chd_pinned = -1;
+	sim_chd_want_next = 0;
+	sim_chd_want_end = 0;
+	memset(&sim_chd_stats, 0, sizeof(sim_chd_stats));
+
+	sim_chd_stop = 0;
+	sim_chd_worker = std::thread(sim_chd_prefetch);
+
+	info_->sectors = sim_chd_sectors;
+	info_->sector_size = sim_chd_tracks[0].sector_size;
+	return 0;
+}
+
+static void sim_chd_close() {
+	{
+		std::lock_guard<std::mutex> lock(sim_chd_lock);
+		sim_chd_stop = 1;
+	}
+	sim_chd_wake.notify_one();
+	sim_chd_worker.join();
+
+	for (int i = 0; i < SIM_CHD_CACHE_HUNKS; i++) {
+		sim_chd_cache[i].state = SIM_CHD_SLOT_EMPTY;
+		std::vector<uint8_t>().swap(sim_chd_cache[i].data);
+	}
+	sim_chd_hunks.clear();
+	sim_chd_tracks.clear();
+	sim_chd_map = NULL;
+}
+
+// Stops the worker if the program exits with a CHD still open. (std::thread would abort otherwise)
+static struct sim_chd_exit_t {
+	~sim_chd_exit_t() { if (sim_chd_worker.joinable()) sim_chd_close(); }
+} sim_chd_exit;
+
+static const uint8_t* sim_chd_sector(uint32_t lba_) {
+	if (lba_ >= sim_chd_sectors) return NULL;
+
+	// Nearly always the same track as last time.
+	const sim_chd_track_t* track = &sim_chd_tracks[sim_chd_last_track];
+	if (lba_ < track->lba || lba_ >= track->lba + track->frames) {
+		for (sim_chd_last_track = 0; sim_chd_last_track < sim_chd_tracks.size() - 1; sim_chd_last_track++) {
+			if (lba_ < sim_chd_tracks[sim_chd_last_track + 1].lba) break;
+		}
+		track = &sim_chd_tracks[sim_chd_last_track];
+	}
+
+	uint32_t frame = track->frame + (lba_ - track->lba);
+	uint32_t frames_per_hunk = sim_chd_hunkbytes / SIM_CHD_CD_FRAME;
+
+	const uint8_t* hunk = sim_chd_get_hunk(frame / frames_per_hunk);
+	if (hunk == NULL) return NULL;
+
+	return hunk + (frame % frames_per_hunk) * SIM_CHD_CD_FRAME + track->offset;
+}
+
+void sim_chd_get_stats(sim_chd_stats_t* stats_) {
+	std::lock_guard<std::mutex> lock(sim_chd_lock);
+	*stats_ = sim_chd_stats;
+}
+
+#else
+
+static int sim_chd_open(const sim_cdimage_map_t* map_, sim_cdimage_info_t* info_) {
+	if (map_->size < 16 || memcmp(map_->base, SIM_CHD_MAGIC, 8)) return 1;
+
+	fprintf(stderr, "No CHD support in this build. (needs SIM_CHD_ENABLE=1, with zlib and liblzma)\n");
+	return -1;
+}
+
+static void sim_chd_close() {
+}
+
+static const uint8_t* sim_chd_sector(uint32_t lba_) {
+	return NULL;
+}
+
+void sim_chd_get_stats(sim_chd_stats_t* stats_) {
+	memset(stats_, 0, sizeof(*stats_));
+}
+
+#endif
+
+const sim_cdimage_format_t sim_chd_format = { "chd", sim_chd_open, sim_chd_close, sim_chd_sector };
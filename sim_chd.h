@@ -0,0 +1,40 @@
+#ifndef SIM_CHD_H_INCLUDED
+#define SIM_CHD_H_INCLUDED
+
+// CHD (MAME's "Compressed Hunks of Data") CD images, as a sim_cdimage format.
+//
+// A CHD is cut into hunks (8 CD frames of 2448 bytes each, as chdman makes them), and each hunk is compressed on its own.
+// Decompressed hunks are kept in an LRU cache of SIM_CHD_CACHE_HUNKS. A worker thread decompresses the next
+// SIM_CHD_PREFETCH hunks past wherever the drive last read, so a sequential read (FMV) finds its hunks already there
+// and the sim thread never waits on the codec.
+//
+// Only v5 CHDs (chdman 0.146 onwards), and only stand-alone ones, not parent / child diffs.
+// Codecs: cdzl, cdlz, zlib, lzma. Hunks that chdman packed with FLAC (cdfl / flac, normally only the audio tracks)
+// can't be read, and come back as NULL sectors.
+//
+// Needs zlib and liblzma, so it's only built in with SIM_CHD_ENABLE=1. (verilate_headless.sh does)
+// Without that, CHD files are still recognised, and refused with a message, instead of being read as a flat image.
+//
+#include <stdint.h>
+
+#include "sim_cdimage.h"
+
+#ifndef SIM_CHD_ENABLE
+#define SIM_CHD_ENABLE 0
+#endif
+
+#define SIM_CHD_CACHE_HUNKS 64		// About 1.2MB with chdman's usual 19584-byte hunks.
+#define SIM_CHD_PREFETCH    4		// Hunks decompressed ahead of the drive. (32 sectors)
+
+extern const sim_cdimage_format_t sim_chd_format;
+
+typedef struct sim_chd_stats_t {
+	uint64_t hits;			// Hunk was in the cache, or was already being prefetched.
+	uint64_t misses;		// Had to be decompressed on the sim thread.
+	uint64_t prefetched;	// Decompressed by the worker.
+	uint64_t errors;		// Hunks that couldn't be decompressed.
+} sim_chd_stats_t;
+
+void sim_chd_get_stats(sim_chd_stats_t* stats_);
+
+#endif /* SIM_CHD_H_INCLUDED */
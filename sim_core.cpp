@@ -0,0 +1,1338 @@
+// Simulation core for the 3DO Verilator model.
+//
+// Everything needed to step Vcore_3do lives here: the host-side memories (BIOS, DRAM, VRAM, NVRAM),
+// the bus glue in verilate(), and the bits of Opera we still borrow (CD-ROM, XBUS, diag port, DSP).
+// Both front-ends link against this file: sim_main.cpp (Win32 / D3D11 / ImGui debugger),
+// and sim_headless.cpp (command-line batch runner). Nothing in here may touch ImGui or D3D. ElectronAsh.
+//
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sim_core.h"
+
+// libopera includes...
+#include "opera_3do.h"
+
+#include "opera_arm.h"
+#include "opera_clio.h"
+#include "opera_clock.h"
+#include "opera_core.h"
+#include "opera_diag_port.h"
+#include "opera_dsp.h"
+#include "opera_madam.h"
+#include "opera_region.h"
+#include "opera_sport.h"
+#include "opera_vdlp.h"
+#include "opera_xbus.h"
+#include "opera_xbus_cdrom_plugin.h"
+#include "opera_cdrom.h"
+#include "opera_nvram.h"
+
+#include "inline.h"
+
+#include "sim_xbus.h"
+#include "sim_bus.h"
+#include "sim_log.h"
+#include "sim_cdimage.h"
+#include "sim_mem.h"
+#include "sim_wave.h"
+#include "sim_idle.h"
+
+#include "opera_vdlp_i.h"
+//extern vdlp_t   g_VDLP;
+
+uint32_t opera_line;
+uint32_t opera_field;
+
+
+//extern cdrom_device_t g_CDROM_DEVICE;
+
+uint8_t* dram;
+uint8_t* vram;
+extern arm_core_t CPU;
+
+
+FILE* inst_file;
+FILE* soundfile;
+
+uint32_t sound_out;
+
+
+// Instantiation of module.
+Vcore_3do* top = new Vcore_3do;
+
+char decode_string[65];
+char issue_string[65];
+char shifter_string[65];
+char alu_string[65];
+char memory_string[65];
+char rb_string[65];
+
+bool old_fiq_n = 1;
+
+bool rom2_select = 0;   // Select the BIOS ROM at startup! (not Kanji).
+
+bool map_bios = 1;
+
+bool trace = 0;
+bool inst_trace = 0;
+bool soundtrace = 0;
+
+int pix_count = 0;
+
+uint32_t cur_pc;
+uint32_t old_pc;
+
+unsigned char rgb[3];
+int frame_count = 0;
+int line_count = 0;
+
+bool trig_irq = 0;
+bool trig_fiq = 0;
+
+uint16_t sim_joypad = 0;		// SIM_JOYPAD_xx bits. Set by the front-end, sampled by pbus_dma().
+
+sim_print_cb_t sim_print_cb = NULL;	// Where the BIOS "MADAM Print" characters go (besides stdout).
+
+
+vluint64_t main_time = 0;       // Current simulation time.
+
+unsigned int file_size;
+unsigned int iso_size;
+
+unsigned int rom_size = 1024 * 1024;            // 1MB. (8-bit wide, 32-bit access). BIOS.
+uint8_t* rom_ptr = (uint8_t*)malloc(rom_size);
+
+unsigned int rom2_size = 1024 * 1024;           // 1MB. (8-bit wide, 32-bit access). Kanji font ROM.
+uint8_t* rom2_ptr = (uint8_t*)malloc(rom2_size);
+
+unsigned int ram_size = 1024 * 2048;            // 2MB. (8-bit wide, 32-bit access).
+uint8_t* ram_ptr = (uint8_t*)malloc(ram_size);
+
+unsigned int vram_size = 1024 * 1024;			// 1MB. (8-bit wide, 32-bit access).
+//unsigned int vram_size = 1024 * 2048;			// 2MB. (8-bit wide, 32-bit access).
+uint8_t* vram_ptr = (uint8_t*)malloc(vram_size);
+
+unsigned int nvram_size = 1024 * 128;           // 128KB?
+uint8_t* nvram_ptr = (uint8_t*)malloc(nvram_size);
+
+unsigned int disp_size = 1024 * 1024 * 4;       // 4MB. (32-bit wide). Sim display window.
+uint32_t* disp_ptr = (uint32_t*)malloc(disp_size);
+
+unsigned int disp2_size = 1024 * 1024 * 4;       // 4MB. (32-bit wide). Opera display window.
+uint32_t* disp2_ptr = (uint32_t*)malloc(disp2_size);
+
+double sc_time_stamp() {       // Called by $time in Verilog.
+	return main_time;
+}
+
+extern opera_cdrom_get_size_cb_t    CDROM_GET_SIZE;
+extern opera_cdrom_set_sector_cb_t  CDROM_SET_SECTOR;
+extern opera_cdrom_read_sector_cb_t CDROM_READ_SECTOR;
+
+uint16_t CDIMAGE_SECTOR_SIZE = 2048;
+
+
+static
+uint32_t
+cdimage_get_size(void)
+{
+	return sim_cdimage_sectors();
+}
+
+static
+void
+cdimage_set_sector(const uint32_t sector_)
+{
+	CDIMAGE_SECTOR = sector_;
+}
+
+static
+void
+cdimage_read_sector(void* buf_)
+{
+	// Only the user data goes to the drive, whatever the sector size of the image. Past the end reads back as zeroes.
+	const uint8_t* sector = sim_cdimage_sector(CDIMAGE_SECTOR);
+	if (sector) memcpy(buf_, sector, REQSIZE);
+	else memset(buf_, 0, REQSIZE);
+}
+
+
+uint32_t g_OPT_VIDEO_WIDTH = 0;
+uint32_t g_OPT_VIDEO_HEIGHT = 0;
+uint32_t g_OPT_VIDEO_PITCH_SHIFT = 0;
+uint32_t g_OPT_VDLP_FLAGS = 0;
+uint32_t g_OPT_VDLP_PIXEL_FORMAT = 0;
+uint32_t g_OPT_ACTIVE_DEVICES = 0;
+
+void my_opera_init() {
+	opera_cdrom_set_callbacks(cdimage_get_size, cdimage_set_sector, cdimage_read_sector);
+
+	//opera_3do_init(libopera_callback);
+
+	opera_clock_init();
+	opera_arm_init();
+
+	// Opera gets the same ROMs as the sim. (Load them with sim_load_bios() / sim_load_rom2() first.)
+	memcpy(opera_arm_rom1_get(), rom_ptr, (size_t)opera_arm_rom1_size());
+	opera_arm_rom1_byteswap_if_necessary();
+	memcpy(opera_arm_rom2_get(), rom2_ptr, (size_t)opera_arm_rom2_size());
+	opera_arm_rom2_byteswap_if_necessary();
+
+	uint32_t size = (384 * 288 * 4);
+	if (!g_VIDEO_BUFFER) g_VIDEO_BUFFER = (uint32_t*)calloc(size, sizeof(uint32_t));
+	opera_vdlp_configure(g_VIDEO_BUFFER, (vdlp_pixel_format_e)VDLP_PIXEL_FORMAT_XRGB8888, g_OPT_VDLP_FLAGS);
+
+	dram = opera_arm_ram_get();
+	vram = opera_arm_vram_get();
+
+	opera_vdlp_init(vram);
+	opera_sport_init(vram);
+	opera_madam_init(dram);
+	opera_nvram_init();
+	
+	//opera_xbus_init(xbus_cdrom_plugin);
+	//opera_xbus_device_load(0, NULL);
+	sim_xbus_init(xbus_cdrom_plugin);
+	sim_xbus_device_load(0, NULL);
+
+	cdimage_set_sector(0);
+
+	// 0x40 for start from 3D0-CD
+	// 0x01/0x02 from PhotoCD ??
+	// (NO use 0x40/0x02 for BIOS test)
+	opera_clio_init(0x40);	// bit[6]=DIPIR.
+	//opera_clio_init(0x01);		// <- This value gets written to CLIO cstatbits. bit[0]=POR.
+	opera_dsp_init();
+}
+
+
+static uint16_t sim_SNDDebugFIFO0;
+static uint16_t sim_SNDDebugFIFO1;
+static uint16_t sim_RCVDebugFIFO0;
+static uint16_t sim_RCVDebugFIFO1;
+static uint16_t sim_GetIdx;
+static uint16_t sim_SendIdx;
+
+void
+sim_diag_port_init(const int32_t test_code_)
+{
+	int32_t test_code = test_code_;
+
+	sim_GetIdx = 16;
+	sim_SendIdx = 16;
+	sim_SNDDebugFIFO0 = 0;
+	sim_SNDDebugFIFO1 = 0;
+
+	if (test_code >= 0)
+	{
+		test_code ^= 0xFF;
+		test_code |= 0xA000;
+	}
+	else
+	{
+		test_code = 0;
+	}
+
+	sim_RCVDebugFIFO0 = test_code;
+	sim_RCVDebugFIFO1 = test_code;
+}
+
+
+void
+sim_diag_port_send(const uint32_t val_)
+{
+	if (sim_GetIdx != 16)
+	{
+		sim_GetIdx = 16;
+		sim_SendIdx = 16;
+		sim_SNDDebugFIFO0 = 0;
+		sim_SNDDebugFIFO1 = 0;
+	}
+
+	sim_SNDDebugFIFO0 |= ((val_ & 1) << (sim_SendIdx - 1));
+	sim_SNDDebugFIFO1 |= (((val_ & 1) >> 1) << (sim_SendIdx - 1));
+
+	sim_SendIdx--;
+
+	if (sim_SendIdx == 0)
+		sim_SendIdx = 16;
+}
+
+uint32_t
+sim_diag_port_get(void)
+{
+	unsigned int val = 0;
+
+	if (sim_SendIdx != 16)
+	{
+		sim_GetIdx = 16;
+		sim_SendIdx = 16;
+	}
+
+	val = ((sim_RCVDebugFIFO0 >> (sim_GetIdx - 1)) & 0x1);
+	val |= (((sim_RCVDebugFIFO1 >> (sim_GetIdx - 1)) & 0x1) << 0x1);
+	sim_GetIdx--;
+
+	if (sim_GetIdx == 0)
+		sim_GetIdx = 16;
+
+	return val;
+}
+
+
+volatile uint32_t vdl_ctl  = 0x00004410;
+volatile uint32_t vdl_curr = 0x002C0000;
+volatile uint32_t vdl_prev = 0x002C0000;
+volatile uint32_t vdl_next = 0x002C0000;
+
+volatile uint32_t clut[256];
+
+void sim_process_vdl() {
+	// Load default CLUT...
+	clut[0x00] = 0x000000; clut[0x01] = 0x080808; clut[0x02] = 0x101010; clut[0x03] = 0x191919; clut[0x04] = 0x212121; clut[0x05] = 0x292929; clut[0x06] = 0x313131; clut[0x07] = 0x3A3A3A;
+	clut[0x08] = 0x424242; clut[0x09] = 0x4A4A4A; clut[0x0A] = 0x525252; clut[0x0B] = 0x5A5A5A; clut[0x0C] = 0x636363; clut[0x0D] = 0x6B6B6B; clut[0x0E] = 0x737373; clut[0x0F] = 0x7B7B7B;
+	clut[0x10] = 0x848484; clut[0x11] = 0x8C8C8C; clut[0x12] = 0x949494; clut[0x13] = 0x9C9C9C; clut[0x14] = 0xA5A5A5; clut[0x15] = 0xADADAD; clut[0x16] = 0xB5B5B5; clut[0x17] = 0xBDBDBD;
+	clut[0x18] = 0xC5C5C5; clut[0x19] = 0xCECECE; clut[0x1A] = 0xD6D6D6; clut[0x1B] = 0xDEDEDE; clut[0x1C] = 0xE6E6E6; clut[0x1D] = 0xEFEFEF; clut[0x1E] = 0xF8F8F8; clut[0x1F] = 0xFFFFFF;
+
+	uint32_t header = top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma24_curaddr & 0xfffff;	// Mask address to 1MB (VRAM).
+
+	// Read the VDL / CLUT from vram_ptr...
+	if (header>0) {
+		vdl_ctl = 0x00000000;
+		vdl_curr = 0x00000000;
+		vdl_prev = 0x00000000;
+		vdl_next = 0x00000000;
+
+		for (int i = 0; i <= 35; i++) {
+			if (i == 0) {
+				vdl_ctl |= (vram_ptr[header + (i*4) + 0]) << 24;
+				vdl_ctl |= (vram_ptr[header + (i*4) + 1]) << 16;
+				vdl_ctl |= (vram_ptr[header + (i*4) + 2]) << 8;
+				vdl_ctl |= (vram_ptr[header + (i*4) + 3]) << 0;
+			}
+			if (i == 1) {
+				vdl_curr |= (vram_ptr[header + (i*4) + 0]) << 24;
+				vdl_curr |= (vram_ptr[header + (i*4) + 1]) << 16;
+				vdl_curr |= (vram_ptr[header + (i*4) + 2]) << 8;
+				vdl_curr |= (vram_ptr[header + (i*4) + 3]) << 0;
+			}
+			if (i == 2) {
+				vdl_prev |= (vram_ptr[header + (i*4) + 0]) << 24;
+				vdl_prev |= (vram_ptr[header + (i*4) + 1]) << 16;
+				vdl_prev |= (vram_ptr[header + (i*4) + 2]) << 8;
+				vdl_prev |= (vram_ptr[header + (i*4) + 3]) << 0;
+			}
+			if (i == 3) {
+				vdl_next |= (vram_ptr[header + (i*4) + 0]) << 24;
+				vdl_next |= (vram_ptr[header + (i*4) + 1]) << 16;
+				vdl_next |= (vram_ptr[header + (i*4) + 2]) << 8;
+				vdl_next |= (vram_ptr[header + (i*4) + 3]) << 0;
+			}
+			//else if (i>=4) clut[i-4] = vram_ptr[header+i];         // TESTING !!!
+		}
+	}
+
+	// Copy the VRAM pixels into disp_ptr...
+	// Just a dumb test atm. Assuming 16bpp from vram_ptr, with odd and even pixels in the upper/lower 16 bits.
+	//
+	// vram_ptr is 32-bit wide!
+	// vram_size = 1MB, so needs to be divided by 4 if used as an index.
+	//
+	uint32_t my_line = 0;
+
+	//uint32_t offset = 0xC0000;
+	uint32_t offset = vdl_curr & 0xfffff;
+	//uint32_t offset = vdl_next & 0xfffff;
+
+	for (uint32_t i = 0; i < (vram_size / 16); i++) {
+		uint16_t pixel;
+
+		if ((i % 320) == 0) my_line++;
+
+		pixel = vram_ptr[ (offset+(i*4)+0)&0xfffff ]<<8 | vram_ptr[ (offset+(i*4)+1)&0xfffff ];
+		rgb[0] = clut[(pixel & 0x7C00) >> 10] >> 16;
+		rgb[1] = clut[(pixel & 0x03E0) >> 5] >> 8;
+		rgb[2] = clut[(pixel & 0x001F) << 0] >> 0;
+		disp_ptr[i + (my_line * 320)] = 0xff<<24 | rgb[2]<<16 | rgb[1]<<8 | rgb[0];			// Our debugger framebuffer is in the 32-bit ABGR format.
+
+		pixel = vram_ptr[ (offset+(i*4)+2)&0xfffff ]<<8 | vram_ptr[ (offset+(i*4)+3)&0xfffff ];
+		rgb[0] = clut[(pixel & 0x7C00) >> 10] >> 16;
+		rgb[1] = clut[(pixel & 0x03E0) >> 5] >> 8;
+		rgb[2] = clut[(pixel & 0x001F) << 0] >> 0;
+		disp_ptr[i + (my_line * 320) + 320] = 0xff<<24 | rgb[2]<<16 | rgb[1]<<8 | rgb[0];	// Our debugger framebuffer is in the 32-bit ABGR format.
+	}
+}
+
+volatile uint32_t opera_vdl_ctl = 0x00000000;
+volatile uint32_t opera_vdl_curr = 0x00000000;
+volatile uint32_t opera_vdl_prev = 0x00000000;
+volatile uint32_t opera_vdl_next = 0x00000000;
+
+volatile uint32_t opera_clut[256];
+
+void opera_process_vdl() {
+	// Load default CLUT...
+	clut[0x00] = 0x000000; clut[0x01] = 0x080808; clut[0x02] = 0x101010; clut[0x03] = 0x191919; clut[0x04] = 0x212121; clut[0x05] = 0x292929; clut[0x06] = 0x313131; clut[0x07] = 0x3A3A3A;
+	clut[0x08] = 0x424242; clut[0x09] = 0x4A4A4A; clut[0x0A] = 0x525252; clut[0x0B] = 0x5A5A5A; clut[0x0C] = 0x636363; clut[0x0D] = 0x6B6B6B; clut[0x0E] = 0x737373; clut[0x0F] = 0x7B7B7B;
+	clut[0x10] = 0x848484; clut[0x11] = 0x8C8C8C; clut[0x12] = 0x949494; clut[0x13] = 0x9C9C9C; clut[0x14] = 0xA5A5A5; clut[0x15] = 0xADADAD; clut[0x16] = 0xB5B5B5; clut[0x17] = 0xBDBDBD;
+	clut[0x18] = 0xC5C5C5; clut[0x19] = 0xCECECE; clut[0x1A] = 0xD6D6D6; clut[0x1B] = 0xDEDEDE; clut[0x1C] = 0xE6E6E6; clut[0x1D] = 0xEFEFEF; clut[0x1E] = 0xF8F8F8; clut[0x1F] = 0xFFFFFF;
+
+	volatile uint32_t header = g_VDLP.curr_vdl & 0xfffff;
+
+	// Read the VDL / CLUT from vram_ptr...
+	if (header>0) {
+		for (int i = 0; i <= 35; i++) {
+			if (i == 0) {
+				opera_vdl_ctl |= (vram[header + (i*4) + 0]) << 24;
+				opera_vdl_ctl |= (vram[header + (i*4) + 1]) << 16;
+				opera_vdl_ctl |= (vram[header + (i*4) + 2]) << 8;
+				opera_vdl_ctl |= (vram[header + (i*4) + 3]) << 0;
+			}
+			if (i == 1) {
+				opera_vdl_curr |= (vram[header + (i*4) + 0]) << 24;
+				opera_vdl_curr |= (vram[header + (i*4) + 1]) << 16;
+				opera_vdl_curr |= (vram[header + (i*4) + 2]) << 8;
+				opera_vdl_curr |= (vram[header + (i*4) + 3]) << 0;
+			}
+			if (i == 2) {
+				opera_vdl_prev |= (vram[header + (i*4) + 0]) << 24;
+				opera_vdl_prev |= (vram[header + (i*4) + 1]) << 16;
+				opera_vdl_prev |= (vram[header + (i*4) + 2]) << 8;
+				opera_vdl_prev |= (vram[header + (i*4) + 3]) << 0;
+			}
+			if (i == 3) {
+				opera_vdl_next |= (vram[header + (i*4) + 0]) << 24;
+				opera_vdl_next |= (vram[header + (i*4) + 1]) << 16;
+				opera_vdl_next |= (vram[header + (i*4) + 2]) << 8;
+				opera_vdl_next |= (vram[header + (i*4) + 3]) << 0;
+			}
+			//else if (i>=4) clut[i-4] = vram_ptr[header+i];         // TESTING !!!
+		}
+	}
+
+	// Copy the VRAM pixels into disp_ptr...
+	// Just a dumb test atm. Assuming 16bpp from vram_ptr, with odd and even pixels in the upper/lower 16 bits.
+	//
+	// vram_ptr is 32-bit wide!
+	// vram_size = 1MB, so needs to be divided by 4 if used as an index.
+	//
+
+	//uint32_t offset = opera_vdl_curr & 0xfffff;
+	//uint32_t offset = opera_vdl_next & 0xfffff;
+
+	uint32_t offset = g_VDLP.curr_bmp & 0xfffff;
+	//uint32_t offset = opera_vdlp_bmp_origin & 0xfffff;
+	//uint32_t offset = 0x21000;
+	//uint32_t offset = 0xC0000;
+
+	uint32_t my_line = opera_line;
+
+	for (int i = 0; i < 320; i++) {
+		uint16_t pixel;
+
+		pixel = vram[offset + (i * 4) + 3] << 8 | vram[offset + (i * 4) + 2];
+		rgb[0] = clut[(pixel & 0x7C00) >> 10] >> 16;
+		rgb[1] = clut[(pixel & 0x03E0) >> 5] >> 8;
+		rgb[2] = clut[(pixel & 0x001F) << 0] >> 0;
+		disp2_ptr[i + (my_line * 320)] = 0xff << 24 | rgb[2] << 16 | rgb[1] << 8 | rgb[0];			// Our debugger framebuffer is in the 32-bit ABGR format.
+
+		pixel = vram[offset + (i * 4) + 1] << 8 | vram[offset + (i * 4) + 0];
+		rgb[0] = clut[(pixel & 0x7C00) >> 10] >> 16;
+		rgb[1] = clut[(pixel & 0x03E0) >> 5] >> 8;
+		rgb[2] = clut[(pixel & 0x001F) << 0] >> 0;
+		disp2_ptr[i + (my_line * 320) + 320] = 0xff << 24 | rgb[2] << 16 | rgb[1] << 8 | rgb[0];	// Our debugger framebuffer is in the 32-bit ABGR format.
+	}
+
+	/*
+	for (int i = 0; i < (vram_size / 16); i++) {
+		uint16_t pixel;
+
+		if ((i % 320) == 0) my_line++;
+
+		pixel = vram[offset + (i * 4) + 3] << 8 | vram[offset + (i * 4) + 2];
+		rgb[0] = clut[(pixel & 0x7C00) >> 10] >> 16;
+		rgb[1] = clut[(pixel & 0x03E0) >> 5] >> 8;
+		rgb[2] = clut[(pixel & 0x001F) << 0] >> 0;
+		disp2_ptr[i + (my_line * 320)] = 0xff << 24 | rgb[2] << 16 | rgb[1] << 8 | rgb[0];			// Our debugger framebuffer is in the 32-bit ABGR format.
+
+		pixel = vram[offset + (i * 4) + 1] << 8 | vram[offset + (i * 4) + 0];
+		rgb[0] = clut[(pixel & 0x7C00) >> 10] >> 16;
+		rgb[1] = clut[(pixel & 0x03E0) >> 5] >> 8;
+		rgb[2] = clut[(pixel & 0x001F) << 0] >> 0;
+		disp2_ptr[i + (my_line * 320) + 320] = 0xff << 24 | rgb[2] << 16 | rgb[1] << 8 | rgb[0];	// Our debugger framebuffer is in the 32-bit ABGR format.
+	}
+	*/
+}
+
+uint32_t svf_src_addr = 00;
+void svf_set_source() {
+	svf_src_addr = (top->mem_addr & 0x7ff) << 9;
+}
+
+void svf_page_copy() {
+	uint32_t dest_addr = (top->mem_addr & 0x7ff) << 9;	// Remember, the *address* is used here, not o_wb_dat.
+	uint32_t mask = top->o_wb_dat;                      // The write *data* is used as an mask. I think? ElectronAsh.
+
+	uint32_t keep = mask ^ 0xffffffff;
+
+	for(int i = 0; i < 2048; i += 4)   // Block size is 2KB. Copying a WORD at a time, so i+=4.
+	{
+		uint32_t dest = sim_mem_read32(vram_ptr, dest_addr + i);
+		uint32_t src = sim_mem_read32(vram_ptr, svf_src_addr + i);
+		sim_mem_write32(vram_ptr, dest_addr + i, (dest & keep) | (src & mask));
+	}
+}
+
+uint32_t svf_color = 0;
+void svf_set_color() {
+	svf_color = top->o_wb_dat;
+}
+
+void svf_flash_write() {        // "Color fill", basically.
+	uint32_t dest_addr = (top->mem_addr & 0x7ff) << 9;	// Remember, the *address* is used here, not o_wb_dat.
+	uint32_t mask = top->o_wb_dat;						// The write *data* is used as an mask. I think? ElectronAsh.
+
+	uint32_t keep = mask ^ 0xffffffff;
+
+	for (int i = 0; i < 2048; i+=4)   // Block size is 2KB. Writing a WORD at a time, so i+=4.
+	{
+		uint32_t dest = sim_mem_read32(vram_ptr, dest_addr + i);
+		sim_mem_write32(vram_ptr, dest_addr + i, (dest & keep) | (svf_color & mask));
+	}
+}
+
+#define PBUS_BUF_SIZE 256
+
+#define PBUS_FLIGHTSTICK_ID_0       0x01
+#define PBUS_FLIGHTSTICK_ID_1       0x7B
+#define PBUS_JOYPAD_ID              0x80
+#define PBUS_MOUSE_ID               0x49
+#define PBUS_LIGHTGUN_ID            0x4D
+#define PBUS_ORBATAK_TRACKBALL_ID   PBUS_MOUSE_ID
+#define PBUS_ORBATAK_BUTTONS_ID     0xC0
+
+#define PBUS_JOYPAD_SHIFT_LT        0x02
+#define PBUS_JOYPAD_SHIFT_RT        0x03
+#define PBUS_JOYPAD_SHIFT_X         0x04
+#define PBUS_JOYPAD_SHIFT_P         0x05
+#define PBUS_JOYPAD_SHIFT_C         0x06
+#define PBUS_JOYPAD_SHIFT_B         0x07
+#define PBUS_JOYPAD_SHIFT_A         0x00
+#define PBUS_JOYPAD_SHIFT_L         0x01
+#define PBUS_JOYPAD_SHIFT_R         0x02
+#define PBUS_JOYPAD_SHIFT_U         0x03
+#define PBUS_JOYPAD_SHIFT_D         0x04
+
+uint8_t pbus_buf[PBUS_BUF_SIZE];
+uint32_t pbus_idx;
+
+void pbus_dma() {
+	bool jp_d = (sim_joypad & SIM_JOYPAD_DOWN) != 0;
+	bool jp_u = (sim_joypad & SIM_JOYPAD_UP) != 0;
+	bool jp_r = (sim_joypad & SIM_JOYPAD_RIGHT) != 0;
+	bool jp_l = (sim_joypad & SIM_JOYPAD_LEFT) != 0;
+	bool jp_a = (sim_joypad & SIM_JOYPAD_A) != 0;
+	bool jp_b = (sim_joypad & SIM_JOYPAD_B) != 0;
+	bool jp_c = (sim_joypad & SIM_JOYPAD_C) != 0;
+	bool jp_p = (sim_joypad & SIM_JOYPAD_P) != 0;
+	bool jp_x = (sim_joypad & SIM_JOYPAD_X) != 0;
+	bool jp_rt = (sim_joypad & SIM_JOYPAD_RT) != 0;
+	bool jp_lt = (sim_joypad & SIM_JOYPAD_LT) != 0;
+
+	uint32_t str = top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma23_curaddr;	// 0x570.
+	uint32_t len = top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma23_curlen;	// 0x574.
+	uint32_t end = top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma23_nextaddr;	// 0x578.
+
+	uint32_t temp_word = 0x00000000;
+
+	str += 4;
+	len -= 4;
+	end += 4;
+
+	pbus_idx = 0;
+
+	pbus_buf[0] = ((PBUS_JOYPAD_ID) |
+		(jp_d << PBUS_JOYPAD_SHIFT_D) |
+		(jp_u << PBUS_JOYPAD_SHIFT_U) |
+		(jp_r << PBUS_JOYPAD_SHIFT_R) |
+		(jp_l << PBUS_JOYPAD_SHIFT_L) |
+		(jp_a << PBUS_JOYPAD_SHIFT_A));
+
+	pbus_buf[1] = ((jp_b << PBUS_JOYPAD_SHIFT_B) |
+		(jp_c << PBUS_JOYPAD_SHIFT_C) |
+		(jp_p << PBUS_JOYPAD_SHIFT_P) |
+		(jp_x << PBUS_JOYPAD_SHIFT_X) |
+		(jp_rt << PBUS_JOYPAD_SHIFT_RT) |
+		(jp_lt << PBUS_JOYPAD_SHIFT_LT));
+
+
+	temp_word = (pbus_buf[0] << 24) | (pbus_buf[1] << 16) | (pbus_buf[2] << 8) | (pbus_buf[3] << 0);
+	//ram_ptr[ dst&0x1fffff ] = temp_word;  // ram_ptr is now BYTE addressed!
+
+	sim_log(SIM_LOG_PBUS_DMA, SIM_LOG_MISC, main_time, cur_pc, str, len, end, 0);
+
+	/*
+	for (int i = 0; i < 8; i+=4) {
+			ram_ptr[ (dst&0x1fffff)+i ] = pbus_buf[i+0] << 24;
+			temp_word = ram_ptr[ (dst&0x1fffff)+i ];
+			ram_ptr[ (dst&0x1fffff)+i ] = temp_word&0xff00ffff | (pbus_buf[i+1] << 16);
+			temp_word = ram_ptr[ (dst&0x1fffff)+i ];
+			ram_ptr[ (dst&0x1fffff)+i ] = temp_word&0xffff00ff | (pbus_buf[i+2] << 8);
+			temp_word = ram_ptr[ (dst&0x1fffff)+i ];
+			ram_ptr[ (dst&0x1fffff)+i ] = temp_word&0xffffff00 | (pbus_buf[i+3] << 0);
+	}
+	*/
+
+	//pbus_buf[pbus_idx++] = 0xffffffff;    // Pad the last word??
+
+	//top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma23_curaddr += len;
+	//top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma23_nextaddr += len;
+
+	//0x8000FFFF 0xFFFFFFFF 0xFFFF0000 0xFFFFFFFF
+	//0xFFFFFFFF 0xFFFFFFFF 0xFFFFFFFF 0xFFFFFFFF
+	ram_ptr[str+0]= pbus_buf[0]; ram_ptr[str+1]= pbus_buf[1]; ram_ptr[str+2]= 0xff; ram_ptr[str+3]= 0xff,
+	ram_ptr[str+4]= 0xff; ram_ptr[str+5]= 0xff; ram_ptr[str+6]= 0xff; ram_ptr[str+7]= 0xff;
+	ram_ptr[str+8]= 0xff; ram_ptr[str+9]= 0xff; ram_ptr[str+10]=0xff; ram_ptr[str+11]=0xff,
+	ram_ptr[str+12]=0xff; ram_ptr[str+13]=0xff; ram_ptr[str+14]=0xff; ram_ptr[str+15]=0xff;
+	ram_ptr[str+16]=0xff; ram_ptr[str+17]=0xff; ram_ptr[str+18]=0x00; ram_ptr[str+19]=0x00,
+	ram_ptr[str+20]=0xff; ram_ptr[str+21]=0xff; ram_ptr[str+22]=0xff; ram_ptr[str+23]=0xff;
+	ram_ptr[str+24]=0xff; ram_ptr[str+25]=0xff; ram_ptr[str+26]=0xff; ram_ptr[str+27]=0xff,
+	ram_ptr[str+28]=0xff; ram_ptr[str+29]=0xff; ram_ptr[str+30]=0xff; ram_ptr[str+31]=0xff;
+
+	ram_ptr[str+32]=0xff; ram_ptr[str+33]=0xff; ram_ptr[str+34]=0xff; ram_ptr[str+35]=0xff;
+
+	top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma23_curlen = 0xfffffffc;	// Set the length to -4 when done?
+	top->rootp->core_3do__DOT__clio_inst__DOT__irq1_pend |= 1;              // Bit 0 of irq1_pend is the PBUS DMA Done bit.
+	top->rootp->core_3do__DOT__madam_inst__DOT__mctl &= ~0x8000;			// Clear bit 15 (PBUS DMA Enable) of mctl reg.
+
+	/*
+	for (int i=str; i<end; i+=4) {
+		fprintf(logfile, "0x%08X: ", i);
+		fprintf(logfile, "0x%02X%02X%02X%02X\n", ram_ptr[i+0], ram_ptr[i+1], ram_ptr[i+2], ram_ptr[i+3]);
+	}
+	*/
+}
+
+
+static void opera_sound_out(uint32_t sample_) {
+	sound_out = sample_;	// Almost certain this is the DSP sound output. ElectronAsh.
+	//fprintf(soundfile, "Sound 0x%08X: ", sound_out);
+	if (soundtrace) {
+		fputc( (sound_out>>24) & 0xff, soundfile);
+		fputc( (sound_out>>16) & 0xff, soundfile);
+		fputc( (sound_out>>8)  & 0xff, soundfile);
+		fputc( (sound_out>>0)  & 0xff, soundfile);
+	}
+}
+
+void opera_tick() {
+	opera_3do_process_frame(&opera_line, &opera_field);	// Tweaked, to render one LINE at a time. ElectronAsh.
+
+	//opera_arm_execute();		// <- This contains all of our Opera fprintfs.
+	//opera_clock_push_cycles(main_time);
+
+	//if (opera_clock_dsp_queued()) libopera_callback(EXT_DSP_TRIGGER, NULL);
+	//if (opera_clock_dsp_queued()) opera_lr_dsp_process();
+
+	if (opera_clock_dsp_queued()) {
+		//g_DSP_BUF[g_DSP_BUF_IDX++] = opera_dsp_loop();
+		//g_DSP_BUF_IDX &= DSP_BUF_SIZE_MASK;
+		opera_sound_out(opera_dsp_loop());
+	}
+}
+
+static void opera_field_line(void* data_, uint32_t line_, uint32_t field_) {
+	opera_line = line_;
+	opera_process_vdl();
+}
+
+static void opera_field_dsp(void* data_, uint32_t sample_) {
+	opera_sound_out(sample_);
+}
+
+// The rest of the current Opera field in one go. Same as calling opera_tick() until the field flips, but without coming back
+// out for every instruction. The Opera display gets every line drawn, rather than every 8th one like verilate() does.
+void opera_run_field() {
+	const opera_3do_lines_cb_t cb = { opera_field_line, opera_field_dsp, NULL };
+	opera_3do_process_field(&cb, &opera_line, &opera_field);
+}
+
+// Opera's SWI profile (opera_arm_swi_prof_set), busiest first. The histogram is log2 buckets of cycles, only the ones with calls in.
+void opera_swi_prof_print(FILE* file_, int max_) {
+	static opera_arm_swi_prof_t prof[64];
+	uint32_t n = opera_arm_swi_prof_get(prof, (max_ > 0 && max_ < 64) ? max_ : 64);
+
+	for (uint32_t i = 0; i < n; i++) {
+		fprintf(file_, "swi 0x%06X  calls: %-8u hle: %-8u cycles: %-12llu avg: %-8llu |", prof[i].swi, prof[i].calls, prof[i].hle,
+			(unsigned long long)prof[i].cycles, (unsigned long long)(prof[i].cycles / prof[i].calls));
+		for (int b = 0; b < OPERA_ARM_SWI_PROF_BUCKETS; b++) {
+			if (prof[i].hist[b]) fprintf(file_, " <2^%d:%u", b, prof[i].hist[b]);
+		}
+		fprintf(file_, "\n");
+	}
+}
+
+static void sim_clio_handle_dma(uint32_t val_)
+{
+	if (val_ & 0x00100000)	// Check if the Xbus DMA Enable bit in the write to 0x03400304 (CLIO dmactrl) is set.
+	{
+		int len;		// Needs to be a signed int, so the while (len >= 0) below works.
+		uint32_t trg;
+		uint8_t b0, b1, b2, b3;
+
+		trg = top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma20_curaddr;	// 0x03300540. DMA Target (Source/Dest address). Likely always the dest, for a CDROM DMA?
+		len = top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma20_curlen;	// 0x03300544. DMA Length (in BYTES).
+
+		sim_log(SIM_LOG_XBUS_DMA, SIM_LOG_XBUS, main_time, cur_pc, trg, len, 0, 0);
+
+		top->rootp->core_3do__DOT__clio_inst__DOT__dmactrl &= ~0x00100000;	// Clear bit [20] in the CLIO dmactrl reg.
+		top->rootp->core_3do__DOT__clio_inst__DOT__expctl &= ~0x80;			// Clear bit [7] in the CLIO expctl reg "DMA has control of Xbus".
+
+		//if (top->rootp->core_3do__DOT__clio_inst__DOT__expctl & 0x200)	// XB_DmadirectION bit.There was an "else" after this "if" in
+		//{																	// the Opera source, but the code was identical.
+			while (len >= 0)												// Very likely because the CDROM drive is always Xbus -> RAM. ElectronAsh.
+			{
+				b3 = sim_xbus_fifo_get_data();
+				b2 = sim_xbus_fifo_get_data();
+				b1 = sim_xbus_fifo_get_data();
+				b0 = sim_xbus_fifo_get_data();
+
+				//fprintf(logfile, "Addr: 0x%08X  0x%02X%02X%02X%02X\n", trg, b0, b1, b2, b3);
+
+				// Mask address, so DMA can only target 2MB main DRAM ,or 1MB VRAM (but not registers?). ElectronAsh.
+				if (trg < 0x200000) {
+					ram_ptr[ (trg & 0x1fffff) + 0 ] = b0;
+					ram_ptr[ (trg & 0x1fffff) + 1 ] = b1;
+					ram_ptr[ (trg & 0x1fffff) + 2 ] = b2;
+					ram_ptr[ (trg & 0x1fffff) + 3 ] = b3;
+				}
+				/*
+				else {
+					vram_ptr[ (trg & 0xfffff) + 0 ] = b0;
+					vram_ptr[ (trg & 0xfffff) + 1 ] = b1;
+					vram_ptr[ (trg & 0xfffff) + 2 ] = b2;
+					vram_ptr[ (trg & 0xfffff) + 3 ] = b3;
+				}
+				*/
+
+				trg += 4;
+				len -= 4;
+			}
+
+			top->rootp->core_3do__DOT__clio_inst__DOT__expctl |= 0x80;	// Set bit [7] in the CLIO expctl reg "ARM has control of Xbus".
+		//}
+
+		top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma20_curlen = 0xFFFFFFFC;	// Length reg should end up with this value once it wraps 0?
+		top->rootp->core_3do__DOT__clio_inst__DOT__irq0_pend |= (1<<29);		// Set the IRQ0 Pending bit, for "XBus DMA Done"!
+	}
+}
+
+static
+void
+sim_if_set_set_reset(uint32_t* output_,
+	uint32_t  val_,
+	uint32_t  mask_chk_,
+	uint32_t  mask_set_)
+{
+	if ((val_ & mask_chk_) == mask_chk_)
+	{
+		*output_ = ((val_ & mask_set_) ?
+			(*output_ | mask_set_) :
+			(*output_ & ~mask_set_));
+	}
+}
+
+void handle_adbio_write() {
+	sim_if_set_set_reset(&top->rootp->core_3do__DOT__clio_inst__DOT__adbio_reg, top->o_wb_dat, 0x10, 0x01);
+	sim_if_set_set_reset(&top->rootp->core_3do__DOT__clio_inst__DOT__adbio_reg, top->o_wb_dat, 0x20, 0x02);
+	sim_if_set_set_reset(&top->rootp->core_3do__DOT__clio_inst__DOT__adbio_reg, top->o_wb_dat, 0x40, 0x04);
+	sim_if_set_set_reset(&top->rootp->core_3do__DOT__clio_inst__DOT__adbio_reg, top->o_wb_dat, 0x80, 0x08);
+}
+
+static void sim_strrev(char* str_)
+{
+	size_t len = strlen(str_);
+	for (size_t i = 0; i < len / 2; i++) {
+		char tmp = str_[i];
+		str_[i] = str_[len - 1 - i];
+		str_[len - 1 - i] = tmp;
+	}
+}
+
+// Pull the Zap pipeline decompile strings out of the model, for the debugger window.
+// This used to run on every verilate() call, but only the UI reads them, so it's now called once per UI frame.
+void sim_update_decompile() {
+	uint32_t decode_word[16];
+	uint32_t issue_word[16];
+	uint32_t shifter_word[16];
+	uint32_t alu_word[16];
+	uint32_t memory_word[16];
+	uint32_t rb_word[16];
+	for (int i = 0; i < 16; i++) {
+		decode_word[i] = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__decode_decompile[i];
+		issue_word[i] = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__issue_decompile[i];
+		shifter_word[i] = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__shifter_decompile[i];
+		alu_word[i] = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__alu_decompile[i];
+		memory_word[i] = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__memory_decompile[i];
+		rb_word[i] = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__rb_decompile[i];
+	}
+
+	for (int i = 0; i < 64; i += 4) {
+		decode_string[i + 0] = decode_word[(i >> 2)] >> 0; decode_string[i + 1] = decode_word[(i >> 2)] >> 8; decode_string[i + 2] = decode_word[(i >> 2)] >> 16; decode_string[i + 3] = decode_word[(i >> 2)] >> 24;
+		issue_string[i + 0] = issue_word[(i >> 2)] >> 0; issue_string[i + 1] = issue_word[(i >> 2)] >> 8; issue_string[i + 2] = issue_word[(i >> 2)] >> 16; issue_string[i + 3] = issue_word[(i >> 2)] >> 24;
+		shifter_string[i + 0] = shifter_word[(i >> 2)] >> 0; shifter_string[i + 1] = shifter_word[(i >> 2)] >> 8; shifter_string[i + 2] = shifter_word[(i >> 2)] >> 16; shifter_string[i + 3] = shifter_word[(i >> 2)] >> 24;
+		alu_string[i + 0] = alu_word[(i >> 2)] >> 0; alu_string[i + 1] = alu_word[(i >> 2)] >> 8; alu_string[i + 2] = alu_word[(i >> 2)] >> 16; alu_string[i + 3] = alu_word[(i >> 2)] >> 24;
+		memory_string[i + 0] = memory_word[(i >> 2)] >> 0; memory_string[i + 1] = memory_word[(i >> 2)] >> 8; memory_string[i + 2] = memory_word[(i >> 2)] >> 16; memory_string[i + 3] = memory_word[(i >> 2)] >> 24;
+		rb_string[i + 0] = rb_word[(i >> 2)] >> 0; rb_string[i + 1] = rb_word[(i >> 2)] >> 8; rb_string[i + 2] = rb_word[(i >> 2)] >> 16; rb_string[i + 3] = rb_word[(i >> 2)] >> 24;
+	}
+
+	sim_strrev(decode_string);
+	sim_strrev(issue_string);
+	sim_strrev(shifter_string);
+	sim_strrev(alu_string);
+	sim_strrev(memory_string);
+	sim_strrev(rb_string);
+}
+
+int verilate() {
+	if (!Verilated::gotFinish()) {
+		if (main_time < 50) {
+			top->reset_n = 0;		// Assert reset (active LOW)
+			frame_count = 0;
+		}
+		if (main_time == 50) {		// Do == here, so we can still reset it in the main loop.
+			top->reset_n = 1;		// Deassert reset./
+		}
+
+		if (top->reset_n) {
+			/*
+			if (top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_writeback__DOT__o_trace_valid &&
+				top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_writeback__DOT__o_trace_uop_last)
+				opera_tick();
+			*/
+
+			map_bios = 0;
+			top->rootp->core_3do__DOT__madam_inst__DOT__map_bios = 0;
+			//top->rootp->core_3do__DOT__madam_inst__DOT__nextccb = 0x000BB770;
+			//top->rootp->core_3do__DOT__madam_inst__DOT__nextccb = 0x000B7ee4;
+			//top->rootp->core_3do__DOT__madam_inst__DOT__nextccb = 0x000bc4f0;
+			//top->rootp->core_3do__DOT__madam_inst__DOT__nextccb = 0x000Bfc70;
+
+			top->rootp->core_3do__DOT__madam_inst__DOT__nextccb = 0x00000000;
+		}
+
+		pix_count++;
+
+		uint16_t spr_wi = (top->rootp->core_3do__DOT__madam_inst__DOT__pre1&0x7ff) + 1;
+		//uint16_t spr_wi = spr_width;
+
+		/*
+		clut[0x00] = 0x35ED42; clut[0x01] = 0x3035EF; clut[0x02] = 0x31CD35; clut[0x03] = 0xAB2DAD; clut[0x04] = 0x3E0E29; clut[0x05] = 0x8B4650; clut[0x06] = 0x256A25; clut[0x07] = 0x492128;
+		clut[0x08] = 0x467142; clut[0x09] = 0x514E92; clut[0x0a] = 0x56D44E; clut[0x0b] = 0xB456B2; clut[0x0c] = 0x5EF456; clut[0x0d] = 0xD518E6; clut[0x0e] = 0x1D0614; clut[0x0f] = 0xC56335;
+		clut[0x10] = 0x5F176B; clut[0x11] = 0x587399; clut[0x12] = 0x77BA7F; clut[0x13] = 0xFF0C62; clut[0x14] = 0x7BDE00; clut[0x15] = 0x010000; clut[0x16] = 0x000000; clut[0x17] = 0x000000;
+		clut[0x18] = 0x000000; clut[0x19] = 0x003FE6; clut[0x1a] = 0x462000; clut[0x1b] = 0x0B8DB0; clut[0x1c] = 0x000B8D; clut[0x1d] = 0xFC000B; clut[0x1e] = 0xB4F400; clut[0x1f] = 0x800000;
+		*/
+
+		// PLUT, for coded_packed_6bpp.cel...
+		clut[0x00] = 0x7FFF; clut[0x01] = 0x698C; clut[0x02] = 0x64E8; clut[0x03] = 0x60A6; clut[0x04] = 0x7BBD; clut[0x05] = 0x6B5B; clut[0x06] = 0x5EF7; clut[0x07] = 0x4A52;
+		clut[0x08] = 0x2951; clut[0x09] = 0x3192; clut[0x0a] = 0x4E73; clut[0x0b] = 0x2110; clut[0x0c] = 0x0C6C; clut[0x0d] = 0x56B5; clut[0x0f] = 0x10AE; clut[0x17] = 0x39CE;
+		clut[0x10] = 0x294A; clut[0x11] = 0x1084; clut[0x12] = 0x18C0; clut[0x13] = 0x2528; clut[0x14] = 0x318C; clut[0x15] = 0x2108; clut[0x16] = 0x0840; clut[0x17] = 0x2921;
+		clut[0x18] = 0x0000; clut[0x19] = 0x3161; clut[0x1a] = 0x3DC2; clut[0x1b] = 0x4A02; clut[0x1c] = 0x5E83; clut[0x1d] = 0x6AE3; clut[0x1f] = 0x7B64; clut[0x27] = 0x7F84;
+
+		/*
+		// PLUT, for one of the BIOS "Please Insert CD" screen CELs...
+		clut[0x00] = 0x35ED; clut[0x01] = 0x4230; clut[0x02] = 0x35EF; clut[0x03] = 0x31CD; clut[0x04] = 0x35AB; clut[0x05] = 0x2DAD; clut[0x06] = 0x3E0E; clut[0x07] = 0x298B;
+		clut[0x08] = 0x4650; clut[0x09] = 0x256A; clut[0x0a] = 0x2549; clut[0x0b] = 0x2128; clut[0x0c] = 0x4671; clut[0x0d] = 0x4251; clut[0x0e] = 0x4E92; clut[0x0f] = 0x56D4;
+		clut[0x10] = 0x4EB4; clut[0x11] = 0x56B2; clut[0x12] = 0x5EF4; clut[0x13] = 0x56D5; clut[0x14] = 0x18E6; clut[0x15] = 0x1D06; clut[0x16] = 0x14C5; clut[0x17] = 0x6335;
+		clut[0x18] = 0x5F17; clut[0x19] = 0x6B58; clut[0x1a] = 0x7399; clut[0x1b] = 0x77BA; clut[0x1c] = 0x7FFF; clut[0x1d] = 0x0C62; clut[0x1e] = 0x7BDE; clut[0x1f] = 0x0001;
+		clut[0x20] = 0x0000; clut[0x21] = 0x0000; clut[0x22] = 0x0000; clut[0x23] = 0x0000; clut[0x24] = 0x0000; clut[0x25] = 0x0000; clut[0x26] = 0x3FE6; clut[0x27] = 0x4620;
+		clut[0x28] = 0x000B; clut[0x29] = 0x8DB0; clut[0x2a] = 0x000B; clut[0x2b] = 0x8DFC; clut[0x2c] = 0x000B; clut[0x2d] = 0xB4F4; clut[0x2e] = 0x0080; clut[0x2f] = 0x0000;
+		*/
+
+		//if (top->i_wb_dat==0x00f00104) run_enable = 0;
+
+		/*
+		//if (my_x == spr_wi || top->rootp->core_3do__DOT__madam_inst__DOT__unpacker_inst__DOT__eol) {
+		if (top->rootp->core_3do__DOT__madam_inst__DOT__unpacker_inst__DOT__eol) {
+			my_x = 0;
+			my_y++;
+		}
+		if (top->rootp->core_3do__DOT__madam_inst__DOT__unpacker_inst__DOT__pix_valid) {
+			uint16_t colour = clut[top->rootp->core_3do__DOT__madam_inst__DOT__unpacker_inst__DOT__col_out];
+			rgb[0] = (colour & 0x7C00) >> 7;
+			rgb[1] = (colour & 0x03E0) >> 2;
+			rgb[2] = (colour & 0x001F) << 3;
+			disp_ptr[ ((my_y*320) + my_x) & 0xfffff] = 0xff<<24 | rgb[2]<<16 | rgb[1]<<8 | rgb[0];	// ABGR.
+			my_x++;
+		}
+		*/
+
+		//jp_a = top->rootp->core_3do__DOT__clio_inst__DOT__field;	// Toggling "A" button, to test joypad. (works in BIOS joypad test)
+
+		//cur_pc = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__pc_from_alu;
+		//cur_pc = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_alu_main__DOT__o_pc_plus_8_ff;
+		//cur_pc = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__postalu_pc_plus_8_ff - 8;
+		cur_pc = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_writeback__DOT__i_pc_plus_8_buf_ff - 8;
+		sim_idle_step(cur_pc);
+
+		//if (top->mem_addr==0x000011664) run_enable = 0;
+
+		//if (cur_pc==0x00000ee0) run_enable=0;
+		//if (top->mem_addr==0x0000FEDC && top->o_wb_we) run_enable = 0;
+
+		/*
+		if (frame_count==30 && top->rootp->core_3do__DOT__clio_inst__DOT__hcnt==0 && top->rootp->core_3do__DOT__clio_inst__DOT__vcnt==9) {
+			run_enable = 0;
+			//inst_trace = 1;
+		}
+		*/
+
+		/*
+		if (cur_pc == 0x000117F8) {
+			inst_trace = 1;
+			//run_enable = 0;
+		}
+		*/
+
+
+		/*
+		if (inst_trace && decode_string != "IGNORE" && top->o_wb_stb && top->i_wb_ack) {
+			//fprintf(inst_file, "PC: 0x%08X   Inst: %s\n", cur_pc, decode_string);
+			fprintf(logfile, "PC: 0x%08X   Inst: %s\n", cur_pc, decode_string);
+		}
+		*/
+
+		/*
+		if (top->mem_addr == 0x03400000 && top->o_wb_we) {
+			run_enable = 0;
+			inst_trace = 1;
+		}
+		*/
+
+		if (trace) {
+			if ( (cur_pc < (old_pc-8)) || (cur_pc > (old_pc+8)) ) {
+				uint32_t arm_reg[40];
+				for (int i = 0; i < 40; i++) {
+					arm_reg[i] = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_writeback__DOT__u_zap_register_file__DOT__mem[i];
+				}
+				//fprintf(logfile, "PC: 0x%08X  Addr: 0x%08X  dat_i: 0x%08X  dat_o: 0x%08X  write: %d\n", cur_pc, top->mem_addr, top->i_wb_dat, top->o_wb_dat, top->o_wb_we);
+				sim_log(SIM_LOG_PC, SIM_LOG_MISC, main_time, cur_pc, top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__postalu_address_ff, top->i_wb_dat, top->o_wb_dat, top->o_wb_we);
+
+				//fprintf(logfile, "          PC: 0x%08X", top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_issue_main__DOT__o_pc_ff);
+				/*
+				fprintf(logfile, "          PC: 0x%08X\n", cur_pc);
+				fprintf(logfile, "          R0: 0x%08X\n", arm_reg[0]);
+				fprintf(logfile, "          R1: 0x%08X\n", arm_reg[1]);
+				fprintf(logfile, "          R2: 0x%08X\n", arm_reg[2]);
+				fprintf(logfile, "          R3: 0x%08X\n", arm_reg[3]);
+				fprintf(logfile, "          R4: 0x%08X\n", arm_reg[4]);
+				fprintf(logfile, "          R5: 0x%08X\n", arm_reg[5]);
+				fprintf(logfile, "          R6: 0x%08X\n", arm_reg[6]);
+				fprintf(logfile, "          R7: 0x%08X\n", arm_reg[7]);
+				fprintf(logfile, "          R8: 0x%08X\n", arm_reg[8]);
+				fprintf(logfile, "          R9: 0x%08X\n", arm_reg[9]);
+				fprintf(logfile, "         R10: 0x%08X\n", arm_reg[10]);
+				fprintf(logfile, "         R11: 0x%08X\n", arm_reg[11]);
+				fprintf(logfile, "         R12: 0x%08X\n", arm_reg[12]);
+				fprintf(logfile, "      SP R13: 0x%08X\n", arm_reg[13]);
+				fprintf(logfile, "      LR R14: 0x%08X\n", arm_reg[14]);
+				*/
+				old_pc = cur_pc;
+			}
+		}
+
+		//top->i_wb_ack = top->o_wb_stb;
+
+		if ( (top->o_wb_stb && top->i_wb_ack) || top->rootp->core_3do__DOT__madam_inst__DOT__dma_ack) {
+			// Handle writes to Main RAM, with byte masking...
+			if (top->rootp->core_3do__DOT__madam_inst__DOT__dram_cs && top->mem_wr) {                // 2MB masked.
+				//printf("Main RAM Write!  Addr:0x%08X  Data:0x%08X  BE:0x%01X\n", top->mem_addr&0xFFFFF, top->o_wb_dat, top->o_wb_sel);
+				sim_mem_write32_sel(ram_ptr, top->mem_addr & 0x1ffffc, top->o_wb_dat, top->o_wb_sel);	// Mask mem_addr to 2MB, ignore the lower two bits.
+			}
+
+			// Handle writes to VRAM, with byte masking...
+			if (top->rootp->core_3do__DOT__madam_inst__DOT__vram_cs && top->mem_wr) {                // 1MB masked.
+				//printf("VRAM Write!  Addr:0x%08X  Data:0x%08X  BE:0x%01X\n", top->mem_addr&0xFFFFF, top->o_wb_dat, top->o_wb_sel);
+				sim_mem_write32_sel(vram_ptr, top->mem_addr & 0xffffc, top->o_wb_dat, top->o_wb_sel);	// Mask mem_addr to 1MB, ignore the lower two bits.
+			}
+
+			// Handle writes to NVRAM...
+			if (top->mem_addr >= 0x03140000 && top->mem_addr <= 0x0315ffff && top->mem_wr) {          // 128KB Masked.
+				nvram_ptr[ (top->mem_addr>>2) & 0x1ffff] = top->o_wb_dat & 0xff;       // Only writes the lower byte from the core to 8-bit NVRAM. mem_addr is the BYTE address, so shouldn't need shifting.
+			}
+
+			/*if ((top->mem_addr == 0x03400400) && top->o_wb_we) {	// XBUS direction.
+				if (!(top->o_wb_dat & 0x800)) top->rootp->core_3do__DOT__clio_inst__DOT__expctl = top->o_wb_dat;
+			}*/
+			
+			if (top->o_wb_stb && top->i_wb_ack) sim_idle_access(top->mem_addr, top->o_wb_we);
+
+			// Handler for this address, from the page tables in sim_bus.cpp.
+			const sim_bus_entry_t* bus = sim_bus_decode(top->mem_addr, top->o_wb_we);
+
+			//if (top->mem_addr >= 0x03100000 && top->mem_addr <= 0x034FFFFF && top->mem_addr != 0x03400034) fprintf(logfile, "Addr: 0x%08X ", top->mem_addr);
+
+			// Tech manual suggests "Any write to this area will unmap the BIOS".
+			if (top->rootp->core_3do__DOT__madam_inst__DOT__dram_cs && top->o_wb_we) map_bios = 0;
+
+			// Main RAM reads. Skipped if the switch below supplies the data anyway...
+			if (!sim_bus_op_has_data(bus->op)) {
+				if (map_bios) top->i_wb_dat = sim_mem_read32(rom_ptr, top->mem_addr & 0xffffc);     // Mask mem_addr to 1MB, ignoring the lower two bits.
+				else top->i_wb_dat = sim_mem_read32(ram_ptr, top->mem_addr & 0x1ffffc);              // Mask mem_addr to 2MB, ignoring the lower two bits.
+			}
+
+			// The trace line gets its name from sim_bus_decode() again when it's formatted, so only the address goes in the record.
+			if (top->mem_addr >= 0x03100000 && top->mem_addr <= 0x034FFFFF && top->mem_addr != 0x03400034) {
+				sim_log(SIM_LOG_ACCESS, sim_log_region(top->mem_addr), main_time, cur_pc, top->mem_addr, 0, top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__postalu_address_ff, top->o_wb_we);
+			}
+
+			// Every core access that isn't handled here gets its data from the Verilog MADAM / CLIO...
+			switch (bus->op) {
+				case SIM_BUS_NONE: break;
+
+				case SIM_BUS_VRAM: top->i_wb_dat = sim_mem_read32(vram_ptr, top->mem_addr & 0xffffc); break;
+				case SIM_BUS_BIOS: top->i_wb_dat = sim_mem_read32(rom2_select ? rom2_ptr : rom_ptr, top->mem_addr & 0xffffc); break;
+				case SIM_BUS_BROOKTREE: top->i_wb_dat = 0x0000006A; break;		// Was 0xBADACCE5.
+				case SIM_BUS_NVRAM: top->i_wb_dat = nvram_ptr[ (top->mem_addr>>2) & 0x1ffff] & 0xff; break;
+				case SIM_BUS_DIAG_SEND: sim_diag_port_send(top->o_wb_dat); break;
+				case SIM_BUS_DIAG_GET: top->i_wb_dat = sim_diag_port_get(); break;
+				case SIM_BUS_ZERO: top->i_wb_dat = 0x00000000; break;
+				case SIM_BUS_BADACCE5: top->i_wb_dat = 0xBADACCE5; break;
+
+				case SIM_BUS_SVF_SOURCE: svf_set_source(); top->i_wb_dat = 0x00000000; break;
+				case SIM_BUS_SVF_COPY: svf_page_copy(); break;
+				case SIM_BUS_SVF_COLOR: svf_set_color(); break;
+				case SIM_BUS_SVF_FLASH: svf_flash_write(); break;
+
+				case SIM_BUS_MADAM_PRINT: if (sim_print_cb) sim_print_cb(top->o_wb_dat & 0xff); printf("%c", top->o_wb_dat & 0xff); break;
+
+				case SIM_BUS_CLIO_ADBIO: rom2_select = (top->o_wb_dat & 0x04); handle_adbio_write(); break;
+				case SIM_BUS_CLIO_DMACTRL: sim_clio_handle_dma(top->o_wb_dat); break;
+				case SIM_BUS_CLIO_DIPIR2: top->i_wb_dat = 0x4000; break;	// TO CHECK!!! requested by CDROMDIPIR.
+
+				// Xbus...
+				case SIM_BUS_XBUS_SEL: sim_xbus_set_sel(top->o_wb_dat & 0xff); break;
+				case SIM_BUS_XBUS_RES: top->i_wb_dat = sim_xbus_get_res(); break;
+				case SIM_BUS_XBUS_POLL_WR: sim_xbus_set_poll(top->o_wb_dat & 0xff); break;
+				case SIM_BUS_XBUS_POLL_RD: top->i_wb_dat = sim_xbus_get_poll(); break;
+				case SIM_BUS_XBUS_CMD: sim_xbus_fifo_set_cmd(top->o_wb_dat & 0xff); break;		// on FIFO Filled execute the command.
+				case SIM_BUS_XBUS_STATUS: top->i_wb_dat = sim_xbus_fifo_get_status(); break;
+				case SIM_BUS_XBUS_DATA_WR: sim_xbus_fifo_set_data(top->o_wb_dat & 0xff); break;	// on FIFO Filled execute the command.
+				case SIM_BUS_XBUS_DATA_RD: top->i_wb_dat = sim_xbus_fifo_get_data(); break;
+			}
+
+			/*
+			uint32_t zap_din = top->rootp->core_3do__DOT__zap_top_inst__DOT__i_wb_dat;
+			if ((top->mem_addr >= 0x03100000 && top->mem_addr <= 0x034fffff && top->mem_addr != 0x03400034) ) {
+				if (top->o_wb_we) fprintf(logfile, "Write: 0x%08X  (PC: 0x%08X)\n", top->o_wb_dat, cur_pc);
+				else fprintf(logfile, " Read: 0x%08X  (PC: 0x%08X)\n", zap_din, cur_pc);
+			}
+			*/
+		}
+
+		if (top->rootp->core_3do__DOT__clio_inst__DOT__vcnt == top->rootp->core_3do__DOT__clio_inst__DOT__vcnt_max && top->rootp->core_3do__DOT__clio_inst__DOT__hcnt==0) {
+			frame_count++;
+			sim_log(SIM_LOG_FRAME, SIM_LOG_MISC, main_time, cur_pc, 0, frame_count, 0, 0);
+		}
+
+		if ( (top->rootp->core_3do__DOT__clio_inst__DOT__vcnt & 0x7)==0 && top->rootp->core_3do__DOT__clio_inst__DOT__hcnt == 0) {
+		//if ( top->rootp->core_3do__DOT__clio_inst__DOT__vcnt==0 && top->rootp->core_3do__DOT__clio_inst__DOT__hcnt == 0 && top->rootp->core_3do__DOT__clio_inst__DOT__field==0) {
+			sim_process_vdl();
+			opera_process_vdl();
+		}
+		
+		//if (top->mem_addr==0x03400178 && top->o_wb_we) run_enable = 0;
+		//if (top->mem_addr== 0x03400580 && top->o_wb_we && top->o_wb_dat==0x00000010) run_enable = 0;
+		//if (cur_pc== 0x000014A8) run_enable = 0;
+
+		//if (top->mem_addr == 0x03300100 && top->o_wb_we) run_enable = 0;	// Stop on write to CEL SPRSTRT.
+
+		/*
+		if (old_fiq_n == 1 && top->rootp->core_3do__DOT__clio_inst__DOT__firq_n == 0) { // firq_n falling edge.
+			fprintf(logfile, "FIQ triggered!  (PC: 0x%08X)  irq0_pend: 0x%08X  irq1_pend: 0x%08X\n", cur_pc, top->rootp->core_3do__DOT__clio_inst__DOT__irq0_pend, top->rootp->core_3do__DOT__clio_inst__DOT__irq1_pend);
+		}
+		old_fiq_n = top->rootp->core_3do__DOT__clio_inst__DOT__firq_n;
+
+		uint32_t instruction = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_decode_main__DOT__u_zap_decode__DOT__i_instruction;
+		if ( ((instruction & 0xF000000)>>24 == 0b1111) && top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_decode_main__DOT__u_zap_decode__DOT__i_instruction_valid) {
+			fprintf(logfile, "SWI 0x%08X  (PC: 0x%08X)\n", instruction, cur_pc);
+			//run_enable = 0;
+		}
+		*/
+
+		if (sim_xbus_fiq_request) {
+			sim_xbus_fiq_request = 0;
+			top->rootp->core_3do__DOT__clio_inst__DOT__irq0_pend |= (1<<2);	// Set irq0_pend, bit 2. (XBUs IRQ).
+		}
+
+		top->sys_clk = 0;
+		top->eval();
+		sim_wave_sample(10 * main_time);
+
+		uint32_t zap_din = top->rootp->core_3do__DOT__zap_top_inst__DOT__i_wb_dat;
+		if ((top->mem_addr >= 0x03100000 && top->mem_addr <= 0x034fffff && top->mem_addr != 0x03400034) && top->o_wb_stb && top->i_wb_ack) {
+			sim_log(SIM_LOG_DATA, sim_log_region(top->mem_addr), main_time, cur_pc, top->mem_addr, top->o_wb_we ? top->o_wb_dat : zap_din, 0, top->o_wb_we);
+		}
+
+		if (top->rootp->core_3do__DOT__madam_inst__DOT__mctl & 0x8000) pbus_dma();
+
+		top->sys_clk = 1;
+		top->eval();
+		sim_wave_sample(10 * main_time + 5);
+
+		return 1;
+	}
+
+	// Stop Verilating...
+	top->final();
+	delete top;
+	exit(0);
+	return 0;
+}
+
+/*
+When reading, the states of the bits of the interrupt sources (flags) are read, by writing the bits are equal to 1
+set the corresponding bits of the interrupt flags to 1. Apparently this can be simulated
+software hardware interrupt.
+Interrupt sources with higher numbers have higher priority (implemented in software in
+interrupt handler).
+VINT0 goes every even half-frame, and VINT1 every odd one (this is the very beginning of the quenching pulse).
+bit 00 - VINT0
+bit 01 - VINT1 (VSyncTimerFirq, ControlPort, SPORTfirq, GraphicsFirq is hung here)
+bit 02 - EXINT (interrupt from devices on XBUS, i.e. for example from CDROM)
+bit 03: Timer0.15 Interrupts from timers, only possible from odd (highest in pairs)
+bit 04: Timer0.13
+bit 05: Timer0.11
+bit 06: Timer0.9
+bit 07: Timer0.7
+bit 08: Timer0.5
+bit 09: Timer0.3
+bit 10: Timer0.1
+bit 11: AudioTimer
+bit 12: AudioDMA_DSPtoRAM0
+bit 13: AudioDMA_DSPtoRAM1
+bit 14: AudioDMA_DSPtoRAM2
+bit 15: AudioDMA_DSPtoRAM3
+bit 16: AudioDMA_DSPfromRAM0
+bit 17: AudioDMA_DSPfromRAM1
+bit 18: AudioDMA_DSPfromRAM2
+bit 19: AudioDMA_DSPfromRAM3
+bit 20: AudioDMA_DSPfromRAM4
+bit 21: AudioDMA_DSPfromRAM5
+bit 22: AudioDMA_DSPfromRAM6
+bit 23: AudioDMA_DSPfromRAM7
+bit 24: AudioDMA_DSPfromRAM8
+bit 25: AudioDMA_DSPfromRAM9
+bit 26: AudioDMA_DSPfromRAM10
+bit 27: AudioDMA_DSPfromRAM11
+bit 28: AudioDMA_DSPfromRAM12
+bit 29: XBUS DMA transfer complete
+bit 30: ??? An empty handler - possibly even a watchdog (if that interrupt is enabled and re-triggered). came, and the previous one was not processed, then reset, huh?)
+bit 31 - Indicates that there are more interrupts in register 0x0340 0060
+*/
+
+// Clear all of the host-side memories, ready for a (re)boot.
+void sim_clear_memory() {
+	memset(ram_ptr, 0x00, ram_size);                // Clear Main RAM.
+	memset(vram_ptr, 0x00, vram_size);              // Clear VRAM.
+	memset(nvram_ptr, 0x00, nvram_size);            // Clear NVRAM (SRAM).
+	memset(disp_ptr, 0x44, disp_size);              // Clear the DISPLAY buffers (to grey).
+	memset(disp2_ptr, 0x44, disp2_size);
+}
+
+// Put the sim (and the Opera side) back to the state it has at power-on.
+// main_time is zeroed, so verilate() will hold reset_n low for the first 50 cycles again.
+void sim_reset() {
+	my_opera_init();
+
+	main_time = 0;
+	rom2_select = 0;        // Select the BIOS ROM at startup! (not Kanji).
+	map_bios = 1;
+	trig_irq = 0;
+	trig_fiq = 0;
+	frame_count = 0;
+	line_count = 0;
+	sim_idle_reset();
+	sim_clear_memory();
+}
+
+// Everything verilate() and the VDL / PBUS / diag port code keep between calls, besides the model and the memories.
+// Saved as one blob for sim_state.cpp. The front-end settings (trace flags, joypad, etc.) aren't in here.
+typedef struct sim_core_state_s {
+	uint64_t main_time;
+	uint32_t cur_pc;
+	uint32_t old_pc;
+	int32_t  frame_count;
+	int32_t  line_count;
+	int32_t  pix_count;
+	uint8_t  rom2_select;
+	uint8_t  map_bios;
+	uint8_t  trig_irq;
+	uint8_t  trig_fiq;
+	uint8_t  old_fiq_n;
+	uint8_t  fiq_request;		// sim_xbus_fiq_request, which verilate() hands to the core.
+	uint32_t sound_out;
+
+	uint32_t vdl_ctl, vdl_curr, vdl_prev, vdl_next;
+	uint32_t clut[256];
+	uint32_t opera_vdl_ctl, opera_vdl_curr, opera_vdl_prev, opera_vdl_next;
+	uint32_t opera_clut[256];
+	uint32_t opera_line;
+	uint32_t opera_field;
+
+	uint32_t svf_src_addr;
+	uint32_t svf_color;
+
+	uint8_t  pbus_buf[PBUS_BUF_SIZE];
+	uint32_t pbus_idx;
+
+	uint16_t diag_snd[2];
+	uint16_t diag_rcv[2];
+	uint16_t diag_get_idx;
+	uint16_t diag_send_idx;
+
+	uint32_t cdimage_sector;
+} sim_core_state_t;
+
+uint32_t sim_core_state_size() {
+	return sizeof(sim_core_state_t);
+}
+
+void sim_core_state_save(void* buf_) {
+	sim_core_state_t st;
+	memset(&st, 0, sizeof(st));
+
+	st.main_time = main_time;
+	st.cur_pc = cur_pc;
+	st.old_pc = old_pc;
+	st.frame_count = frame_count;
+	st.line_count = line_count;
+	st.pix_count = pix_count;
+	st.rom2_select = rom2_select;
+	st.map_bios = map_bios;
+	st.trig_irq = trig_irq;
+	st.trig_fiq = trig_fiq;
+	st.old_fiq_n = old_fiq_n;
+	st.fiq_request = sim_xbus_fiq_request;
+	st.sound_out = sound_out;
+
+	st.vdl_ctl = vdl_ctl;
+	st.vdl_curr = vdl_curr;
+	st.vdl_prev = vdl_prev;
+	st.vdl_next = vdl_next;
+	st.opera_vdl_ctl = opera_vdl_ctl;
+	st.opera_vdl_curr = opera_vdl_curr;
+	st.opera_vdl_prev = opera_vdl_prev;
+	st.opera_vdl_next = opera_vdl_next;
+	for (int i = 0; i < 256; i++) {
+		st.clut[i] = clut[i];
+		st.opera_clut[i] = opera_clut[i];
+	}
+	st.opera_line = opera_line;
+	st.opera_field = opera_field;
+
+	st.svf_src_addr = svf_src_addr;
+	st.svf_color = svf_color;
+
+	memcpy(st.pbus_buf, pbus_buf, PBUS_BUF_SIZE);
+	st.pbus_idx = pbus_idx;
+
+	st.diag_snd[0] = sim_SNDDebugFIFO0;
+	st.diag_snd[1] = sim_SNDDebugFIFO1;
+	st.diag_rcv[0] = sim_RCVDebugFIFO0;
+	st.diag_rcv[1] = sim_RCVDebugFIFO1;
+	st.diag_get_idx = sim_GetIdx;
+	st.diag_send_idx = sim_SendIdx;
+
+	st.cdimage_sector = CDIMAGE_SECTOR;
+
+	memcpy(buf_, &st, sizeof(st));
+}
+
+void sim_core_state_load(const void* buf_) {
+	sim_core_state_t st;
+	memcpy(&st, buf_, sizeof(st));
+
+	main_time = st.main_time;
+	cur_pc = st.cur_pc;
+	old_pc = st.old_pc;
+	frame_count = st.frame_count;
+	line_count = st.line_count;
+	pix_count = st.pix_count;
+	rom2_select = st.rom2_select;
+	map_bios = st.map_bios;
+	trig_irq = st.trig_irq;
+	trig_fiq = st.trig_fiq;
+	old_fiq_n = st.old_fiq_n;
+	sim_xbus_fiq_request = st.fiq_request;
+	sound_out = st.sound_out;
+
+	vdl_ctl = st.vdl_ctl;
+	vdl_curr = st.vdl_curr;
+	vdl_prev = st.vdl_prev;
+	vdl_next = st.vdl_next;
+	opera_vdl_ctl = st.opera_vdl_ctl;
+	opera_vdl_curr = st.opera_vdl_curr;
+	opera_vdl_prev = st.opera_vdl_prev;
+	opera_vdl_next = st.opera_vdl_next;
+	for (int i = 0; i < 256; i++) {
+		clut[i] = st.clut[i];
+		opera_clut[i] = st.opera_clut[i];
+	}
+	opera_line = st.opera_line;
+	opera_field = st.opera_field;
+
+	svf_src_addr = st.svf_src_addr;
+	svf_color = st.svf_color;
+
+	memcpy(pbus_buf, st.pbus_buf, PBUS_BUF_SIZE);
+	pbus_idx = st.pbus_idx;
+
+	sim_SNDDebugFIFO0 = st.diag_snd[0];
+	sim_SNDDebugFIFO1 = st.diag_snd[1];
+	sim_RCVDebugFIFO0 = st.diag_rcv[0];
+	sim_RCVDebugFIFO1 = st.diag_rcv[1];
+	sim_GetIdx = st.diag_get_idx;
+	sim_SendIdx = st.diag_send_idx;
+
+	CDIMAGE_SECTOR = st.cdimage_sector;
+}
+
+static int sim_load_file(const char* path_, uint8_t* dest_, unsigned int max_size_) {
+	FILE* file = fopen(path_, "rb");
+	if (file == NULL) {
+		fprintf(stderr, "Could not open %s\n", path_);
+		return -1;
+	}
+
+	fseek(file, 0L, SEEK_END);
+	file_size = ftell(file);
+	fseek(file, 0L, SEEK_SET);
+	fread(dest_, 1, (file_size < max_size_) ? file_size : max_size_, file);
+	fclose(file);
+	return 0;
+}
+
+int sim_load_bios(const char* path_) {
+	return sim_load_file(path_, rom_ptr, rom_size);     // Read the whole BIOS file into RAM.
+}
+
+int sim_load_rom2(const char* path_) {
+	return sim_load_file(path_, rom2_ptr, rom2_size);   // Kanji font ROM.
+}
+
+// The image stays mapped, since cdimage_read_sector() pulls sectors from it on demand.
+// 2048 or 2352-byte sectors, whichever the image turns out to have.
+int sim_load_iso(const char* path_) {
+	if (sim_cdimage_open(path_)) return -1;
+
+	iso_size = (unsigned int)sim_cdimage_file_size();
+	CDIMAGE_SECTOR_SIZE = sim_cdimage_sector_size();
+	return 0;
+}
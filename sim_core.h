@@ -0,0 +1,111 @@
+#ifndef SIM_CORE_H_INCLUDED
+#define SIM_CORE_H_INCLUDED
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <verilated.h>
+
+#include "Vcore_3do___024root.h"
+#include "Vcore_3do.h"
+
+// The Verilator model, and the sim time (one unit per verilate() call).
+extern Vcore_3do* top;
+extern vluint64_t main_time;
+
+// Host-side memories. All are BYTE addressed, and stored big-endian (same as the 3DO sees them).
+extern unsigned int rom_size;
+extern uint8_t* rom_ptr;
+extern unsigned int rom2_size;
+extern uint8_t* rom2_ptr;
+extern unsigned int ram_size;
+extern uint8_t* ram_ptr;
+extern unsigned int vram_size;
+extern uint8_t* vram_ptr;
+extern unsigned int nvram_size;
+extern uint8_t* nvram_ptr;
+
+// Debugger framebuffers (32-bit ABGR, 320 wide). disp_ptr is the sim, disp2_ptr is Opera.
+extern unsigned int disp_size;
+extern uint32_t* disp_ptr;
+extern unsigned int disp2_size;
+extern uint32_t* disp2_ptr;
+
+extern uint8_t* dram;	// Opera DRAM.
+extern uint8_t* vram;	// Opera VRAM.
+
+extern FILE* inst_file;
+extern FILE* soundfile;
+
+extern unsigned int iso_size;
+extern uint16_t CDIMAGE_SECTOR_SIZE;
+
+extern bool rom2_select;
+extern bool map_bios;
+extern bool trace;
+extern bool inst_trace;
+extern bool soundtrace;
+
+extern uint32_t cur_pc;
+extern int frame_count;
+extern int line_count;
+extern bool trig_irq;
+extern bool trig_fiq;
+
+extern uint32_t sound_out;
+
+extern char decode_string[65];
+extern char issue_string[65];
+extern char shifter_string[65];
+extern char alu_string[65];
+extern char memory_string[65];
+extern char rb_string[65];
+
+extern volatile uint32_t vdl_ctl;
+extern volatile uint32_t vdl_curr;
+extern volatile uint32_t vdl_prev;
+extern volatile uint32_t vdl_next;
+
+// Joypad state for pbus_dma(). The front-end sets these bits however it likes (keyboard, script, etc.)
+#define SIM_JOYPAD_DOWN   0x0001
+#define SIM_JOYPAD_UP     0x0002
+#define SIM_JOYPAD_RIGHT  0x0004
+#define SIM_JOYPAD_LEFT   0x0008
+#define SIM_JOYPAD_A      0x0010
+#define SIM_JOYPAD_B      0x0020
+#define SIM_JOYPAD_C      0x0040
+#define SIM_JOYPAD_P      0x0080
+#define SIM_JOYPAD_X      0x0100
+#define SIM_JOYPAD_RT     0x0200
+#define SIM_JOYPAD_LT     0x0400
+
+extern uint16_t sim_joypad;
+
+// Called for each character the BIOS writes to the "MADAM Print" register.
+typedef void (*sim_print_cb_t)(char c);
+extern sim_print_cb_t sim_print_cb;
+
+void my_opera_init();
+void opera_tick();
+void opera_run_field();
+void opera_swi_prof_print(FILE* file_, int max_);
+
+void sim_diag_port_init(const int32_t test_code_);
+
+int  sim_load_bios(const char* path_);
+int  sim_load_rom2(const char* path_);
+int  sim_load_iso(const char* path_);
+
+void sim_clear_memory();
+void sim_reset();
+
+// sim_core's own state, for sim_state.cpp. (main_time, VDL, PBUS, diag port, etc. Not the model or the memories)
+uint32_t sim_core_state_size();
+void sim_core_state_save(void* buf_);
+void sim_core_state_load(const void* buf_);
+
+void sim_update_decompile();
+
+int  verilate();
+
+#endif /* SIM_CORE_H_INCLUDED */
@@ -0,0 +1,313 @@
+// Fast-forward on Opera, then hand over to the model. See sim_ffwd.h. ElectronAsh.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "sim_core.h"
+#include "sim_ffwd.h"
+#include "sim_xbus.h"
+#include "sim_mem.h"
+
+// libopera includes...
+#include "opera_arm.h"
+#include "opera_clio.h"
+#include "opera_madam.h"
+#include "opera_xbus.h"
+#include "opera_xbus_cdrom_plugin.h"
+
+extern uint32_t opera_line;
+extern uint32_t opera_field;
+
+#define ZAP_WB(sig)   top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_writeback__DOT__##sig
+#define ZAP_REGS      top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_writeback__DOT__u_zap_register_file__DOT__mem
+#define SIM_MADAM(sig) top->rootp->core_3do__DOT__madam_inst__DOT__##sig
+#define SIM_DMA(sig)   top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__##sig
+#define SIM_CLIO(sig)  top->rootp->core_3do__DOT__clio_inst__DOT__##sig
+
+// Zap physical register numbers. (From zap_localparams.svh)
+#define PHY_PC        15
+#define PHY_FIQ_R8    18
+#define PHY_IRQ_R13   25
+#define PHY_SVC_R13   27
+#define PHY_UND_R13   29
+#define PHY_ABT_R13   31
+#define PHY_FIQ_SPSR  35
+#define PHY_IRQ_SPSR  36
+#define PHY_SVC_SPSR  37
+#define PHY_UND_SPSR  38
+#define PHY_ABT_SPSR  39
+
+// CPSR mode bits.
+#define ARM_USR 0x10
+#define ARM_FIQ 0x11
+#define ARM_IRQ 0x12
+#define ARM_SVC 0x13
+#define ARM_ABT 0x17
+#define ARM_UND 0x1B
+
+// Opera's SPSR[] index for each mode. (Its arm_mode_table)
+#define OPERA_SPSR_FIQ 1
+#define OPERA_SPSR_IRQ 2
+#define OPERA_SPSR_SVC 3
+#define OPERA_SPSR_ABT 4
+#define OPERA_SPSR_UND 5
+
+int sim_ffwd_parse(const char* str_, sim_ffwd_cfg_t* cfg_) {
+	const char* val = strchr(str_, ':');
+	if (val == NULL) return -1;
+
+	size_t len = val - str_;
+	if (len == 2 && !strncmp(str_, "pc", 2)) {
+		cfg_->use_pc = 1;
+		cfg_->pc = (uint32_t)strtoul(val + 1, NULL, 0);
+	}
+	else if (len == 5 && !strncmp(str_, "frame", 5)) cfg_->frames = strtol(val + 1, NULL, 0);
+	else return -1;
+	return 0;
+}
+
+// Opera keeps the current mode's registers in USER[], and parks whatever they replaced in CASH[] (user r8-r14)
+// or the mode's own bank. The Zap register file has a fixed slot for every banked register instead.
+static void sim_ffwd_arm() {
+	opera_arm_flags_sync();		// Opera only works out NZCV when something needs them.
+	uint32_t mode = CPU.CPSR & 0x1F;
+
+	for (int i = 0; i < 8; i++) ZAP_REGS[i] = CPU.USER[i];
+	for (int i = 8; i < 13; i++) ZAP_REGS[i] = (mode == ARM_FIQ) ? CPU.CASH[i - 8] : CPU.USER[i];
+	for (int i = 13; i < 15; i++) ZAP_REGS[i] = (mode == ARM_USR) ? CPU.USER[i] : CPU.CASH[i - 8];
+
+	for (int i = 0; i < 7; i++) ZAP_REGS[PHY_FIQ_R8 + i] = (mode == ARM_FIQ) ? CPU.USER[8 + i] : CPU.FIQ[i];
+	for (int i = 0; i < 2; i++) {
+		ZAP_REGS[PHY_IRQ_R13 + i] = (mode == ARM_IRQ) ? CPU.USER[13 + i] : CPU.IRQ[i];
+		ZAP_REGS[PHY_SVC_R13 + i] = (mode == ARM_SVC) ? CPU.USER[13 + i] : CPU.SVC[i];
+		ZAP_REGS[PHY_UND_R13 + i] = (mode == ARM_UND) ? CPU.USER[13 + i] : CPU.UND[i];
+		ZAP_REGS[PHY_ABT_R13 + i] = (mode == ARM_ABT) ? CPU.USER[13 + i] : CPU.ABT[i];
+	}
+
+	ZAP_REGS[PHY_FIQ_SPSR] = CPU.SPSR[OPERA_SPSR_FIQ];
+	ZAP_REGS[PHY_IRQ_SPSR] = CPU.SPSR[OPERA_SPSR_IRQ];
+	ZAP_REGS[PHY_SVC_SPSR] = CPU.SPSR[OPERA_SPSR_SVC];
+	ZAP_REGS[PHY_UND_SPSR] = CPU.SPSR[OPERA_SPSR_UND];
+	ZAP_REGS[PHY_ABT_SPSR] = CPU.SPSR[OPERA_SPSR_ABT];
+
+	// USER[15] is the next instruction. pc_ff bit 32 is the fetch valid, same as the reset value.
+	ZAP_REGS[PHY_PC] = CPU.USER[15];
+	ZAP_WB(pc_ff) = (1ULL << 32) | CPU.USER[15];
+	ZAP_WB(cpsr_ff) = CPU.CPSR;
+
+	cur_pc = CPU.USER[15];
+}
+
+// Opera keeps RAM as host-order words. The sim memories are big-endian bytes.
+static void sim_ffwd_memory() {
+	for (uint32_t i = 0; i < ram_size; i += 4) sim_mem_write32(ram_ptr, i, opera_mem_read32(i));
+	uint32_t vram_base = (uint32_t)opera_arm_ram_size();	// Opera's VRAM follows its DRAM.
+	for (uint32_t i = 0; i < vram_size; i += 4) sim_mem_write32(vram_ptr, i, opera_mem_read32(vram_base + i));
+
+	// One byte per word on both sides. Opera only has the first 32KB of it.
+	uint32_t nvram_len = (uint32_t)opera_arm_nvram_size();
+	memcpy(nvram_ptr, opera_arm_nvram_get(), (nvram_len < nvram_size) ? nvram_len : nvram_size);
+
+	map_bios = 0;
+	SIM_MADAM(map_bios) = 0;
+}
+
+#define SIM_FFWD_DMA(n) \
+	SIM_DMA(dma##n##_curaddr)  = regs[0x400 + n * 16 + 0x0] & 0x3FFFFF; \
+	SIM_DMA(dma##n##_curlen)   = regs[0x400 + n * 16 + 0x4] & 0x3FFFFF; \
+	SIM_DMA(dma##n##_nextaddr) = regs[0x400 + n * 16 + 0x8] & 0x3FFFFF; \
+	SIM_DMA(dma##n##_nextlen)  = regs[0x400 + n * 16 + 0xC] & 0x3FFFFF;
+
+static void sim_ffwd_madam() {
+	const uint32_t* regs = opera_madam_registers();
+
+	SIM_MADAM(mctl)      = regs[0x008];
+	SIM_MADAM(sltime)    = regs[0x00C];
+	SIM_MADAM(abortbits) = regs[0x020];
+	SIM_MADAM(privbits)  = regs[0x024];
+	SIM_MADAM(statbits)  = opera_madam_peek(0x028);		// Opera makes this one up from the CEL engine state.
+	SIM_MADAM(msb_check) = regs[0x02C];
+	SIM_MADAM(diag)      = regs[0x040];
+
+	SIM_MADAM(ccobctl0) = regs[0x110];
+	SIM_MADAM(ppmpc)    = regs[0x120];
+	SIM_MADAM(regctl0)  = regs[0x130];
+	SIM_MADAM(regctl1)  = regs[0x134];
+	SIM_MADAM(regctl2)  = regs[0x138];
+	SIM_MADAM(regctl3)  = regs[0x13C];
+	SIM_MADAM(xyposh)   = regs[0x140];
+	SIM_MADAM(xyposl)   = regs[0x144];
+	SIM_MADAM(linedxyh) = regs[0x148];
+	SIM_MADAM(linedxyl) = regs[0x14C];
+	SIM_MADAM(dxyh)     = regs[0x150];
+	SIM_MADAM(dxyl)     = regs[0x154];
+	SIM_MADAM(ddxyh)    = regs[0x158];
+	SIM_MADAM(ddxyl)    = regs[0x15C];
+
+	SIM_MADAM(fence_0l) = regs[0x230];
+	SIM_MADAM(fence_0r) = regs[0x234];
+	SIM_MADAM(fence_1l) = regs[0x238];
+	SIM_MADAM(fence_1r) = regs[0x23C];
+	SIM_MADAM(fence_2l) = regs[0x270];
+	SIM_MADAM(fence_2r) = regs[0x274];
+	SIM_MADAM(fence_3l) = regs[0x278];
+	SIM_MADAM(fence_3r) = regs[0x27C];
+
+	SIM_MADAM(currentccb) = regs[0x5A0];
+	SIM_MADAM(nextccb)    = regs[0x5A4];
+
+	// The DMA stack. Four regs per channel: current address / length, next address / length.
+	SIM_FFWD_DMA(0)  SIM_FFWD_DMA(1)  SIM_FFWD_DMA(2)  SIM_FFWD_DMA(3)
+	SIM_FFWD_DMA(4)  SIM_FFWD_DMA(5)  SIM_FFWD_DMA(6)  SIM_FFWD_DMA(7)
+	SIM_FFWD_DMA(8)  SIM_FFWD_DMA(9)  SIM_FFWD_DMA(10) SIM_FFWD_DMA(11)
+	SIM_FFWD_DMA(12) SIM_FFWD_DMA(13) SIM_FFWD_DMA(14) SIM_FFWD_DMA(15)
+	SIM_FFWD_DMA(16) SIM_FFWD_DMA(17) SIM_FFWD_DMA(18) SIM_FFWD_DMA(19)
+	SIM_FFWD_DMA(20) SIM_FFWD_DMA(21) SIM_FFWD_DMA(22) SIM_FFWD_DMA(23)
+	SIM_FFWD_DMA(24) SIM_FFWD_DMA(25) SIM_FFWD_DMA(26) SIM_FFWD_DMA(27)
+	SIM_FFWD_DMA(28) SIM_FFWD_DMA(29) SIM_FFWD_DMA(30) SIM_FFWD_DMA(31)
+}
+
+// tmr_cnt_prev too, or the timer would see a wrap that never happened.
+#define SIM_FFWD_TIMER(n) \
+	SIM_CLIO(tmr##n##_inst__DOT__tmr_cnt)      = regs[0x100 + n * 8] & 0xFFFF; \
+	SIM_CLIO(tmr##n##_inst__DOT__tmr_cnt_prev) = regs[0x100 + n * 8] & 0xFFFF; \
+	SIM_CLIO(tmr##n##_inst__DOT__tmr_bkp)      = regs[0x104 + n * 8] & 0xFFFF;
+
+static void sim_ffwd_clio() {
+	const uint32_t* regs = opera_clio_registers();
+
+	SIM_CLIO(csysbits)  = regs[0x04];
+	SIM_CLIO(vint0)     = regs[0x08];
+	SIM_CLIO(vint1)     = regs[0x0C];
+	SIM_CLIO(audin)     = regs[0x20];
+	SIM_CLIO(audout)    = regs[0x24];
+	SIM_CLIO(cstatbits) = regs[0x28];
+	SIM_CLIO(wdog)      = regs[0x2C];
+	SIM_CLIO(seed)      = regs[0x38];
+
+	// Set / clear pairs. Opera keeps the value at the "set" address.
+	SIM_CLIO(irq0_pend)   = regs[0x40];
+	SIM_CLIO(irq0_enable) = regs[0x48];
+	SIM_CLIO(mode)        = regs[0x50];
+	SIM_CLIO(irq1_pend)   = regs[0x60];
+	SIM_CLIO(irq1_enable) = regs[0x68];
+	SIM_CLIO(tmr_ctrl_l)  = regs[0x200];
+	SIM_CLIO(tmr_ctrl_u)  = regs[0x208];
+	SIM_CLIO(dmactrl)     = regs[0x304];
+
+	SIM_CLIO(badbits) = regs[0x58];
+	SIM_CLIO(spare)   = regs[0x5C];
+	SIM_CLIO(hdelay)  = regs[0x80];
+	SIM_CLIO(adbctl)  = regs[0x88];
+	SIM_CLIO(slack)   = regs[0x220];
+	SIM_CLIO(type0_4) = regs[0x408];
+	SIM_CLIO(dipir1)  = regs[0x410];
+	SIM_CLIO(dipir2)  = regs[0x414];
+
+	SIM_CLIO(sema)          = regs[0x17D0];
+	SIM_CLIO(semaack)       = regs[0x17D4];
+	SIM_CLIO(dspdma)        = regs[0x17E0];
+	SIM_CLIO(dspppc)        = regs[0x17F4];
+	SIM_CLIO(dsppnr)        = regs[0x17F8];
+	SIM_CLIO(dsppgw)        = regs[0x17FC];
+	SIM_CLIO(dsppclkreload) = regs[0x39DC];
+	SIM_CLIO(uncle_addr)    = regs[0xC008];
+	SIM_CLIO(uncle_rom)     = regs[0xC00C];
+
+	SIM_FFWD_TIMER(0)  SIM_FFWD_TIMER(1)  SIM_FFWD_TIMER(2)  SIM_FFWD_TIMER(3)
+	SIM_FFWD_TIMER(4)  SIM_FFWD_TIMER(5)  SIM_FFWD_TIMER(6)  SIM_FFWD_TIMER(7)
+	SIM_FFWD_TIMER(8)  SIM_FFWD_TIMER(9)  SIM_FFWD_TIMER(10) SIM_FFWD_TIMER(11)
+	SIM_FFWD_TIMER(12) SIM_FFWD_TIMER(13) SIM_FFWD_TIMER(14) SIM_FFWD_TIMER(15)
+
+	// Start of Opera's current line.
+	SIM_CLIO(hcnt) = 0;
+	SIM_CLIO(vcnt) = opera_line;
+	SIM_CLIO(field) = opera_field;
+
+	rom2_select = (regs[0x84] & 0x04);
+}
+
+// Both XBUS copies came from the same code, so the state blobs match.
+static int sim_ffwd_xbus() {
+	uint32_t size = opera_xbus_state_size();
+	if (size != sim_xbus_state_size()) {
+		fprintf(stderr, "Fast-forward: Opera and sim_xbus have different XBUS devices attached\n");
+		return -1;
+	}
+
+	std::vector<uint8_t> buf(size);
+	opera_xbus_state_save(buf.data());
+	sim_xbus_state_load(buf.data());
+	return 0;
+}
+
+int sim_ffwd_run(const sim_ffwd_cfg_t* cfg_) {
+	if (main_time != 0) {
+		fprintf(stderr, "Fast-forward only works from power-on. (main_time is %llu)\n", (unsigned long long)main_time);
+		return -1;
+	}
+
+	// Opera already has the sim's ROMs (my_opera_init()). It gets its own XBUS, with the same CD drive on it.
+	opera_xbus_init(xbus_cdrom_plugin);
+	opera_xbus_device_load(0, NULL);
+
+	int max_frames = cfg_->frames ? cfg_->frames : SIM_FFWD_MAX_FRAMES;
+	int frames = 0;
+	uint32_t last_field = opera_field;
+
+	// The JIT runs whole blocks per tick, so it has to be told where to stop as well.
+	if (cfg_->use_pc) opera_arm_jit_break(cfg_->pc);
+
+	while (1) {
+		if (cfg_->use_pc && CPU.USER[15] == cfg_->pc) break;
+		if (frames >= max_frames) {
+			if (cfg_->use_pc && !cfg_->frames) {
+				fprintf(stderr, "Fast-forward: no PC 0x%08X after %d frames\n", cfg_->pc, frames);
+				opera_arm_jit_break(0xFFFFFFFF);
+				return -1;
+			}
+			break;
+		}
+
+		// Nothing to stop for in the middle of a field without a PC, so a whole one at a time.
+		if (!cfg_->use_pc) {
+			opera_run_field();
+			last_field = opera_field;
+			frames++;
+			continue;
+		}
+
+		opera_tick();
+
+		if (opera_field != last_field) {
+			last_field = opera_field;
+			frames++;
+		}
+	}
+
+	opera_arm_jit_break(0xFFFFFFFF);
+
+	// The model has no way to pick up a CEL list halfway through.
+	if (opera_madam_fsm_get() == FSM_INPROCESS) {
+		opera_madam_cel_handle();
+		opera_madam_fsm_set(FSM_IDLE);
+	}
+
+	// Reset as usual. Everything gets copied in just before the first clock with reset_n high.
+	while (main_time < 50) {
+		verilate();
+		main_time++;
+	}
+	top->reset_n = 1;
+
+	sim_ffwd_arm();
+	sim_ffwd_memory();
+	sim_ffwd_madam();
+	sim_ffwd_clio();
+	if (sim_ffwd_xbus()) return -1;
+
+	frame_count = frames;
+	return 0;
+}
@@ -0,0 +1,36 @@
+#ifndef SIM_FFWD_H_INCLUDED
+#define SIM_FFWD_H_INCLUDED
+
+// Fast-forward. Boots on Opera (libopera's interpreter, or its JIT with --jit, thousands of times quicker than the Zap core), up to a PC or
+// a frame, then copies Opera's state into the model and lets the sim carry on cycle-accurately from there.
+//
+// What gets carried over:
+//   ARM     All the banked registers, CPSR and the SPSRs, into the Zap register file. The PC goes in as if the core
+//           had just come out of reset at that address, so the pipeline starts empty.
+//   Memory  DRAM, VRAM and NVRAM.
+//   MADAM   The CPU-visible registers, and the whole DMA stack (0x400 - 0x5FC).
+//   CLIO    Interrupt pending / enable, mode, VINTs, the timers (count, backup, control), DSP control, Uncle, etc.
+//           hcnt / vcnt / field come from Opera's line counter, so video timing lines up to within a line.
+//   XBUS    sim_xbus (and the CD drive behind it) take over from Opera's XBUS.
+//
+// Not carried over: DSP internals (Opera's DSP keeps its own program / data memory), the matrix engine registers
+// (written before every use anyway), and anything in flight inside the CEL engine. (Opera finishes its CEL list first)
+//
+#include <stdint.h>
+
+#define SIM_FFWD_MAX_FRAMES 36000		// Give up on a PC that never turns up after this many frames. (10 minutes)
+
+typedef struct sim_ffwd_cfg_t {
+	bool     use_pc;
+	uint32_t pc;			// Stop just before Opera executes this.
+	int      frames;		// Or stop after this many frames (frame_count). Whichever comes first.
+} sim_ffwd_cfg_t;
+
+// "pc:<addr>" or "frame:<n>", same as the --wave-start triggers.
+int sim_ffwd_parse(const char* str_, sim_ffwd_cfg_t* cfg_);
+
+// Only from power-on (main_time 0), after my_opera_init(). Runs the model through reset, then hands over.
+// main_time ends up just past reset, and frame_count at the frames Opera ran, so the caller's loop just carries on.
+int sim_ffwd_run(const sim_ffwd_cfg_t* cfg_);
+
+#endif /* SIM_FFWD_H_INCLUDED */
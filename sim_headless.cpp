@@ -0,0 +1,284 @@
+// Headless batch runner for the 3DO Verilator sim.
+//
+// Same model and bus glue as the ImGui debugger (see sim_core.cpp), but with no window, no D3D, and no
+// 2048-steps-per-UI-frame cap. verilate() just runs in a tight loop until the cycle or frame limit is hit,
+// then whichever outputs were asked for on the command line get written.
+//
+// Example:
+//   sim_3do_headless --bios panafz10.bin --iso 3DentrO.iso --frames 30 --screenshot frame30.ppm
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "sim_core.h"
+#include "sim_bus.h"
+#include "sim_log.h"
+#include "sim_wave.h"
+#include "sim_cdimage.h"
+#include "sim_chd.h"
+#include "sim_state.h"
+#include "sim_ffwd.h"
+#include "sim_idle.h"
+
+// libopera includes...
+#include "opera_arm.h"
+#include "opera_diag_port.h"
+#include "opera_log.h"
+
+static void usage(const char* prog_) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  --bios <file>        BIOS ROM image (default: panafz10.bin)\n"
+		"  --rom2 <file>        Kanji font ROM image (default: panafz1-kanji.bin)\n"
+		"  --iso <file>         CD image (.iso / .bin with 2048 or 2352-byte sectors, or .chd)\n"
+		"  --cycles <n>         Stop after n sim cycles\n"
+		"  --frames <n>         Stop after n frames (frame_count)\n"
+		"  --load-state <file>  Carry on from a save state (--cycles / --frames still count from power-on)\n"
+		"  --save-state <file>  Write a save state at the end of the run\n"
+		"  --ffwd <trig>        Boot on Opera up to pc:<addr> or frame:<n>, then hand over to the sim\n"
+		"  --jit                Run Opera's ARM through its x86-64 JIT (quicker --ffwd)\n"
+		"  --idle-skip          Let Opera skip ARM polling loops up to the next line / timer / DSP event\n"
+		"  --swi-hle            Run Opera's operamath SWIs on the host instead of through the folio\n"
+		"  --swi-prof           Print Opera's per-SWI call counts and cycle histograms at the end\n"
+		"  --diag <code>        Diag port test code (default: -1, normal boot)\n"
+		"  --log <file>         Write the bus trace (sim_trace.txt format)\n"
+		"  --binlog <file>      Write the bus trace as binary records (see sim_log_decode)\n"
+		"  --logmask <list>     Regions to trace: madam,clio,xbus,svf,diag,slow,misc,all (default: all)\n"
+		"  --opera-log <file>   Write Opera's trace (opera_trace.txt format), for the same --logmask regions\n"
+		"  --wave <file>        Write a waveform (FST or VCD, depending on how the model was Verilated)\n"
+		"  --wave-start <trig>  Start the waveform at cycle:<n>, pc:<addr> or frame:<n> (default: cycle 0)\n"
+		"  --wave-stop <trig>   Stop the waveform at cycle:<n>, pc:<addr> or frame:<n> (default: end of run)\n"
+		"  --wave-scope <list>  Only dump these scopes under core_3do, eg. madam_inst,zap_top_inst.u_zap_core\n"
+		"  --wave-depth <n>     Levels to dump below each scope (default: all)\n"
+		"  --sound <file>       Write the Opera DSP output\n"
+		"  --ramdump <file>     Dump main RAM at the end of the run\n"
+		"  --vramdump <file>    Dump VRAM at the end of the run\n"
+		"  --nvramdump <file>   Dump NVRAM at the end of the run\n"
+		"  --screenshot <file>  Write the sim display as a PPM at the end of the run\n"
+		"  --quiet              Don't print the run summary\n",
+		prog_);
+}
+
+static int dump_file(const char* path_, const void* data_, size_t size_) {
+	FILE* file = fopen(path_, "wb");
+	if (file == NULL) {
+		fprintf(stderr, "Could not create %s\n", path_);
+		return -1;
+	}
+	fwrite(data_, 1, size_, file);
+	fclose(file);
+	return 0;
+}
+
+// disp_ptr is 32-bit ABGR, 320 wide. 263 lines is what the debugger window shows.
+static int dump_screenshot(const char* path_) {
+	const int width = 320;
+	const int height = 263;
+
+	FILE* file = fopen(path_, "wb");
+	if (file == NULL) {
+		fprintf(stderr, "Could not create %s\n", path_);
+		return -1;
+	}
+
+	fprintf(file, "P6\n%d %d\n255\n", width, height);
+	for (int i = 0; i < width * height; i++) {
+		uint32_t pixel = disp_ptr[i];
+		fputc((pixel >> 0) & 0xff, file);
+		fputc((pixel >> 8) & 0xff, file);
+		fputc((pixel >> 16) & 0xff, file);
+	}
+	fclose(file);
+	return 0;
+}
+
+int main(int argc, char** argv, char** env) {
+	const char* bios_path = "panafz10.bin";
+	const char* rom2_path = "panafz1-kanji.bin";
+	const char* iso_path = NULL;
+	const char* log_path = NULL;
+	const char* binlog_path = NULL;
+	const char* opera_log_path = NULL;
+	const char* sound_path = NULL;
+	const char* ramdump_path = NULL;
+	const char* vramdump_path = NULL;
+	const char* nvramdump_path = NULL;
+	const char* screenshot_path = NULL;
+	const char* load_state_path = NULL;
+	const char* save_state_path = NULL;
+	sim_ffwd_cfg_t ffwd = { 0, 0, 0 };
+	bool use_ffwd = 0;
+	uint32_t log_mask = SIM_LOG_MASK_ALL;
+	sim_wave_cfg_t wave = { NULL, { SIM_WAVE_TRIG_NONE, 0 }, { SIM_WAVE_TRIG_NONE, 0 }, NULL, 0 };
+	uint64_t max_cycles = 0;
+	int max_frames = 0;
+	int diag_code = -1;
+	bool quiet = 0;
+	bool use_jit = 0;
+	bool use_idle_skip = 0;
+	bool use_swi_hle = 0;
+	bool use_swi_prof = 0;
+
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		const char* val = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+		if (arg[0] == '+') continue;	// Verilator plusargs.
+
+		if (!strcmp(arg, "--quiet")) { quiet = 1; continue; }
+		if (!strcmp(arg, "--jit")) { use_jit = 1; continue; }
+		if (!strcmp(arg, "--idle-skip")) { use_idle_skip = 1; continue; }
+		if (!strcmp(arg, "--swi-hle")) { use_swi_hle = 1; continue; }
+		if (!strcmp(arg, "--swi-prof")) { use_swi_prof = 1; continue; }
+		if (!strcmp(arg, "--help") || !strcmp(arg, "-h")) { usage(argv[0]); return 0; }
+
+		if (val == NULL) { usage(argv[0]); return 1; }
+
+		if (!strcmp(arg, "--bios")) bios_path = val;
+		else if (!strcmp(arg, "--rom2")) rom2_path = val;
+		else if (!strcmp(arg, "--iso")) iso_path = val;
+		else if (!strcmp(arg, "--cycles")) max_cycles = strtoull(val, NULL, 0);
+		else if (!strcmp(arg, "--frames")) max_frames = strtol(val, NULL, 0);
+		else if (!strcmp(arg, "--load-state")) load_state_path = val;
+		else if (!strcmp(arg, "--save-state")) save_state_path = val;
+		else if (!strcmp(arg, "--ffwd")) { if (sim_ffwd_parse(val, &ffwd)) { fprintf(stderr, "Bad --ffwd: %s\n", val); return 1; } use_ffwd = 1; }
+		else if (!strcmp(arg, "--diag")) diag_code = strtol(val, NULL, 0);
+		else if (!strcmp(arg, "--log")) log_path = val;
+		else if (!strcmp(arg, "--binlog")) binlog_path = val;
+		else if (!strcmp(arg, "--opera-log")) opera_log_path = val;
+		else if (!strcmp(arg, "--logmask")) { if (sim_log_parse_mask(val, &log_mask)) { fprintf(stderr, "Bad --logmask: %s\n", val); return 1; } }
+		else if (!strcmp(arg, "--wave")) wave.path = val;
+		else if (!strcmp(arg, "--wave-start")) { if (sim_wave_parse_trig(val, &wave.start)) { fprintf(stderr, "Bad --wave-start: %s\n", val); return 1; } }
+		else if (!strcmp(arg, "--wave-stop")) { if (sim_wave_parse_trig(val, &wave.stop)) { fprintf(stderr, "Bad --wave-stop: %s\n", val); return 1; } }
+		else if (!strcmp(arg, "--wave-scope")) wave.scopes = val;
+		else if (!strcmp(arg, "--wave-depth")) wave.depth = strtol(val, NULL, 0);
+		else if (!strcmp(arg, "--sound")) sound_path = val;
+		else if (!strcmp(arg, "--ramdump")) ramdump_path = val;
+		else if (!strcmp(arg, "--vramdump")) vramdump_path = val;
+		else if (!strcmp(arg, "--nvramdump")) nvramdump_path = val;
+		else if (!strcmp(arg, "--screenshot")) screenshot_path = val;
+		else { usage(argv[0]); return 1; }
+		i++;
+	}
+
+	if (max_cycles == 0 && max_frames == 0) {
+		fprintf(stderr, "Need --cycles and/or --frames, or the run would never end.\n");
+		return 1;
+	}
+
+	Verilated::commandArgs(argc, argv);
+
+	sim_clear_memory();
+	sim_bus_init();
+
+	if (sim_load_bios(bios_path)) return 1;
+	if (sim_load_rom2(rom2_path)) return 1;
+	if (iso_path && sim_load_iso(iso_path)) return 1;
+
+	if (log_path && binlog_path) {
+		fprintf(stderr, "Only one of --log and --binlog, please.\n");
+		return 1;
+	}
+
+	// With neither, nothing gets recorded at all. Opera only traces with --opera-log.
+	sim_log_set_mask(log_mask);
+
+	if (log_path && sim_log_open_text(log_path)) return 1;
+	if (binlog_path && sim_log_open_binary(binlog_path)) return 1;
+	if (opera_log_path && opera_log_open(opera_log_path, log_mask)) { fprintf(stderr, "Could not create %s\n", opera_log_path); return 1; }
+
+	if (wave.path && sim_wave_open(&wave)) return 1;
+
+	if (sound_path) {
+		soundfile = fopen(sound_path, "wb");
+		if (soundfile == NULL) { fprintf(stderr, "Could not create %s\n", sound_path); return 1; }
+		soundtrace = 1;
+	}
+
+	my_opera_init();
+
+	sim_diag_port_init(diag_code);
+	opera_diag_port_init(diag_code);
+
+	if (load_state_path && use_ffwd) {
+		fprintf(stderr, "Only one of --load-state and --ffwd, please.\n");
+		return 1;
+	}
+
+	if (use_jit && !opera_arm_jit_set(1)) {
+		fprintf(stderr, "No Opera JIT on this platform (x86-64 only).\n");
+		return 1;
+	}
+
+	if (use_idle_skip) opera_arm_idle_set(1);
+	if (use_swi_hle) opera_arm_swi_hle_set(1);
+	if (use_swi_prof) opera_arm_swi_prof_set(1);
+
+	if (use_ffwd) {
+		auto ffwd_start = std::chrono::steady_clock::now();
+		if (sim_ffwd_run(&ffwd)) return 1;
+		if (!quiet) fprintf(stderr, "Fast-forwarded to PC 0x%08X, frame %d in %.3f s\n", cur_pc, frame_count,
+			std::chrono::duration<double>(std::chrono::steady_clock::now() - ffwd_start).count());
+	}
+
+	// After all the init, since that would undo half of it.
+	if (load_state_path) {
+		auto load_start = std::chrono::steady_clock::now();
+		if (sim_state_load(load_state_path)) return 1;
+		if (!quiet) fprintf(stderr, "Loaded %s at cycle %llu in %.1f ms\n", load_state_path, (unsigned long long)main_time,
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start).count());
+	}
+
+	uint64_t start_time = main_time;
+	auto start = std::chrono::steady_clock::now();
+
+	while (1) {
+		verilate();
+		main_time++;
+
+		if (max_cycles && main_time >= max_cycles) break;
+		if (max_frames && frame_count >= max_frames) break;
+	}
+
+	auto stop = std::chrono::steady_clock::now();
+	double secs = std::chrono::duration<double>(stop - start).count();
+
+	int ret = 0;
+	if (ramdump_path && dump_file(ramdump_path, ram_ptr, ram_size)) ret = 1;
+	if (vramdump_path && dump_file(vramdump_path, vram_ptr, vram_size)) ret = 1;
+	if (nvramdump_path && dump_file(nvramdump_path, nvram_ptr, nvram_size)) ret = 1;
+	if (screenshot_path && dump_screenshot(screenshot_path)) ret = 1;
+	if (save_state_path && sim_state_save(save_state_path)) ret = 1;
+
+	if (!quiet) {
+		fprintf(stderr, "cycles: %llu  frames: %d  PC: 0x%08X  time: %.3f s  (%.0f cycles/s)\n",
+			(unsigned long long)main_time, frame_count, cur_pc, secs, (secs > 0.0) ? (double)(main_time - start_time) / secs : 0.0);
+
+		// The Zap core can't skip them, but it's worth knowing how much of the run went on polling.
+		sim_idle_stats_t idle;
+		sim_idle_get_stats(&idle);
+		if (idle.cycles) fprintf(stderr, "idle: %llu cycles (%.1f%%) in %llu polling loops\n", (unsigned long long)idle.cycles,
+			(main_time > start_time) ? 100.0 * (double)idle.cycles / (double)(main_time - start_time) : 0.0, (unsigned long long)idle.loops);
+
+		if (use_swi_prof) opera_swi_prof_print(stderr, 32);
+
+		const char* format = sim_cdimage_format();
+		if (format && !strcmp(format, "chd")) {
+			sim_chd_stats_t chd;
+			sim_chd_get_stats(&chd);
+			fprintf(stderr, "chd: hits: %llu  misses: %llu  prefetched: %llu  errors: %llu\n",
+				(unsigned long long)chd.hits, (unsigned long long)chd.misses, (unsigned long long)chd.prefetched, (unsigned long long)chd.errors);
+		}
+	}
+
+	sim_log_close();
+	sim_wave_close();
+	if (soundfile) fclose(soundfile);
+
+	top->final();
+	delete top;
+
+	return ret;
+}
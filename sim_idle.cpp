@@ -0,0 +1,108 @@
+// Idle-loop meter for the Zap core. See sim_idle.h. ElectronAsh.
+//
+#include <stdio.h>
+#include <string.h>
+
+#include "sim_core.h"
+#include "sim_idle.h"
+
+#define SIM_IDLE_NONE      0xFFFFFFFF
+#define SIM_IDLE_MAX_LEN   32			// Loop body, in bytes. Polling loops are a handful of instructions.
+#define SIM_IDLE_MAX_FAILS 4			// Trips that changed something, before a loop gets written off as busy (a delay loop, etc.)
+#define SIM_IDLE_REGS      40			// All of the Zap register file, banked ones included. (same as the trace in verilate())
+
+static uint32_t sim_idle_head = SIM_IDLE_NONE;
+static uint32_t sim_idle_tail = SIM_IDLE_NONE;
+static uint32_t sim_idle_busy = SIM_IDLE_NONE;
+static uint32_t sim_idle_last_pc = SIM_IDLE_NONE;
+static uint64_t sim_idle_trip_start = 0;
+static bool sim_idle_impure = 0;
+static bool sim_idle_idle = 0;
+static int sim_idle_fails = 0;
+static uint32_t sim_idle_regs[SIM_IDLE_REGS];
+static sim_idle_stats_t sim_idle_stats;
+
+static uint32_t sim_idle_reg(int i_) {
+	return top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_writeback__DOT__u_zap_register_file__DOT__mem[i_];
+}
+
+// Reads that can't change anything. DRAM, VRAM, ROM, and CLIO below the expansion bus / DSP (0x500 up).
+static bool sim_idle_pure_read(uint32_t addr_) {
+	if (addr_ < 0x00300000) return 1;
+	if ((addr_ & ~0xFFFFF) == 0x03000000) return 1;
+	if (addr_ >= 0x03400000 && addr_ < 0x03400500) return 1;
+	return 0;
+}
+
+static void sim_idle_snap() {
+	for (int i = 0; i < SIM_IDLE_REGS; i++) sim_idle_regs[i] = sim_idle_reg(i);
+	sim_idle_trip_start = main_time;
+	sim_idle_impure = 0;
+}
+
+static void sim_idle_forget() {
+	sim_idle_head = SIM_IDLE_NONE;
+	sim_idle_tail = SIM_IDLE_NONE;
+	sim_idle_idle = 0;
+	sim_idle_fails = 0;
+}
+
+// Back at the head. The trip counts if it only read, and left every register as it found it.
+static void sim_idle_pass() {
+	bool same = !sim_idle_impure;
+	for (int i = 0; same && i < SIM_IDLE_REGS; i++) same = (sim_idle_reg(i) == sim_idle_regs[i]);
+
+	if (same) {
+		if (!sim_idle_idle) sim_idle_stats.loops++;
+		sim_idle_idle = 1;
+		sim_idle_stats.cycles += main_time - sim_idle_trip_start;
+	}
+	else {
+		sim_idle_idle = 0;
+		if (++sim_idle_fails > SIM_IDLE_MAX_FAILS) {
+			sim_idle_busy = sim_idle_head;
+			sim_idle_forget();
+			return;
+		}
+	}
+	sim_idle_snap();
+}
+
+void sim_idle_reset() {
+	sim_idle_forget();
+	sim_idle_busy = SIM_IDLE_NONE;
+	sim_idle_last_pc = SIM_IDLE_NONE;
+	memset(&sim_idle_stats, 0, sizeof(sim_idle_stats));
+}
+
+// Once per verilate(), with cur_pc. It only moves when an instruction gets to writeback.
+void sim_idle_step(uint32_t pc_) {
+	if (pc_ == sim_idle_last_pc) return;
+	uint32_t from = sim_idle_last_pc;
+	sim_idle_last_pc = pc_;
+
+	if (sim_idle_head != SIM_IDLE_NONE) {
+		if (pc_ < sim_idle_head || pc_ > sim_idle_tail) sim_idle_forget();	// Fell out of it, or an interrupt.
+		else {
+			if (pc_ == sim_idle_head && from > pc_) sim_idle_pass();
+			return;
+		}
+	}
+
+	// A short backward branch. Watch it, unless it's the one that was just written off.
+	if (pc_ < from && from - pc_ <= SIM_IDLE_MAX_LEN && pc_ != sim_idle_busy) {
+		sim_idle_head = pc_;
+		sim_idle_tail = from;
+		sim_idle_snap();
+	}
+}
+
+// Every core access on the bus (not DMA). Only matters while a loop is being watched.
+void sim_idle_access(uint32_t addr_, bool write_) {
+	if (sim_idle_head == SIM_IDLE_NONE) return;
+	if (write_ || !sim_idle_pure_read(addr_)) sim_idle_impure = 1;
+}
+
+void sim_idle_get_stats(sim_idle_stats_t* stats_) {
+	*stats_ = sim_idle_stats;
+}
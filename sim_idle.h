@@ -0,0 +1,23 @@
+#ifndef SIM_IDLE_H_INCLUDED
+#define SIM_IDLE_H_INCLUDED
+
+// Idle-loop meter for the Zap core in verilate().
+//
+// Same idea as the Opera detector (opera_arm_idle_set): a short backward loop that only reads DRAM, ROM or the plain CLIO
+// registers (vcnt, irq pend, etc.), and comes back round with every register the same, can't do anything until the hardware
+// changes under it. Only here the hardware is the Verilog, so the clocks can't be skipped without the model going out of
+// step (CLIO's counters, MADAM's DMA, etc. all need ticking). It just counts them, so it's easy to see where the time goes.
+//
+#include <stdint.h>
+
+typedef struct sim_idle_stats_t {
+	uint64_t cycles;		// main_time spent going round confirmed idle loops.
+	uint64_t loops;			// Times a loop was confirmed idle (ie. entered, not trips round it).
+} sim_idle_stats_t;
+
+void sim_idle_reset();
+void sim_idle_step(uint32_t pc_);
+void sim_idle_access(uint32_t addr_, bool write_);
+void sim_idle_get_stats(sim_idle_stats_t* stats_);
+
+#endif /* SIM_IDLE_H_INCLUDED */
@@ -0,0 +1,181 @@
+// Bus trace ring buffer and sinks. See sim_log.h. ElectronAsh.
+//
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "sim_log.h"
+#include "sim_bus.h"
+
+static_assert(sizeof(sim_log_rec_t) == 32, "sim_log_rec_t should be 32 bytes");
+
+// Records. Must be a power of two.
+#define SIM_LOG_RING_SIZE (1 << 16)
+
+uint32_t sim_log_mask = 0;
+
+static uint32_t sim_log_want = SIM_LOG_MASK_ALL;	// What sim_log_set_mask() asked for.
+
+static sim_log_rec_t sim_log_ring[SIM_LOG_RING_SIZE];
+static std::atomic<uint32_t> sim_log_head(0);		// Next slot to fill. Only the sim thread stores this.
+static std::atomic<uint32_t> sim_log_tail(0);		// Next slot to drain. Only the writer thread stores this.
+static std::atomic<bool> sim_log_stop(false);
+
+static FILE* sim_log_file = NULL;
+static bool sim_log_binary = 0;
+static std::thread sim_log_thread;
+
+static const char* sim_log_region_names[SIM_LOG_REGION_COUNT] = { "madam", "clio", "xbus", "svf", "diag", "slow", "misc" };
+
+// Same text as the old fprintf()s in verilate(), so the logs still diff against older sim_trace.txt files.
+int sim_log_format(const sim_log_rec_t* rec_, char* buf_, size_t size_) {
+	switch (rec_->kind) {
+		case SIM_LOG_ACCESS: {
+			int len = snprintf(buf_, size_, "Addr: 0x%08X ", rec_->aux);
+
+			const sim_bus_entry_t* bus = sim_bus_decode(rec_->addr, rec_->dir);
+			if (bus->name) len += snprintf(buf_ + len, size_ - len, "%s", bus->name);
+			return len;
+		}
+		case SIM_LOG_DATA:
+			if (rec_->dir) return snprintf(buf_, size_, "Write: 0x%08X  (PC: 0x%08X)\n", rec_->data, rec_->pc);
+			return snprintf(buf_, size_, " Read: 0x%08X  (PC: 0x%08X)\n", rec_->data, rec_->pc);
+		case SIM_LOG_FRAME:
+			return snprintf(buf_, size_, "frame: %d\n", (int)rec_->data);
+		case SIM_LOG_PC:
+			return snprintf(buf_, size_, "PC: 0x%08X  Addr: 0x%08X  dat_i: 0x%08X  dat_o: 0x%08X  write: %d\n", rec_->pc, rec_->addr, rec_->data, rec_->aux, rec_->dir);
+		case SIM_LOG_XBUS_DMA:
+			return snprintf(buf_, size_, "Xbus DMA  trg: 0x%08X  len: 0x%08X\n", rec_->addr, rec_->data);
+		case SIM_LOG_PBUS_DMA:
+			return snprintf(buf_, size_, "PBUS DMA  toRAM: 0x%08X  len: 0x%08X  fromRAM: 0x%08X\n", rec_->addr, rec_->data, rec_->aux);
+	}
+	return 0;
+}
+
+static void sim_log_write(const sim_log_rec_t* rec_, uint32_t count_) {
+	if (sim_log_binary) {
+		fwrite(rec_, sizeof(sim_log_rec_t), count_, sim_log_file);
+		return;
+	}
+
+	char buf[256];
+	for (uint32_t i = 0; i < count_; i++) {
+		int len = sim_log_format(&rec_[i], buf, sizeof(buf));
+		fwrite(buf, 1, len, sim_log_file);
+	}
+}
+
+// Writer thread. Drains whatever is in the ring, in up to two runs (before and after the wrap).
+static void sim_log_writer() {
+	uint32_t tail = sim_log_tail.load(std::memory_order_relaxed);
+
+	while (1) {
+		bool stop = sim_log_stop.load(std::memory_order_acquire);	// Read before head, so nothing pushed before the stop gets missed.
+		uint32_t head = sim_log_head.load(std::memory_order_acquire);
+
+		if (head == tail) {
+			if (stop) break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		while (tail != head) {
+			uint32_t idx = tail & (SIM_LOG_RING_SIZE - 1);
+			uint32_t count = head - tail;
+			if (count > SIM_LOG_RING_SIZE - idx) count = SIM_LOG_RING_SIZE - idx;
+
+			sim_log_write(&sim_log_ring[idx], count);
+			tail += count;
+			sim_log_tail.store(tail, std::memory_order_release);
+		}
+	}
+
+	fflush(sim_log_file);
+}
+
+// Called from the sim thread only. If the writer falls a whole ring behind, the sim waits for it rather than dropping records.
+void sim_log_push(const sim_log_rec_t* rec_) {
+	uint32_t head = sim_log_head.load(std::memory_order_relaxed);
+
+	while (head - sim_log_tail.load(std::memory_order_acquire) >= SIM_LOG_RING_SIZE) std::this_thread::yield();
+
+	sim_log_ring[head & (SIM_LOG_RING_SIZE - 1)] = *rec_;
+	sim_log_head.store(head + 1, std::memory_order_release);
+}
+
+static int sim_log_open(const char* path_, bool binary_) {
+	sim_log_close();
+
+	sim_log_file = fopen(path_, binary_ ? "wb" : "w");
+	if (sim_log_file == NULL) {
+		fprintf(stderr, "Could not create %s\n", path_);
+		return -1;
+	}
+
+	if (binary_) {
+		sim_log_header_t header;
+		memcpy(header.magic, SIM_LOG_MAGIC, sizeof(header.magic));
+		header.version = SIM_LOG_VERSION;
+		header.rec_size = sizeof(sim_log_rec_t);
+		fwrite(&header, sizeof(header), 1, sim_log_file);
+	}
+
+	sim_log_binary = binary_;
+	sim_log_stop.store(false);
+	sim_log_thread = std::thread(sim_log_writer);
+
+	sim_log_mask = sim_log_want;
+	return 0;
+}
+
+int sim_log_open_text(const char* path_) {
+	return sim_log_open(path_, 0);
+}
+
+int sim_log_open_binary(const char* path_) {
+	return sim_log_open(path_, 1);
+}
+
+// Waits for the writer to drain the ring, then closes the file. Safe to call with nothing open.
+void sim_log_close() {
+	if (sim_log_file == NULL) return;
+
+	sim_log_mask = 0;
+	sim_log_stop.store(true, std::memory_order_release);
+	sim_log_thread.join();
+
+	fclose(sim_log_file);
+	sim_log_file = NULL;
+}
+
+void sim_log_set_mask(uint32_t mask_) {
+	sim_log_want = mask_ & SIM_LOG_MASK_ALL;
+	if (sim_log_file) sim_log_mask = sim_log_want;
+}
+
+// "madam,clio,xbus" etc, or "all". Returns -1 on an unknown name.
+int sim_log_parse_mask(const char* list_, uint32_t* mask_) {
+	uint32_t mask = 0;
+
+	while (*list_) {
+		size_t len = strcspn(list_, ",");
+
+		if (len == 3 && !strncmp(list_, "all", 3)) mask = SIM_LOG_MASK_ALL;
+		else {
+			int i;
+			for (i = 0; i < SIM_LOG_REGION_COUNT; i++) {
+				if (strlen(sim_log_region_names[i]) == len && !strncmp(list_, sim_log_region_names[i], len)) break;
+			}
+			if (i == SIM_LOG_REGION_COUNT) return -1;
+			mask |= 1u << i;
+		}
+
+		list_ += len;
+		if (*list_ == ',') list_++;
+	}
+
+	*mask_ = mask;
+	return 0;
+}
@@ -0,0 +1,103 @@
+#ifndef SIM_LOG_H_INCLUDED
+#define SIM_LOG_H_INCLUDED
+
+// Bus trace for verilate(). (sim_trace.txt)
+//
+// verilate() used to fprintf() the "Addr: / Read: / Write:" lines straight to logfile on every MMIO access,
+// which was most of the wall time whenever the BIOS sat polling CLIO, even with logfile pointed at the null device.
+//
+// Now every trace line is a fixed-size sim_log_rec_t, pushed into a lock-free ring. A writer thread drains the ring,
+// and either formats the records into the old sim_trace.txt text, or dumps them raw to a binary file for
+// sim_log_decode to turn back into text later.
+//
+// Nothing is recorded until a sink is opened, and each region can be masked at runtime with sim_log_set_mask().
+// Build with SIM_LOG_ENABLE=0 to compile all of the sim_log() calls out.
+//
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef SIM_LOG_ENABLE
+#define SIM_LOG_ENABLE 1
+#endif
+
+// Which chip / address range a record belongs to. One bit each in the mask.
+enum sim_log_region_e {
+	SIM_LOG_MADAM = 0,		// 0x033xxxxx.
+	SIM_LOG_CLIO,			// 0x034xxxxx, apart from the Xbus regs.
+	SIM_LOG_XBUS,			// 0x03400500 - 0x034005FF, plus the Xbus DMA.
+	SIM_LOG_SVF,			// 0x032xxxxx.
+	SIM_LOG_DIAG,			// 0x03180000 - 0x03180003.
+	SIM_LOG_SLOW,			// The rest of 0x031xxxxx. (Brooktree, NVRAM, Slow Bus)
+	SIM_LOG_MISC,			// Frame count, PC trace, PBUS DMA.
+	SIM_LOG_REGION_COUNT
+};
+
+#define SIM_LOG_MASK_ALL ((1u << SIM_LOG_REGION_COUNT) - 1)
+
+enum sim_log_kind_e {
+	SIM_LOG_ACCESS = 0,		// "Addr: <aux> <name>". addr = mem_addr, aux = postalu_address_ff.
+	SIM_LOG_DATA,			// "Write: <data>  (PC: <pc>)" or " Read: <data>  (PC: <pc>)".
+	SIM_LOG_FRAME,			// "frame: <data>".
+	SIM_LOG_PC,				// "PC: <pc>  Addr: <addr>  dat_i: <data>  dat_o: <aux>  write: <dir>".
+	SIM_LOG_XBUS_DMA,		// "Xbus DMA  trg: <addr>  len: <data>".
+	SIM_LOG_PBUS_DMA		// "PBUS DMA  toRAM: <addr>  len: <data>  fromRAM: <aux>".
+};
+
+typedef struct sim_log_rec_t {
+	uint64_t cycle;		// main_time.
+	uint32_t pc;		// cur_pc.
+	uint32_t addr;
+	uint32_t data;
+	uint32_t aux;
+	uint8_t dir;		// 1 = write.
+	uint8_t region;		// sim_log_region_e.
+	uint8_t kind;		// sim_log_kind_e.
+	uint8_t pad[5];
+} sim_log_rec_t;
+
+// Binary sink file header. The records follow straight after it, in cycle order.
+#define SIM_LOG_MAGIC "SIM3DOLG"
+#define SIM_LOG_VERSION 1
+
+typedef struct sim_log_header_t {
+	char magic[8];
+	uint32_t version;
+	uint32_t rec_size;	// sizeof(sim_log_rec_t).
+} sim_log_header_t;
+
+// Regions that get recorded right now. Zero while no sink is open.
+extern uint32_t sim_log_mask;
+
+int sim_log_open_text(const char* path_);
+int sim_log_open_binary(const char* path_);
+void sim_log_close();
+
+void sim_log_set_mask(uint32_t mask_);
+int sim_log_parse_mask(const char* list_, uint32_t* mask_);
+
+void sim_log_push(const sim_log_rec_t* rec_);
+int sim_log_format(const sim_log_rec_t* rec_, char* buf_, size_t size_);
+
+// Region for an MMIO address, for the ACCESS / DATA records.
+static inline uint8_t sim_log_region(uint32_t addr_) {
+	switch (addr_ >> 20) {
+		case 0x031: return (addr_ >> 2) == (0x03180000 >> 2) ? SIM_LOG_DIAG : SIM_LOG_SLOW;
+		case 0x032: return SIM_LOG_SVF;
+		case 0x033: return SIM_LOG_MADAM;
+		case 0x034: return (addr_ >> 8) == (0x03400500 >> 8) ? SIM_LOG_XBUS : SIM_LOG_CLIO;
+		default: return SIM_LOG_MISC;
+	}
+}
+
+#if SIM_LOG_ENABLE
+static inline void sim_log(uint8_t kind_, uint8_t region_, uint64_t cycle_, uint32_t pc_, uint32_t addr_, uint32_t data_, uint32_t aux_, uint8_t dir_) {
+	if (!(sim_log_mask & (1u << region_))) return;
+
+	sim_log_rec_t rec = { cycle_, pc_, addr_, data_, aux_, dir_, region_, kind_, { 0 } };
+	sim_log_push(&rec);
+}
+#else
+static inline void sim_log(uint8_t, uint8_t, uint64_t, uint32_t, uint32_t, uint32_t, uint32_t, uint8_t) {}
+#endif
+
+#endif /* SIM_LOG_H_INCLUDED */
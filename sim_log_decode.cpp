@@ -0,0 +1,96 @@
+// Turns a --binlog file from sim_3do_headless back into sim_trace.txt text. See sim_log.h.
+//
+// Usage:
+//   sim_log_decode trace.bin > sim_trace.txt
+//   sim_log_decode --logmask clio,xbus --from 1000000 --to 2000000 trace.bin
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_bus.h"
+#include "sim_log.h"
+
+static void usage(const char* prog_) {
+	fprintf(stderr,
+		"Usage: %s [options] <file.bin>\n"
+		"  --logmask <list>  Only these regions: madam,clio,xbus,svf,diag,slow,misc,all (default: all)\n"
+		"  --from <cycle>    Skip records before this cycle\n"
+		"  --to <cycle>      Stop at this cycle\n"
+		"  --out <file>      Write here instead of stdout\n",
+		prog_);
+}
+
+int main(int argc, char** argv) {
+	const char* in_path = NULL;
+	const char* out_path = NULL;
+	uint32_t mask = SIM_LOG_MASK_ALL;
+	uint64_t from = 0;
+	uint64_t to = ~0ull;
+
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		const char* val = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+		if (arg[0] != '-') { in_path = arg; continue; }
+		if (val == NULL) { usage(argv[0]); return 1; }
+
+		if (!strcmp(arg, "--logmask")) { if (sim_log_parse_mask(val, &mask)) { fprintf(stderr, "Bad --logmask: %s\n", val); return 1; } }
+		else if (!strcmp(arg, "--from")) from = strtoull(val, NULL, 0);
+		else if (!strcmp(arg, "--to")) to = strtoull(val, NULL, 0);
+		else if (!strcmp(arg, "--out")) out_path = val;
+		else { usage(argv[0]); return 1; }
+		i++;
+	}
+
+	if (in_path == NULL) { usage(argv[0]); return 1; }
+
+	FILE* in = fopen(in_path, "rb");
+	if (in == NULL) {
+		fprintf(stderr, "Could not open %s\n", in_path);
+		return 1;
+	}
+
+	sim_log_header_t header;
+	if (fread(&header, sizeof(header), 1, in) != 1 || memcmp(header.magic, SIM_LOG_MAGIC, sizeof(header.magic))) {
+		fprintf(stderr, "%s is not a sim_3do binary log\n", in_path);
+		return 1;
+	}
+	if (header.version != SIM_LOG_VERSION || header.rec_size != sizeof(sim_log_rec_t)) {
+		fprintf(stderr, "%s is log version %u (record size %u), this decoder wants version %u (record size %u)\n",
+			in_path, header.version, header.rec_size, SIM_LOG_VERSION, (unsigned)sizeof(sim_log_rec_t));
+		return 1;
+	}
+
+	FILE* out = stdout;
+	if (out_path) {
+		out = fopen(out_path, "w");
+		if (out == NULL) {
+			fprintf(stderr, "Could not create %s\n", out_path);
+			return 1;
+		}
+	}
+
+	sim_bus_init();	// ACCESS records get their register names from the decoder tables.
+
+	static sim_log_rec_t recs[4096];
+	char buf[256];
+	size_t count;
+
+	while ((count = fread(recs, sizeof(sim_log_rec_t), sizeof(recs) / sizeof(recs[0]), in)) > 0) {
+		for (size_t i = 0; i < count; i++) {
+			const sim_log_rec_t* rec = &recs[i];
+			if (rec->cycle < from || !(mask & (1u << rec->region))) continue;
+			if (rec->cycle > to) goto done;
+
+			int len = sim_log_format(rec, buf, sizeof(buf));
+			fwrite(buf, 1, len, out);
+		}
+	}
+
+done:
+	fclose(in);
+	if (out != stdout) fclose(out);
+
+	return 0;
+}
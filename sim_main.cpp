@@ -10,68 +10,25 @@
 
 #include "imgui_functions.h"
 
-#include <verilated.h>
-
-#include "Vcore_3do___024root.h"
-#include "Vcore_3do.h"
-
-#include "verilated_vcd_c.h"
+#include "sim_core.h"
+#include "sim_bus.h"
+#include "sim_log.h"
+#include "sim_wave.h"
+#include "sim_state.h"
+#include "sim_ffwd.h"
+#include "sim_idle.h"
 
 // libopera includes...
-#include "opera_3do.h"
-
 #include "opera_arm.h"
-#include "opera_clio.h"
-#include "opera_clock.h"
-#include "opera_core.h"
 #include "opera_diag_port.h"
-#include "opera_dsp.h"
-#include "opera_madam.h"
-#include "opera_region.h"
-#include "opera_sport.h"
-#include "opera_vdlp.h"
-#include "opera_xbus.h"
-#include "opera_xbus_cdrom_plugin.h"
 #include "opera_cdrom.h"
-#include "opera_nvram.h"
-
-#include "inline.h"
+#include "opera_madam.h"
+#include "opera_log.h"
 
 #include "sim_xbus.h"
 
-#include "opera_vdlp_i.h"
-//extern vdlp_t   g_VDLP;
-
-uint32_t opera_line;
-uint32_t opera_field;
-
-
-volatile extern xbus_datum_t      XBUS;
-volatile extern sim_xbus_device xdev[16];
-//extern cdrom_device_t g_CDROM_DEVICE;
-
-volatile extern uint32_t CDIMAGE_SECTOR;
-
-uint8_t* dram;
-uint8_t* vram;
-int flagtime;
-extern arm_core_t CPU;
-
-
-FILE* logfile;
-FILE* inst_file;
-FILE* soundfile;
-FILE* isofile;
 FILE* ramdump;
 
-FILE* cel_file;
-uint32_t cel_size = 0;
-
-uint32_t sound_out;
-
-
-extern int sim_xbus_fiq_request = 0;
-
 #include <d3d11.h>
 #define DIRECTINPUT_VERSION 0x0800
 #include <dinput.h>
@@ -101,55 +58,6 @@ static ID3D11RasterizerState* g_pRasterizerState = NULL;
 static ID3D11BlendState* g_pBlendState = NULL;
 static ID3D11DepthStencilState* g_pDepthStencilState = NULL;
 static int                      g_VertexBufferSize = 5000, g_IndexBufferSize = 10000;
-
-
-// Instantiation of module.
-Vcore_3do* top = new Vcore_3do;
-
-char decode_string[64];
-char issue_string[64];
-char shifter_string[64];
-char alu_string[64];
-char memory_string[64];
-char rb_string[64];
-
-bool old_fiq_n = 1;
-
-bool next_ack = 0;
-
-bool rom2_select = 0;   // Select the BIOS ROM at startup! (not Kanji).
-
-bool map_bios = 1;
-uint32_t rom_byteswapped;
-uint32_t rom2_byteswapped;
-uint32_t ram_byteswapped;
-
-uint16_t shift_reg = 0;
-bool toggle = 1;
-
-char my_string[1024];
-
-bool trace = 0;
-bool inst_trace = 0;
-bool soundtrace = 0;
-
-int pix_count = 0;
-
-uint32_t cur_pc;
-uint32_t old_pc;
-
-bool dump_ram = 0;
-
-unsigned char rgb[3];
-bool prev_vsync = 0;
-int frame_count = 0;
-
-bool prev_hsync = 0;
-int line_count = 0;
-
-bool trig_irq = 0;
-bool trig_fiq = 0;
-
 bool run_enable = 0;
 bool single_step = 0;
 bool multi_step = 0;
@@ -157,7 +65,7 @@ int multi_step_amount = 8;
 
 int spr_width = 128;
 
-FILE* vgap;
+bool dump_ram = 0;
 
 // Data
 static IDXGISwapChain* g_pSwapChain = NULL;
@@ -242,1407 +150,11 @@ LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 	return DefWindowProc(hWnd, msg, wParam, lParam);
 }
 
-static float values[90] = { 0 };
-static int values_offset = 0;
-
-int my_x = 0;
-int my_y = 0;
-
-vluint64_t main_time = 0;       // Current simulation time.
-
-unsigned int file_size;
-unsigned int iso_size;
-
-unsigned char buffer[16];
-
-unsigned int rom_size = 1024 * 1024;            // 1MB. (8-bit wide, 32-bit access). BIOS.
-uint8_t* rom_ptr = (uint8_t*)malloc(rom_size);
-
-unsigned int rom2_size = 1024 * 1024;           // 1MB. (8-bit wide, 32-bit access). Kanji font ROM.
-uint8_t* rom2_ptr = (uint8_t*)malloc(rom2_size);
-
-unsigned int ram_size = 1024 * 2048;            // 2MB. (8-bit wide, 32-bit access).
-uint8_t* ram_ptr = (uint8_t*)malloc(ram_size);
-
-unsigned int vram_size = 1024 * 1024;			// 1MB. (8-bit wide, 32-bit access).
-//unsigned int vram_size = 1024 * 2048;			// 2MB. (8-bit wide, 32-bit access).
-uint8_t* vram_ptr = (uint8_t*)malloc(vram_size);
-
-unsigned int nvram_size = 1024 * 128;           // 128KB?
-uint8_t* nvram_ptr = (uint8_t*)malloc(nvram_size);
-
-unsigned int disp_size = 1024 * 1024 * 4;       // 4MB. (32-bit wide). Sim display window.
-uint32_t* disp_ptr = (uint32_t*)malloc(disp_size);
-
-unsigned int disp2_size = 1024 * 1024 * 4;       // 4MB. (32-bit wide). Opera display window.
-uint32_t* disp2_ptr = (uint32_t*)malloc(disp2_size);
-
-double sc_time_stamp() {       // Called by $time in Verilog.
-	return main_time;
-}
-
-extern opera_cdrom_get_size_cb_t    CDROM_GET_SIZE;
-extern opera_cdrom_set_sector_cb_t  CDROM_SET_SECTOR;
-extern opera_cdrom_read_sector_cb_t CDROM_READ_SECTOR;
-
-uint16_t CDIMAGE_SECTOR_SIZE = 2048;
-
-
-static
-uint32_t
-cdimage_get_size(void)
-{
-	return (iso_size / CDIMAGE_SECTOR_SIZE);
-}
-
-static
-void
-cdimage_set_sector(const uint32_t sector_)
-{
-	CDIMAGE_SECTOR = sector_;
-}
-
-static
-void
-cdimage_read_sector(void* buf_)
-{	uint32_t start_offset = CDIMAGE_SECTOR * CDIMAGE_SECTOR_SIZE;
-	//if (CDIMAGE_SECTOR_SIZE == 2352) start_offset += 16;
-	//if ( start_offset>(iso_size -CDIMAGE_SECTOR_SIZE) ) start_offset=(iso_size - CDIMAGE_SECTOR_SIZE);	// Clamp the max offset.
-	fseek(isofile, start_offset, SEEK_SET);
-	fread(buf_, 1, CDIMAGE_SECTOR_SIZE, isofile);
-}
-
-
-uint32_t g_OPT_VIDEO_WIDTH = 0;
-uint32_t g_OPT_VIDEO_HEIGHT = 0;
-uint32_t g_OPT_VIDEO_PITCH_SHIFT = 0;
-uint32_t g_OPT_VDLP_FLAGS = 0;
-uint32_t g_OPT_VDLP_PIXEL_FORMAT = 0;
-uint32_t g_OPT_ACTIVE_DEVICES = 0;
-
-void my_opera_init() {
-	opera_cdrom_set_callbacks(cdimage_get_size, cdimage_set_sector, cdimage_read_sector);
-
-	//opera_3do_init(libopera_callback);
-
-	opera_clock_init();
-	opera_arm_init();
-
-	uint32_t size = (384 * 288 * 4);
-	if (!g_VIDEO_BUFFER) g_VIDEO_BUFFER = (uint32_t*)calloc(size, sizeof(uint32_t));
-	opera_vdlp_configure(g_VIDEO_BUFFER, (vdlp_pixel_format_e)VDLP_PIXEL_FORMAT_XRGB8888, g_OPT_VDLP_FLAGS);
-
-	dram = opera_arm_ram_get();
-	vram = opera_arm_vram_get();
-
-	opera_vdlp_init(vram);
-	opera_sport_init(vram);
-	opera_madam_init(dram);
-	opera_nvram_init();
-	
-	//opera_xbus_init(xbus_cdrom_plugin);
-	//opera_xbus_device_load(0, NULL);
-	sim_xbus_init(xbus_cdrom_plugin);
-	sim_xbus_device_load(0, NULL);
-
-	cdimage_set_sector(0);
-
-	// 0x40 for start from 3D0-CD
-	// 0x01/0x02 from PhotoCD ??
-	// (NO use 0x40/0x02 for BIOS test)
-	opera_clio_init(0x40);	// bit[6]=DIPIR.
-	//opera_clio_init(0x01);		// <- This value gets written to CLIO cstatbits. bit[0]=POR.
-	opera_dsp_init();
-}
-
-
-static uint16_t sim_SNDDebugFIFO0;
-static uint16_t sim_SNDDebugFIFO1;
-static uint16_t sim_RCVDebugFIFO0;
-static uint16_t sim_RCVDebugFIFO1;
-static uint16_t sim_GetIdx;
-static uint16_t sim_SendIdx;
-
-void
-sim_diag_port_init(const int32_t test_code_)
-{
-	int32_t test_code = test_code_;
-
-	sim_GetIdx = 16;
-	sim_SendIdx = 16;
-	sim_SNDDebugFIFO0 = 0;
-	sim_SNDDebugFIFO1 = 0;
-
-	if (test_code >= 0)
-	{
-		test_code ^= 0xFF;
-		test_code |= 0xA000;
-	}
-	else
-	{
-		test_code = 0;
-	}
-
-	sim_RCVDebugFIFO0 = test_code;
-	sim_RCVDebugFIFO1 = test_code;
-}
-
-
-void
-sim_diag_port_send(const uint32_t val_)
-{
-	if (sim_GetIdx != 16)
-	{
-		sim_GetIdx = 16;
-		sim_SendIdx = 16;
-		sim_SNDDebugFIFO0 = 0;
-		sim_SNDDebugFIFO1 = 0;
-	}
-
-	sim_SNDDebugFIFO0 |= ((val_ & 1) << (sim_SendIdx - 1));
-	sim_SNDDebugFIFO1 |= (((val_ & 1) >> 1) << (sim_SendIdx - 1));
-
-	sim_SendIdx--;
-
-	if (sim_SendIdx == 0)
-		sim_SendIdx = 16;
-}
-
-uint32_t
-sim_diag_port_get(void)
-{
-	unsigned int val = 0;
-
-	if (sim_SendIdx != 16)
-	{
-		sim_GetIdx = 16;
-		sim_SendIdx = 16;
-	}
-
-	val = ((sim_RCVDebugFIFO0 >> (sim_GetIdx - 1)) & 0x1);
-	val |= (((sim_RCVDebugFIFO1 >> (sim_GetIdx - 1)) & 0x1) << 0x1);
-	sim_GetIdx--;
-
-	if (sim_GetIdx == 0)
-		sim_GetIdx = 16;
-
-	return val;
-}
-
-
-volatile uint32_t vdl_ctl  = 0x00004410;
-volatile uint32_t vdl_curr = 0x002C0000;
-volatile uint32_t vdl_prev = 0x002C0000;
-volatile uint32_t vdl_next = 0x002C0000;
-
-volatile uint32_t clut[256];
-
-void sim_process_vdl() {
-	// Load default CLUT...
-	clut[0x00] = 0x000000; clut[0x01] = 0x080808; clut[0x02] = 0x101010; clut[0x03] = 0x191919; clut[0x04] = 0x212121; clut[0x05] = 0x292929; clut[0x06] = 0x313131; clut[0x07] = 0x3A3A3A;
-	clut[0x08] = 0x424242; clut[0x09] = 0x4A4A4A; clut[0x0A] = 0x525252; clut[0x0B] = 0x5A5A5A; clut[0x0C] = 0x636363; clut[0x0D] = 0x6B6B6B; clut[0x0E] = 0x737373; clut[0x0F] = 0x7B7B7B;
-	clut[0x10] = 0x848484; clut[0x11] = 0x8C8C8C; clut[0x12] = 0x949494; clut[0x13] = 0x9C9C9C; clut[0x14] = 0xA5A5A5; clut[0x15] = 0xADADAD; clut[0x16] = 0xB5B5B5; clut[0x17] = 0xBDBDBD;
-	clut[0x18] = 0xC5C5C5; clut[0x19] = 0xCECECE; clut[0x1A] = 0xD6D6D6; clut[0x1B] = 0xDEDEDE; clut[0x1C] = 0xE6E6E6; clut[0x1D] = 0xEFEFEF; clut[0x1E] = 0xF8F8F8; clut[0x1F] = 0xFFFFFF;
-
-	uint32_t header = top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma24_curaddr & 0xfffff;	// Mask address to 1MB (VRAM).
-
-	// Read the VDL / CLUT from vram_ptr...
-	if (header>0) {
-		vdl_ctl = 0x00000000;
-		vdl_curr = 0x00000000;
-		vdl_prev = 0x00000000;
-		vdl_next = 0x00000000;
-
-		for (int i = 0; i <= 35; i++) {
-			if (i == 0) {
-				vdl_ctl |= (vram_ptr[header + (i*4) + 0]) << 24;
-				vdl_ctl |= (vram_ptr[header + (i*4) + 1]) << 16;
-				vdl_ctl |= (vram_ptr[header + (i*4) + 2]) << 8;
-				vdl_ctl |= (vram_ptr[header + (i*4) + 3]) << 0;
-			}
-			if (i == 1) {
-				vdl_curr |= (vram_ptr[header + (i*4) + 0]) << 24;
-				vdl_curr |= (vram_ptr[header + (i*4) + 1]) << 16;
-				vdl_curr |= (vram_ptr[header + (i*4) + 2]) << 8;
-				vdl_curr |= (vram_ptr[header + (i*4) + 3]) << 0;
-			}
-			if (i == 2) {
-				vdl_prev |= (vram_ptr[header + (i*4) + 0]) << 24;
-				vdl_prev |= (vram_ptr[header + (i*4) + 1]) << 16;
-				vdl_prev |= (vram_ptr[header + (i*4) + 2]) << 8;
-				vdl_prev |= (vram_ptr[header + (i*4) + 3]) << 0;
-			}
-			if (i == 3) {
-				vdl_next |= (vram_ptr[header + (i*4) + 0]) << 24;
-				vdl_next |= (vram_ptr[header + (i*4) + 1]) << 16;
-				vdl_next |= (vram_ptr[header + (i*4) + 2]) << 8;
-				vdl_next |= (vram_ptr[header + (i*4) + 3]) << 0;
-			}
-			//else if (i>=4) clut[i-4] = vram_ptr[header+i];         // TESTING !!!
-		}
-	}
-
-	// Copy the VRAM pixels into disp_ptr...
-	// Just a dumb test atm. Assuming 16bpp from vram_ptr, with odd and even pixels in the upper/lower 16 bits.
-	//
-	// vram_ptr is 32-bit wide!
-	// vram_size = 1MB, so needs to be divided by 4 if used as an index.
-	//
-	uint32_t my_line = 0;
-
-	//uint32_t offset = 0xC0000;
-	uint32_t offset = vdl_curr & 0xfffff;
-	//uint32_t offset = vdl_next & 0xfffff;
-
-	for (uint32_t i = 0; i < (vram_size / 16); i++) {
-		uint16_t pixel;
-
-		if ((i % 320) == 0) my_line++;
-
-		pixel = vram_ptr[ (offset+(i*4)+0)&0xfffff ]<<8 | vram_ptr[ (offset+(i*4)+1)&0xfffff ];
-		rgb[0] = clut[(pixel & 0x7C00) >> 10] >> 16;
-		rgb[1] = clut[(pixel & 0x03E0) >> 5] >> 8;
-		rgb[2] = clut[(pixel & 0x001F) << 0] >> 0;
-		disp_ptr[i + (my_line * 320)] = 0xff<<24 | rgb[2]<<16 | rgb[1]<<8 | rgb[0];			// Our debugger framebuffer is in the 32-bit ABGR format.
-
-		pixel = vram_ptr[ (offset+(i*4)+2)&0xfffff ]<<8 | vram_ptr[ (offset+(i*4)+3)&0xfffff ];
-		rgb[0] = clut[(pixel & 0x7C00) >> 10] >> 16;
-		rgb[1] = clut[(pixel & 0x03E0) >> 5] >> 8;
-		rgb[2] = clut[(pixel & 0x001F) << 0] >> 0;
-		disp_ptr[i + (my_line * 320) + 320] = 0xff<<24 | rgb[2]<<16 | rgb[1]<<8 | rgb[0];	// Our debugger framebuffer is in the 32-bit ABGR format.
-	}
-}
-
-volatile uint32_t opera_vdl_ctl = 0x00000000;
-volatile uint32_t opera_vdl_curr = 0x00000000;
-volatile uint32_t opera_vdl_prev = 0x00000000;
-volatile uint32_t opera_vdl_next = 0x00000000;
-
-volatile uint32_t opera_clut[256];
-
-void opera_process_vdl() {
-	// Load default CLUT...
-	clut[0x00] = 0x000000; clut[0x01] = 0x080808; clut[0x02] = 0x101010; clut[0x03] = 0x191919; clut[0x04] = 0x212121; clut[0x05] = 0x292929; clut[0x06] = 0x313131; clut[0x07] = 0x3A3A3A;
-	clut[0x08] = 0x424242; clut[0x09] = 0x4A4A4A; clut[0x0A] = 0x525252; clut[0x0B] = 0x5A5A5A; clut[0x0C] = 0x636363; clut[0x0D] = 0x6B6B6B; clut[0x0E] = 0x737373; clut[0x0F] = 0x7B7B7B;
-	clut[0x10] = 0x848484; clut[0x11] = 0x8C8C8C; clut[0x12] = 0x949494; clut[0x13] = 0x9C9C9C; clut[0x14] = 0xA5A5A5; clut[0x15] = 0xADADAD; clut[0x16] = 0xB5B5B5; clut[0x17] = 0xBDBDBD;
-	clut[0x18] = 0xC5C5C5; clut[0x19] = 0xCECECE; clut[0x1A] = 0xD6D6D6; clut[0x1B] = 0xDEDEDE; clut[0x1C] = 0xE6E6E6; clut[0x1D] = 0xEFEFEF; clut[0x1E] = 0xF8F8F8; clut[0x1F] = 0xFFFFFF;
-
-	volatile uint32_t header = g_VDLP.curr_vdl & 0xfffff;
-
-	// Read the VDL / CLUT from vram_ptr...
-	if (header>0) {
-		for (int i = 0; i <= 35; i++) {
-			if (i == 0) {
-				opera_vdl_ctl |= (vram[header + (i*4) + 0]) << 24;
-				opera_vdl_ctl |= (vram[header + (i*4) + 1]) << 16;
-				opera_vdl_ctl |= (vram[header + (i*4) + 2]) << 8;
-				opera_vdl_ctl |= (vram[header + (i*4) + 3]) << 0;
-			}
-			if (i == 1) {
-				opera_vdl_curr |= (vram[header + (i*4) + 0]) << 24;
-				opera_vdl_curr |= (vram[header + (i*4) + 1]) << 16;
-				opera_vdl_curr |= (vram[header + (i*4) + 2]) << 8;
-				opera_vdl_curr |= (vram[header + (i*4) + 3]) << 0;
-			}
-			if (i == 2) {
-				opera_vdl_prev |= (vram[header + (i*4) + 0]) << 24;
-				opera_vdl_prev |= (vram[header + (i*4) + 1]) << 16;
-				opera_vdl_prev |= (vram[header + (i*4) + 2]) << 8;
-				opera_vdl_prev |= (vram[header + (i*4) + 3]) << 0;
-			}
-			if (i == 3) {
-				opera_vdl_next |= (vram[header + (i*4) + 0]) << 24;
-				opera_vdl_next |= (vram[header + (i*4) + 1]) << 16;
-				opera_vdl_next |= (vram[header + (i*4) + 2]) << 8;
-				opera_vdl_next |= (vram[header + (i*4) + 3]) << 0;
-			}
-			//else if (i>=4) clut[i-4] = vram_ptr[header+i];         // TESTING !!!
-		}
-	}
-
-	// Copy the VRAM pixels into disp_ptr...
-	// Just a dumb test atm. Assuming 16bpp from vram_ptr, with odd and even pixels in the upper/lower 16 bits.
-	//
-	// vram_ptr is 32-bit wide!
-	// vram_size = 1MB, so needs to be divided by 4 if used as an index.
-	//
-
-	//uint32_t offset = opera_vdl_curr & 0xfffff;
-	//uint32_t offset = opera_vdl_next & 0xfffff;
-
-	uint32_t offset = g_VDLP.curr_bmp & 0xfffff;
-	//uint32_t offset = opera_vdlp_bmp_origin & 0xfffff;
-	//uint32_t offset = 0x21000;
-	//uint32_t offset = 0xC0000;
-
-	uint32_t my_line = opera_line;
-
-	for (int i = 0; i < 320; i++) {
-		uint16_t pixel;
-
-		pixel = vram[offset + (i * 4) + 3] << 8 | vram[offset + (i * 4) + 2];
-		rgb[0] = clut[(pixel & 0x7C00) >> 10] >> 16;
-		rgb[1] = clut[(pixel & 0x03E0) >> 5] >> 8;
-		rgb[2] = clut[(pixel & 0x001F) << 0] >> 0;
-		disp2_ptr[i + (my_line * 320)] = 0xff << 24 | rgb[2] << 16 | rgb[1] << 8 | rgb[0];			// Our debugger framebuffer is in the 32-bit ABGR format.
-
-		pixel = vram[offset + (i * 4) + 1] << 8 | vram[offset + (i * 4) + 0];
-		rgb[0] = clut[(pixel & 0x7C00) >> 10] >> 16;
-		rgb[1] = clut[(pixel & 0x03E0) >> 5] >> 8;
-		rgb[2] = clut[(pixel & 0x001F) << 0] >> 0;
-		disp2_ptr[i + (my_line * 320) + 320] = 0xff << 24 | rgb[2] << 16 | rgb[1] << 8 | rgb[0];	// Our debugger framebuffer is in the 32-bit ABGR format.
-	}
-
-	/*
-	for (int i = 0; i < (vram_size / 16); i++) {
-		uint16_t pixel;
-
-		if ((i % 320) == 0) my_line++;
-
-		pixel = vram[offset + (i * 4) + 3] << 8 | vram[offset + (i * 4) + 2];
-		rgb[0] = clut[(pixel & 0x7C00) >> 10] >> 16;
-		rgb[1] = clut[(pixel & 0x03E0) >> 5] >> 8;
-		rgb[2] = clut[(pixel & 0x001F) << 0] >> 0;
-		disp2_ptr[i + (my_line * 320)] = 0xff << 24 | rgb[2] << 16 | rgb[1] << 8 | rgb[0];			// Our debugger framebuffer is in the 32-bit ABGR format.
-
-		pixel = vram[offset + (i * 4) + 1] << 8 | vram[offset + (i * 4) + 0];
-		rgb[0] = clut[(pixel & 0x7C00) >> 10] >> 16;
-		rgb[1] = clut[(pixel & 0x03E0) >> 5] >> 8;
-		rgb[2] = clut[(pixel & 0x001F) << 0] >> 0;
-		disp2_ptr[i + (my_line * 320) + 320] = 0xff << 24 | rgb[2] << 16 | rgb[1] << 8 | rgb[0];	// Our debugger framebuffer is in the 32-bit ABGR format.
-	}
-	*/
-}
-
-uint32_t svf_src_addr = 00;
-void svf_set_source() {
-	svf_src_addr = (top->mem_addr & 0x7ff) << 9;
-}
-
-void svf_page_copy() {
-	uint32_t dest_addr = (top->mem_addr & 0x7ff) << 9;	// Remember, the *address* is used here, not o_wb_dat.
-	uint32_t mask = top->o_wb_dat;                      // The write *data* is used as an mask. I think? ElectronAsh.
-
-	uint32_t keep = mask ^ 0xffffffff;
-	uint8_t keep0 = (keep >> 24) & 0xff;
-	uint8_t keep1 = (keep >> 16) & 0xff;
-	uint8_t keep2 = (keep >> 8) & 0xff;
-	uint8_t keep3 = (keep >> 0) & 0xff;
-	uint8_t mask0 = (mask >> 24) & 0xff;
-	uint8_t mask1 = (mask >> 16) & 0xff;
-	uint8_t mask2 = (mask >> 8) & 0xff;
-	uint8_t mask3 = (mask >> 0) & 0xff;
-
-	for(int i = 0; i < 2048; i += 4)   // Block size is 2KB. Copying a WORD at a time, so i+=4.
-	{
-		vram_ptr[dest_addr+i+0] = (vram_ptr[dest_addr+i+0] & keep0) | (vram_ptr[svf_src_addr+i+0] & mask0);
-		vram_ptr[dest_addr+i+1] = (vram_ptr[dest_addr+i+1] & keep1) | (vram_ptr[svf_src_addr+i+1] & mask1);
-		vram_ptr[dest_addr+i+2] = (vram_ptr[dest_addr+i+2] & keep2) | (vram_ptr[svf_src_addr+i+2] & mask2);
-		vram_ptr[dest_addr+i+3] = (vram_ptr[dest_addr+i+3] & keep3) | (vram_ptr[svf_src_addr+i+3] & mask3);
-	}
-}
-
-uint32_t svf_color = 0;
-void svf_set_color() {
-	svf_color = top->o_wb_dat;
-}
-
-void svf_flash_write() {        // "Color fill", basically.
-	uint32_t dest_addr = (top->mem_addr & 0x7ff) << 9;	// Remember, the *address* is used here, not o_wb_dat.
-	uint32_t mask = top->o_wb_dat;						// The write *data* is used as an mask. I think? ElectronAsh.
-
-	uint32_t keep = mask ^ 0xffffffff;
-	uint8_t keep0 = (keep>>24) & 0xff;
-	uint8_t keep1 = (keep>>16) & 0xff;
-	uint8_t keep2 = (keep>>8)  & 0xff;
-	uint8_t keep3 = (keep>>0)  & 0xff;
-	uint8_t mask0 = (mask>>24) & 0xff;
-	uint8_t mask1 = (mask>>16) & 0xff;
-	uint8_t mask2 = (mask>>8) & 0xff;
-	uint8_t mask3 = (mask>>0) & 0xff;
-
-	for (int i = 0; i < 2048; i+=4)   // Block size is 2KB. Writing a WORD at a time, so i+=4.
-	{
-		vram_ptr[dest_addr+i+0] = (vram_ptr[dest_addr+i+0] & keep0) | ((svf_color>>24) & mask0);
-		vram_ptr[dest_addr+i+1] = (vram_ptr[dest_addr+i+1] & keep1) | ((svf_color>>16) & mask1);
-		vram_ptr[dest_addr+i+2] = (vram_ptr[dest_addr+i+2] & keep2) | ((svf_color>>8)  & mask2);
-		vram_ptr[dest_addr+i+3] = (vram_ptr[dest_addr+i+3] & keep3) | ((svf_color>>0)  & mask3);
-	}
-}
-
-#define PBUS_BUF_SIZE 256
-
-#define PBUS_FLIGHTSTICK_ID_0       0x01
-#define PBUS_FLIGHTSTICK_ID_1       0x7B
-#define PBUS_JOYPAD_ID              0x80
-#define PBUS_MOUSE_ID               0x49
-#define PBUS_LIGHTGUN_ID            0x4D
-#define PBUS_ORBATAK_TRACKBALL_ID   PBUS_MOUSE_ID
-#define PBUS_ORBATAK_BUTTONS_ID     0xC0
-
-#define PBUS_JOYPAD_SHIFT_LT        0x02
-#define PBUS_JOYPAD_SHIFT_RT        0x03
-#define PBUS_JOYPAD_SHIFT_X         0x04
-#define PBUS_JOYPAD_SHIFT_P         0x05
-#define PBUS_JOYPAD_SHIFT_C         0x06
-#define PBUS_JOYPAD_SHIFT_B         0x07
-#define PBUS_JOYPAD_SHIFT_A         0x00
-#define PBUS_JOYPAD_SHIFT_L         0x01
-#define PBUS_JOYPAD_SHIFT_R         0x02
-#define PBUS_JOYPAD_SHIFT_U         0x03
-#define PBUS_JOYPAD_SHIFT_D         0x04
-
-uint8_t pbus_buf[PBUS_BUF_SIZE];
-uint32_t pbus_idx;
-
-void pbus_dma() {
-	bool jp_d = ImGui::IsKeyPressed(ImGuiKey_DownArrow);
-	bool jp_u = ImGui::IsKeyPressed(ImGuiKey_UpArrow);
-	bool jp_r = ImGui::IsKeyPressed(ImGuiKey_RightArrow);
-	bool jp_l = ImGui::IsKeyPressed(ImGuiKey_LeftArrow);
-	bool jp_a = ImGui::IsKeyPressed(ImGuiKey_A);
-	bool jp_b = ImGui::IsKeyPressed(ImGuiKey_B);
-	bool jp_c = ImGui::IsKeyPressed(ImGuiKey_C);
-	bool jp_p = ImGui::IsKeyPressed(ImGuiKey_P);
-	bool jp_x = ImGui::IsKeyPressed(ImGuiKey_X);
-	bool jp_rt = ImGui::IsKeyPressed(ImGuiKey_R);
-	bool jp_lt = ImGui::IsKeyPressed(ImGuiKey_L);
-
-	uint32_t str = top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma23_curaddr;	// 0x570.
-	uint32_t len = top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma23_curlen;	// 0x574.
-	uint32_t end = top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma23_nextaddr;	// 0x578.
-
-	uint32_t temp_word = 0x00000000;
-
-	str += 4;
-	len -= 4;
-	end += 4;
-
-	pbus_idx = 0;
-
-	pbus_buf[0] = ((PBUS_JOYPAD_ID) |
-		(jp_d << PBUS_JOYPAD_SHIFT_D) |
-		(jp_u << PBUS_JOYPAD_SHIFT_U) |
-		(jp_r << PBUS_JOYPAD_SHIFT_R) |
-		(jp_l << PBUS_JOYPAD_SHIFT_L) |
-		(jp_a << PBUS_JOYPAD_SHIFT_A));
-
-	pbus_buf[1] = ((jp_b << PBUS_JOYPAD_SHIFT_B) |
-		(jp_c << PBUS_JOYPAD_SHIFT_C) |
-		(jp_p << PBUS_JOYPAD_SHIFT_P) |
-		(jp_x << PBUS_JOYPAD_SHIFT_X) |
-		(jp_rt << PBUS_JOYPAD_SHIFT_RT) |
-		(jp_lt << PBUS_JOYPAD_SHIFT_LT));
-
-
-	temp_word = (pbus_buf[0] << 24) | (pbus_buf[1] << 16) | (pbus_buf[2] << 8) | (pbus_buf[3] << 0);
-	//ram_ptr[ dst&0x1fffff ] = temp_word;  // ram_ptr is now BYTE addressed!
-
-	fprintf(logfile, "PBUS DMA  toRAM: 0x%08X  len: 0x%08X  fromRAM: 0x%08X\n", str, len, end);
-
-	/*
-	for (int i = 0; i < 8; i+=4) {
-			ram_ptr[ (dst&0x1fffff)+i ] = pbus_buf[i+0] << 24;
-			temp_word = ram_ptr[ (dst&0x1fffff)+i ];
-			ram_ptr[ (dst&0x1fffff)+i ] = temp_word&0xff00ffff | (pbus_buf[i+1] << 16);
-			temp_word = ram_ptr[ (dst&0x1fffff)+i ];
-			ram_ptr[ (dst&0x1fffff)+i ] = temp_word&0xffff00ff | (pbus_buf[i+2] << 8);
-			temp_word = ram_ptr[ (dst&0x1fffff)+i ];
-			ram_ptr[ (dst&0x1fffff)+i ] = temp_word&0xffffff00 | (pbus_buf[i+3] << 0);
-	}
-	*/
-
-	//pbus_buf[pbus_idx++] = 0xffffffff;    // Pad the last word??
-
-	//top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma23_curaddr += len;
-	//top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma23_nextaddr += len;
-
-	//0x8000FFFF 0xFFFFFFFF 0xFFFF0000 0xFFFFFFFF
-	//0xFFFFFFFF 0xFFFFFFFF 0xFFFFFFFF 0xFFFFFFFF
-	ram_ptr[str+0]= pbus_buf[0]; ram_ptr[str+1]= pbus_buf[1]; ram_ptr[str+2]= 0xff; ram_ptr[str+3]= 0xff,
-	ram_ptr[str+4]= 0xff; ram_ptr[str+5]= 0xff; ram_ptr[str+6]= 0xff; ram_ptr[str+7]= 0xff;
-	ram_ptr[str+8]= 0xff; ram_ptr[str+9]= 0xff; ram_ptr[str+10]=0xff; ram_ptr[str+11]=0xff,
-	ram_ptr[str+12]=0xff; ram_ptr[str+13]=0xff; ram_ptr[str+14]=0xff; ram_ptr[str+15]=0xff;
-	ram_ptr[str+16]=0xff; ram_ptr[str+17]=0xff; ram_ptr[str+18]=0x00; ram_ptr[str+19]=0x00,
-	ram_ptr[str+20]=0xff; ram_ptr[str+21]=0xff; ram_ptr[str+22]=0xff; ram_ptr[str+23]=0xff;
-	ram_ptr[str+24]=0xff; ram_ptr[str+25]=0xff; ram_ptr[str+26]=0xff; ram_ptr[str+27]=0xff,
-	ram_ptr[str+28]=0xff; ram_ptr[str+29]=0xff; ram_ptr[str+30]=0xff; ram_ptr[str+31]=0xff;
-
-	ram_ptr[str+32]=0xff; ram_ptr[str+33]=0xff; ram_ptr[str+34]=0xff; ram_ptr[str+35]=0xff;
-
-	top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma23_curlen = 0xfffffffc;	// Set the length to -4 when done?
-	top->rootp->core_3do__DOT__clio_inst__DOT__irq1_pend |= 1;              // Bit 0 of irq1_pend is the PBUS DMA Done bit.
-	top->rootp->core_3do__DOT__madam_inst__DOT__mctl &= ~0x8000;			// Clear bit 15 (PBUS DMA Enable) of mctl reg.
-
-	/*
-	for (int i=str; i<end; i+=4) {
-		fprintf(logfile, "0x%08X: ", i);
-		fprintf(logfile, "0x%02X%02X%02X%02X\n", ram_ptr[i+0], ram_ptr[i+1], ram_ptr[i+2], ram_ptr[i+3]);
-	}
-	*/
-}
-
-
-void opera_tick() {
-	opera_3do_process_frame(&opera_line, &opera_field);	// Tweaked, to render one LINE at a time. ElectronAsh.
-
-	//opera_arm_execute();		// <- This contains all of our Opera fprintfs.
-	//opera_clock_push_cycles(main_time);
 
-	//if (opera_clock_dsp_queued()) libopera_callback(EXT_DSP_TRIGGER, NULL);
-	//if (opera_clock_dsp_queued()) opera_lr_dsp_process();
-
-	if (opera_clock_dsp_queued()) {
-		//g_DSP_BUF[g_DSP_BUF_IDX++] = opera_dsp_loop();
-		//g_DSP_BUF_IDX &= DSP_BUF_SIZE_MASK;
-		sound_out = opera_dsp_loop();	// Almost certain this is the DSP sound output. ElectronAsh.
-		//fprintf(soundfile, "Sound 0x%08X: ", sound_out);
-		if (soundtrace) {
-			fputc( (sound_out>>24) & 0xff, soundfile);
-			fputc( (sound_out>>16) & 0xff, soundfile);
-			fputc( (sound_out>>8)  & 0xff, soundfile);
-			fputc( (sound_out>>0)  & 0xff, soundfile);
-		}
-	}
+static void sim_print_to_console(char c) {
+	MyAddLog("%c", c);
 }
 
-static void sim_clio_handle_dma(uint32_t val_)
-{
-	if (val_ & 0x00100000)	// Check if the Xbus DMA Enable bit in the write to 0x03400304 (CLIO dmactrl) is set.
-	{
-		int len;		// Needs to be a signed int, so the while (len >= 0) below works.
-		uint32_t trg;
-		uint8_t b0, b1, b2, b3;
-
-		trg = top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma20_curaddr;	// 0x03300540. DMA Target (Source/Dest address). Likely always the dest, for a CDROM DMA?
-		len = top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma20_curlen;	// 0x03300544. DMA Length (in BYTES).
-
-		fprintf(logfile, "Xbus DMA  trg: 0x%08X  len: 0x%08X\n", trg, len);
-
-		top->rootp->core_3do__DOT__clio_inst__DOT__dmactrl &= ~0x00100000;	// Clear bit [20] in the CLIO dmactrl reg.
-		top->rootp->core_3do__DOT__clio_inst__DOT__expctl &= ~0x80;			// Clear bit [7] in the CLIO expctl reg "DMA has control of Xbus".
-
-		//if (top->rootp->core_3do__DOT__clio_inst__DOT__expctl & 0x200)	// XB_DmadirectION bit.There was an "else" after this "if" in
-		//{																	// the Opera source, but the code was identical.
-			while (len >= 0)												// Very likely because the CDROM drive is always Xbus -> RAM. ElectronAsh.
-			{
-				b3 = sim_xbus_fifo_get_data();
-				b2 = sim_xbus_fifo_get_data();
-				b1 = sim_xbus_fifo_get_data();
-				b0 = sim_xbus_fifo_get_data();
-
-				//fprintf(logfile, "Addr: 0x%08X  0x%02X%02X%02X%02X\n", trg, b0, b1, b2, b3);
-
-				// Mask address, so DMA can only target 2MB main DRAM ,or 1MB VRAM (but not registers?). ElectronAsh.
-				if (trg < 0x200000) {
-					ram_ptr[ (trg & 0x1fffff) + 0 ] = b0;
-					ram_ptr[ (trg & 0x1fffff) + 1 ] = b1;
-					ram_ptr[ (trg & 0x1fffff) + 2 ] = b2;
-					ram_ptr[ (trg & 0x1fffff) + 3 ] = b3;
-				}
-				/*
-				else {
-					vram_ptr[ (trg & 0xfffff) + 0 ] = b0;
-					vram_ptr[ (trg & 0xfffff) + 1 ] = b1;
-					vram_ptr[ (trg & 0xfffff) + 2 ] = b2;
-					vram_ptr[ (trg & 0xfffff) + 3 ] = b3;
-				}
-				*/
-
-				trg += 4;
-				len -= 4;
-			}
-
-			top->rootp->core_3do__DOT__clio_inst__DOT__expctl |= 0x80;	// Set bit [7] in the CLIO expctl reg "ARM has control of Xbus".
-		//}
-
-		top->rootp->core_3do__DOT__madam_inst__DOT__dma_stack_inst__DOT__dma20_curlen = 0xFFFFFFFC;	// Length reg should end up with this value once it wraps 0?
-		top->rootp->core_3do__DOT__clio_inst__DOT__irq0_pend |= (1<<29);		// Set the IRQ0 Pending bit, for "XBus DMA Done"!
-	}
-}
-
-static
-void
-sim_if_set_set_reset(uint32_t* output_,
-	uint32_t  val_,
-	uint32_t  mask_chk_,
-	uint32_t  mask_set_)
-{
-	if ((val_ & mask_chk_) == mask_chk_)
-	{
-		*output_ = ((val_ & mask_set_) ?
-			(*output_ | mask_set_) :
-			(*output_ & ~mask_set_));
-	}
-}
-
-void handle_adbio_write() {
-	sim_if_set_set_reset(&top->rootp->core_3do__DOT__clio_inst__DOT__adbio_reg, top->o_wb_dat, 0x10, 0x01);
-	sim_if_set_set_reset(&top->rootp->core_3do__DOT__clio_inst__DOT__adbio_reg, top->o_wb_dat, 0x20, 0x02);
-	sim_if_set_set_reset(&top->rootp->core_3do__DOT__clio_inst__DOT__adbio_reg, top->o_wb_dat, 0x40, 0x04);
-	sim_if_set_set_reset(&top->rootp->core_3do__DOT__clio_inst__DOT__adbio_reg, top->o_wb_dat, 0x80, 0x08);
-}
-
-int verilate() {
-	if (!Verilated::gotFinish()) {
-		if (main_time < 50) {
-			top->reset_n = 0;		// Assert reset (active LOW)
-			frame_count = 0;
-		}
-		if (main_time == 50) {		// Do == here, so we can still reset it in the main loop.
-			top->reset_n = 1;		// Deassert reset./
-		}
-
-		if (top->reset_n) {
-			/*
-			if (top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_writeback__DOT__o_trace_valid &&
-				top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_writeback__DOT__o_trace_uop_last)
-				opera_tick();
-			*/
-
-			map_bios = 0;
-			top->rootp->core_3do__DOT__madam_inst__DOT__map_bios = 0;
-			//top->rootp->core_3do__DOT__madam_inst__DOT__nextccb = 0x000BB770;
-			//top->rootp->core_3do__DOT__madam_inst__DOT__nextccb = 0x000B7ee4;
-			//top->rootp->core_3do__DOT__madam_inst__DOT__nextccb = 0x000bc4f0;
-			//top->rootp->core_3do__DOT__madam_inst__DOT__nextccb = 0x000Bfc70;
-
-			top->rootp->core_3do__DOT__madam_inst__DOT__nextccb = 0x00000000;
-		}
-
-		pix_count++;
-
-		uint16_t spr_wi = (top->rootp->core_3do__DOT__madam_inst__DOT__pre1&0x7ff) + 1;
-		//uint16_t spr_wi = spr_width;
-
-		/*
-		clut[0x00] = 0x35ED42; clut[0x01] = 0x3035EF; clut[0x02] = 0x31CD35; clut[0x03] = 0xAB2DAD; clut[0x04] = 0x3E0E29; clut[0x05] = 0x8B4650; clut[0x06] = 0x256A25; clut[0x07] = 0x492128;
-		clut[0x08] = 0x467142; clut[0x09] = 0x514E92; clut[0x0a] = 0x56D44E; clut[0x0b] = 0xB456B2; clut[0x0c] = 0x5EF456; clut[0x0d] = 0xD518E6; clut[0x0e] = 0x1D0614; clut[0x0f] = 0xC56335;
-		clut[0x10] = 0x5F176B; clut[0x11] = 0x587399; clut[0x12] = 0x77BA7F; clut[0x13] = 0xFF0C62; clut[0x14] = 0x7BDE00; clut[0x15] = 0x010000; clut[0x16] = 0x000000; clut[0x17] = 0x000000;
-		clut[0x18] = 0x000000; clut[0x19] = 0x003FE6; clut[0x1a] = 0x462000; clut[0x1b] = 0x0B8DB0; clut[0x1c] = 0x000B8D; clut[0x1d] = 0xFC000B; clut[0x1e] = 0xB4F400; clut[0x1f] = 0x800000;
-		*/
-
-		// PLUT, for coded_packed_6bpp.cel...
-		clut[0x00] = 0x7FFF; clut[0x01] = 0x698C; clut[0x02] = 0x64E8; clut[0x03] = 0x60A6; clut[0x04] = 0x7BBD; clut[0x05] = 0x6B5B; clut[0x06] = 0x5EF7; clut[0x07] = 0x4A52;
-		clut[0x08] = 0x2951; clut[0x09] = 0x3192; clut[0x0a] = 0x4E73; clut[0x0b] = 0x2110; clut[0x0c] = 0x0C6C; clut[0x0d] = 0x56B5; clut[0x0f] = 0x10AE; clut[0x17] = 0x39CE;
-		clut[0x10] = 0x294A; clut[0x11] = 0x1084; clut[0x12] = 0x18C0; clut[0x13] = 0x2528; clut[0x14] = 0x318C; clut[0x15] = 0x2108; clut[0x16] = 0x0840; clut[0x17] = 0x2921;
-		clut[0x18] = 0x0000; clut[0x19] = 0x3161; clut[0x1a] = 0x3DC2; clut[0x1b] = 0x4A02; clut[0x1c] = 0x5E83; clut[0x1d] = 0x6AE3; clut[0x1f] = 0x7B64; clut[0x27] = 0x7F84;
-
-		/*
-		// PLUT, for one of the BIOS "Please Insert CD" screen CELs...
-		clut[0x00] = 0x35ED; clut[0x01] = 0x4230; clut[0x02] = 0x35EF; clut[0x03] = 0x31CD; clut[0x04] = 0x35AB; clut[0x05] = 0x2DAD; clut[0x06] = 0x3E0E; clut[0x07] = 0x298B;
-		clut[0x08] = 0x4650; clut[0x09] = 0x256A; clut[0x0a] = 0x2549; clut[0x0b] = 0x2128; clut[0x0c] = 0x4671; clut[0x0d] = 0x4251; clut[0x0e] = 0x4E92; clut[0x0f] = 0x56D4;
-		clut[0x10] = 0x4EB4; clut[0x11] = 0x56B2; clut[0x12] = 0x5EF4; clut[0x13] = 0x56D5; clut[0x14] = 0x18E6; clut[0x15] = 0x1D06; clut[0x16] = 0x14C5; clut[0x17] = 0x6335;
-		clut[0x18] = 0x5F17; clut[0x19] = 0x6B58; clut[0x1a] = 0x7399; clut[0x1b] = 0x77BA; clut[0x1c] = 0x7FFF; clut[0x1d] = 0x0C62; clut[0x1e] = 0x7BDE; clut[0x1f] = 0x0001;
-		clut[0x20] = 0x0000; clut[0x21] = 0x0000; clut[0x22] = 0x0000; clut[0x23] = 0x0000; clut[0x24] = 0x0000; clut[0x25] = 0x0000; clut[0x26] = 0x3FE6; clut[0x27] = 0x4620;
-		clut[0x28] = 0x000B; clut[0x29] = 0x8DB0; clut[0x2a] = 0x000B; clut[0x2b] = 0x8DFC; clut[0x2c] = 0x000B; clut[0x2d] = 0xB4F4; clut[0x2e] = 0x0080; clut[0x2f] = 0x0000;
-		*/
-
-		//if (top->i_wb_dat==0x00f00104) run_enable = 0;
-
-		/*
-		//if (my_x == spr_wi || top->rootp->core_3do__DOT__madam_inst__DOT__unpacker_inst__DOT__eol) {
-		if (top->rootp->core_3do__DOT__madam_inst__DOT__unpacker_inst__DOT__eol) {
-			my_x = 0;
-			my_y++;
-		}
-		if (top->rootp->core_3do__DOT__madam_inst__DOT__unpacker_inst__DOT__pix_valid) {
-			uint16_t colour = clut[top->rootp->core_3do__DOT__madam_inst__DOT__unpacker_inst__DOT__col_out];
-			rgb[0] = (colour & 0x7C00) >> 7;
-			rgb[1] = (colour & 0x03E0) >> 2;
-			rgb[2] = (colour & 0x001F) << 3;
-			disp_ptr[ ((my_y*320) + my_x) & 0xfffff] = 0xff<<24 | rgb[2]<<16 | rgb[1]<<8 | rgb[0];	// ABGR.
-			my_x++;
-		}
-		*/
-
-		//jp_a = top->rootp->core_3do__DOT__clio_inst__DOT__field;	// Toggling "A" button, to test joypad. (works in BIOS joypad test)
-
-		//cur_pc = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__pc_from_alu;
-		//cur_pc = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_alu_main__DOT__o_pc_plus_8_ff;
-		//cur_pc = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__postalu_pc_plus_8_ff - 8;
-		cur_pc = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_writeback__DOT__i_pc_plus_8_buf_ff - 8;
-
-		//if (top->mem_addr==0x000011664) run_enable = 0;
-
-		//if (cur_pc==0x00000ee0) run_enable=0;
-		//if (top->mem_addr==0x0000FEDC && top->o_wb_we) run_enable = 0;
-
-		/*
-		if (frame_count==30 && top->rootp->core_3do__DOT__clio_inst__DOT__hcnt==0 && top->rootp->core_3do__DOT__clio_inst__DOT__vcnt==9) {
-			run_enable = 0;
-			//inst_trace = 1;
-		}
-		*/
-
-		/*
-		if (cur_pc == 0x000117F8) {
-			inst_trace = 1;
-			//run_enable = 0;
-		}
-		*/
-
-		uint32_t decode_word[16];
-		uint32_t issue_word[16];
-		uint32_t shifter_word[16];
-		uint32_t alu_word[16];
-		uint32_t memory_word[16];
-		uint32_t rb_word[16];
-		for (int i = 0; i < 16; i++) {
-			decode_word[i] = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__decode_decompile[i];
-			issue_word[i] = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__issue_decompile[i];
-			shifter_word[i] = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__shifter_decompile[i];
-			alu_word[i] = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__alu_decompile[i];
-			memory_word[i] = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__memory_decompile[i];
-			rb_word[i] = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__rb_decompile[i];
-		}
-
-		for (int i = 0; i < 64; i += 4) {
-			decode_string[i + 0] = decode_word[(i >> 2)] >> 0; decode_string[i + 1] = decode_word[(i >> 2)] >> 8; decode_string[i + 2] = decode_word[(i >> 2)] >> 16; decode_string[i + 3] = decode_word[(i >> 2)] >> 24;
-			issue_string[i + 0] = issue_word[(i >> 2)] >> 0; issue_string[i + 1] = issue_word[(i >> 2)] >> 8; issue_string[i + 2] = issue_word[(i >> 2)] >> 16; issue_string[i + 3] = issue_word[(i >> 2)] >> 24;
-			shifter_string[i + 0] = shifter_word[(i >> 2)] >> 0; shifter_string[i + 1] = shifter_word[(i >> 2)] >> 8; shifter_string[i + 2] = shifter_word[(i >> 2)] >> 16; shifter_string[i + 3] = shifter_word[(i >> 2)] >> 24;
-			alu_string[i + 0] = alu_word[(i >> 2)] >> 0; alu_string[i + 1] = alu_word[(i >> 2)] >> 8; alu_string[i + 2] = alu_word[(i >> 2)] >> 16; alu_string[i + 3] = alu_word[(i >> 2)] >> 24;
-			memory_string[i + 0] = memory_word[(i >> 2)] >> 0; memory_string[i + 1] = memory_word[(i >> 2)] >> 8; memory_string[i + 2] = memory_word[(i >> 2)] >> 16; memory_string[i + 3] = memory_word[(i >> 2)] >> 24;
-			rb_string[i + 0] = rb_word[(i >> 2)] >> 0; rb_string[i + 1] = rb_word[(i >> 2)] >> 8; rb_string[i + 2] = rb_word[(i >> 2)] >> 16; rb_string[i + 3] = rb_word[(i >> 2)] >> 24;
-		}
-
-		strrev(decode_string);
-		strrev(issue_string);
-		strrev(shifter_string);
-		strrev(alu_string);
-		strrev(memory_string);
-		strrev(rb_string);
-
-		/*
-		if (inst_trace && decode_string != "IGNORE" && top->o_wb_stb && top->i_wb_ack) {
-			//fprintf(inst_file, "PC: 0x%08X   Inst: %s\n", cur_pc, decode_string);
-			fprintf(logfile, "PC: 0x%08X   Inst: %s\n", cur_pc, decode_string);
-		}
-		*/
-
-		/*
-		if (top->mem_addr == 0x03400000 && top->o_wb_we) {
-			run_enable = 0;
-			inst_trace = 1;
-		}
-		*/
-
-		if (trace) {
-			if ( (cur_pc < (old_pc-8)) || (cur_pc > (old_pc+8)) ) {
-				uint32_t arm_reg[40];
-				for (int i = 0; i < 40; i++) {
-					arm_reg[i] = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_writeback__DOT__u_zap_register_file__DOT__mem[i];
-				}
-				//fprintf(logfile, "PC: 0x%08X  Addr: 0x%08X  dat_i: 0x%08X  dat_o: 0x%08X  write: %d\n", cur_pc, top->mem_addr, top->i_wb_dat, top->o_wb_dat, top->o_wb_we);
-				fprintf(logfile, "PC: 0x%08X  Addr: 0x%08X  dat_i: 0x%08X  dat_o: 0x%08X  write: %d\n", cur_pc, top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__postalu_address_ff, top->i_wb_dat, top->o_wb_dat, top->o_wb_we);
-
-				//fprintf(logfile, "          PC: 0x%08X", top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_issue_main__DOT__o_pc_ff);
-				/*
-				fprintf(logfile, "          PC: 0x%08X\n", cur_pc);
-				fprintf(logfile, "          R0: 0x%08X\n", arm_reg[0]);
-				fprintf(logfile, "          R1: 0x%08X\n", arm_reg[1]);
-				fprintf(logfile, "          R2: 0x%08X\n", arm_reg[2]);
-				fprintf(logfile, "          R3: 0x%08X\n", arm_reg[3]);
-				fprintf(logfile, "          R4: 0x%08X\n", arm_reg[4]);
-				fprintf(logfile, "          R5: 0x%08X\n", arm_reg[5]);
-				fprintf(logfile, "          R6: 0x%08X\n", arm_reg[6]);
-				fprintf(logfile, "          R7: 0x%08X\n", arm_reg[7]);
-				fprintf(logfile, "          R8: 0x%08X\n", arm_reg[8]);
-				fprintf(logfile, "          R9: 0x%08X\n", arm_reg[9]);
-				fprintf(logfile, "         R10: 0x%08X\n", arm_reg[10]);
-				fprintf(logfile, "         R11: 0x%08X\n", arm_reg[11]);
-				fprintf(logfile, "         R12: 0x%08X\n", arm_reg[12]);
-				fprintf(logfile, "      SP R13: 0x%08X\n", arm_reg[13]);
-				fprintf(logfile, "      LR R14: 0x%08X\n", arm_reg[14]);
-				*/
-				old_pc = cur_pc;
-			}
-		}
-
-		//top->i_wb_ack = top->o_wb_stb;
-
-		if ( (top->o_wb_stb && top->i_wb_ack) || top->rootp->core_3do__DOT__madam_inst__DOT__dma_ack) {
-			// Handle writes to Main RAM, with byte masking...
-			if (top->rootp->core_3do__DOT__madam_inst__DOT__dram_cs && top->mem_wr) {                // 2MB masked.
-				//printf("Main RAM Write!  Addr:0x%08X  Data:0x%08X  BE:0x%01X\n", top->mem_addr&0xFFFFF, top->o_wb_dat, top->o_wb_sel);
-				if (top->o_wb_sel & 8) ram_ptr[(top->mem_addr & 0x1ffffc) + 0] = (top->o_wb_dat >> 24) & 0xff;  // ram_ptr is now BYTE addressed.
-				if (top->o_wb_sel & 4) ram_ptr[(top->mem_addr & 0x1ffffc) + 1] = (top->o_wb_dat >> 16) & 0xff;  // Mask mem_addr to 2MB, ignore the lower two bits, add the offset.
-				if (top->o_wb_sel & 2) ram_ptr[(top->mem_addr & 0x1ffffc) + 2] = (top->o_wb_dat >> 8)  & 0xff;
-				if (top->o_wb_sel & 1) ram_ptr[(top->mem_addr & 0x1ffffc) + 3] = (top->o_wb_dat >> 0)  & 0xff;
-			}
-
-			// Handle writes to VRAM, with byte masking...
-			if (top->rootp->core_3do__DOT__madam_inst__DOT__vram_cs && top->mem_wr) {                // 1MB masked.
-				//printf("VRAM Write!  Addr:0x%08X  Data:0x%08X  BE:0x%01X\n", top->mem_addr&0xFFFFF, top->o_wb_dat, top->o_wb_sel);
-				if (top->o_wb_sel & 8) vram_ptr[(top->mem_addr & 0xffffc) + 0] = (top->o_wb_dat >> 24) & 0xff;  // vram_ptr is now BYTE addressed.
-				if (top->o_wb_sel & 4) vram_ptr[(top->mem_addr & 0xffffc) + 1] = (top->o_wb_dat >> 16) & 0xff;  // Mask mem_addr to 1MB, ignore the lower two bits, add the offset.
-				if (top->o_wb_sel & 2) vram_ptr[(top->mem_addr & 0xffffc) + 2] = (top->o_wb_dat >> 8)  & 0xff;
-				if (top->o_wb_sel & 1) vram_ptr[(top->mem_addr & 0xffffc) + 3] = (top->o_wb_dat >> 0)  & 0xff;
-			}
-
-			// Handle writes to NVRAM...
-			if (top->mem_addr >= 0x03140000 && top->mem_addr <= 0x0315ffff && top->mem_wr) {          // 128KB Masked.
-				nvram_ptr[ (top->mem_addr>>2) & 0x1ffff] = top->o_wb_dat & 0xff;       // Only writes the lower byte from the core to 8-bit NVRAM. mem_addr is the BYTE address, so shouldn't need shifting.
-			}
-
-			/*if ((top->mem_addr == 0x03400400) && top->o_wb_we) {	// XBUS direction.
-				if (!(top->o_wb_dat & 0x800)) top->rootp->core_3do__DOT__clio_inst__DOT__expctl = top->o_wb_dat;
-			}*/
-			
-			uint8_t rom_byte0 = rom_ptr[(top->mem_addr & 0xffffc) + 0] & 0xff;      // rom_ptr is now BYTE addressed.
-			uint8_t rom_byte1 = rom_ptr[(top->mem_addr & 0xffffc) + 1] & 0xff;      // Mask mem_addr to 1MB, ignorring the lower two bits, add the offset.
-			uint8_t rom_byte2 = rom_ptr[(top->mem_addr & 0xffffc) + 2] & 0xff;
-			uint8_t rom_byte3 = rom_ptr[(top->mem_addr & 0xffffc) + 3] & 0xff;
-			uint32_t rom_word = rom_byte0 << 24 | rom_byte1 << 16 | rom_byte2 << 8 | rom_byte3;
-
-			uint8_t rom2_byte0 = rom2_ptr[(top->mem_addr & 0xffffc) + 0] & 0xff;    // rom2_ptr is now BYTE addressed.
-			uint8_t rom2_byte1 = rom2_ptr[(top->mem_addr & 0xffffc) + 1] & 0xff;    // Mask mem_addr to 1MB, ignorring the lower two bits, add the offset.
-			uint8_t rom2_byte2 = rom2_ptr[(top->mem_addr & 0xffffc) + 2] & 0xff;
-			uint8_t rom2_byte3 = rom2_ptr[(top->mem_addr & 0xffffc) + 3] & 0xff;
-			uint32_t rom2_word = rom2_byte0 << 24 | rom2_byte1 << 16 | rom2_byte2 << 8 | rom2_byte3;
-			//uint32_t rom2_word = 0x00000000;	// TESTING. Disable the Kanji ROM for now. Text on BIOS should then be in English.
-
-			uint8_t ram_byte0 = ram_ptr[(top->mem_addr & 0x1ffffc) + 0] & 0xff;     // ram_ptr is now BYTE addressed.
-			uint8_t ram_byte1 = ram_ptr[(top->mem_addr & 0x1ffffc) + 1] & 0xff;     // Mask mem_addr to 2MB, ignorring the lower two bits, add the offset.
-			uint8_t ram_byte2 = ram_ptr[(top->mem_addr & 0x1ffffc) + 2] & 0xff;
-			uint8_t ram_byte3 = ram_ptr[(top->mem_addr & 0x1ffffc) + 3] & 0xff;
-			uint32_t ram_word = ram_byte0 << 24 | ram_byte1 << 16 | ram_byte2 << 8 | ram_byte3;
-
-			uint8_t vram_byte0 = vram_ptr[(top->mem_addr & 0xffffc) + 0] & 0xff;     // vram_ptr is now BYTE addressed.
-			uint8_t vram_byte1 = vram_ptr[(top->mem_addr & 0xffffc) + 1] & 0xff;     // Mask mem_addr to 1MB, ignorring the lower two bits, add the offset.
-			uint8_t vram_byte2 = vram_ptr[(top->mem_addr & 0xffffc) + 2] & 0xff;
-			uint8_t vram_byte3 = vram_ptr[(top->mem_addr & 0xffffc) + 3] & 0xff;
-			uint32_t vram_word = vram_byte0 << 24 | vram_byte1 << 16 | vram_byte2 << 8 | vram_byte3;
-
-			//if (top->mem_addr >= 0x03100000 && top->mem_addr <= 0x034FFFFF && top->mem_addr != 0x03400034) fprintf(logfile, "Addr: 0x%08X ", top->mem_addr);
-			if (top->mem_addr >= 0x03100000 && top->mem_addr <= 0x034FFFFF && top->mem_addr != 0x03400034) fprintf(logfile, "Addr: 0x%08X ", top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__postalu_address_ff);
-			
-			// Handle Xbus writes...
-			if ((top->mem_addr >= 0x03400500) && (top->mem_addr <= 0x0340053f) && top->o_wb_we) { fprintf(logfile, "CLIO sel        "); sim_xbus_set_sel(top->o_wb_dat & 0xff); }
-			else if ((top->mem_addr >= 0x03400540) && (top->mem_addr <= 0x0340057f) && top->o_wb_we) { fprintf(logfile, "CLIO poll       "); sim_xbus_set_poll(top->o_wb_dat & 0xff); }
-			else if ((top->mem_addr >= 0x03400580) && (top->mem_addr <= 0x034005bf) && top->o_wb_we) { fprintf(logfile, "CLIO CmdStFIFO  "); sim_xbus_fifo_set_cmd(top->o_wb_dat & 0xff); }		// on FIFO Filled execute the command.
-			else if ((top->mem_addr >= 0x034005C0) && (top->mem_addr <= 0x034005ff) && top->o_wb_we) { fprintf(logfile, "CLIO Data FIFO  "); sim_xbus_fifo_set_data(top->o_wb_dat & 0xff); }	// on FIFO Filled execute the command.
-
-			// Tech manual suggests "Any write to this area will unmap the BIOS".
-			if (top->rootp->core_3do__DOT__madam_inst__DOT__dram_cs && top->o_wb_we) map_bios = 0;
-
-			// Main RAM reads...
-			//if (top->mem_addr >= 0x00000000 && top->mem_addr <= 0x001FFFFF) {
-			//if (top->rootp->core_3do__DOT__madam_inst__DOT__dram_cs) {
-				if (map_bios) top->i_wb_dat = rom_word;
-				else top->i_wb_dat = ram_word;
-			//}
-
-			if (top->mem_addr >= 0x00200000 && top->mem_addr <= 0x003FFFFF) { /*fprintf(logfile, "VRAM            ");*/ top->i_wb_dat = vram_word; }
-
-			// BIOS reads...
-			//else if (top->mem_addr >= 0x03000510 && top->mem_addr <= 0x03000510) top->i_wb_dat = 0xE1A00000;  // NOP ! (MOV R0,R0) Skip another delay.
-			//else if (top->mem_addr >= 0x03000504 && top->mem_addr <= 0x0300050C) top->i_wb_dat = 0xE1A00000;  // NOP ! (MOV R0,R0) Skip another delay.
-			//else if (top->mem_addr >= 0x03000340 && top->mem_addr <= 0x03000340) top->i_wb_dat = 0xE1A00000;  // NOP ! (MOV R0,R0) Skip endless loop on mem size check fail.
-			//else if (top->mem_addr >= 0x030006a8 && top->mem_addr <= 0x030006b0) top->i_wb_dat = 0xE1A00000;  // NOP ! (MOV R0,R0) Skip test_vram_svf.
-			else if (top->mem_addr >= 0x03000000 && top->mem_addr <= 0x030FFFFF) { /*fprintf(logfile, "BIOS            ");*/
-				if (rom2_select == 0) top->i_wb_dat = rom_word; else { top->i_wb_dat = rom2_word; }
-			}
-
-			//else if (top->mem_addr >= 0x03100000 && top->mem_addr <= 0x0313FFFF) { fprintf(logfile, "Brooktree       "); top->i_wb_dat = 0xBADACCE5; }
-			else if (top->mem_addr >= 0x03100000 && top->mem_addr <= 0x0313FFFF) { fprintf(logfile, "Brooktree       "); top->i_wb_dat = 0x0000006A; }
-
-			else if (top->mem_addr >= 0x03140000 && top->mem_addr <= 0x0315FFFF) { fprintf(logfile, "NVRAM           "); top->i_wb_dat = nvram_ptr[ (top->mem_addr>>2) & 0x1ffff] & 0xff; }
-			else if (top->mem_addr == 0x03180000 && top->o_wb_we) { fprintf(logfile, "DiagPort        "); sim_diag_port_send(top->o_wb_dat); }
-			else if (top->mem_addr == 0x03180000 && !top->o_wb_we) { fprintf(logfile, "DiagPort        "); top->i_wb_dat = sim_diag_port_get(); }
-			else if (top->mem_addr >= 0x03180004 && top->mem_addr <= 0x031BFFFF) { fprintf(logfile, "Slow Bus        "); top->i_wb_dat = 0x00000000; }
-
-			else if (top->mem_addr >= 0x03200000 && top->mem_addr <= 0x03200fff && !top->o_wb_we) { fprintf(logfile, "VRAM SVF Source "); svf_set_source(); top->i_wb_dat = 0x00000000; }
-			else if (top->mem_addr >= 0x03200000 && top->mem_addr <= 0x03200fff && top->o_wb_we) { fprintf(logfile, "VRAM SVF Copy   "); svf_page_copy(); }
-			else if (top->mem_addr >= 0x03202000 && top->mem_addr <= 0x03202fff && top->o_wb_we) { fprintf(logfile, "VRAM SVF Color  "); svf_set_color(); }
-			else if (top->mem_addr >= 0x03204000 && top->mem_addr <= 0x03204fff && top->o_wb_we) { fprintf(logfile, "VRAM SVF Flash  ");  svf_flash_write(); }
-			else if (top->mem_addr >= 0x03206000 && top->mem_addr <= 0x03206fff) { fprintf(logfile, "VRAM SVF Refresh"); top->i_wb_dat = 0xBADACCE5; }
-
-			else if (top->mem_addr >= 0x032F0000 && top->mem_addr <= 0x032FFFFF) { fprintf(logfile, "Unknown         "); top->i_wb_dat = 0xBADACCE5; }
-
-
-			// Every core access from here down, gets its data from the Verilog MADAM / CLIO...
-			// 
-			// MADAM...
-			if (top->mem_addr == 0x03300000 && !top->o_wb_we) { fprintf(logfile, "MADAM Revision  "); }
-			if (top->mem_addr == 0x03300000 && top->o_wb_we) { fprintf(logfile, "MADAM Print     "); MyAddLog("%c", top->o_wb_dat & 0xff); printf("%c", top->o_wb_dat & 0xff); }
-			
-			if (top->mem_addr == 0x03300004) { fprintf(logfile, "MADAM msysbits  "); }
-			if (top->mem_addr == 0x03300008) { fprintf(logfile, "MADAM mctl      "); }
-			if (top->mem_addr == 0x0330000C) { fprintf(logfile, "MADAM sltime    "); }
-			if (top->mem_addr >= 0x03300010 && top->mem_addr <= 0x0330001f) { fprintf(logfile, "MADAM MultiChip "); }
-
-			if (top->mem_addr == 0x03300020) { fprintf(logfile, "MADAM Abortbits "); }
-			if (top->mem_addr == 0x03300024) { fprintf(logfile, "MADAM Privbits  "); }
-			if (top->mem_addr == 0x03300028) { fprintf(logfile, "MADAM StatBits  "); }
-			if (top->mem_addr == 0x0330002c) { fprintf(logfile, "MADAM Rsrvd 2c  "); }
-
-			if (top->mem_addr == 0x03300030) { fprintf(logfile, "MADAM Rsrvd 30  "); }
-			if (top->mem_addr == 0x03300040) { fprintf(logfile, "MADAM Diag/hcnt "); }
-			if (top->mem_addr == 0x03300044) { fprintf(logfile, "MADAM Spare 44  "); }
-			if (top->mem_addr == 0x03300048) { fprintf(logfile, "MADAM Rsrvd 48  "); }
-			if (top->mem_addr == 0x03300080) { fprintf(logfile, "MADAM Rsrvd 80  "); }
-
-			if (top->mem_addr == 0x03300100) { fprintf(logfile, "MADAM CELStart  "); }
-			if (top->mem_addr == 0x03300104) { fprintf(logfile, "MADAM CELStop   "); }
-			if (top->mem_addr == 0x03300108) { fprintf(logfile, "MADAM CELCont   "); }
-			if (top->mem_addr == 0x0330010c) { fprintf(logfile, "MADAM CELPause  "); }
-			if (top->mem_addr == 0x03300110) { fprintf(logfile, "MADAM CCBCtl0   "); }
-			if (top->mem_addr == 0x03300114) { fprintf(logfile, "MADAM Rsrvd 114 "); }
-			if (top->mem_addr == 0x03300120) { fprintf(logfile, "MADAM CCB_PIXC  "); }
-
-			if (top->mem_addr == 0x03300130) { fprintf(logfile, "MADAM RegisCtl0 "); }
-			if (top->mem_addr == 0x03300134) { fprintf(logfile, "MADAM RegisCtl1 "); }
-			if (top->mem_addr == 0x03300138) { fprintf(logfile, "MADAM RegisCtl2 "); }
-			if (top->mem_addr == 0x0330013c) { fprintf(logfile, "MADAM RegisCtl3 "); }
-
-			if (top->mem_addr == 0x03300140) { fprintf(logfile, "MADAM XYPosH    "); }
-			if (top->mem_addr == 0x03300144) { fprintf(logfile, "MADAM XYPosL    "); }
-			if (top->mem_addr == 0x03300148) { fprintf(logfile, "MADAM Line_dXYH "); }
-			if (top->mem_addr == 0x0330014c) { fprintf(logfile, "MADAM Line_dXYL "); }
-			if (top->mem_addr == 0x03300150) { fprintf(logfile, "MADAM dXYH      "); }
-			if (top->mem_addr == 0x03300154) { fprintf(logfile, "MADAM dXYL      "); }
-			if (top->mem_addr == 0x03300158) { fprintf(logfile, "MADAM ddXYH     "); }
-			if (top->mem_addr == 0x0330015c) { fprintf(logfile, "MADAM ddXYL     "); }
-			if (top->mem_addr == 0x03300160) { fprintf(logfile, "MADAM Rsrvd 160 "); }
-
-			if (top->mem_addr >= 0x03300180 && top->mem_addr <= 0x033001ff) { fprintf(logfile, "MADAM PLUT      "); }
-
-			if (top->mem_addr == 0x03300218) { fprintf(logfile, "MADAM Fence0    "); }
-			if (top->mem_addr == 0x0330021c) { fprintf(logfile, "MADAM Fence1    "); }
-			if (top->mem_addr == 0x03300238) { fprintf(logfile, "MADAM Fence2    "); }
-			if (top->mem_addr == 0x0330023c) { fprintf(logfile, "MADAM Fence3    "); }
-
-			if (top->mem_addr == 0x03300400) { fprintf(logfile, "MADAM DMA00 Adr "); } // RamToDSPP0
-			if (top->mem_addr == 0x03300404) { fprintf(logfile, "MADAM DMA00 Len "); }
-			if (top->mem_addr == 0x03300408) { fprintf(logfile, "MADAM DMA00 NAd "); }
-			if (top->mem_addr == 0x0330040c) { fprintf(logfile, "MADAM DMA00 NLn "); }
-
-			if (top->mem_addr == 0x03300410) { fprintf(logfile, "MADAM DMA01 Adr "); } // RamToDSPP1
-			if (top->mem_addr == 0x03300414) { fprintf(logfile, "MADAM DMA01 Len "); }
-			if (top->mem_addr == 0x03300418) { fprintf(logfile, "MADAM DMA01 NAd "); }
-			if (top->mem_addr == 0x0330041c) { fprintf(logfile, "MADAM DMA01 NLn "); }
-
-			if (top->mem_addr == 0x03300420) { fprintf(logfile, "MADAM DMA02 Adr "); } // RamToDSPP2
-			if (top->mem_addr == 0x03300424) { fprintf(logfile, "MADAM DMA02 Len "); }
-			if (top->mem_addr == 0x03300428) { fprintf(logfile, "MADAM DMA02 NAd "); }
-			if (top->mem_addr == 0x0330042c) { fprintf(logfile, "MADAM DMA02 NLn "); }
-
-			if (top->mem_addr == 0x03300430) { fprintf(logfile, "MADAM DMA03 Adr "); } // RamToDSPP3
-			if (top->mem_addr == 0x03300434) { fprintf(logfile, "MADAM DMA03 Len "); }
-			if (top->mem_addr == 0x03300438) { fprintf(logfile, "MADAM DMA03 NAd "); }
-			if (top->mem_addr == 0x0330043c) { fprintf(logfile, "MADAM DMA03 NLn "); }
-
-			if (top->mem_addr == 0x03300440) { fprintf(logfile, "MADAM DMA04 Adr "); } // RamToDSPP4
-			if (top->mem_addr == 0x03300444) { fprintf(logfile, "MADAM DMA04 Len "); }
-			if (top->mem_addr == 0x03300448) { fprintf(logfile, "MADAM DMA04 NAd "); }
-			if (top->mem_addr == 0x0330044c) { fprintf(logfile, "MADAM DMA04 NLn "); }
-
-			if (top->mem_addr == 0x03300450) { fprintf(logfile, "MADAM DMA05 Adr "); } // RamToDSPP5
-			if (top->mem_addr == 0x03300454) { fprintf(logfile, "MADAM DMA05 Len "); }
-			if (top->mem_addr == 0x03300458) { fprintf(logfile, "MADAM DMA05 NAd "); }
-			if (top->mem_addr == 0x0330045c) { fprintf(logfile, "MADAM DMA05 NLn "); }
-
-			if (top->mem_addr == 0x03300460) { fprintf(logfile, "MADAM DMA06 Adr "); } // RamToDSPP6
-			if (top->mem_addr == 0x03300464) { fprintf(logfile, "MADAM DMA06 Len "); }
-			if (top->mem_addr == 0x03300468) { fprintf(logfile, "MADAM DMA06 NAd "); }
-			if (top->mem_addr == 0x0330046c) { fprintf(logfile, "MADAM DMA06 NLn "); }
-
-			if (top->mem_addr == 0x03300470) { fprintf(logfile, "MADAM DMA07 Adr "); } // RamToDSPP7
-			if (top->mem_addr == 0x03300474) { fprintf(logfile, "MADAM DMA07 Len "); }
-			if (top->mem_addr == 0x03300478) { fprintf(logfile, "MADAM DMA07 NAd "); }
-			if (top->mem_addr == 0x0330047c) { fprintf(logfile, "MADAM DMA07 NLn "); }
-
-			if (top->mem_addr == 0x03300480) { fprintf(logfile, "MADAM DMA08 Adr "); } // RamToDSPP8
-			if (top->mem_addr == 0x03300484) { fprintf(logfile, "MADAM DMA08 Len "); }
-			if (top->mem_addr == 0x03300488) { fprintf(logfile, "MADAM DMA08 NAd "); }
-			if (top->mem_addr == 0x0330048c) { fprintf(logfile, "MADAM DMA08 NLn "); }
-
-			if (top->mem_addr == 0x03300490) { fprintf(logfile, "MADAM DMA09 Adr "); } // RamToDSPP9
-			if (top->mem_addr == 0x03300494) { fprintf(logfile, "MADAM DMA09 Len "); }
-			if (top->mem_addr == 0x03300498) { fprintf(logfile, "MADAM DMA09 NAd "); }
-			if (top->mem_addr == 0x0330049c) { fprintf(logfile, "MADAM DMA09 NLn "); }
-
-			if (top->mem_addr == 0x033004a0) { fprintf(logfile, "MADAM DMA10 Adr "); } // RamToDSPP10
-			if (top->mem_addr == 0x033004a4) { fprintf(logfile, "MADAM DMA10 Len "); }
-			if (top->mem_addr == 0x033004a8) { fprintf(logfile, "MADAM DMA10 NAd "); }
-			if (top->mem_addr == 0x033004ac) { fprintf(logfile, "MADAM DMA10 NLn "); }
-
-			if (top->mem_addr == 0x033004b0) { fprintf(logfile, "MADAM DMA11 Adr "); } // RamToDSPP11
-			if (top->mem_addr == 0x033004b4) { fprintf(logfile, "MADAM DMA11 Len "); }
-			if (top->mem_addr == 0x033004b8) { fprintf(logfile, "MADAM DMA11 NAd "); }
-			if (top->mem_addr == 0x033004bc) { fprintf(logfile, "MADAM DMA11 NLn "); }
-
-			if (top->mem_addr == 0x033004c0) { fprintf(logfile, "MADAM DMA12 Adr "); } // RamToDSPP12
-			if (top->mem_addr == 0x033004c4) { fprintf(logfile, "MADAM DMA12 Len "); }
-			if (top->mem_addr == 0x033004c8) { fprintf(logfile, "MADAM DMA12 NAd "); }
-			if (top->mem_addr == 0x033004cc) { fprintf(logfile, "MADAM DMA12 NLn "); }
-
-			if (top->mem_addr == 0x033004d0) { fprintf(logfile, "MADAM DMA13 Adr "); } // RamToUncle
-			if (top->mem_addr == 0x033004d4) { fprintf(logfile, "MADAM DMA13 Len "); }
-			if (top->mem_addr == 0x033004d8) { fprintf(logfile, "MADAM DMA13 NAd "); }
-			if (top->mem_addr == 0x033004dc) { fprintf(logfile, "MADAM DMA13 NLn "); }
-
-			if (top->mem_addr == 0x033004e0) { fprintf(logfile, "MADAM DMA14 Adr "); } // RamToExternal
-			if (top->mem_addr == 0x033004e4) { fprintf(logfile, "MADAM DMA14 Len "); }
-			if (top->mem_addr == 0x033004e8) { fprintf(logfile, "MADAM DMA14 NAd "); }
-			if (top->mem_addr == 0x033004ec) { fprintf(logfile, "MADAM DMA14 NLn "); }
-
-			if (top->mem_addr == 0x033004f0) { fprintf(logfile, "MADAM DMA15 Adr "); } // RamToDSPPNStack
-			if (top->mem_addr == 0x033004f4) { fprintf(logfile, "MADAM DMA15 Len "); }
-			if (top->mem_addr == 0x033004f8) { fprintf(logfile, "MADAM DMA15 NAd "); }
-			if (top->mem_addr == 0x033004fc) { fprintf(logfile, "MADAM DMA15 NLn "); }
-
-			if (top->mem_addr == 0x03300500) { fprintf(logfile, "MADAM DMA16 Adr "); } // DSPPToRam0
-			if (top->mem_addr == 0x03300504) { fprintf(logfile, "MADAM DMA16 Len "); }
-			if (top->mem_addr == 0x03300508) { fprintf(logfile, "MADAM DMA16 NAd "); }
-			if (top->mem_addr == 0x0330050c) { fprintf(logfile, "MADAM DMA16 NLn "); }
-
-			if (top->mem_addr == 0x03300510) { fprintf(logfile, "MADAM DMA10 Adr "); } // DSPPToRam1
-			if (top->mem_addr == 0x03300514) { fprintf(logfile, "MADAM DMA10 Len "); }
-			if (top->mem_addr == 0x03300518) { fprintf(logfile, "MADAM DMA10 NAd "); }
-			if (top->mem_addr == 0x0330051c) { fprintf(logfile, "MADAM DMA10 NLn "); }
-
-			if (top->mem_addr == 0x03300520) { fprintf(logfile, "MADAM DMA11 Adr "); } // DSPPToRam2
-			if (top->mem_addr == 0x03300524) { fprintf(logfile, "MADAM DMA11 Len "); }
-			if (top->mem_addr == 0x03300528) { fprintf(logfile, "MADAM DMA11 NAd "); }
-			if (top->mem_addr == 0x0330052c) { fprintf(logfile, "MADAM DMA11 NLn "); }
-
-			if (top->mem_addr == 0x03300530) { fprintf(logfile, "MADAM DMA12 Adr "); } // DSPPToRam3
-			if (top->mem_addr == 0x03300534) { fprintf(logfile, "MADAM DMA12 Len "); }
-			if (top->mem_addr == 0x03300538) { fprintf(logfile, "MADAM DMA12 NAd "); }
-			if (top->mem_addr == 0x0330053c) { fprintf(logfile, "MADAM DMA12 NLn "); }
-
-			if (top->mem_addr == 0x03300540) { fprintf(logfile, "MADAM XBus Adr  "); } // DMAExpo
-			if (top->mem_addr == 0x03300544) { fprintf(logfile, "MADAM XBus Len  "); }
-			if (top->mem_addr == 0x03300548) { fprintf(logfile, "MADAM XBus NAd  "); }
-			if (top->mem_addr == 0x0330054c) { fprintf(logfile, "MADAM XBus NLn  "); }
-
-			if (top->mem_addr == 0x03300550) { fprintf(logfile, "MADAM DMA14 Adr "); } // UncleToRam
-			if (top->mem_addr == 0x03300554) { fprintf(logfile, "MADAM DMA14 Len "); }
-			if (top->mem_addr == 0x03300558) { fprintf(logfile, "MADAM DMA14 NAd "); }
-			if (top->mem_addr == 0x0330055c) { fprintf(logfile, "MADAM DMA14 NLn "); }
-
-			if (top->mem_addr == 0x03300560) { fprintf(logfile, "MADAM DMA15 Adr "); } // ExternalToRam
-			if (top->mem_addr == 0x03300564) { fprintf(logfile, "MADAM DMA15 Len "); }
-			if (top->mem_addr == 0x03300568) { fprintf(logfile, "MADAM DMA15 NAd "); }
-			if (top->mem_addr == 0x0330056c) { fprintf(logfile, "MADAM DMA15 NLn "); }
-
-			if (top->mem_addr == 0x03300570) { fprintf(logfile, "MADAM PbToRam   "); } // ControlPort (PlayerBus)
-			if (top->mem_addr == 0x03300574) { fprintf(logfile, "MADAM PbLength  "); }
-			if (top->mem_addr == 0x03300578) { fprintf(logfile, "MADAM PbFromRam "); }
-			if (top->mem_addr == 0x0330057c) { fprintf(logfile, "MADAM PbRefresh "); }
-
-			//if (top->mem_addr == 0x03300580) { fprintf(logfile, "MADAM CLUT Ctrl "); } // CLUT_MID (CLUT Ctrl)
-			if (top->mem_addr == 0x03300580) { fprintf(logfile, "MADAM vdl_addr! "); }
-			if (top->mem_addr == 0x03300584) { fprintf(logfile, "MADAM CLUT Vid  "); }
-			if (top->mem_addr == 0x03300588) { fprintf(logfile, "MADAM CLUT Mid  "); }
-			if (top->mem_addr == 0x0330058c) { fprintf(logfile, "MADAM CMID Rsvd "); }
-
-			if (top->mem_addr == 0x03300590) { fprintf(logfile, "MADAM VID Prev  "); } // Video_MID
-			if (top->mem_addr == 0x03300594) { fprintf(logfile, "MADAM VID Curr  "); }
-			if (top->mem_addr == 0x03300598) { fprintf(logfile, "MADAM VID PrevM "); }
-			if (top->mem_addr == 0x0330059c) { fprintf(logfile, "MADAM VID CurrM "); }
-
-			if (top->mem_addr == 0x033005a0) { fprintf(logfile, "MADAM currentccb"); } // CELControl
-			if (top->mem_addr == 0x033005a4) { fprintf(logfile, "MADAM FirstCCB  "); }
-			if (top->mem_addr == 0x033005a8) { fprintf(logfile, "MADAM CL PLUT   "); }
-			if (top->mem_addr == 0x033005ac) { fprintf(logfile, "MADAM CL DStart "); }
-
-			if (top->mem_addr == 0x033005b0) { fprintf(logfile, "MADAM engafetch "); } // CELData
-			if (top->mem_addr == 0x033005b4) { fprintf(logfile, "MADAM engalen   "); }
-			if (top->mem_addr == 0x033005b8) { fprintf(logfile, "MADAM engbfetch "); }
-			if (top->mem_addr == 0x033005bc) { fprintf(logfile, "MADAM engblen   "); }
-
-			if (top->mem_addr == 0x033005c0) { fprintf(logfile, "MADAM DMA21 Adr "); } // Commandgrabber
-			if (top->mem_addr == 0x033005c4) { fprintf(logfile, "MADAM DMA21 Len "); }
-			if (top->mem_addr == 0x033005c8) { fprintf(logfile, "MADAM DMA21 NAd "); }
-			if (top->mem_addr == 0x033005cc) { fprintf(logfile, "MADAM DMA21 NLn "); }
-
-			if (top->mem_addr == 0x033005d0) { fprintf(logfile, "MADAM DMA22 Adr "); } // Framegrabber
-			if (top->mem_addr == 0x033005d4) { fprintf(logfile, "MADAM DMA22 Len "); }
-			if (top->mem_addr == 0x033005d8) { fprintf(logfile, "MADAM DMA22 NAd "); }
-			if (top->mem_addr == 0x033005dc) { fprintf(logfile, "MADAM DMA22 NLn "); }
-
-			if (top->mem_addr >= 0x03300600 && top->mem_addr <= 0x0330063f) { fprintf(logfile, "MADAM Matrix    "); }
-			if (top->mem_addr >= 0x03300640 && top->mem_addr <= 0x0330069c) { fprintf(logfile, "MADAM B0_B1     "); }
-
-			if (top->mem_addr == 0x033006a0) { fprintf(logfile, "MADAM Rsrvd 6a0 "); }
-			if (top->mem_addr == 0x03300700) { fprintf(logfile, "MADAM Rsrvd 700 "); }
-
-			if (top->mem_addr == 0x033007f0) { fprintf(logfile, "MADAM Math Set  "); }
-			if (top->mem_addr == 0x033007f4) { fprintf(logfile, "MADAM Math Clr  "); }
-			if (top->mem_addr == 0x033007f8) { fprintf(logfile, "MADAM Math Stat "); }
-			if (top->mem_addr == 0x033007fc) { fprintf(logfile, "MADAM Math Start"); }
-
-			// CLIO...
-			if (top->mem_addr == 0x03400000) { fprintf(logfile, "CLIO Revision   "); }
-			if (top->mem_addr == 0x03400004) { fprintf(logfile, "CLIO csysbits   "); }
-			if (top->mem_addr == 0x03400008) { fprintf(logfile, "CLIO vint0      "); }
-			if (top->mem_addr == 0x0340000C) { fprintf(logfile, "CLIO vint1      "); }
-			if (top->mem_addr == 0x03400024) { fprintf(logfile, "CLIO audout     "); }
-			if (top->mem_addr == 0x03400028) { fprintf(logfile, "CLIO cstatbits  "); }
-			if (top->mem_addr == 0x0340002C) { fprintf(logfile, "CLIO WatchDog   "); }
-			//if (top->mem_addr == 0x03400034) { fprintf(logfile, "CLIO vcnt       "); }
-			if (top->mem_addr == 0x03400038) { fprintf(logfile, "CLIO RandSeed   "); }
-
-			if (top->mem_addr == 0x0340003c) { fprintf(logfile, "CLIO RandSample?"); top->i_wb_dat = 0x00000000; }
-
-			if (top->mem_addr == 0x03400040 && top->o_wb_we) { fprintf(logfile, "CLIO irq0 set   "); }
-			if (top->mem_addr == 0x03400044 && top->o_wb_we) { fprintf(logfile, "CLIO irq0 clear "); }
-			if (top->mem_addr == 0x03400048 && top->o_wb_we) { fprintf(logfile, "CLIO mask0 set  "); }
-			if (top->mem_addr == 0x0340004c && top->o_wb_we) { fprintf(logfile, "CLIO mask0 clear"); }
-			if (top->mem_addr == 0x03400040 && !top->o_wb_we) { fprintf(logfile, "CLIO irq0 pend  "); }
-			if (top->mem_addr == 0x03400044 && !top->o_wb_we) { fprintf(logfile, "CLIO irq0 pend  "); }
-			if (top->mem_addr == 0x03400048 && !top->o_wb_we) { fprintf(logfile, "CLIO mask0 read "); }
-			if (top->mem_addr == 0x0340004c && !top->o_wb_we) { fprintf(logfile, "CLIO mask0 read "); }
-
-			if (top->mem_addr == 0x03400050 && top->o_wb_we) { fprintf(logfile, "CLIO SetMode    "); }
-			if (top->mem_addr == 0x03400054 && top->o_wb_we) { fprintf(logfile, "CLIO ClrMode    "); }
-			if (top->mem_addr == 0x03400058 && top->o_wb_we) { fprintf(logfile, "CLIO BadBits    "); }
-			if (top->mem_addr == 0x0340005c && top->o_wb_we) { fprintf(logfile, "CLIO Spare      "); }
-
-			if (top->mem_addr == 0x03400060 && top->o_wb_we) { fprintf(logfile, "CLIO irq1 set   "); }
-			if (top->mem_addr == 0x03400064 && top->o_wb_we) { fprintf(logfile, "CLIO irq1 clear "); }
-			if (top->mem_addr == 0x03400068 && top->o_wb_we) { fprintf(logfile, "CLIO mask1 set  "); }
-			if (top->mem_addr == 0x0340006c && top->o_wb_we) { fprintf(logfile, "CLIO mask1 clear"); }
-			if (top->mem_addr == 0x03400060 && !top->o_wb_we) { fprintf(logfile, "CLIO irq1 pend  "); }
-			if (top->mem_addr == 0x03400064 && !top->o_wb_we) { fprintf(logfile, "CLIO irq1 pend  "); }
-			if (top->mem_addr == 0x03400068 && !top->o_wb_we) { fprintf(logfile, "CLIO mask1 read "); }
-			if (top->mem_addr == 0x0340006c && !top->o_wb_we) { fprintf(logfile, "CLIO mask1 read "); }
-
-			if (top->mem_addr == 0x03400080) { fprintf(logfile, "CLIO hdelay     "); }
-			if (top->mem_addr == 0x03400084 && !top->o_wb_we) { fprintf(logfile, "CLIO adbio      "); }
-			if (top->mem_addr == 0x03400084 && top->o_wb_we) { fprintf(logfile, "CLIO adbio      "); rom2_select = (top->o_wb_dat & 0x04); handle_adbio_write(); }
-			if (top->mem_addr == 0x03400088) { fprintf(logfile, "CLIO adbctl     "); }
-
-			if (top->mem_addr == 0x03400100) { fprintf(logfile, "CLIO tmr_cnt_0  "); }
-			if (top->mem_addr == 0x03400108) { fprintf(logfile, "CLIO tmr_cnt_1  "); }
-			if (top->mem_addr == 0x03400110) { fprintf(logfile, "CLIO tmr_cnt_2  "); }
-			if (top->mem_addr == 0x03400118) { fprintf(logfile, "CLIO tmr_cnt_3  "); }
-			if (top->mem_addr == 0x03400120) { fprintf(logfile, "CLIO tmr_cnt_4  "); }
-			if (top->mem_addr == 0x03400128) { fprintf(logfile, "CLIO tmr_cnt_5  "); }
-			if (top->mem_addr == 0x03400130) { fprintf(logfile, "CLIO tmr_cnt_6  "); }
-			if (top->mem_addr == 0x03400138) { fprintf(logfile, "CLIO tmr_cnt_7  "); }
-			if (top->mem_addr == 0x03400140) { fprintf(logfile, "CLIO tmr_cnt_8  "); }
-			if (top->mem_addr == 0x03400148) { fprintf(logfile, "CLIO tmr_cnt_9  "); }
-			if (top->mem_addr == 0x03400150) { fprintf(logfile, "CLIO tmr_cnt_10 "); }
-			if (top->mem_addr == 0x03400158) { fprintf(logfile, "CLIO tmr_cnt_11 "); }
-			if (top->mem_addr == 0x03400160) { fprintf(logfile, "CLIO tmr_cnt_12 "); }
-			if (top->mem_addr == 0x03400168) { fprintf(logfile, "CLIO tmr_cnt_13 "); }
-			if (top->mem_addr == 0x03400170) { fprintf(logfile, "CLIO tmr_cnt_14 "); }
-			if (top->mem_addr == 0x03400178) { fprintf(logfile, "CLIO tmr_cnt_15 "); }
-
-			if (top->mem_addr == 0x03400104) { fprintf(logfile, "CLIO tmr_bkp_0  "); }
-			if (top->mem_addr == 0x0340010c) { fprintf(logfile, "CLIO tmr_bkp_1  "); }
-			if (top->mem_addr == 0x03400114) { fprintf(logfile, "CLIO tmr_bkp_2  "); }
-			if (top->mem_addr == 0x0340011c) { fprintf(logfile, "CLIO tmr_bkp_3  "); }
-			if (top->mem_addr == 0x03400124) { fprintf(logfile, "CLIO tmr_bkp_4  "); }
-			if (top->mem_addr == 0x0340012c) { fprintf(logfile, "CLIO tmr_bkp_5  "); }
-			if (top->mem_addr == 0x03400134) { fprintf(logfile, "CLIO tmr_bkp_6  "); }
-			if (top->mem_addr == 0x0340013c) { fprintf(logfile, "CLIO tmr_bkp_7  "); }
-			if (top->mem_addr == 0x03400144) { fprintf(logfile, "CLIO tmr_bkp_8  "); }
-			if (top->mem_addr == 0x0340014c) { fprintf(logfile, "CLIO tmr_bkp_9  "); }
-			if (top->mem_addr == 0x03400154) { fprintf(logfile, "CLIO tmr_bkp_10 "); }
-			if (top->mem_addr == 0x0340015c) { fprintf(logfile, "CLIO tmr_bkp_11 "); }
-			if (top->mem_addr == 0x03400164) { fprintf(logfile, "CLIO tmr_bkp_12 "); }
-			if (top->mem_addr == 0x0340016c) { fprintf(logfile, "CLIO tmr_bkp_13 "); }
-			if (top->mem_addr == 0x03400174) { fprintf(logfile, "CLIO tmr_bkp_14 "); }
-			if (top->mem_addr == 0x0340017c) { fprintf(logfile, "CLIO tmr_bkp_15 "); }
-
-			if (top->mem_addr == 0x03400200) { fprintf(logfile, "CLIO tmr_set_l  "); }
-			if (top->mem_addr == 0x03400204) { fprintf(logfile, "CLIO tmr_clr_l  "); }
-			if (top->mem_addr == 0x03400208) { fprintf(logfile, "CLIO tmr_set_u  "); }
-			if (top->mem_addr == 0x0340020C) { fprintf(logfile, "CLIO tmr_clr_u  "); }
-
-			if (top->mem_addr == 0x03400220) { fprintf(logfile, "CLIO TmrSlack   "); }
-			if (top->mem_addr == 0x03400304 && !top->o_wb_we) { fprintf(logfile, "CLIO dmactrl    "); }
-			if (top->mem_addr == 0x03400304 && top->o_wb_we) { fprintf(logfile, "CLIO dmactrl    "); sim_clio_handle_dma(top->o_wb_dat); }
-			if (top->mem_addr == 0x03400308) { fprintf(logfile, "CLIO ClrDMAEna  "); }
-
-			if (top->mem_addr == 0x03400380) { fprintf(logfile, "CLIO DMA DSPP0  "); }
-			if (top->mem_addr == 0x03400384) { fprintf(logfile, "CLIO DMA DSPP1  "); }
-			if (top->mem_addr == 0x03400388) { fprintf(logfile, "CLIO DMA DSPP2  "); }
-			if (top->mem_addr == 0x0340038c) { fprintf(logfile, "CLIO DMA DSPP3  "); }
-			if (top->mem_addr == 0x03400390) { fprintf(logfile, "CLIO DMA DSPP4  "); }
-			if (top->mem_addr == 0x03400394) { fprintf(logfile, "CLIO DMA DSPP5  "); }
-			if (top->mem_addr == 0x03400398) { fprintf(logfile, "CLIO DMA DSPP6  "); }
-			if (top->mem_addr == 0x0340039c) { fprintf(logfile, "CLIO DMA DSPP7  "); }
-			if (top->mem_addr == 0x034003a0) { fprintf(logfile, "CLIO DMA DSPP8  "); }
-			if (top->mem_addr == 0x034003a4) { fprintf(logfile, "CLIO DMA DSPP9  "); }
-			if (top->mem_addr == 0x034003a8) { fprintf(logfile, "CLIO DMA DSPP10 "); }
-			if (top->mem_addr == 0x034003ac) { fprintf(logfile, "CLIO DMA DSPP11 "); }
-			if (top->mem_addr == 0x034003b0) { fprintf(logfile, "CLIO DMA DSPP12 "); }
-			if (top->mem_addr == 0x034003b4) { fprintf(logfile, "CLIO DMA DSPP13 "); }
-			if (top->mem_addr == 0x034003b8) { fprintf(logfile, "CLIO DMA DSPP14 "); }
-			if (top->mem_addr == 0x034003bc) { fprintf(logfile, "CLIO DMA DSPP15 "); }
-
-			if (top->mem_addr == 0x034003c0) { fprintf(logfile, "CLIO DSPP DMA0  "); }
-			if (top->mem_addr == 0x034003c4) { fprintf(logfile, "CLIO DSPP DMA1  "); }
-			if (top->mem_addr == 0x034003c8) { fprintf(logfile, "CLIO DSPP DMA2  "); }
-			if (top->mem_addr == 0x034003cc) { fprintf(logfile, "CLIO DSPP DMA3  "); }
-			if (top->mem_addr == 0x034003d0) { fprintf(logfile, "CLIO DSPP DMA4  "); }
-			if (top->mem_addr == 0x034003d4) { fprintf(logfile, "CLIO DSPP DMA5  "); }
-			if (top->mem_addr == 0x034003d8) { fprintf(logfile, "CLIO DSPP DMA6  "); }
-			if (top->mem_addr == 0x034003dc) { fprintf(logfile, "CLIO DSPP DMA7  "); }
-			if (top->mem_addr == 0x034003e0) { fprintf(logfile, "CLIO DSPP DMA8  "); }
-			if (top->mem_addr == 0x034003e4) { fprintf(logfile, "CLIO DSPP DMA9  "); }
-			if (top->mem_addr == 0x034003e8) { fprintf(logfile, "CLIO DSPP DMA10 "); }
-			if (top->mem_addr == 0x034003ec) { fprintf(logfile, "CLIO DSPP DMA11 "); }
-			if (top->mem_addr == 0x034003f0) { fprintf(logfile, "CLIO DSPP DMA12 "); }
-			if (top->mem_addr == 0x034003f4) { fprintf(logfile, "CLIO DSPP DMA13 "); }
-			if (top->mem_addr == 0x034003f8) { fprintf(logfile, "CLIO DSPP DMA14 "); }
-			if (top->mem_addr == 0x034003fc) { fprintf(logfile, "CLIO DSPP DMA15 "); }
-
-			if (top->mem_addr == 0x03400400) { fprintf(logfile, "CLIO expctl_set "); }
-			if (top->mem_addr == 0x03400404) { fprintf(logfile, "CLIO expctl_clr "); }
-			if (top->mem_addr == 0x03400408) { fprintf(logfile, "CLIO type0_4    "); }
-			if (top->mem_addr == 0x03400410) { fprintf(logfile, "CLIO dipir1     "); }
-			if (top->mem_addr == 0x03400414) { fprintf(logfile, "CLIO dipir2     "); top->i_wb_dat = 0x4000; }	// TO CHECK!!! requested by CDROMDIPIR.
-
-			// Handle Xbus reads...
-			//if (top->mem_addr == 0x03400400) top->i_wb_dat = /*top->rootp->core_3do__DOT__clio_inst__DOT__expctl*/ 0x00000080;
-			if ((top->mem_addr >= 0x03400500) && (top->mem_addr <= 0x0340053f) && !top->o_wb_we) { fprintf(logfile, "CLIO sel        "); top->i_wb_dat = sim_xbus_get_res(); }
-			if ((top->mem_addr >= 0x03400540) && (top->mem_addr <= 0x0340057f) && !top->o_wb_we) { fprintf(logfile, "CLIO poll       "); top->i_wb_dat = sim_xbus_get_poll(); }
-			if ((top->mem_addr >= 0x03400580) && (top->mem_addr <= 0x034005bf) && !top->o_wb_we) { fprintf(logfile, "CLIO CmdStFIFO  "); top->i_wb_dat = sim_xbus_fifo_get_status(); }
-			if ((top->mem_addr >= 0x034005C0) && (top->mem_addr <= 0x034005ff) && !top->o_wb_we) { fprintf(logfile, "CLIO Data FIFO  "); top->i_wb_dat = sim_xbus_fifo_get_data(); }
-
-			// DSP...
-			if (top->mem_addr == 0x034017d0) { fprintf(logfile, "CLIO sema       "); }
-			if (top->mem_addr == 0x034017d4) { fprintf(logfile, "CLIO semaack    "); }
-			if (top->mem_addr == 0x034017e0) { fprintf(logfile, "CLIO dspdma     "); }
-			if (top->mem_addr == 0x034017e4) { fprintf(logfile, "CLIO dspprst0   "); }
-			if (top->mem_addr == 0x034017e8) { fprintf(logfile, "CLIO dspprst1   "); }
-
-			if (top->mem_addr == 0x034017f0) { fprintf(logfile, "CLIO fastrand   "); }
-
-			if (top->mem_addr == 0x034017f4) { fprintf(logfile, "CLIO dspppc     "); }
-			if (top->mem_addr == 0x034017f8) { fprintf(logfile, "CLIO dsppnr     "); }
-			if (top->mem_addr == 0x034017fc) { fprintf(logfile, "CLIO dsppgw     "); }
-			if (top->mem_addr == 0x034039dc) { fprintf(logfile, "CLIO dsppclkreload"); }
-
-			if (top->mem_addr >= 0x03401800 && top->mem_addr <= 0x03401fff) { fprintf(logfile, "CLIO DSPP  N 32 "); }
-			if (top->mem_addr >= 0x03402000 && top->mem_addr <= 0x03402fff) { fprintf(logfile, "CLIO DSPP  N 16 "); }
-			if (top->mem_addr >= 0x03403000 && top->mem_addr <= 0x034031ff) { fprintf(logfile, "CLIO DSPP EI 32 "); }
-			if (top->mem_addr >= 0x03403400 && top->mem_addr <= 0x034037ff) { fprintf(logfile, "CLIO DSPP EI 16 "); }
-
-			// Uncle spoofing stuff handled in clio.v now. ElectronAsh...
-			if (top->mem_addr == 0x0340C000) { fprintf(logfile, "CLIO unc_rev    "); }
-			if (top->mem_addr == 0x0340C004) { fprintf(logfile, "CLIO unc_soft_rv"); }
-			if (top->mem_addr == 0x0340C008) { fprintf(logfile, "CLIO unc_addr   "); }
-			if (top->mem_addr == 0x0340C00c) { fprintf(logfile, "CLIO unc_rom    "); }
-
-			//else { fprintf(logfile, "UNKNOWN ?? Addr: 0x%08X  o_wb_we: %d\n", top->mem_addr, top->o_wb_we); top->i_wb_dat = 0xBADACCE5; }
-
-			/*
-			uint32_t zap_din = top->rootp->core_3do__DOT__zap_top_inst__DOT__i_wb_dat;
-			if ((top->mem_addr >= 0x03100000 && top->mem_addr <= 0x034fffff && top->mem_addr != 0x03400034) ) {
-				if (top->o_wb_we) fprintf(logfile, "Write: 0x%08X  (PC: 0x%08X)\n", top->o_wb_dat, cur_pc);
-				else fprintf(logfile, " Read: 0x%08X  (PC: 0x%08X)\n", zap_din, cur_pc);
-			}
-			*/
-		}
-
-		if (top->rootp->core_3do__DOT__clio_inst__DOT__vcnt == top->rootp->core_3do__DOT__clio_inst__DOT__vcnt_max && top->rootp->core_3do__DOT__clio_inst__DOT__hcnt==0) {
-			frame_count++;
-			fprintf(logfile, "frame: %d\n", frame_count);
-		}
-
-		if ( (top->rootp->core_3do__DOT__clio_inst__DOT__vcnt & 0x7)==0 && top->rootp->core_3do__DOT__clio_inst__DOT__hcnt == 0) {
-		//if ( top->rootp->core_3do__DOT__clio_inst__DOT__vcnt==0 && top->rootp->core_3do__DOT__clio_inst__DOT__hcnt == 0 && top->rootp->core_3do__DOT__clio_inst__DOT__field==0) {
-			sim_process_vdl();
-			opera_process_vdl();
-		}
-		
-		//if (top->mem_addr==0x03400178 && top->o_wb_we) run_enable = 0;
-		//if (top->mem_addr== 0x03400580 && top->o_wb_we && top->o_wb_dat==0x00000010) run_enable = 0;
-		//if (cur_pc== 0x000014A8) run_enable = 0;
-
-		//if (top->mem_addr == 0x03300100 && top->o_wb_we) run_enable = 0;	// Stop on write to CEL SPRSTRT.
-
-		/*
-		if (old_fiq_n == 1 && top->rootp->core_3do__DOT__clio_inst__DOT__firq_n == 0) { // firq_n falling edge.
-			fprintf(logfile, "FIQ triggered!  (PC: 0x%08X)  irq0_pend: 0x%08X  irq1_pend: 0x%08X\n", cur_pc, top->rootp->core_3do__DOT__clio_inst__DOT__irq0_pend, top->rootp->core_3do__DOT__clio_inst__DOT__irq1_pend);
-		}
-		old_fiq_n = top->rootp->core_3do__DOT__clio_inst__DOT__firq_n;
-
-		uint32_t instruction = top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_decode_main__DOT__u_zap_decode__DOT__i_instruction;
-		if ( ((instruction & 0xF000000)>>24 == 0b1111) && top->rootp->core_3do__DOT__zap_top_inst__DOT__u_zap_core__DOT__u_zap_decode_main__DOT__u_zap_decode__DOT__i_instruction_valid) {
-			fprintf(logfile, "SWI 0x%08X  (PC: 0x%08X)\n", instruction, cur_pc);
-			//run_enable = 0;
-		}
-		*/
-
-		if (sim_xbus_fiq_request) {
-			sim_xbus_fiq_request = 0;
-			top->rootp->core_3do__DOT__clio_inst__DOT__irq0_pend |= (1<<2);	// Set irq0_pend, bit 2. (XBUs IRQ).
-		}
-
-		top->sys_clk = 0;
-		top->eval();
-
-		uint32_t zap_din = top->rootp->core_3do__DOT__zap_top_inst__DOT__i_wb_dat;
-		if ((top->mem_addr >= 0x03100000 && top->mem_addr <= 0x034fffff && top->mem_addr != 0x03400034) && top->o_wb_stb && top->i_wb_ack) {
-			if (top->o_wb_we) fprintf(logfile, "Write: 0x%08X  (PC: 0x%08X)\n", top->o_wb_dat, cur_pc);
-			else fprintf(logfile, " Read: 0x%08X  (PC: 0x%08X)\n", zap_din, cur_pc);
-		}
-
-		if (top->rootp->core_3do__DOT__madam_inst__DOT__mctl & 0x8000) pbus_dma();
-
-		top->sys_clk = 1;
-		top->eval();
-
-		return 1;
-	}
-
-	// Stop Verilating...
-	top->final();
-	delete top;
-	exit(0);
-	return 0;
-}
-
-/*
-When reading, the states of the bits of the interrupt sources (flags) are read, by writing the bits are equal to 1
-set the corresponding bits of the interrupt flags to 1. Apparently this can be simulated
-software hardware interrupt.
-Interrupt sources with higher numbers have higher priority (implemented in software in
-interrupt handler).
-VINT0 goes every even half-frame, and VINT1 every odd one (this is the very beginning of the quenching pulse).
-bit 00 - VINT0
-bit 01 - VINT1 (VSyncTimerFirq, ControlPort, SPORTfirq, GraphicsFirq is hung here)
-bit 02 - EXINT (interrupt from devices on XBUS, i.e. for example from CDROM)
-bit 03: Timer0.15 Interrupts from timers, only possible from odd (highest in pairs)
-bit 04: Timer0.13
-bit 05: Timer0.11
-bit 06: Timer0.9
-bit 07: Timer0.7
-bit 08: Timer0.5
-bit 09: Timer0.3
-bit 10: Timer0.1
-bit 11: AudioTimer
-bit 12: AudioDMA_DSPtoRAM0
-bit 13: AudioDMA_DSPtoRAM1
-bit 14: AudioDMA_DSPtoRAM2
-bit 15: AudioDMA_DSPtoRAM3
-bit 16: AudioDMA_DSPfromRAM0
-bit 17: AudioDMA_DSPfromRAM1
-bit 18: AudioDMA_DSPfromRAM2
-bit 19: AudioDMA_DSPfromRAM3
-bit 20: AudioDMA_DSPfromRAM4
-bit 21: AudioDMA_DSPfromRAM5
-bit 22: AudioDMA_DSPfromRAM6
-bit 23: AudioDMA_DSPfromRAM7
-bit 24: AudioDMA_DSPfromRAM8
-bit 25: AudioDMA_DSPfromRAM9
-bit 26: AudioDMA_DSPfromRAM10
-bit 27: AudioDMA_DSPfromRAM11
-bit 28: AudioDMA_DSPfromRAM12
-bit 29: XBUS DMA transfer complete
-bit 30: ??? An empty handler - possibly even a watchdog (if that interrupt is enabled and re-triggered). came, and the previous one was not processed, then reset, huh?)
-bit 31 - Indicates that there are more interrupts in register 0x0340 0060
-*/
-
 static MemoryEditor mem_edit_1;
 static MemoryEditor mem_edit_2;
 static MemoryEditor mem_edit_3;
@@ -1653,9 +165,6 @@ static MemoryEditor mem_edit_6;
 
 int main(int argc, char** argv, char** env) {
 	Verilated::traceEverOn(true);
-	VerilatedVcdC* m_trace = new VerilatedVcdC;
-	top->trace(m_trace, 99);
-	m_trace->open("F:\\waveform.vcd");
 
 	// Create application window
 	WNDCLASSEX wc = { sizeof(WNDCLASSEX), CS_CLASSDC, WndProc, 0L, 0L, GetModuleHandle(NULL), NULL, NULL, NULL, NULL, _T("ImGui Example"), NULL };
@@ -1709,12 +218,8 @@ int main(int argc, char** argv, char** env) {
 	Verilated::commandArgs(argc, argv);
 
 	//memset(rom_ptr, 0x00, rom_size);
-	memset(ram_ptr, 0x00, ram_size);
-	memset(vram_ptr, 0x00000000, vram_size);
-	memset(nvram_ptr, 0x00, nvram_size);
-
-	memset(disp_ptr, 0xff444444, disp_size);
-	memset(disp2_ptr, 0xff444444, disp2_size);
+	sim_clear_memory();
+	sim_bus_init();
 
 	//memset(vga_ptr,  0xAA, vga_size);
 
@@ -1722,7 +227,8 @@ int main(int argc, char** argv, char** env) {
 	//ramdump = fopen("ramdump.bin", "rb");
 	//fread(ram_ptr, 1, ram_size, ramdump);
 
-	logfile = fopen("sim_trace.txt", "w");
+	sim_log_open_text("sim_trace.txt");
+	opera_log_open("opera_trace.txt", OPERA_LOG_ALL);
 	inst_file = fopen("sim_inst_trace.txt", "w");
 
 	soundfile = fopen("soundfile.bin", "wb");
@@ -1736,43 +242,23 @@ int main(int argc, char** argv, char** env) {
 	fread(ram_ptr+0, 1, cel_size, cel_file);
 	*/
 
-	//isofile = fopen("aitd_us.iso", "rb");
-	//isofile = fopen("StarBlade.iso", "rb");
-	isofile = fopen("3DentrO.iso", "rb");
-	//isofile = fopen("3DO teaser trailer 25% ISO.iso", "rb");
-	//isofile = fopen("3DO Homebrew pack #1.iso", "rb");
-	//isofile = fopen("stniccc_3do_4bpp.iso", "rb");
-	//isofile = fopen("optidoom_02c.iso", "rb");
-	//CDIMAGE_SECTOR_SIZE = 2352; isofile = fopen("nfs_usa.bin", "rb");			// 2352-byte sectors!
-	//isofile = fopen("PhotoCD_Gallery.iso", "rb");
-	fseek(isofile, 0L, SEEK_END);
-	
-	fseek(isofile, 0L, SEEK_SET);
-
-
-	FILE* romfile;
-	//romfile = fopen("panafz1.bin", "rb");
-	romfile = fopen("panafz10.bin", "rb");			// This is the version MAME v226b uses by default, with "mame64 3do".
-	//romfile = fopen("panafz10-norsa.bin", "rb");
-	//romfile = fopen("sanyotry.bin", "rb");
-	//romfile = fopen("goldstar.bin", "rb");
-	//if (romfile != NULL) { sprintf(my_string, "\nBIOS file loaded OK.\n");  MyAddLog(my_string); }
-	//else { sprintf(my_string, "\nBIOS file not found!\n\n"); MyAddLog(my_string); return 0; }
-	//unsigned int file_size;
-	fseek(romfile, 0L, SEEK_END);
-	file_size = ftell(romfile);
-	fseek(romfile, 0L, SEEK_SET);
-	fread(rom_ptr, 1, rom_size, romfile);   // Read the whole BIOS file into RAM.
-
-	FILE* rom2file;
-	rom2file = fopen("panafz1-kanji.bin", "rb");
-	//if (rom2file != NULL) { sprintf(my_string, "\nBIOS file loaded OK.\n");  MyAddLog(my_string); }
-	//else { sprintf(my_string, "\nBIOS file not found!\n\n"); MyAddLog(my_string); return 0; }
-	//unsigned int file_size;
-	fseek(rom2file, 0L, SEEK_END);
-	file_size = ftell(rom2file);
-	fseek(rom2file, 0L, SEEK_SET);
-	fread(rom2_ptr, 1, rom2_size, rom2file);        // Read the whole BIOS file into RAM.
+	//sim_load_iso("aitd_us.iso");
+	//sim_load_iso("StarBlade.iso");
+	sim_load_iso("3DentrO.iso");
+	//sim_load_iso("3DO teaser trailer 25% ISO.iso");
+	//sim_load_iso("3DO Homebrew pack #1.iso");
+	//sim_load_iso("stniccc_3do_4bpp.iso");
+	//sim_load_iso("optidoom_02c.iso");
+	//sim_load_iso("nfs_usa.bin");			// 2352-byte sectors!
+	//sim_load_iso("PhotoCD_Gallery.iso");
+
+	//sim_load_bios("panafz1.bin");
+	sim_load_bios("panafz10.bin");			// This is the version MAME v226b uses by default, with "mame64 3do".
+	//sim_load_bios("panafz10-norsa.bin");
+	//sim_load_bios("sanyotry.bin");
+	//sim_load_bios("goldstar.bin");
+
+	sim_load_rom2("panafz1-kanji.bin");
 
 	/*
 	top->rootp->core_3do__DOT__matrix_inst__DOT__MI00_in = 0x8002aabb;
@@ -1907,6 +393,8 @@ int main(int argc, char** argv, char** env) {
 
 	static bool show_app_console = true;
 
+	sim_print_cb = sim_print_to_console;
+
 	my_opera_init();
 
 	/* select test, use -1 -- if don't need tests */
@@ -1969,26 +457,76 @@ int main(int argc, char** argv, char** env) {
 
 		ShowMyExampleAppConsole(&show_app_console);
 
-		if (ImGui::Button("RESET")) {
-			my_opera_init();
-
-			main_time = 0;
-			rom2_select = 0;        // Select the BIOS ROM at startup! (not Kanji).
-			map_bios = 1;
-			trig_irq = 0;
-			trig_fiq = 0;
-			frame_count = 0;
-			line_count = 0;
-			memset(disp_ptr, 0xff444444, disp_size);        // Clear the DISPLAY buffer.
-			memset(ram_ptr, 0x00, ram_size);                // Clear Main RAM.
-			memset(vram_ptr, 0x00000000, vram_size);        // Clear VRAM.
-			memset(nvram_ptr, 0x00000000, nvram_size);      // Clear NVRAM (SRAM).
-		}
+		// Joypad, for pbus_dma()...
+		sim_joypad = 0;
+		if (ImGui::IsKeyPressed(ImGuiKey_DownArrow))  sim_joypad |= SIM_JOYPAD_DOWN;
+		if (ImGui::IsKeyPressed(ImGuiKey_UpArrow))    sim_joypad |= SIM_JOYPAD_UP;
+		if (ImGui::IsKeyPressed(ImGuiKey_RightArrow)) sim_joypad |= SIM_JOYPAD_RIGHT;
+		if (ImGui::IsKeyPressed(ImGuiKey_LeftArrow))  sim_joypad |= SIM_JOYPAD_LEFT;
+		if (ImGui::IsKeyPressed(ImGuiKey_A)) sim_joypad |= SIM_JOYPAD_A;
+		if (ImGui::IsKeyPressed(ImGuiKey_B)) sim_joypad |= SIM_JOYPAD_B;
+		if (ImGui::IsKeyPressed(ImGuiKey_C)) sim_joypad |= SIM_JOYPAD_C;
+		if (ImGui::IsKeyPressed(ImGuiKey_P)) sim_joypad |= SIM_JOYPAD_P;
+		if (ImGui::IsKeyPressed(ImGuiKey_X)) sim_joypad |= SIM_JOYPAD_X;
+		if (ImGui::IsKeyPressed(ImGuiKey_R)) sim_joypad |= SIM_JOYPAD_RT;
+		if (ImGui::IsKeyPressed(ImGuiKey_L)) sim_joypad |= SIM_JOYPAD_LT;
+
+		if (ImGui::Button("RESET")) sim_reset();
 		ImGui::SameLine(); ImGui::Text("main_time %d", main_time);
+
+		// Reset, boot on Opera up to "frame:<n>" or "pc:<addr>", then carry on in the sim from there.
+		static char ffwd_to[32] = "frame:60";
+		if (ImGui::Button("Fast Forward")) {
+			sim_ffwd_cfg_t ffwd = { 0, 0, 0 };
+			if (sim_ffwd_parse(ffwd_to, &ffwd)) fprintf(stderr, "Bad fast-forward target: %s\n", ffwd_to);
+			else {
+				sim_reset();
+				sim_ffwd_run(&ffwd);
+			}
+		}
+		ImGui::SameLine(); ImGui::InputText("to", ffwd_to, sizeof(ffwd_to));
+		static bool opera_jit = 0;
+		ImGui::SameLine();
+		if (ImGui::Checkbox("Opera JIT", &opera_jit)) opera_jit = opera_arm_jit_set(opera_jit);	// Stays off where there isn't one (x86-64 only).
+		static bool opera_idle = 0;
+		ImGui::SameLine();
+		if (ImGui::Checkbox("Opera idle skip", &opera_idle)) opera_arm_idle_set(opera_idle);
+		static bool opera_swi_hle = 0;
+		static bool opera_swi_prof = 0;
+		if (ImGui::Checkbox("Opera SWI HLE", &opera_swi_hle)) opera_arm_swi_hle_set(opera_swi_hle);
+		ImGui::SameLine();
+		if (ImGui::Checkbox("SWI profile", &opera_swi_prof)) opera_arm_swi_prof_set(opera_swi_prof);
+		ImGui::SameLine(); if (ImGui::Button("Print SWIs")) opera_swi_prof_print(stdout, 32);
+		ImGui::SameLine(); if (ImGui::Button("Clear SWIs")) opera_arm_swi_prof_clear();
+		opera_madam_ccb_stats_t ccbs;
+		opera_madam_ccb_stats_get(&ccbs);
+		ImGui::Text("Opera CCBs: %llu  PLUTs: %llu  PIXC setups: %llu reused, %llu new", (unsigned long long)ccbs.ccbs, (unsigned long long)ccbs.pluts,
+			(unsigned long long)ccbs.pixc_hits, (unsigned long long)ccbs.pixc_misses);
+		ImGui::SameLine(); if (ImGui::Button("Clear CCBs")) opera_madam_ccb_stats_clear();
 		ImGui::Text("frame_count: %d  field: %d  hcnt: %04d  vcnt: %d", frame_count, top->rootp->core_3do__DOT__clio_inst__DOT__field, top->rootp->core_3do__DOT__clio_inst__DOT__hcnt, top->rootp->core_3do__DOT__clio_inst__DOT__vcnt);
 
+		sim_idle_stats_t idle;
+		sim_idle_get_stats(&idle);
+		ImGui::Text("Zap idle: %llu cycles in %llu polling loops", (unsigned long long)idle.cycles, (unsigned long long)idle.loops);
+
 		ImGui::Checkbox("RUN", &run_enable);
 
+		// Waveform from now until it's unticked. Only the scopes listed get dumped (all of them if it's blank).
+		static bool wave_enable = 0;
+		static char wave_scopes[256] = "";
+		if (ImGui::Checkbox("Waveform", &wave_enable)) {
+			if (wave_enable) {
+				sim_wave_cfg_t wave = { "waveform.vcd", { SIM_WAVE_TRIG_NONE, 0 }, { SIM_WAVE_TRIG_NONE, 0 }, wave_scopes, 0 };
+				if (sim_wave_open(&wave)) wave_enable = 0;
+			}
+			else sim_wave_close();
+		}
+		ImGui::SameLine(); ImGui::InputText("Scopes", wave_scopes, sizeof(wave_scopes));
+
+		// Snapshot of the whole sim. Loading it puts main_time etc. back, so it just carries on from there.
+		if (ImGui::Button("Save State")) sim_state_save("sim_state.bin");
+		ImGui::SameLine(); if (ImGui::Button("Load State")) sim_state_load("sim_state.bin");
+
 		dump_ram = ImGui::Button("RAM Dump");
 		ImGui::SameLine(); ImGui::SliderInt("spr_width", &spr_width, 32, 388);
 
@@ -2138,6 +676,8 @@ int main(int argc, char** argv, char** env) {
 			main_time++;
 		}
 
+		sim_update_decompile();
+
 		ImGui::Text("    reset_n: %d", top->rootp->core_3do__DOT__reset_n);
 		ImGui::Separator();
 		ImGui::Text("    dma_ack: %d", top->rootp->core_3do__DOT__madam_inst__DOT__dma_ack);
@@ -2251,6 +791,7 @@ int main(int argc, char** argv, char** env) {
 				/*ImGui::TextColored(ImVec4(reg_col[17]), "       CPSR: 0x%08X", arm_reg[17]);*/ break;
 		}
 
+		opera_arm_flags_sync();
 		ImGui::TextColored(ImVec4(reg_col[17]), "       CPSR: 0x%08X", cpsr); ImGui::SameLine(); ImGui::Text("Opera CPSR: 0x%08X", CPU.CPSR);	// BAD / USR ??
 
 		//if (arm_reg[0]==0x100002B5) run_enable = 0;
@@ -2688,6 +1229,9 @@ int main(int argc, char** argv, char** env) {
 		//g_pSwapChain->Present(1, 0); // Present with vsync
 		g_pSwapChain->Present(0, 0); // Present without vsync
 	}
+	sim_log_close();	// Let the writer thread drain the rest of the trace.
+	sim_wave_close();
+
 	// Close imgui stuff properly...
 	ImGui_ImplDX11_Shutdown();
 	ImGui_ImplWin32_Shutdown();
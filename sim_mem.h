@@ -0,0 +1,54 @@
+#ifndef SIM_MEM_H_INCLUDED
+#define SIM_MEM_H_INCLUDED
+
+// Word access to the host-side memories (rom_ptr, rom2_ptr, ram_ptr, vram_ptr).
+//
+// Those stay BYTE addressed and big-endian, since Opera, the dumps, and the debugger all look at them that way.
+// But the bus glue only ever moves whole words, so instead of four byte loads (or four o_wb_sel-gated byte stores)
+// per access, these do one 32-bit load or store and a byte swap.
+//
+#include <stdint.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#include <stdlib.h>
+#define sim_bswap32(x_) _byteswap_ulong(x_)
+#else
+#define sim_bswap32(x_) __builtin_bswap32(x_)
+#endif
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define sim_mem_be32(x_) (x_)
+#else
+#define sim_mem_be32(x_) sim_bswap32(x_)
+#endif
+
+// o_wb_sel to data mask. Bit 3 of o_wb_sel is the byte at offset 0, so bits [31:24] of o_wb_dat.
+static const uint32_t sim_mem_sel_mask[16] = {
+	0x00000000, 0x000000FF, 0x0000FF00, 0x0000FFFF,
+	0x00FF0000, 0x00FF00FF, 0x00FFFF00, 0x00FFFFFF,
+	0xFF000000, 0xFF0000FF, 0xFF00FF00, 0xFF00FFFF,
+	0xFFFF0000, 0xFFFF00FF, 0xFFFFFF00, 0xFFFFFFFF
+};
+
+// offset_ must be word-aligned.
+static inline uint32_t sim_mem_read32(const uint8_t* mem_, uint32_t offset_) {
+	uint32_t word;
+	memcpy(&word, mem_ + offset_, 4);
+	return sim_mem_be32(word);
+}
+
+static inline void sim_mem_write32(uint8_t* mem_, uint32_t offset_, uint32_t val_) {
+	uint32_t word = sim_mem_be32(val_);
+	memcpy(mem_ + offset_, &word, 4);
+}
+
+// Only the bytes enabled in sel_ (o_wb_sel) get written.
+static inline void sim_mem_write32_sel(uint8_t* mem_, uint32_t offset_, uint32_t val_, uint8_t sel_) {
+	uint32_t mask = sim_mem_sel_mask[sel_ & 0xf];
+
+	if (mask != 0xFFFFFFFF) val_ = (sim_mem_read32(mem_, offset_) & ~mask) | (val_ & mask);
+	sim_mem_write32(mem_, offset_, val_);
+}
+
+#endif /* SIM_MEM_H_INCLUDED */
@@ -0,0 +1,145 @@
+// Save states. See sim_state.h. ElectronAsh.
+//
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "sim_core.h"
+#include "sim_state.h"
+#include "sim_xbus.h"
+
+// libopera includes...
+#include "opera_3do.h"
+
+#if SIM_STATE_ENABLE
+#include "verilated_save.h"
+
+#define SIM_STATE_MAGIC   "SIM3DOST"
+#define SIM_STATE_VERSION 1
+
+// The section sizes go in the header, so a file from a different build gets turned away before anything is touched.
+typedef struct sim_state_header_s {
+	char     magic[8];
+	uint32_t version;
+	uint32_t core_size;
+	uint32_t xbus_size;
+	uint32_t opera_size;
+	uint32_t ram_size;
+	uint32_t vram_size;
+	uint32_t nvram_size;
+	uint32_t bios_hash;
+} sim_state_header_t;
+
+// FNV-1a. Only there to catch a state being loaded on top of a different BIOS.
+static uint32_t sim_state_hash(const uint8_t* data_, uint32_t size_) {
+	uint32_t hash = 0x811C9DC5;
+	for (uint32_t i = 0; i < size_; i++) hash = (hash ^ data_[i]) * 0x01000193;
+	return hash;
+}
+
+static void sim_state_fill_header(sim_state_header_t* header_) {
+	memset(header_, 0, sizeof(*header_));
+	memcpy(header_->magic, SIM_STATE_MAGIC, 8);
+	header_->version = SIM_STATE_VERSION;
+	header_->core_size = sim_core_state_size();
+	header_->xbus_size = sim_xbus_state_size();
+	header_->opera_size = opera_3do_state_size();
+	header_->ram_size = ram_size;
+	header_->vram_size = vram_size;
+	header_->nvram_size = nvram_size;
+	header_->bios_hash = sim_state_hash(rom_ptr, rom_size);
+}
+
+int sim_state_save(const char* path_) {
+	VerilatedSave os;
+	os.open(path_);
+	if (!os.isOpen()) {
+		fprintf(stderr, "Could not create %s\n", path_);
+		return -1;
+	}
+
+	sim_state_header_t header;
+	sim_state_fill_header(&header);
+	os.write(&header, sizeof(header));
+
+	std::vector<uint8_t> buf(header.core_size);
+	sim_core_state_save(buf.data());
+	os.write(buf.data(), buf.size());
+
+	buf.resize(header.xbus_size);
+	sim_xbus_state_save(buf.data());
+	os.write(buf.data(), buf.size());
+
+	buf.resize(header.opera_size);
+	opera_3do_state_save(buf.data());
+	os.write(buf.data(), buf.size());
+
+	os.write(ram_ptr, ram_size);
+	os.write(vram_ptr, vram_size);
+	os.write(nvram_ptr, nvram_size);
+
+	os << *top;		// Every signal and memory in the model. (Verilator checks it's the same model on the way back in)
+	os.close();
+	return 0;
+}
+
+int sim_state_load(const char* path_) {
+	VerilatedRestore is;
+	is.open(path_);
+	if (!is.isOpen()) {
+		fprintf(stderr, "Could not open %s\n", path_);
+		return -1;
+	}
+
+	sim_state_header_t header;
+	sim_state_header_t want;
+	sim_state_fill_header(&want);
+	is.read(&header, sizeof(header));
+
+	if (memcmp(header.magic, want.magic, 8) || header.version != want.version) {
+		fprintf(stderr, "%s is not a save state (or is from an older version)\n", path_);
+		is.close();
+		return -1;
+	}
+	if (header.core_size != want.core_size || header.xbus_size != want.xbus_size || header.opera_size != want.opera_size ||
+		header.ram_size != want.ram_size || header.vram_size != want.vram_size || header.nvram_size != want.nvram_size) {
+		fprintf(stderr, "%s was saved by a different build of the sim\n", path_);
+		is.close();
+		return -1;
+	}
+	if (header.bios_hash != want.bios_hash) fprintf(stderr, "Warning: %s was saved with a different BIOS\n", path_);
+
+	std::vector<uint8_t> buf(header.core_size);
+	is.read(buf.data(), buf.size());
+	sim_core_state_load(buf.data());
+
+	buf.resize(header.xbus_size);
+	is.read(buf.data(), buf.size());
+	sim_xbus_state_load(buf.data());
+
+	buf.resize(header.opera_size);
+	is.read(buf.data(), buf.size());
+	opera_3do_state_load(buf.data());
+
+	is.read(ram_ptr, ram_size);
+	is.read(vram_ptr, vram_size);
+	is.read(nvram_ptr, nvram_size);
+
+	is >> *top;
+	is.close();
+	return 0;
+}
+
+#else
+
+int sim_state_save(const char* path_) {
+	fprintf(stderr, "No save state support in this build. Verilate with --savable (and SIM_STATE_ENABLE=1) for %s.\n", path_);
+	return -1;
+}
+
+int sim_state_load(const char* path_) {
+	fprintf(stderr, "No save state support in this build. Verilate with --savable (and SIM_STATE_ENABLE=1) for %s.\n", path_);
+	return -1;
+}
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef SIM_STATE_H_INCLUDED
+#define SIM_STATE_H_INCLUDED
+
+// Save states for the whole sim, in one file.
+//
+// Everything needed to carry on from where the sim was: the Verilator model, main_time and the rest of sim_core's own
+// state, RAM / VRAM / NVRAM, sim_xbus (and the CD drive behind it), the diag port, and the Opera side.
+// Loading is one read per section straight into place, so it's about as quick as the file can be read.
+//
+// The BIOS, Kanji ROM and CD image aren't in the file. Load the same ones before restoring. (The BIOS gets checked)
+// A file only loads back into a model Verilated from the same RTL, with the same options.
+//
+// Needs the model Verilated with --savable, and SIM_STATE_ENABLE=1. (verilate.sh and verilate_headless.sh both do)
+//
+#ifndef SIM_STATE_ENABLE
+#define SIM_STATE_ENABLE 0
+#endif
+
+int sim_state_save(const char* path_);
+int sim_state_load(const char* path_);
+
+#endif /* SIM_STATE_H_INCLUDED */
@@ -0,0 +1,121 @@
+// Waveform capture windows. See sim_wave.h. ElectronAsh.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "sim_core.h"
+#include "sim_wave.h"
+
+#if VM_TRACE_FST
+#include "verilated_fst_c.h"
+typedef VerilatedFstC sim_wave_file_t;
+#elif VM_TRACE
+#include "verilated_vcd_c.h"
+typedef VerilatedVcdC sim_wave_file_t;
+#endif
+
+bool sim_wave_armed = 0;
+
+int sim_wave_parse_trig(const char* str_, sim_wave_trig_t* trig_) {
+	const char* val = strchr(str_, ':');
+	if (val == NULL) return -1;
+
+	size_t len = val - str_;
+	if (len == 5 && !strncmp(str_, "cycle", 5)) trig_->type = SIM_WAVE_TRIG_CYCLE;
+	else if (len == 2 && !strncmp(str_, "pc", 2)) trig_->type = SIM_WAVE_TRIG_PC;
+	else if (len == 5 && !strncmp(str_, "frame", 5)) trig_->type = SIM_WAVE_TRIG_FRAME;
+	else return -1;
+
+	trig_->value = strtoull(val + 1, NULL, 0);
+	return 0;
+}
+
+#if VM_TRACE
+
+static sim_wave_file_t* sim_wave_file = NULL;
+static sim_wave_cfg_t sim_wave_cfg;
+static std::string sim_wave_path;
+static std::string sim_wave_scopes;
+
+static bool sim_wave_hit(const sim_wave_trig_t* trig_) {
+	switch (trig_->type) {
+		case SIM_WAVE_TRIG_CYCLE: return main_time >= trig_->value;
+		case SIM_WAVE_TRIG_PC: return cur_pc == (uint32_t)trig_->value;
+		case SIM_WAVE_TRIG_FRAME: return (uint64_t)frame_count >= trig_->value;
+	}
+	return 0;
+}
+
+// The file only gets created when the start trigger hits, so it doesn't begin with millions of cycles of boot.
+static void sim_wave_begin() {
+	sim_wave_file = new sim_wave_file_t;
+
+	// Each scope gets its own dumpvars() entry. Anything not under one of them is left out of the file.
+	const char* scopes = sim_wave_scopes.c_str();
+	while (*scopes) {
+		size_t len = strcspn(scopes, ",");
+		if (len) sim_wave_file->dumpvars(sim_wave_cfg.depth ? sim_wave_cfg.depth : 99, "TOP.core_3do." + std::string(scopes, len));
+		scopes += len;
+		if (*scopes == ',') scopes++;
+	}
+
+	top->trace(sim_wave_file, 99);
+	sim_wave_file->open(sim_wave_path.c_str());
+}
+
+int sim_wave_open(const sim_wave_cfg_t* cfg_) {
+	sim_wave_close();
+	Verilated::traceEverOn(true);
+
+	sim_wave_cfg = *cfg_;
+	sim_wave_path = cfg_->path;
+	sim_wave_scopes = cfg_->scopes ? cfg_->scopes : "";
+	sim_wave_armed = 1;
+	return 0;
+}
+
+void sim_wave_close() {
+	sim_wave_armed = 0;
+
+	if (sim_wave_file) {
+		sim_wave_file->close();		// Waits for the FST writer thread to finish.
+		delete sim_wave_file;
+		sim_wave_file = NULL;
+	}
+}
+
+bool sim_wave_active() {
+	return sim_wave_file != NULL;
+}
+
+void sim_wave_step(uint64_t time_) {
+	if (sim_wave_file == NULL) {
+		if (sim_wave_cfg.start.type != SIM_WAVE_TRIG_NONE && !sim_wave_hit(&sim_wave_cfg.start)) return;
+		sim_wave_begin();
+	}
+
+	sim_wave_file->dump(time_);		// No flush() here. Leave the buffering to the writer.
+
+	if (sim_wave_hit(&sim_wave_cfg.stop)) sim_wave_close();
+}
+
+#else
+
+int sim_wave_open(const sim_wave_cfg_t* cfg_) {
+	fprintf(stderr, "No waveform support in this build. Verilate with --trace-fst (or --trace) for %s.\n", cfg_->path);
+	return -1;
+}
+
+void sim_wave_close() {
+}
+
+bool sim_wave_active() {
+	return 0;
+}
+
+void sim_wave_step(uint64_t time_) {
+}
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef SIM_WAVE_H_INCLUDED
+#define SIM_WAVE_H_INCLUDED
+
+// Waveform capture for verilate().
+//
+// Dumping the whole design on every cycle makes a run 20-50x slower, and the files get huge. So capture is now a window:
+// it starts and stops on a cycle count, a PC match, or a frame_count, and can be limited to a few scopes (eg. madam_inst).
+//
+// The file type depends on how the model was Verilated:
+//   --trace-fst --trace-threads 1   FST, written by Verilator's own writer thread. (verilate_headless.sh with TRACE=1)
+//   --trace                         VCD, written on the sim thread. (verilate.sh / MSVC)
+// Without either, sim_wave_open() just says so and fails.
+//
+#include <stdint.h>
+
+enum sim_wave_trig_e {
+	SIM_WAVE_TRIG_NONE = 0,	// Start: straight away. Stop: never (until sim_wave_close).
+	SIM_WAVE_TRIG_CYCLE,	// main_time >= value.
+	SIM_WAVE_TRIG_PC,		// cur_pc == value.
+	SIM_WAVE_TRIG_FRAME		// frame_count >= value.
+};
+
+typedef struct sim_wave_trig_t {
+	uint8_t type;			// sim_wave_trig_e.
+	uint64_t value;
+} sim_wave_trig_t;
+
+typedef struct sim_wave_cfg_t {
+	const char* path;
+	sim_wave_trig_t start;
+	sim_wave_trig_t stop;
+	const char* scopes;		// Comma-separated scopes under core_3do, eg. "madam_inst,zap_top_inst.u_zap_core". NULL for everything.
+	int depth;				// Levels below each scope. (0 = all)
+} sim_wave_cfg_t;
+
+// Set while a capture is open and hasn't hit its stop trigger, so verilate() only pays for one test otherwise.
+extern bool sim_wave_armed;
+
+int  sim_wave_open(const sim_wave_cfg_t* cfg_);
+void sim_wave_close();
+bool sim_wave_active();		// Past the start trigger, and writing.
+
+// "cycle:<n>", "pc:<addr>", or "frame:<n>".
+int  sim_wave_parse_trig(const char* str_, sim_wave_trig_t* trig_);
+
+void sim_wave_step(uint64_t time_);
+
+// Called by verilate() after each eval(). time_ is in Verilator time units (10 per main_time).
+static inline void sim_wave_sample(uint64_t time_) {
+	if (sim_wave_armed) sim_wave_step(time_);
+}
+
+#endif /* SIM_WAVE_H_INCLUDED */
@@ -13,6 +13,11 @@
 #define POLMA	  0x40
 #define POLRE	  0x80
 
+volatile xbus_datum_t XBUS;
+volatile sim_xbus_device xdev[16];
+
+int sim_xbus_fiq_request = 0;
+
 void
 sim_xbus_execute_command_f(void)
 {
@@ -42,7 +47,7 @@ sim_xbus_execute_command_f(void)
 }
 
 void
-sim_xbus_fifo_set_cmd(const uint8_t val_)
+sim_xbus_fifo_set_cmd(const uint32_t val_)
 {
 	if (xdev[XBUS.xb_sel_l])
 	{
@@ -131,14 +136,14 @@ sim_xbus_fifo_get_status(void)
 }
 
 void
-sim_xbus_fifo_set_data(const uint8_t val_)
+sim_xbus_fifo_set_data(const uint32_t val_)
 {
 	if (xdev[XBUS.xb_sel_l])
 		xdev[XBUS.xb_sel_l](XBP_SET_DATA, (void*)(uintptr_t)val_);
 }
 
 void
-sim_xbus_set_poll(const uint8_t val_)
+sim_xbus_set_poll(const uint32_t val_)
 {
 	if (XBUS.xb_sel_l == 0x0F)
 	{
@@ -155,7 +160,7 @@ sim_xbus_set_poll(const uint8_t val_)
 	}
 }
 
-void sim_xbus_set_sel(const uint8_t val_)
+void sim_xbus_set_sel(const uint32_t val_)
 {
 	XBUS.xb_sel_l = (val_ & 0x0F);
 	XBUS.xb_sel_h = (val_ & 0xF0);
@@ -33,13 +33,13 @@ struct xbus_datum_s
 
 typedef struct xbus_datum_s xbus_datum_t;
 
-volatile xbus_datum_t      XBUS;
+extern volatile xbus_datum_t XBUS;
 
-int sim_xbus_fiq_request;
+extern int sim_xbus_fiq_request;
 
 typedef void* (*sim_xbus_device)(int, void*);
 
-volatile sim_xbus_device xdev[16];
+extern volatile sim_xbus_device xdev[16];
 
 void     sim_xbus_init(sim_xbus_device zero_dev_);
 void     sim_xbus_destroy(void);
@@ -0,0 +1,81 @@
+# Headless batch runner (sim_headless.cpp) for Linux, GCC or Clang. No ImGui / D3D needed.
+#
+# libopera and sim_xbus are plain C, so they get built into a static lib first. (verilated.mk would build any .c file as C++.)
+#
+# Usage: ./verilate_headless.sh     (CC / CXX pick the compiler, eg. CC=clang CXX=clang++)
+#
+# Build options, all set from the environment:
+#   THREADS=<n>   Verilator --threads. (default 8. Use bench_threads.sh to find the best one for your machine.)
+#   TRACE=1       Adds FST waveform support for --wave. Slower, even when not dumping.
+#   PGO=gen       Instrumented build. Records Verilator's thread profile (--prof-pgo) and the compiler's branch profile.
+#   PGO=use       Rebuild using both profiles from a PGO=gen run. (pgo_headless.sh does gen / train / use in one go.)
+#   SAVABLE=0     Leaves out --savable, and with it --save-state / --load-state. (The model compiles a bit quicker)
+#   OUT=<dir>     Build directory. (default out_headless)
+#
+# CHD images need zlib and liblzma. (eg. zlib1g-dev and liblzma-dev)
+
+set -e
+
+CC=${CC:-gcc}
+CXX=${CXX:-g++}
+THREADS=${THREADS:-8}
+OUT=${OUT:-out_headless}
+
+# FST gets compressed and written out by Verilator's own thread, so the sim thread only has to copy the changes.
+TRACE_FLAGS=""
+if [ "${TRACE:-0}" = "1" ]; then
+	TRACE_FLAGS="--trace-fst --trace-threads 1 -LDFLAGS -lz"
+fi
+
+# --savable adds the model's save / restore functions. SIM_STATE_ENABLE tells sim_state.cpp they're there.
+SAVE_FLAGS=""
+SAVE_CFLAGS=""
+if [ "${SAVABLE:-1}" = "1" ]; then
+	SAVE_FLAGS="--savable"
+	SAVE_CFLAGS="-DSIM_STATE_ENABLE=1"
+fi
+
+# The compiler profile goes in $OUT/pgo. GCC names the .gcda files after the object paths, so gen and use need the same OUT.
+PGO_DIR=$PWD/$OUT/pgo
+PGO_FLAGS=""
+PGO_CFLAGS=""
+case "${PGO:-}" in
+	"") ;;
+	gen)
+		rm -rf $PGO_DIR $OUT/profile.vlt
+		mkdir -p $PGO_DIR
+		PGO_FLAGS="--prof-pgo -LDFLAGS -fprofile-generate=$PGO_DIR"
+		PGO_CFLAGS="-fprofile-generate=$PGO_DIR"
+		;;
+	use)
+		if [ ! -f $OUT/profile.vlt ]; then
+			echo "No $OUT/profile.vlt. Do a PGO=gen build and a training run first. (see pgo_headless.sh)"
+			exit 1
+		fi
+		# Clang leaves raw profiles that need merging. GCC reads its .gcda files as they are.
+		if ls $PGO_DIR/*.profraw >/dev/null 2>&1; then
+			llvm-profdata merge -o $PGO_DIR/default.profdata $PGO_DIR/*.profraw
+		fi
+		PGO_FLAGS="$PWD/$OUT/profile.vlt"
+		PGO_CFLAGS="-fprofile-use=$PGO_DIR -Wno-missing-profile"
+		;;
+	*)
+		echo "PGO should be gen or use."
+		exit 1
+		;;
+esac
+
+mkdir -p $OUT/libopera
+rm -f $OUT/Vcore*.* $OUT/libopera/*.o
+
+for f in libopera/*.c sim_xbus.c; do
+	$CC -O2 $PGO_CFLAGS -Ilibopera -c $f -o $OUT/libopera/$(basename $f .c).o
+done
+ar rcs $OUT/libopera.a $OUT/libopera/*.o
+
+verilator --assert --public-flat-rw --compiler gcc --threads $THREADS -O3 $TRACE_FLAGS $SAVE_FLAGS $PGO_FLAGS --converge-limit 2000 -Wno-PINMISSING -Wno-TIMESCALEMOD -Wno-LITENDIAN -Wno-CASEOVERLAP -Wno-WIDTH -Wno-IMPLICIT -Wno-MODDUP -Wno-UNSIGNED -Wno-CASEINCOMPLETE -Wno-CASEX -Wno-SYMRSVDWORD -Wno-COMBDLY -Wno-INITIALDLY -Wno-BLKANDNBLK -Wno-MULTIDRIVEN -Wno-UNOPT -Wno-UNOPTFLAT -Wno-LATCH -y -I. -Irtl -Irtl/zap --top-module core_3do -Mdir $OUT --cc core_3do.v --exe sim_headless.cpp sim_core.cpp sim_bus.cpp sim_log.cpp sim_wave.cpp sim_cdimage.cpp sim_chd.cpp sim_state.cpp sim_ffwd.cpp sim_idle.cpp $PWD/$OUT/libopera.a -CFLAGS "-O2 $PGO_CFLAGS -DSIM_CHD_ENABLE=1 $SAVE_CFLAGS -I$PWD -I$PWD/libopera" -LDFLAGS "-lz -llzma" -MAKEFLAGS "CXX=$CXX" --build -j 0 -o sim_3do_headless
+
+# Offline decoder for --binlog files. Doesn't need the model.
+$CXX -O2 -I. -o $OUT/sim_log_decode sim_log_decode.cpp sim_log.cpp sim_bus.cpp -lpthread
+
+echo "Built $OUT/sim_3do_headless and $OUT/sim_log_decode"